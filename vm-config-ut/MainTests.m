@@ -23,6 +23,11 @@
 #import <XCTest/XCTest.h>
 
 #import <os/lock.h>
+#import <pthread.h>
+#import <signal.h>
+#import <spawn.h>
+
+#import <sys/wait.h>
 
 #import "main.h"
 
@@ -35,6 +40,8 @@
 #import "SMVMwareNVRAM.h"
 #import "SMVMwareNVRAMHelper.h"
 
+#import "SMServer.h"
+
 #import "SMVMwareVMXHelper.h"
 
 
@@ -71,6 +78,25 @@ typedef struct
 	size_t	value_size;
 } SMNVRAMEFIVariableTest;
 
+typedef struct
+{
+	char		socket_path[64];
+	pthread_t	thread;
+	int			exit_code;
+	
+	SMServerClient *client;
+} SMMainTestServeContext;
+
+
+/*
+** Prototypes
+*/
+#pragma mark - Prototypes
+
+static int		SMMainTestServeRequest(const char *working_directory, int argc, const char *argv[], FILE *fout, FILE *ferr, void *context);
+static void *	SMMainTestServe(void *server);
+static void *	SMMainTestServeMain(void *context);
+
 
 /*
 ** MainTests
@@ -385,6 +411,181 @@ typedef struct
 	XCTAssertContainString(*bout, sout, "Value");
 }
 
+- (void)testShowJSON
+{
+	// Generate test vm.
+	NSString *vmPath = [self generateVMwareVMWithResultingVMXFilePath:nil resultingNVRAMFilePath:nil];
+	
+	// Test main.
+	const char *argv[] = {
+		"ut-main",
+		"show",
+		vmPath.fileSystemRepresentation,
+		"--all",
+		"--format",
+		"json"
+	};
+	
+	XCTAssertDefaultMain(SMMainExitSuccess);
+	
+	// Check output.
+	XCTAssertEqual(serr, 0);
+	XCTAssertGreaterThan(sout, 0);
+	XCTAssertEqual((*bout)[sout - 1], '\n');
+	
+	NSDictionary *record = [NSJSONSerialization JSONObjectWithData:[NSData dataWithBytes:*bout length:sout] options:0 error:nil];
+	
+	XCTAssertTrue([record isKindOfClass:[NSDictionary class]]);
+	XCTAssertEqualObjects(record[@"path"], vmPath);
+	XCTAssertEqualObjects(record[@"vmx"][0][@"key"], @".encoding");
+	
+	NSArray *nvram = record[@"nvram"];
+	
+	XCTAssertEqualObjects(nvram[0][@"name"], @"KEY1");
+	XCTAssertEqualObjects(nvram[0][@"subname"], @"SUB1");
+	XCTAssertEqualObjects([nvram valueForKeyPath:@"@unionOfArrays.variables.utf8_name"], (@[ @"PROP1", @"HELLOWORLD" ]));
+}
+
+- (void)testShowInvalidFormat
+{
+	// Generate test vm.
+	NSString *vmPath = [self generateVMwareVMWithResultingVMXFilePath:nil resultingNVRAMFilePath:nil];
+	
+	// Test main.
+	const char *argv[] = {
+		"ut-main",
+		"show",
+		vmPath.fileSystemRepresentation,
+		"--all",
+		"--format",
+		"xml"
+	};
+	
+	XCTAssertDefaultMain(SMMainExitInvalidArgs);
+	
+	// Check output.
+	XCTAssertEqual(sout, 0);
+	XCTAssertContainString(*berr, serr, "xml");
+}
+
+
+- (void)testShowLibrary
+{
+	// Generate test vms.
+	NSString *vmPath1 = [self generateVMwareVMWithResultingVMXFilePath:nil resultingNVRAMFilePath:nil];
+	NSString *vmPath2 = [self generateVMwareVMWithResultingVMXFilePath:nil resultingNVRAMFilePath:nil];
+
+	// Test main.
+	const char *argv[] = {
+		"ut-main",
+		"show",
+		_testDirectory.fileSystemRepresentation,
+		"--library",
+		"--vmx",
+		"--jobs",
+		"2"
+	};
+	
+	XCTAssertDefaultMain(SMMainExitSuccess);
+	
+	// Check output.
+	XCTAssertEqual(serr, 0);
+	
+	XCTAssertContainString(*bout, sout, vmPath1.fileSystemRepresentation);
+	XCTAssertContainString(*bout, sout, vmPath2.fileSystemRepresentation);
+	XCTAssertContainString(*bout, sout, "-- VMX");
+}
+
+- (void)testShowLibraryInvalidVM
+{
+	// Generate test vm & an invalid one.
+	NSString *vmPath = [self generateVMwareVMWithResultingVMXFilePath:nil resultingNVRAMFilePath:nil];
+	NSString *invalidVMPath = [_testDirectory stringByAppendingPathComponent:@"invalid.vmwarevm"];
+	
+	XCTAssertTrue([[NSFileManager defaultManager] createDirectoryAtPath:invalidVMPath withIntermediateDirectories:YES attributes:nil error:nil]);
+
+	// Test main.
+	const char *argv[] = {
+		"ut-main",
+		"show",
+		_testDirectory.fileSystemRepresentation,
+		"--library",
+		"--vmx",
+	};
+	
+	XCTAssertDefaultMain(SMMainExitInvalidVM);
+	
+	// Check output.
+	XCTAssertContainString(*bout, sout, vmPath.fileSystemRepresentation);
+	XCTAssertContainString(*berr, serr, invalidVMPath.fileSystemRepresentation);
+	XCTAssertContainString(*berr, serr, "1 of 2");
+}
+
+- (void)testShowLibraryNDJSON
+{
+	// Generate test vm & an invalid one.
+	NSString *vmPath = [self generateVMwareVMWithResultingVMXFilePath:nil resultingNVRAMFilePath:nil];
+	NSString *invalidVMPath = [_testDirectory stringByAppendingPathComponent:@"invalid.vmwarevm"];
+	
+	XCTAssertTrue([[NSFileManager defaultManager] createDirectoryAtPath:invalidVMPath withIntermediateDirectories:YES attributes:nil error:nil]);
+	
+	// Test main.
+	const char *argv[] = {
+		"ut-main",
+		"show",
+		_testDirectory.fileSystemRepresentation,
+		"--library",
+		"--nvram-efi-variables",
+		"--format",
+		"ndjson"
+	};
+	
+	XCTAssertDefaultMain(SMMainExitInvalidVM);
+	
+	// Check output.
+	// > One record per bundle, in completion order. Failed bundles have an error.
+	NSString		*output = [[NSString alloc] initWithBytes:*bout length:sout encoding:NSUTF8StringEncoding];
+	NSArray			*lines = [output componentsSeparatedByString:@"\n"];
+	NSMutableSet	*paths = [NSMutableSet set];
+	
+	XCTAssertEqual(lines.count, 3);
+	XCTAssertEqualObjects(lines.lastObject, @"");
+	
+	for (NSString *line in [lines subarrayWithRange:NSMakeRange(0, 2)])
+	{
+		NSDictionary *record = [NSJSONSerialization JSONObjectWithData:[line dataUsingEncoding:NSUTF8StringEncoding] options:0 error:nil];
+		
+		XCTAssertTrue([record isKindOfClass:[NSDictionary class]]);
+		
+		if ([record[@"path"] isEqualToString:vmPath])
+			XCTAssertEqualObjects([record valueForKeyPath:@"nvram_efi_variables.utf8_name"], (@[ @"PROP1", @"HELLOWORLD" ]));
+		else
+			XCTAssertNotNil(record[@"error"]);
+		
+		[paths addObject:record[@"path"]];
+	}
+	
+	XCTAssertEqualObjects(paths, ([NSSet setWithObjects:vmPath, invalidVMPath, nil]));
+	XCTAssertContainString(*berr, serr, "1 of 2");
+}
+
+- (void)testShowLibraryEmpty
+{
+	// Test main.
+	const char *argv[] = {
+		"ut-main",
+		"show",
+		_testDirectory.fileSystemRepresentation,
+		"--library",
+		"--all",
+	};
+	
+	XCTAssertDefaultMain(SMMainExitInvalidVM);
+	
+	// Check output.
+	XCTAssertEqual(sout, 0);
+	XCTAssertContainString(*berr, serr, "Error");
+}
 
 #pragma mark > Change
 
@@ -607,8 +808,445 @@ typedef struct
 }
 
 
+- (void)testChangeMultipleBundles
+{
+	// Generate test vms.
+	NSString *vmPath1 = [self generateVMwareVMWithResultingVMXFilePath:nil resultingNVRAMFilePath:nil];
+	NSString *vmPath2 = [self generateVMwareVMWithResultingVMXFilePath:nil resultingNVRAMFilePath:nil];
+
+	// Test main.
+	const char *argv[] = {
+		"ut-main",
+		"change",
+		vmPath1.fileSystemRepresentation,
+		vmPath2.fileSystemRepresentation,
+		"--boot-args",
+		"hello-world",
+		"--jobs",
+		"2"
+	};
+	
+	XCTAssertDefaultMain(SMMainExitSuccess);
+
+	// Check output.
+	XCTAssertEqual(serr, 0);
+
+	// Validate change.
+	SMVMXEntryTest vmxEntries[] = {
+	};
+	
+	SMNVRAMEFIVariableTest nvramVariables[] = {
+		{ .guid = Apple_NVRAM_Variable_Guid, .name = SMEFIAppleNVRAMVarBootArgsName, .value = { 0x68, 0x65, 0x6C, 0x6C, 0x6F, 0x2D, 0x77, 0x6F, 0x72, 0x6C, 0x64, 0x00 }, .value_size = 12 }
+	};
+	
+	[self validateChangeOnVMAtPath:vmPath1 vmxEntries:vmxEntries vmxCount:sizeof(vmxEntries) / sizeof(*vmxEntries) nvramVariables:nvramVariables nvramCount:sizeof(nvramVariables) / sizeof(*nvramVariables)];
+	[self validateChangeOnVMAtPath:vmPath2 vmxEntries:vmxEntries vmxCount:sizeof(vmxEntries) / sizeof(*vmxEntries) nvramVariables:nvramVariables nvramCount:sizeof(nvramVariables) / sizeof(*nvramVariables)];
+}
+
+- (void)testChangeBundlesList
+{
+	// Generate test vms.
+	NSString *vmPath1 = [self generateVMwareVMWithResultingVMXFilePath:nil resultingNVRAMFilePath:nil];
+	NSString *vmPath2 = [self generateVMwareVMWithResultingVMXFilePath:nil resultingNVRAMFilePath:nil];
+	
+	// Write list.
+	NSString *listPath = [_testDirectory stringByAppendingPathComponent:@"bundles.txt"];
+	NSString *list = [NSString stringWithFormat:@"%@\n\n%@\n", vmPath1, vmPath2];
+	
+	XCTAssertTrue([list writeToFile:listPath atomically:NO encoding:NSUTF8StringEncoding error:nil]);
+
+	// Test main.
+	const char *argv[] = {
+		"ut-main",
+		"change",
+		"--bundles-list",
+		listPath.fileSystemRepresentation,
+		"--csr-flags",
+		"0x42"
+	};
+	
+	XCTAssertDefaultMain(SMMainExitSuccess);
+
+	// Check output.
+	XCTAssertEqual(serr, 0);
+
+	// Validate change.
+	SMVMXEntryTest vmxEntries[] = {
+	};
+	
+	SMNVRAMEFIVariableTest nvramVariables[] = {
+		{ .guid = Apple_NVRAM_Variable_Guid, .name = SMEFIAppleNVRAMVarCSRActiveConfigName, .value = { 0x42, 0x00, 0x00, 0x00 }, .value_size = 4 }
+	};
+	
+	[self validateChangeOnVMAtPath:vmPath1 vmxEntries:vmxEntries vmxCount:sizeof(vmxEntries) / sizeof(*vmxEntries) nvramVariables:nvramVariables nvramCount:sizeof(nvramVariables) / sizeof(*nvramVariables)];
+	[self validateChangeOnVMAtPath:vmPath2 vmxEntries:vmxEntries vmxCount:sizeof(vmxEntries) / sizeof(*vmxEntries) nvramVariables:nvramVariables nvramCount:sizeof(nvramVariables) / sizeof(*nvramVariables)];
+}
+
+- (void)testChangeMultipleBundlesInvalidVM
+{
+	// Generate test vm.
+	NSString *vmPath = [self generateVMwareVMWithResultingVMXFilePath:nil resultingNVRAMFilePath:nil];
+
+	// Test main.
+	const char *argv[] = {
+		"ut-main",
+		"change",
+		vmPath.fileSystemRepresentation,
+		_testDirectory.fileSystemRepresentation,
+		"--boot-args",
+		"hello-world"
+	};
+	
+	XCTAssertDefaultMain(SMMainExitInvalidVM);
+
+	// Check output.
+	XCTAssertContainString(*berr, serr, "Error");
+	XCTAssertContainString(*berr, serr, "1 of 2");
+}
+
+#pragma mark > Apply
+
+- (void)testApply
+{
+	// Generate test vms.
+	NSString *vmPath1 = [self generateVMwareVMWithResultingVMXFilePath:nil resultingNVRAMFilePath:nil];
+	NSString *vmPath2 = [self generateVMwareVMWithResultingVMXFilePath:nil resultingNVRAMFilePath:nil];
+	
+	// Write manifest.
+	NSString *manifestPath = [_testDirectory stringByAppendingPathComponent:@"manifest.txt"];
+	NSString *manifest = [NSString stringWithFormat:@"# Comment\n'%@' --boot-args 'hello-world'\n\n'%@' --csr-flags 0x42\n", vmPath1, vmPath2];
+	
+	XCTAssertTrue([manifest writeToFile:manifestPath atomically:NO encoding:NSUTF8StringEncoding error:nil]);
+
+	// Test main.
+	const char *argv[] = {
+		"ut-main",
+		"apply",
+		manifestPath.fileSystemRepresentation,
+	};
+	
+	XCTAssertDefaultMain(SMMainExitSuccess);
+
+	// Check output.
+	XCTAssertEqual(serr, 0);
+
+	// Validate change.
+	SMVMXEntryTest vmxEntries[] = {
+	};
+	
+	SMNVRAMEFIVariableTest nvramVariables1[] = {
+		{ .guid = Apple_NVRAM_Variable_Guid, .name = SMEFIAppleNVRAMVarBootArgsName, .value = { 0x68, 0x65, 0x6C, 0x6C, 0x6F, 0x2D, 0x77, 0x6F, 0x72, 0x6C, 0x64, 0x00 }, .value_size = 12 }
+	};
+	
+	SMNVRAMEFIVariableTest nvramVariables2[] = {
+		{ .guid = Apple_NVRAM_Variable_Guid, .name = SMEFIAppleNVRAMVarCSRActiveConfigName, .value = { 0x42, 0x00, 0x00, 0x00 }, .value_size = 4 }
+	};
+	
+	[self validateChangeOnVMAtPath:vmPath1 vmxEntries:vmxEntries vmxCount:sizeof(vmxEntries) / sizeof(*vmxEntries) nvramVariables:nvramVariables1 nvramCount:sizeof(nvramVariables1) / sizeof(*nvramVariables1)];
+	[self validateChangeOnVMAtPath:vmPath2 vmxEntries:vmxEntries vmxCount:sizeof(vmxEntries) / sizeof(*vmxEntries) nvramVariables:nvramVariables2 nvramCount:sizeof(nvramVariables2) / sizeof(*nvramVariables2)];
+}
+
+- (void)testApplyInvalidRecords
+{
+	// Generate test vm.
+	NSString *vmPath = [self generateVMwareVMWithResultingVMXFilePath:nil resultingNVRAMFilePath:nil];
+	
+	// Write manifest.
+	NSString *manifestPath = [_testDirectory stringByAppendingPathComponent:@"manifest.txt"];
+	NSString *manifest = [NSString stringWithFormat:@"'%@' --csr-flags nope\n--csr-disable\n'%@' --boot-args 'hello-world'\n", vmPath, vmPath];
+	
+	XCTAssertTrue([manifest writeToFile:manifestPath atomically:NO encoding:NSUTF8StringEncoding error:nil]);
+
+	// Test main.
+	const char *argv[] = {
+		"ut-main",
+		"apply",
+		manifestPath.fileSystemRepresentation,
+	};
+	
+	XCTAssertDefaultMain(SMMainExitInvalidArgs);
+
+	// Check output.
+	XCTAssertContainString(*berr, serr, "Manifest line 1");
+	XCTAssertContainString(*berr, serr, "Manifest line 2");
+	XCTAssertContainString(*berr, serr, "2 of 3");
+	
+	// Validate valid record was applied anyway.
+	SMVMXEntryTest vmxEntries[] = {
+	};
+	
+	SMNVRAMEFIVariableTest nvramVariables[] = {
+		{ .guid = Apple_NVRAM_Variable_Guid, .name = SMEFIAppleNVRAMVarBootArgsName, .value = { 0x68, 0x65, 0x6C, 0x6C, 0x6F, 0x2D, 0x77, 0x6F, 0x72, 0x6C, 0x64, 0x00 }, .value_size = 12 }
+	};
+	
+	[self validateChangeOnVMAtPath:vmPath vmxEntries:vmxEntries vmxCount:sizeof(vmxEntries) / sizeof(*vmxEntries) nvramVariables:nvramVariables nvramCount:sizeof(nvramVariables) / sizeof(*nvramVariables)];
+}
+
+#pragma mark > Call
+
+- (void)testCall
+{
+	// Generate test vm.
+	NSString *vmPath = [self generateVMwareVMWithResultingVMXFilePath:nil resultingNVRAMFilePath:nil];
+	
+	// Start server.
+	// > Short path: socket paths are limited to about a hundred bytes.
+	NSString	*socketPath = [NSString stringWithFormat:@"/tmp/vm-config-ut-%@.sock", [[NSUUID UUID].UUIDString substringToIndex:8]];
+	SMServer	*server = SMServerCreate(socketPath.fileSystemRepresentation, SMMainTestServeRequest, NULL, NULL);
+	pthread_t	thread;
+	
+	XCTAssertNotEqual(server, NULL);
+	XCTAssertEqual(pthread_create(&thread, NULL, SMMainTestServe, server), 0);
+	
+	_onExit {
+		SMServerStop(server);
+		pthread_join(thread, NULL);
+		SMServerFree(server);
+	};
+	
+	// Test main.
+	const char *argv[] = {
+		"ut-main",
+		"call",
+		socketPath.fileSystemRepresentation,
+		"--",
+		"change",
+		vmPath.fileSystemRepresentation,
+		"--boot-args",
+		"hello-world"
+	};
+	
+	XCTAssertDefaultMain(SMMainExitSuccess);
+	
+	// Check output.
+	XCTAssertEqual(serr, 0);
+	XCTAssertContainString(*bout, sout, "changed with success");
+	
+	// Validate change.
+	SMVMXEntryTest vmxEntries[] = {
+	};
+	
+	SMNVRAMEFIVariableTest nvramVariables[] = {
+		{ .guid = Apple_NVRAM_Variable_Guid, .name = SMEFIAppleNVRAMVarBootArgsName, .value = { 0x68, 0x65, 0x6C, 0x6C, 0x6F, 0x2D, 0x77, 0x6F, 0x72, 0x6C, 0x64, 0x00 }, .value_size = 12 }
+	};
+	
+	[self validateChangeOnVMAtPath:vmPath vmxEntries:vmxEntries vmxCount:sizeof(vmxEntries) / sizeof(*vmxEntries) nvramVariables:nvramVariables nvramCount:sizeof(nvramVariables) / sizeof(*nvramVariables)];
+}
+
+- (void)testCallInvalidSocket
+{
+	NSString *socketPath = [_testDirectory stringByAppendingPathComponent:@"missing.sock"];
+	
+	// Test main.
+	const char *argv[] = {
+		"ut-main",
+		"call",
+		socketPath.fileSystemRepresentation,
+		"--",
+		"version"
+	};
+	
+	XCTAssertDefaultMain(SMMainExitUnknowError);
+	
+	// Check output.
+	XCTAssertEqual(sout, 0);
+	XCTAssertContainString(*berr, serr, "Error: ");
+}
+
+
+#pragma mark > Serve
+
+- (void)testServe
+{
+	// Generate test vm.
+	NSString *vmPath = [self generateVMwareVMWithResultingVMXFilePath:nil resultingNVRAMFilePath:nil];
+	
+	// Start server.
+	SMMainTestServeContext *context = [self startServe];
+	
+	_onExit {
+		[self stopServe:context];
+	};
+	
+	// Show, twice: the second request is answered from the cache.
+	const char	**show_argv = (const char *[]){ "show", vmPath.fileSystemRepresentation, "--nvram-efi-variable", SMEFIAppleNVRAMVarBootArgsName };
+	NSString	*output = [self runClient:context->client argc:4 argv:show_argv exitCode:SMMainExitSuccess errorOutput:nil];
+	
+	XCTAssertFalse([output containsString:@"hello-world"]);
+	XCTAssertEqualObjects([self runClient:context->client argc:4 argv:show_argv exitCode:SMMainExitSuccess errorOutput:nil], output);
+	
+	// Change, then show again: the cached nvram was replaced on disk, and must be parsed again.
+	const char **change_argv = (const char *[]){ "change", vmPath.fileSystemRepresentation, "--boot-args", "hello-world" };
+	
+	XCTAssertTrue([[self runClient:context->client argc:4 argv:change_argv exitCode:SMMainExitSuccess errorOutput:nil] containsString:@"changed with success"]);
+	XCTAssertTrue([[self runClient:context->client argc:4 argv:show_argv exitCode:SMMainExitSuccess errorOutput:nil] containsString:@"hello-world"]);
+	
+	// Requests can't start or call servers.
+	const char	**serve_argv = (const char *[]){ "serve", "/tmp/vm-config-ut-nested.sock" };
+	const char	**call_argv = (const char *[]){ "call", context->socket_path, "--", "version" };
+	NSString	*errorOutput = nil;
+	
+	XCTAssertEqualObjects([self runClient:context->client argc:2 argv:serve_argv exitCode:SMMainExitInvalidArgs errorOutput:&errorOutput], @"");
+	XCTAssertTrue([errorOutput containsString:@"Verb 'serve' is not allowed in requests"]);
+	
+	XCTAssertEqualObjects([self runClient:context->client argc:4 argv:call_argv exitCode:SMMainExitInvalidArgs errorOutput:&errorOutput], @"");
+	XCTAssertTrue([errorOutput containsString:@"Verb 'call' is not allowed in requests"]);
+	
+	XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:@"/tmp/vm-config-ut-nested.sock"]);
+	
+	// Requests can't read standard input.
+	const char **apply_argv = (const char *[]){ "apply", "-" };
+	const char **list_argv = (const char *[]){ "change", "--bundles-list", "-", "--boot-args", "stdin" };
+	
+	XCTAssertEqualObjects([self runClient:context->client argc:2 argv:apply_argv exitCode:SMMainExitInvalidArgs errorOutput:&errorOutput], @"");
+	XCTAssertTrue([errorOutput containsString:@"Standard input ('-') is not available in requests"]);
+	
+	XCTAssertEqualObjects([self runClient:context->client argc:5 argv:list_argv exitCode:SMMainExitInvalidArgs errorOutput:&errorOutput], @"");
+	XCTAssertTrue([errorOutput containsString:@"Standard input ('-') is not available in requests"]);
+	
+	// Relative paths are resolved against the client working directory.
+	const char	**relative_argv = (const char *[]){ "show", vmPath.lastPathComponent.fileSystemRepresentation, "--nvram-efi-variable", SMEFIAppleNVRAMVarBootArgsName };
+	char		cwd[PATH_MAX];
+	
+	XCTAssertNotEqual(getcwd(cwd, sizeof(cwd)), NULL);
+	XCTAssertEqual(chdir(vmPath.stringByDeletingLastPathComponent.fileSystemRepresentation), 0);
+	
+	output = [self runClient:context->client argc:4 argv:relative_argv exitCode:SMMainExitSuccess errorOutput:nil];
+	
+	XCTAssertEqual(chdir(cwd), 0);
+	XCTAssertTrue([output containsString:@"hello-world"]);
+	
+	// The server still answers.
+	XCTAssertTrue([[self runClient:context->client argc:4 argv:show_argv exitCode:SMMainExitSuccess errorOutput:nil] containsString:@"hello-world"]);
+}
+
+- (void)testPerformanceServeShow
+{
+	// Generate test vm.
+	NSString *vmPath = [self generateVMwareVMWithResultingVMXFilePath:nil resultingNVRAMFilePath:nil];
+	
+	// Start server.
+	SMMainTestServeContext *context = [self startServe];
+	
+	_onExit {
+		[self stopServe:context];
+	};
+	
+	// Measure: one connection, files parsed once.
+	const char **argv = (const char *[]){ "show", vmPath.fileSystemRepresentation, "--all" };
+	
+	[self measureBlock:^{
+		for (unsigned i = 0; i < 100; i++)
+			[self runClient:context->client argc:3 argv:argv exitCode:SMMainExitSuccess errorOutput:nil];
+	}];
+}
+
+- (void)testPerformanceExecShow
+{
+	// Reference for testPerformanceServeShow: a process per request, like a script calling the tool.
+	// > The tool is built next to the tests bundle, when its target was built too.
+	NSString *toolPath = [[NSBundle bundleForClass:self.class].bundlePath.stringByDeletingLastPathComponent stringByAppendingPathComponent:@"vm-config"];
+	
+	XCTSkipUnless([[NSFileManager defaultManager] isExecutableFileAtPath:toolPath], @"vm-config tool not built");
+	
+	// Generate test vm.
+	NSString *vmPath = [self generateVMwareVMWithResultingVMXFilePath:nil resultingNVRAMFilePath:nil];
+	
+	// Measure.
+	char * const				*argv = (char * const []){ "vm-config", "show", (char *)vmPath.fileSystemRepresentation, "--all", NULL };
+	posix_spawn_file_actions_t	actions;
+	
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+	posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+	
+	[self measureBlock:^{
+		for (unsigned i = 0; i < 100; i++)
+		{
+			pid_t	pid = 0;
+			int		status = -1;
+			
+			XCTAssertEqual(posix_spawn(&pid, toolPath.fileSystemRepresentation, &actions, NULL, argv, NULL), 0);
+			XCTAssertEqual(waitpid(pid, &status, 0), pid);
+			XCTAssertTrue(WIFEXITED(status) && WEXITSTATUS(status) == SMMainExitSuccess);
+		}
+	}];
+	
+	posix_spawn_file_actions_destroy(&actions);
+}
+
+
 #pragma mark - Helpers
 
+- (SMMainTestServeContext *)startServe
+{
+	SMMainTestServeContext *context = calloc(1, sizeof(SMMainTestServeContext));
+	
+	XCTAssertNotEqual(context, NULL);
+	
+	// Start the serve verb.
+	// > Short path: socket paths are limited to about a hundred bytes.
+	snprintf(context->socket_path, sizeof(context->socket_path), "/tmp/vm-config-ut-%s.sock", [[NSUUID UUID].UUIDString substringToIndex:8].UTF8String);
+	
+	XCTAssertEqual(pthread_create(&context->thread, NULL, SMMainTestServeMain, context), 0);
+	
+	// Connect, once the server listens.
+	for (unsigned i = 0; i < 500 && !context->client; i++)
+	{
+		context->client = SMServerClientConnect(context->socket_path, NULL);
+		
+		if (!context->client)
+			usleep(10 * 1000);
+	}
+	
+	XCTAssertNotEqual(context->client, NULL);
+	
+	// Wait for a first answer: the server is then running, with its signal handlers installed.
+	const char **argv = (const char *[]){ "version" };
+	
+	[self runClient:context->client argc:1 argv:argv exitCode:SMMainExitSuccess errorOutput:nil];
+	
+	return context;
+}
+
+- (void)stopServe:(SMMainTestServeContext *)context
+{
+	// > Interrupt the server like a user would: its signal handler stops it, and the verb returns.
+	SMServerClientFree(context->client);
+	
+	XCTAssertEqual(pthread_kill(context->thread, SIGTERM), 0);
+	XCTAssertEqual(pthread_join(context->thread, NULL), 0);
+	XCTAssertEqual(context->exit_code, SMMainExitSuccess);
+	
+	XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:@(context->socket_path)]);
+	
+	free(context);
+}
+
+- (NSString *)runClient:(SMServerClient *)client argc:(int)argc argv:(const char **)argv exitCode:(int)expectedExitCode errorOutput:(NSString **)errorOutput
+{
+	SMError	*error = NULL;
+	int		exit_code = -1;
+	char	*out_bytes = NULL, *err_bytes = NULL;
+	size_t	out_size = 0, err_size = 0;
+	
+	_onExit {
+		SMErrorFree(error);
+		free(out_bytes);
+		free(err_bytes);
+	};
+	
+	XCTAssertTrue(SMServerClientRun(client, argc, argv, &exit_code, &out_bytes, &out_size, &err_bytes, &err_size, &error), @"request failed: %s", SMErrorGetUserInfo(error));
+	XCTAssertEqual(exit_code, expectedExitCode);
+	
+	if (errorOutput)
+		*errorOutput = [[NSString alloc] initWithBytes:err_bytes length:err_size encoding:NSUTF8StringEncoding];
+	else
+		XCTAssertEqual(err_size, 0);
+	
+	return [[NSString alloc] initWithBytes:out_bytes length:out_size encoding:NSUTF8StringEncoding];
+}
+
 - (NSString *)generateVMwareVMWithResultingVMXFilePath:(NSString **)vmxFilePath resultingNVRAMFilePath:(NSString **)nvramFilePath
 {
 	SMVMwareVMX		**pvmx = NULL;
@@ -737,3 +1375,44 @@ typedef struct
 }
 
 @end
+
+
+/*
+** C Helpers
+*/
+#pragma mark - C Helpers
+
+static int SMMainTestServeRequest(const char *working_directory, int argc, const char *argv[], FILE *fout, FILE *ferr, void *context)
+{
+	// > Requests don't contain the program name.
+	const char **main_argv = malloc(((size_t)argc + 1) * sizeof(char *));
+	
+	main_argv[0] = "ut-main";
+	memcpy(main_argv + 1, argv, (size_t)argc * sizeof(char *));
+	
+	int result = internal_main(argc + 1, main_argv, fout, ferr);
+	
+	free(main_argv);
+	
+	return result;
+}
+
+static void * SMMainTestServe(void *server)
+{
+	SMServerRun(server);
+	
+	return NULL;
+}
+
+static void * SMMainTestServeMain(void *context)
+{
+	SMMainTestServeContext	*serve = context;
+	const char				*argv[] = { "ut-main", "serve", serve->socket_path, "--cache-size", "8" };
+	FILE					*output = fopen("/dev/null", "w");
+	
+	serve->exit_code = internal_main(sizeof(argv) / sizeof(*argv), argv, output, output);
+	
+	fclose(output);
+	
+	return NULL;
+}
@@ -0,0 +1,206 @@
+/*
+ *  SMBundleFinderTests.m
+ *
+ *  Copyright 2022 Avérous Julien-Pierre
+ *
+ *  This file is part of vm-config.
+ *
+ *  vm-config is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vm-config is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vm-config.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <pthread.h>
+
+#import "SMBundleFinder.h"
+
+#import "SMTestsTools.h"
+#import "SMTestCase.h"
+
+
+/*
+** Types
+*/
+#pragma mark - Types
+
+typedef struct
+{
+	pthread_mutex_t		mutex;
+	CFMutableArrayRef	paths;
+} SMBundleFinderTestResult;
+
+
+/*
+** Prototypes
+*/
+#pragma mark - Prototypes
+
+static void SMBundleFinderTestFound(SMThreadPool *pool, char *bundle_path, void *context);
+
+
+/*
+** SMBundleFinderTests
+*/
+#pragma mark - SMBundleFinderTests
+
+@interface SMBundleFinderTests : SMTestCase
+{
+	NSString *_testDirectory;
+}
+
+@end
+
+@implementation SMBundleFinderTests
+
+#pragma mark - Setup
+
+- (void)setUp
+{
+	[super setUp];
+
+	NSString *tempDirectory = [NSString stringWithFormat:@"%@-vm-config-ut", [NSUUID UUID].UUIDString];
+
+	_testDirectory = [NSTemporaryDirectory() stringByAppendingPathComponent:tempDirectory];
+
+	NSAssert([[NSFileManager defaultManager] createDirectoryAtPath:_testDirectory withIntermediateDirectories:YES attributes:nil error:nil], @"cannot create temp directory");
+}
+
+- (void)tearDown
+{
+	[super tearDown];
+
+	[[NSFileManager defaultManager] removeItemAtPath:_testDirectory error:nil];
+}
+
+
+#pragma mark - Tests
+
+- (void)testWalk
+{
+	// Forge tree.
+	[self createDirectories:@[ @"a/vm1.vmwarevm", @"a/b/c/vm2.vmwarevm", @"d/vm3.vmwarevm/nested.vmwarevm", @"e", @"f/not-a-bundle.vmx" ]];
+
+	XCTAssertTrue([@"" writeToFile:[_testDirectory stringByAppendingPathComponent:@"e/file.vmwarevm"] atomically:NO encoding:NSUTF8StringEncoding error:nil]);
+	XCTAssertTrue([[NSFileManager defaultManager] createSymbolicLinkAtPath:[_testDirectory stringByAppendingPathComponent:@"e/link"] withDestinationPath:_testDirectory error:nil]);
+
+	// Walk.
+	NSArray *paths = [self walkPath:_testDirectory jobs:4];
+
+	NSArray *expected = @[
+		[_testDirectory stringByAppendingPathComponent:@"a/b/c/vm2.vmwarevm"],
+		[_testDirectory stringByAppendingPathComponent:@"a/vm1.vmwarevm"],
+		[_testDirectory stringByAppendingPathComponent:@"d/vm3.vmwarevm"],
+	];
+
+	XCTAssertEqualObjects(paths, expected);
+}
+
+- (void)testWalkBundleRoot
+{
+	[self createDirectories:@[ @"vm1.vmwarevm" ]];
+
+	NSString	*root = [_testDirectory stringByAppendingPathComponent:@"vm1.vmwarevm"];
+	NSArray		*paths = [self walkPath:root jobs:1];
+
+	XCTAssertEqualObjects(paths, @[ root ]);
+}
+
+- (void)testWalkError
+{
+	SMThreadPool	*pool = SMThreadPoolCreate(1);
+	SMError			*error = NULL;
+	NSString		*path = [_testDirectory stringByAppendingPathComponent:@"missing"];
+
+	XCTAssertFalse(SMBundleFinderWalk(pool, path.fileSystemRepresentation, "vmwarevm", SMBundleFinderTestFound, NULL, &error));
+	XCTAssertNotEqual(error, NULL);
+
+	SMErrorFree(error);
+	SMThreadPoolFree(pool);
+}
+
+- (void)testPerformanceWalk
+{
+	// 100 directories of 20 bundles each.
+	NSMutableArray *directories = [NSMutableArray array];
+
+	for (unsigned i = 0; i < 100; i++)
+	{
+		for (unsigned j = 0; j < 20; j++)
+			[directories addObject:[NSString stringWithFormat:@"ds%u/group/vm%u.vmwarevm", i, j]];
+	}
+
+	[self createDirectories:directories];
+
+	// Walk.
+	[self measureBlock:^{
+		XCTAssertEqual([self walkPath:self->_testDirectory jobs:0].count, 2000);
+	}];
+}
+
+
+#pragma mark - Helpers
+
+- (void)createDirectories:(NSArray *)directories
+{
+	for (NSString *directory in directories)
+	{
+		NSString *path = [_testDirectory stringByAppendingPathComponent:directory];
+
+		NSAssert([[NSFileManager defaultManager] createDirectoryAtPath:path withIntermediateDirectories:YES attributes:nil error:nil], @"cannot create test directory");
+	}
+}
+
+- (NSArray *)walkPath:(NSString *)path jobs:(size_t)jobs
+{
+	SMThreadPool				*pool = SMThreadPoolCreate(jobs);
+	SMError						*error = NULL;
+	SMBundleFinderTestResult	result = { .paths = CFArrayCreateMutable(NULL, 0, &kCFTypeArrayCallBacks) };
+
+	pthread_mutex_init(&result.mutex, NULL);
+
+	XCTAssertTrue(SMBundleFinderWalk(pool, path.fileSystemRepresentation, "vmwarevm", SMBundleFinderTestFound, &result, &error));
+
+	NSArray *paths = [(__bridge_transfer NSArray *)result.paths sortedArrayUsingSelector:@selector(compare:)];
+
+	pthread_mutex_destroy(&result.mutex);
+	SMErrorFree(error);
+	SMThreadPoolFree(pool);
+
+	return paths;
+}
+
+@end
+
+
+/*
+** C Helpers
+*/
+#pragma mark - C Helpers
+
+static void SMBundleFinderTestFound(SMThreadPool *pool, char *bundle_path, void *context)
+{
+	SMBundleFinderTestResult	*result = context;
+	CFStringRef					path = CFStringCreateWithCString(NULL, bundle_path, kCFStringEncodingUTF8);
+
+	if (result)
+	{
+		pthread_mutex_lock(&result->mutex);
+		CFArrayAppendValue(result->paths, path);
+		pthread_mutex_unlock(&result->mutex);
+	}
+
+	CFRelease(path);
+	free(bundle_path);
+}
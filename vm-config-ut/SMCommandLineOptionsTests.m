@@ -175,6 +175,13 @@ typedef struct
 	XCTAssertContainString(*bout, sout, "v4-value1");
 	XCTAssertContainString(*bout, sout, "#token-v5-option1");
 	XCTAssertContainString(*bout, sout, "#token-v5-option2");
+
+	// > Verb-7.
+	XCTAssertContainString(*bout, sout, "verb7");
+	XCTAssertContainString(*bout, sout, "#token-verb7");
+
+	XCTAssertContainString(*bout, sout, "[v7-values...]");
+	XCTAssertContainString(*bout, sout, "#token-v7-values");
 }
 
 - (void)testErrorInvalidArgumentsArray
@@ -873,6 +880,154 @@ typedef struct
 	SMCLOptionsResultFree(result);
 }
 
+- (void)testParse11
+{
+	// Get standard options.
+	SMCLOptions *options = [self standardOptions];
+
+	_onExit {
+		SMCLOptionsFree(options);
+	};
+
+	// Parse.
+	const char *argv[] = {
+		"ut-main",
+		"verb4",
+		"-",
+	};
+	
+	SMError				*error = NULL;
+	SMCLOptionsResult	*result = SMCLOptionsParse(options, sizeof(argv) / sizeof(*argv), argv, &error);
+
+	// Test result.
+	XCTAssertSuccess(result, error);
+	
+	// Validate result.
+	SMCLParsedParameterTest expectedResult[] = {
+		{ .verb_identifier = 4, .identifier = 11, .value_type = SMCLValueTypeString, .value.str = "-" },
+	};
+	
+	[self validateResult:result testParameters:expectedResult count:sizeof(expectedResult) / sizeof(*expectedResult)];
+	
+	// Clean.
+	SMErrorFree(error);
+	SMCLOptionsResultFree(result);
+}
+
+- (void)testParseVariadic1
+{
+	// Get standard options.
+	SMCLOptions *options = [self standardOptions];
+
+	_onExit {
+		SMCLOptionsFree(options);
+	};
+
+	// Parse.
+	const char *argv[] = {
+		"ut-main",
+		"verb7",
+		"value-1",
+		"value-2",
+		"--v7-option", "opt",
+		"value-3",
+	};
+	
+	SMError				*error = NULL;
+	SMCLOptionsResult	*result = SMCLOptionsParse(options, sizeof(argv) / sizeof(*argv), argv, &error);
+
+	// Test result.
+	XCTAssertSuccess(result, error);
+	
+	// Validate result.
+	SMCLParsedParameterTest expectedResult[] = {
+		{ .verb_identifier = 7, .identifier = 19, .value_type = SMCLValueTypeString, .value.str = "value-1" },
+		{ .verb_identifier = 7, .identifier = 19, .value_type = SMCLValueTypeString, .value.str = "value-2" },
+		{ .verb_identifier = 7, .identifier = 20, .value_type = SMCLValueTypeString, .value.str = "opt" },
+		{ .verb_identifier = 7, .identifier = 19, .value_type = SMCLValueTypeString, .value.str = "value-3" },
+	};
+	
+	[self validateResult:result testParameters:expectedResult count:sizeof(expectedResult) / sizeof(*expectedResult)];
+	
+	// Clean.
+	SMErrorFree(error);
+	SMCLOptionsResultFree(result);
+}
+
+- (void)testParseVariadic2
+{
+	// Get standard options.
+	SMCLOptions *options = [self standardOptions];
+
+	_onExit {
+		SMCLOptionsFree(options);
+	};
+
+	// Parse.
+	const char *argv[] = {
+		"ut-main",
+		"verb7",
+		"--v7-option", "opt",
+	};
+	
+	SMError				*error = NULL;
+	SMCLOptionsResult	*result = SMCLOptionsParse(options, sizeof(argv) / sizeof(*argv), argv, &error);
+
+	// Test result.
+	XCTAssertSuccess(result, error);
+	
+	// Validate result.
+	SMCLParsedParameterTest expectedResult[] = {
+		{ .verb_identifier = 7, .identifier = 20, .value_type = SMCLValueTypeString, .value.str = "opt" },
+	};
+	
+	[self validateResult:result testParameters:expectedResult count:sizeof(expectedResult) / sizeof(*expectedResult)];
+	
+	// Clean.
+	SMErrorFree(error);
+	SMCLOptionsResultFree(result);
+}
+
+- (void)testParseEndOfOptions
+{
+	// Get standard options.
+	SMCLOptions *options = [self standardOptions];
+
+	_onExit {
+		SMCLOptionsFree(options);
+	};
+
+	// Parse.
+	const char *argv[] = {
+		"ut-main",
+		"verb7",
+		"--v7-option", "opt",
+		"--",
+		"value1", "--v7-option", "-v", "--",
+	};
+	
+	SMError				*error = NULL;
+	SMCLOptionsResult	*result = SMCLOptionsParse(options, sizeof(argv) / sizeof(*argv), argv, &error);
+
+	// Test result.
+	XCTAssertSuccess(result, error);
+	
+	// Validate result.
+	SMCLParsedParameterTest expectedResult[] = {
+		{ .verb_identifier = 7, .identifier = 20, .value_type = SMCLValueTypeString, .value.str = "opt" },
+		{ .verb_identifier = 7, .identifier = 19, .value_type = SMCLValueTypeString, .value.str = "value1" },
+		{ .verb_identifier = 7, .identifier = 19, .value_type = SMCLValueTypeString, .value.str = "--v7-option" },
+		{ .verb_identifier = 7, .identifier = 19, .value_type = SMCLValueTypeString, .value.str = "-v" },
+		{ .verb_identifier = 7, .identifier = 19, .value_type = SMCLValueTypeString, .value.str = "--" },
+	};
+	
+	[self validateResult:result testParameters:expectedResult count:sizeof(expectedResult) / sizeof(*expectedResult)];
+	
+	// Clean.
+	SMErrorFree(error);
+	SMCLOptionsResultFree(result);
+}
+
 - (void)testParseTypes1
 {
 	// Get standard options.
@@ -1547,6 +1702,12 @@ typedef struct
 	SMCLOptionsVerbAddOptionWithArgument(verb6, 17, true,	"v6-uint64",	0,	SMCLValueTypeUInt64,	NULL,	"UInt64 option");
 	SMCLOptionsVerbAddOptionWithArgument(verb6, 18, true,	"v6-int64",		0,	SMCLValueTypeInt64,		NULL,	"Int64 option");
 
+	// > Verb-7.
+	SMCLOptionsVerb *verb7 = SMCLOptionsAddVerb(options, 7, "verb7", "This is verb7 #token-verb7");
+
+	SMCLOptionsVerbAddVariadicValue(verb7,		19, true,	"v7-values",																	"Variadic value #token-v7-values");
+	SMCLOptionsVerbAddOptionWithArgument(verb7, 20, true,	"v7-option",	0,	SMCLValueTypeString,	NULL,	"Option 1 #token-v7-option1");
+
 	return options;
 }
 
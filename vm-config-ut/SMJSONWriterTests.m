@@ -0,0 +1,259 @@
+/*
+ *  SMJSONWriterTests.m
+ *
+ *  Copyright 2022 Avérous Julien-Pierre
+ *
+ *  This file is part of vm-config.
+ *
+ *  vm-config is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vm-config is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vm-config.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#import <XCTest/XCTest.h>
+
+#import "SMJSONWriter.h"
+
+#import "SMTestsTools.h"
+#import "SMTestCase.h"
+
+
+/*
+** SMJSONWriterTests
+*/
+#pragma mark - SMJSONWriterTests
+
+@interface SMJSONWriterTests : SMTestCase
+
+@end
+
+@implementation SMJSONWriterTests
+
+#pragma mark - Tests
+
+- (void)testEscaping
+{
+	SMJSONWriter *writer = SMJSONWriterCreate(NULL);
+
+	_onExit {
+		SMJSONWriterFree(writer);
+	};
+
+	// Escaped characters.
+	SMJSONWriterString(writer, "a\"b\\c\n\t\x01\x1f/é");
+
+	[self checkWriter:writer output:"\"a\\\"b\\\\c\\n\\t\\u0001\\u001f/é\""];
+
+	// Bytes, with embedded zero.
+	SMJSONWriterStringBytes(writer, "a\0b", 3);
+
+	[self checkWriter:writer output:"\"a\\u0000b\""];
+
+	// Hexadecimal.
+	uint8_t bytes[] = { 0x00, 0xab, 0xff };
+
+	SMJSONWriterHexString(writer, bytes, sizeof(bytes));
+
+	[self checkWriter:writer output:"\"00abff\""];
+}
+
+- (void)testInvalidUTF8
+{
+	SMJSONWriter *writer = SMJSONWriterCreate(NULL);
+
+	_onExit {
+		SMJSONWriterFree(writer);
+	};
+
+	// Valid sequences (2, 3 & 4 bytes, and bounds).
+	SMJSONWriterString(writer, "\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80 \xc2\x80 \xed\x9f\xbf \xee\x80\x80 \xf4\x8f\xbf\xbf");
+
+	[self checkWriter:writer output:"\"\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80 \xc2\x80 \xed\x9f\xbf \xee\x80\x80 \xf4\x8f\xbf\xbf\""];
+
+	// Invalid sequences: each invalid byte is replaced.
+	struct {
+		const char *bytes;
+		const char *output;
+	} invalids[] = {
+		{ "a\xff" "b",			"\"a\xef\xbf\xbd" "b\"" },									// Invalid byte.
+		{ "a\x80",				"\"a\xef\xbf\xbd\"" },									// Lone continuation byte.
+		{ "a\xc3",				"\"a\xef\xbf\xbd\"" },									// Truncated sequence.
+		{ "\xe2\x82" "a",		"\"\xef\xbf\xbd\xef\xbf\xbd" "a\"" },						// Truncated sequence, followed by ASCII.
+		{ "\xc0\xaf",			"\"\xef\xbf\xbd\xef\xbf\xbd\"" },						// Overlong.
+		{ "\xe0\x80\xaf",		"\"\xef\xbf\xbd\xef\xbf\xbd\xef\xbf\xbd\"" },			// Overlong.
+		{ "\xed\xa0\x80",		"\"\xef\xbf\xbd\xef\xbf\xbd\xef\xbf\xbd\"" },			// Surrogate.
+		{ "\xf4\x90\x80\x80",	"\"\xef\xbf\xbd\xef\xbf\xbd\xef\xbf\xbd\xef\xbf\xbd\"" },	// Out of range.
+		{ "\xff\"\xc3\xa9\n",	"\"\xef\xbf\xbd\\\"\xc3\xa9\\n\"" },						// Mixed with escapes.
+	};
+
+	for (size_t i = 0; i < sizeof(invalids) / sizeof(*invalids); i++)
+	{
+		SMJSONWriterString(writer, invalids[i].bytes);
+
+		[self checkWriter:writer output:invalids[i].output];
+	}
+
+	// Keys too.
+	SMJSONWriterBeginObject(writer);
+	SMJSONWriterKey(writer, "k\xfe");
+	SMJSONWriterNull(writer);
+	SMJSONWriterEndObject(writer);
+
+	[self checkWriter:writer output:"{\"k\xef\xbf\xbd\":null}"];
+}
+
+- (void)testNesting
+{
+	SMJSONWriter *writer = SMJSONWriterCreate(NULL);
+
+	_onExit {
+		SMJSONWriterFree(writer);
+	};
+
+	// Commas.
+	SMJSONWriterBeginObject(writer);
+	SMJSONWriterKey(writer, "a");
+	SMJSONWriterBeginArray(writer);
+	SMJSONWriterUInt(writer, 0);
+	SMJSONWriterUInt(writer, UINT64_MAX);
+	SMJSONWriterBool(writer, true);
+	SMJSONWriterNull(writer);
+	SMJSONWriterBeginObject(writer);
+	SMJSONWriterEndObject(writer);
+	SMJSONWriterEndArray(writer);
+	SMJSONWriterKey(writer, "b");
+	SMJSONWriterBool(writer, false);
+	SMJSONWriterEndObject(writer);
+
+	[self checkWriter:writer output:"{\"a\":[0,18446744073709551615,true,null,{}],\"b\":false}"];
+
+	// Records.
+	SMJSONWriterBeginArray(writer);
+	SMJSONWriterEndArray(writer);
+	SMJSONWriterNewline(writer);
+	SMJSONWriterString(writer, "b");
+	SMJSONWriterNewline(writer);
+
+	[self checkWriter:writer output:"[]\n\"b\"\n"];
+}
+
+- (void)testEndToDepth
+{
+	SMJSONWriter *writer = SMJSONWriterCreate(NULL);
+
+	_onExit {
+		SMJSONWriterFree(writer);
+	};
+
+	// Interrupt in the middle of a record.
+	SMJSONWriterBeginObject(writer);
+	SMJSONWriterKey(writer, "a");
+	SMJSONWriterBeginArray(writer);
+	SMJSONWriterBeginObject(writer);
+	SMJSONWriterKey(writer, "k");
+
+	XCTAssertEqual(SMJSONWriterDepth(writer), 3);
+
+	SMJSONWriterEndToDepth(writer, 1);
+
+	XCTAssertEqual(SMJSONWriterDepth(writer), 1);
+
+	SMJSONWriterKey(writer, "error");
+	SMJSONWriterString(writer, "failed");
+	SMJSONWriterEndObject(writer);
+
+	[self checkWriter:writer output:"{\"a\":[{\"k\":null}],\"error\":\"failed\"}"];
+}
+
+- (void)testStreaming
+{
+	char	*bytes = NULL;
+	size_t	size = 0;
+	FILE	*output = open_memstream(&bytes, &size);
+
+	_onExit {
+		free(bytes);
+	};
+
+	// Write more than the buffer size.
+	SMJSONWriter	*writer = SMJSONWriterCreate(output);
+	NSMutableData	*ref = [NSMutableData data];
+	char			str[1000];
+
+	memset(str, 'a', sizeof(str) - 1);
+	str[sizeof(str) - 1] = 0;
+
+	SMJSONWriterBeginArray(writer);
+	[ref appendBytes:"[" length:1];
+
+	for (unsigned i = 0; i < 3 * SMJSONWriterFlushSize / sizeof(str); i++)
+	{
+		SMJSONWriterString(writer, str);
+
+		[ref appendBytes:(i == 0 ? "\"" : ",\"") length:(i == 0 ? 1 : 2)];
+		[ref appendBytes:str length:strlen(str)];
+		[ref appendBytes:"\"" length:1];
+	}
+
+	SMJSONWriterEndArray(writer);
+	[ref appendBytes:"]" length:1];
+
+	XCTAssertTrue(SMJSONWriterFlush(writer));
+
+	SMJSONWriterFree(writer);
+	fclose(output);
+
+	// Check.
+	XCTAssertEqual(size, ref.length);
+	XCTAssertEqual(memcmp(bytes, ref.bytes, ref.length), 0);
+}
+
+- (void)testPerformanceEscaping
+{
+	SMJSONWriter	*writer = SMJSONWriterCreate(NULL);
+	NSMutableData	*data = [NSMutableData dataWithLength:1024 * 1024];
+	uint8_t			*bytes = data.mutableBytes;
+
+	_onExit {
+		SMJSONWriterFree(writer);
+	};
+
+	// > Mostly plain text, with a character to escape from time to time.
+	for (size_t i = 0; i < data.length; i++)
+		bytes[i] = (i % 64 == 0 ? '"' : 'a' + (i % 26));
+
+	[self measureBlock:^{
+		for (unsigned i = 0; i < 20; i++)
+		{
+			SMJSONWriterStringBytes(writer, data.bytes, data.length);
+			SMJSONWriterHexString(writer, data.bytes, data.length);
+			SMJSONWriterReset(writer);
+		}
+	}];
+}
+
+
+#pragma mark - Helpers
+
+- (void)checkWriter:(SMJSONWriter *)writer output:(const char *)expectedOutput
+{
+	size_t		size = 0;
+	const char	*bytes = SMJSONWriterGetBytes(writer, &size);
+
+	XCTAssertEqual(size, strlen(expectedOutput));
+	XCTAssertEqual(memcmp(bytes, expectedOutput, MIN(size, strlen(expectedOutput))), 0, "'%.*s' != '%s'", (int)size, bytes, expectedOutput);
+
+	SMJSONWriterReset(writer);
+}
+
+@end
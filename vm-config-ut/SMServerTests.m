@@ -0,0 +1,233 @@
+/*
+ *  SMServerTests.m
+ *
+ *  Copyright 2022 Avérous Julien-Pierre
+ *
+ *  This file is part of vm-config.
+ *
+ *  vm-config is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vm-config is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vm-config.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <pthread.h>
+
+#import "SMServer.h"
+
+#import "SMTestsTools.h"
+#import "SMTestCase.h"
+
+
+/*
+** Prototypes
+*/
+#pragma mark - Prototypes
+
+static int		SMServerTestEcho(const char *working_directory, int argc, const char *argv[], FILE *fout, FILE *ferr, void *context);
+static void *	SMServerTestRun(void *server);
+
+
+/*
+** SMServerTests
+*/
+#pragma mark - SMServerTests
+
+@interface SMServerTests : SMTestCase
+{
+	NSString	*_socketPath;
+	SMServer	*_server;
+	pthread_t	_thread;
+}
+
+@end
+
+@implementation SMServerTests
+
+#pragma mark - Setup
+
+- (void)setUp
+{
+	[super setUp];
+
+	// > Short path: socket paths are limited to about a hundred bytes.
+	_socketPath = [NSString stringWithFormat:@"/tmp/vm-config-ut-%@.sock", [[NSUUID UUID].UUIDString substringToIndex:8]];
+
+	SMError *error = NULL;
+
+	_server = SMServerCreate(_socketPath.fileSystemRepresentation, SMServerTestEcho, NULL, &error);
+
+	NSAssert(_server, @"cannot create server: %s", SMErrorGetUserInfo(error));
+	NSAssert(pthread_create(&_thread, NULL, SMServerTestRun, _server) == 0, @"cannot create server thread");
+}
+
+- (void)tearDown
+{
+	SMServerStop(_server);
+	pthread_join(_thread, NULL);
+	SMServerFree(_server);
+
+	[super tearDown];
+}
+
+
+#pragma mark - Tests
+
+- (void)testRoundTrip
+{
+	SMError			*error = NULL;
+	SMServerClient	*client = SMServerClientConnect(_socketPath.fileSystemRepresentation, &error);
+
+	XCTAssertNotEqual(client, NULL);
+
+	_onExit {
+		SMServerClientFree(client);
+	};
+
+	// Send requests on the same connection.
+	const char *argv1[] = { "show", "path/to/vm.vmwarevm", "--all" };
+	const char *argv2[] = { "" };
+
+	[self runClient:client argc:3 argv:argv1 exitCode:3 output:"show|path/to/vm.vmwarevm|--all|" errorOutput:"argc=3\n"];
+	[self runClient:client argc:1 argv:argv2 exitCode:1 output:"|" errorOutput:"argc=1\n"];
+
+	// Send request on another connection.
+	SMServerClient *client2 = SMServerClientConnect(_socketPath.fileSystemRepresentation, &error);
+
+	XCTAssertNotEqual(client2, NULL);
+
+	[self runClient:client2 argc:3 argv:argv1 exitCode:3 output:"show|path/to/vm.vmwarevm|--all|" errorOutput:"argc=3\n"];
+
+	SMServerClientFree(client2);
+
+	// Send invalid request.
+	int		exit_code = 0;
+	char	*out_bytes = NULL, *err_bytes = NULL;
+	size_t	out_size = 0, err_size = 0;
+
+	XCTAssertFalse(SMServerClientRun(client, 0, argv1, &exit_code, &out_bytes, &out_size, &err_bytes, &err_size, &error));
+	XCTAssertNotEqual(error, NULL);
+
+	SMErrorFree(error);
+}
+
+- (void)testWorkingDirectory
+{
+	SMServerClient	*client = SMServerClientConnect(_socketPath.fileSystemRepresentation, NULL);
+	const char		*argv[] = { "pwd" };
+	char			cwd[PATH_MAX];
+
+	XCTAssertNotEqual(client, NULL);
+	XCTAssertNotEqual(getcwd(cwd, sizeof(cwd)), NULL);
+
+	_onExit {
+		SMServerClientFree(client);
+	};
+
+	// Requests carry the client working directory.
+	[self runClient:client argc:1 argv:argv exitCode:0 output:cwd errorOutput:""];
+}
+
+- (void)testSocketInUse
+{
+	SMError *error = NULL;
+
+	// Running server.
+	XCTAssertEqual(SMServerCreate(_socketPath.fileSystemRepresentation, SMServerTestEcho, NULL, &error), NULL);
+	XCTAssertNotEqual(error, NULL);
+
+	SMErrorFree(error);
+	error = NULL;
+
+	// Not a socket.
+	NSString *filePath = SMGenerateTemporaryTestPath();
+
+	XCTAssertTrue([@"" writeToFile:filePath atomically:NO encoding:NSUTF8StringEncoding error:nil]);
+	XCTAssertEqual(SMServerCreate(filePath.fileSystemRepresentation, SMServerTestEcho, NULL, &error), NULL);
+	XCTAssertNotEqual(error, NULL);
+	XCTAssertTrue([[NSFileManager defaultManager] fileExistsAtPath:filePath]);
+
+	[[NSFileManager defaultManager] removeItemAtPath:filePath error:nil];
+	SMErrorFree(error);
+}
+
+- (void)testPerformanceRoundTrip
+{
+	SMServerClient	*client = SMServerClientConnect(_socketPath.fileSystemRepresentation, NULL);
+	const char		**argv = (const char *[]){ "show", "path/to/vm.vmwarevm", "--all" };
+
+	XCTAssertNotEqual(client, NULL);
+
+	_onExit {
+		SMServerClientFree(client);
+	};
+
+	[self measureBlock:^{
+		for (unsigned i = 0; i < 1000; i++)
+			[self runClient:client argc:3 argv:argv exitCode:3 output:"show|path/to/vm.vmwarevm|--all|" errorOutput:"argc=3\n"];
+	}];
+}
+
+
+#pragma mark - Helpers
+
+- (void)runClient:(SMServerClient *)client argc:(int)argc argv:(const char **)argv exitCode:(int)expectedExitCode output:(const char *)expectedOutput errorOutput:(const char *)expectedErrorOutput
+{
+	SMError	*error = NULL;
+	int		exit_code = -1;
+	char	*out_bytes = NULL, *err_bytes = NULL;
+	size_t	out_size = 0, err_size = 0;
+
+	XCTAssertTrue(SMServerClientRun(client, argc, argv, &exit_code, &out_bytes, &out_size, &err_bytes, &err_size, &error), @"request failed: %s", SMErrorGetUserInfo(error));
+
+	XCTAssertEqual(exit_code, expectedExitCode);
+	XCTAssertEqual(out_size, strlen(expectedOutput));
+	XCTAssertEqualFreeableStrings(out_bytes, expectedOutput);
+	XCTAssertEqual(err_size, strlen(expectedErrorOutput));
+	XCTAssertEqualFreeableStrings(err_bytes, expectedErrorOutput);
+
+	SMErrorFree(error);
+}
+
+@end
+
+
+/*
+** C Helpers
+*/
+#pragma mark - C Helpers
+
+static int SMServerTestEcho(const char *working_directory, int argc, const char *argv[], FILE *fout, FILE *ferr, void *context)
+{
+	// > Working directory, when asked.
+	if (argc == 1 && strcmp(argv[0], "pwd") == 0)
+	{
+		fprintf(fout, "%s", working_directory ?: "");
+		return 0;
+	}
+
+	for (int i = 0; i < argc; i++)
+		fprintf(fout, "%s|", argv[i]);
+
+	fprintf(ferr, "argc=%d\n", argc);
+
+	return argc;
+}
+
+static void * SMServerTestRun(void *server)
+{
+	SMServerRun(server);
+
+	return NULL;
+}
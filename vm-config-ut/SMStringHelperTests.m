@@ -95,6 +95,36 @@
 	XCTAssertEqualFreeableStrings(SMStringReplaceString("hello world", "toto", "tutu", false), "hello world");
 }
 
+- (void)testStringSplitArguments
+{
+	size_t	count = 0;
+	char	**args;
+	
+	// Blanks.
+	args = SMStringSplitArguments(" \t ", &count);
+	
+	XCTAssertEqual(count, 0);
+	XCTAssertEqual(args[0], NULL);
+	
+	free(args);
+	
+	// Quotes & escapes.
+	args = SMStringSplitArguments("  /vms/my\\ vm.vmwarevm\t--boot-args 'debug=0x144 -v' \"a \\\"b\\\" c\"d '' ", &count);
+	
+	XCTAssertEqual(count, 5);
+	XCTAssertEqualStrings(args[0], "/vms/my vm.vmwarevm");
+	XCTAssertEqualStrings(args[1], "--boot-args");
+	XCTAssertEqualStrings(args[2], "debug=0x144 -v");
+	XCTAssertEqualStrings(args[3], "a \"b\" cd");
+	XCTAssertEqualStrings(args[4], "");
+	XCTAssertEqual(args[5], NULL);
+	
+	free(args);
+	
+	// Unterminated quote.
+	XCTAssertEqual(SMStringSplitArguments("a 'b c", &count), NULL);
+}
+
 - (void)testPathAppendComponent
 {
 	XCTAssertEqualFreeableStrings(SMStringPathAppendComponent("", "hello"), "/hello");
@@ -125,4 +155,188 @@
 	XCTAssertFalse(SMStringPathHasExtension("toto", "txt"));
 }
 
+- (void)testUTF16LEToUTF8
+{
+	// ASCII (long enough to go through vector paths), 2, 3 & 4 bytes sequences.
+	const char	*ref = "efi-apple-payload0-data-with-a-long-ascii-name \xc3\xa9t\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80";
+	uint8_t		utf16[] = {
+		'e', 0, 'f', 0, 'i', 0, '-', 0, 'a', 0, 'p', 0, 'p', 0, 'l', 0, 'e', 0, '-', 0, 'p', 0, 'a', 0, 'y', 0, 'l', 0, 'o', 0, 'a', 0,
+		'd', 0, '0', 0, '-', 0, 'd', 0, 'a', 0, 't', 0, 'a', 0, '-', 0, 'w', 0, 'i', 0, 't', 0, 'h', 0, '-', 0, 'a', 0, '-', 0, 'l', 0,
+		'o', 0, 'n', 0, 'g', 0, '-', 0, 'a', 0, 's', 0, 'c', 0, 'i', 0, 'i', 0, '-', 0, 'n', 0, 'a', 0, 'm', 0, 'e', 0, ' ', 0,
+		0xE9, 0x00, 't', 0, 0xE9, 0x00, ' ', 0, 0xAC, 0x20, ' ', 0, 0x3D, 0xD8, 0x00, 0xDE
+	};
+	size_t		len = SIZE_MAX;
+	char		*utf8 = SMStringUTF16LEToUTF8(utf16, sizeof(utf16), &len);
+	
+	XCTAssertEqual(len, strlen(ref));
+	XCTAssertEqualFreeableStrings(utf8, ref);
+	
+	// Embedded zero.
+	uint8_t zero[] = { 'a', 0, 0, 0, 'b', 0 };
+	
+	utf8 = SMStringUTF16LEToUTF8(zero, sizeof(zero), &len);
+	
+	XCTAssertEqual(len, 3);
+	XCTAssertEqual(memcmp(utf8, "a\0b", 4), 0);
+	
+	free(utf8);
+	
+	// Invalid.
+	uint8_t odd[] = { 'a', 0, 'b' };
+	uint8_t lone_high[] = { 'a', 0, 0x3D, 0xD8, 'b', 0 };
+	uint8_t lone_low[] = { 'a', 0, 0x00, 0xDE };
+	uint8_t truncated_pair[] = { 'a', 0, 0x3D, 0xD8 };
+	
+	XCTAssertEqual(SMStringUTF16LEToUTF8(odd, sizeof(odd), NULL), NULL);
+	XCTAssertEqual(SMStringUTF16LEToUTF8(lone_high, sizeof(lone_high), NULL), NULL);
+	XCTAssertEqual(SMStringUTF16LEToUTF8(lone_low, sizeof(lone_low), NULL), NULL);
+	XCTAssertEqual(SMStringUTF16LEToUTF8(truncated_pair, sizeof(truncated_pair), NULL), NULL);
+}
+
+- (void)testUTF8ToUTF16LE
+{
+	// Round trip.
+	const char	*ref = "boot-args with a long enough ascii prefix \xc3\xa9t\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80 and an ascii suffix";
+	size_t		size = SIZE_MAX;
+	void		*utf16 = SMStringUTF8ToUTF16LE(ref, strlen(ref), true, &size);
+	
+	_onExit {
+		free(utf16);
+	};
+	
+	XCTAssertNotEqual(utf16, NULL);
+	XCTAssertEqual(((uint8_t *)utf16)[size - 1], 0);
+	XCTAssertEqual(((uint8_t *)utf16)[size - 2], 0);
+	
+	XCTAssertEqualFreeableStrings(SMStringUTF16LEToUTF8(utf16, size - 2, NULL), ref);
+	
+	// Invalid.
+	const char *invalids[] = {
+		"\x80",				// Lone continuation byte.
+		"a\xc3",				// Truncated sequence.
+		"\xc0\xaf",			// Overlong.
+		"\xe0\x80\xaf",		// Overlong.
+		"\xed\xa0\x80",		// Surrogate.
+		"\xf4\x90\x80\x80",	// Out of range.
+		"\xff",				// Invalid byte.
+	};
+	
+	for (size_t i = 0; i < sizeof(invalids) / sizeof(*invalids); i++)
+		XCTAssertEqual(SMStringUTF8ToUTF16LE(invalids[i], strlen(invalids[i]), false, NULL), NULL, "invalid sequence %zu was converted", i);
+}
+
+- (void)testUTF16ConversionsIconvConsistency
+{
+	srandom(42);
+	
+	for (unsigned i = 0; i < 20000; i++)
+	{
+		// Random UTF-16 (biased toward ASCII & surrogates).
+		uint8_t	bytes[64];
+		size_t	size = (size_t)(random() % (sizeof(bytes) + 1));
+		
+		for (size_t j = 0; j < size; j++)
+		{
+			long kind = random() % 6;
+			
+			bytes[j] = (kind < 3 ? random() % 0x80 : (kind == 3 ? 0xD8 + random() % 8 : random() % 0x100));
+		}
+		
+		size_t	native_len = 0, iconv_len = 0;
+		char	*native = SMStringUTF16LEToUTF8(bytes, size, &native_len);
+		char	*iconv_result = SMStringUTF16LEToUTF8Iconv(bytes, size, &iconv_len);
+		
+		XCTAssertEqual(native == NULL, iconv_result == NULL);
+		
+		if (native && iconv_result)
+		{
+			XCTAssertEqual(native_len, iconv_len);
+			XCTAssertEqual(memcmp(native, iconv_result, native_len), 0);
+		}
+		
+		free(native);
+		free(iconv_result);
+		
+		// Random UTF-8 (biased toward ASCII & sequences bytes).
+		for (size_t j = 0; j < size; j++)
+		{
+			long kind = random() % 5;
+			
+			bytes[j] = (kind < 2 ? random() % 0x80 : (kind == 2 ? 0x80 + random() % 0x40 : (kind == 3 ? 0xC0 + random() % 0x40 : random() % 0x100)));
+		}
+		
+		native = SMStringUTF8ToUTF16LE((const char *)bytes, size, false, &native_len);
+		iconv_result = SMStringUTF8ToUTF16LEIconv((const char *)bytes, size, false, &iconv_len);
+		
+		XCTAssertEqual(native == NULL, iconv_result == NULL);
+		
+		if (native && iconv_result)
+		{
+			XCTAssertEqual(native_len, iconv_len);
+			XCTAssertEqual(memcmp(native, iconv_result, native_len), 0);
+		}
+		
+		free(native);
+		free(iconv_result);
+	}
+}
+
+- (void)testPerformanceUTF16LEToUTF8Native
+{
+	[self measureUTF16LEToUTF8WithConverter:SMStringUTF16LEToUTF8 name:@"native"];
+}
+
+- (void)testPerformanceUTF16LEToUTF8Iconv
+{
+	[self measureUTF16LEToUTF8WithConverter:SMStringUTF16LEToUTF8Iconv name:@"iconv"];
+}
+
+
+#pragma mark - Helpers
+
+- (void)measureUTF16LEToUTF8WithConverter:(char * (*)(const void *, size_t, size_t *))converter name:(NSString *)name
+{
+	// Generate 10k variables names.
+	const NSUInteger	count = 10000;
+	void				**names = calloc(count, sizeof(void *));
+	size_t				*sizes = calloc(count, sizeof(size_t));
+	
+	_onExit {
+		for (NSUInteger i = 0; i < count; i++)
+			free(names[i]);
+		
+		free(names);
+		free(sizes);
+	};
+	
+	for (NSUInteger i = 0; i < count; i++)
+	{
+		char name[64];
+		
+		snprintf(name, sizeof(name), "efi-apple-variable-%lu", (unsigned long)i);
+		
+		names[i] = SMStringUTF8ToUTF16LE(name, strlen(name), true, &sizes[i]);
+	}
+	
+	// Measure throughput.
+	NSUInteger		rounds = 20;
+	CFAbsoluteTime	start = CFAbsoluteTimeGetCurrent();
+	
+	for (NSUInteger r = 0; r < rounds; r++)
+	{
+		for (NSUInteger i = 0; i < count; i++)
+			free(converter(names[i], sizes[i], NULL));
+	}
+	
+	CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - start;
+	
+	NSLog(@"UTF-16 to UTF-8 %@: %.0f names/s", name, (double)(count * rounds) / elapsed);
+	
+	// Measure.
+	[self measureBlock:^{
+		for (NSUInteger i = 0; i < count; i++)
+			free(converter(names[i], sizes[i], NULL));
+	}];
+}
+
 @end
@@ -0,0 +1,184 @@
+/*
+ *  SMStringInternTests.m
+ *
+ *  Copyright 2022 Avérous Julien-Pierre
+ *
+ *  This file is part of vm-config.
+ *
+ *  vm-config is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vm-config is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vm-config.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#import <XCTest/XCTest.h>
+
+#import "SMStringIntern.h"
+
+#import "SMTestsTools.h"
+#import "SMTestCase.h"
+
+
+/*
+** SMStringInternTests
+*/
+#pragma mark - SMStringInternTests
+
+@interface SMStringInternTests : SMTestCase
+
+@end
+
+@implementation SMStringInternTests
+
+- (void)testIntern
+{
+	SMArena				arena = SMArenaInit();
+	SMStringInternTable	table = SMStringInternTableInit(&arena);
+
+	_onExit {
+		SMStringInternTableFree(&table);
+		SMArenaFree(&arena);
+	};
+
+	const SMInternedString *str1 = SMStringIntern(&table, "uuid.bios", 9);
+	const SMInternedString *str2 = SMStringIntern(&table, "UUID.Bios", 9);
+	const SMInternedString *str3 = SMStringIntern(&table, "uuid.bios.extra", 9);
+
+	XCTAssertEqual(str1, str2);
+	XCTAssertEqual(str1, str3);
+	XCTAssertEqual(str1->size, 9);
+	XCTAssertEqualStrings(str1->string, "uuid.bios");
+	XCTAssertEqual(str1->hash, SMStringInternHash("UUID.BIOS", 9));
+
+	XCTAssertNotEqual(SMStringIntern(&table, "uuid.bio", 8), str1);
+}
+
+- (void)testInternLookup
+{
+	SMArena				arena = SMArenaInit();
+	SMStringInternTable	table = SMStringInternTableInit(&arena);
+
+	_onExit {
+		SMStringInternTableFree(&table);
+		SMArenaFree(&arena);
+	};
+
+	XCTAssertEqual(SMStringInternLookup(&table, "never.interned.key", 18), NULL);
+
+	const SMInternedString *str = SMStringIntern(&table, "Lookup.Key", 10);
+
+	XCTAssertEqual(SMStringInternLookup(&table, "lookup.key", 10), str);
+	XCTAssertEqual(SMStringInternLookup(&table, "LOOKUP.KEY", 10), str);
+}
+
+- (void)testInternTables
+{
+	// Tables are independent.
+	SMArena				arena1 = SMArenaInit();
+	SMArena				arena2 = SMArenaInit();
+	SMStringInternTable	table1 = SMStringInternTableInit(&arena1);
+	SMStringInternTable	table2 = SMStringInternTableInit(&arena2);
+
+	_onExit {
+		SMStringInternTableFree(&table1);
+		SMStringInternTableFree(&table2);
+		SMArenaFree(&arena1);
+		SMArenaFree(&arena2);
+	};
+
+	const SMInternedString *str1 = SMStringIntern(&table1, "table.key", 9);
+
+	XCTAssertEqual(SMStringInternLookup(&table2, "table.key", 9), NULL);
+
+	const SMInternedString *str2 = SMStringIntern(&table2, "TABLE.KEY", 9);
+
+	XCTAssertNotEqual(str1, str2);
+	XCTAssertEqual(SMStringInternLookup(&table1, "table.key", 9), str1);
+	XCTAssertEqual(SMStringInternLookup(&table2, "table.key", 9), str2);
+
+	// Freed tables are empty, and can be reused.
+	SMStringInternTableFree(&table1);
+
+	XCTAssertEqual(SMStringInternLookup(&table1, "table.key", 9), NULL);
+	XCTAssertNotEqual(SMStringIntern(&table1, "table.key", 9), NULL);
+}
+
+- (void)testInternGrowth
+{
+	SMArena				arena = SMArenaInit();
+	SMStringInternTable	table = SMStringInternTableInit(&arena);
+
+	_onExit {
+		SMStringInternTableFree(&table);
+		SMArenaFree(&arena);
+	};
+
+	// Interned strings must stay stable while the table grows.
+	const SMInternedString	*first = SMStringIntern(&table, "growth.key0", 11);
+	char					key[64];
+
+	for (unsigned i = 0; i < 100000; i++)
+	{
+		int size = snprintf(key, sizeof(key), "growth.KEY%u", i);
+
+		XCTAssertEqual(SMStringIntern(&table, key, (size_t)size), SMStringIntern(&table, key, (size_t)size));
+	}
+
+	XCTAssertEqual(SMStringIntern(&table, "GROWTH.KEY0", 11), first);
+}
+
+@end
+
+@implementation SMStringInternTests
+
+- (void)testIntern
+{
+	const SMInternedString *str1 = SMStringIntern("uuid.bios", 9);
+	const SMInternedString *str2 = SMStringIntern("UUID.Bios", 9);
+	const SMInternedString *str3 = SMStringIntern("uuid.bios.extra", 9);
+
+	XCTAssertEqual(str1, str2);
+	XCTAssertEqual(str1, str3);
+	XCTAssertEqual(str1->size, 9);
+	XCTAssertEqualStrings(str1->string, "uuid.bios");
+	XCTAssertEqual(str1->hash, SMStringInternHash("UUID.BIOS", 9));
+
+	XCTAssertNotEqual(SMStringIntern("uuid.bio", 8), str1);
+}
+
+- (void)testInternLookup
+{
+	XCTAssertEqual(SMStringInternLookup("never.interned.key", 18), NULL);
+
+	const SMInternedString *str = SMStringIntern("Lookup.Key", 10);
+
+	XCTAssertEqual(SMStringInternLookup("lookup.key", 10), str);
+	XCTAssertEqual(SMStringInternLookup("LOOKUP.KEY", 10), str);
+}
+
+- (void)testInternGrowth
+{
+	// Interned strings must stay stable while the table grows.
+	const SMInternedString	*first = SMStringIntern("growth.key0", 11);
+	char					key[64];
+
+	for (unsigned i = 0; i < 100000; i++)
+	{
+		int size = snprintf(key, sizeof(key), "growth.KEY%u", i);
+
+		XCTAssertEqual(SMStringIntern(key, (size_t)size), SMStringIntern(key, (size_t)size));
+	}
+
+	XCTAssertEqual(SMStringIntern("GROWTH.KEY0", 11), first);
+}
+
+@end
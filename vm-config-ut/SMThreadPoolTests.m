@@ -0,0 +1,159 @@
+/*
+ *  SMThreadPoolTests.m
+ *
+ *  Copyright 2022 Avérous Julien-Pierre
+ *
+ *  This file is part of vm-config.
+ *
+ *  vm-config is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vm-config is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vm-config.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <stdatomic.h>
+
+#import "SMThreadPool.h"
+
+#import "SMTestsTools.h"
+#import "SMTestCase.h"
+
+
+/*
+** Types
+*/
+#pragma mark - Types
+
+typedef struct
+{
+	atomic_size_t	count;
+	unsigned		depth;
+} SMTreeContext;
+
+typedef struct
+{
+	SMTreeContext	*tree;
+	unsigned		depth;
+} SMTreeNode;
+
+
+/*
+** Prototypes
+*/
+#pragma mark - Prototypes
+
+static void SMApplySquare(size_t idx, void *context);
+static void SMApplySleepy(size_t idx, void *context);
+static void SMTreeVisit(SMThreadPool *pool, void *context);
+
+
+/*
+** SMThreadPoolTests
+*/
+#pragma mark - SMThreadPoolTests
+
+@interface SMThreadPoolTests : SMTestCase
+
+@end
+
+@implementation SMThreadPoolTests
+
+- (void)testApply
+{
+	for (size_t threads = 0; threads <= 4; threads++)
+	{
+		SMThreadPool	*pool = SMThreadPoolCreate(threads);
+		size_t			count = 5000;
+		size_t			*results = calloc(count, sizeof(size_t));
+
+		XCTAssertEqual(SMThreadPoolThreadsCount(pool), (threads == 0 ? SMThreadPoolDefaultThreadsCount() : threads));
+
+		SMThreadPoolApply(pool, count, SMApplySquare, results);
+
+		for (size_t i = 0; i < count; i++)
+			XCTAssertEqual(results[i], i * i);
+
+		free(results);
+		SMThreadPoolFree(pool);
+	}
+}
+
+- (void)testNestedTasks
+{
+	// Each node adds 3 children: tasks added from workers must be waited too.
+	SMThreadPool	*pool = SMThreadPoolCreate(4);
+	SMTreeContext	tree = { .count = 0, .depth = 7 };
+	SMTreeNode		*root = malloc(sizeof(SMTreeNode));
+
+	root->tree = &tree;
+	root->depth = tree.depth;
+
+	SMThreadPoolAddTask(pool, SMTreeVisit, root);
+	SMThreadPoolWait(pool);
+
+	XCTAssertEqual(atomic_load(&tree.count), 3280); // (3^8 - 1) / 2
+
+	SMThreadPoolFree(pool);
+}
+
+- (void)testPerformanceUnbalancedApply
+{
+	// A few slow items among many fast ones: idle workers should steal the remaining ones.
+	SMThreadPool *pool = SMThreadPoolCreate(0);
+
+	[self measureBlock:^{
+		SMThreadPoolApply(pool, 2000, SMApplySleepy, NULL);
+	}];
+
+	SMThreadPoolFree(pool);
+}
+
+@end
+
+
+/*
+** C Helpers
+*/
+#pragma mark - C Helpers
+
+static void SMApplySquare(size_t idx, void *context)
+{
+	size_t *results = context;
+
+	results[idx] = idx * idx;
+}
+
+static void SMApplySleepy(size_t idx, void *context)
+{
+	usleep(idx % 100 == 0 ? 20000 : 100);
+}
+
+static void SMTreeVisit(SMThreadPool *pool, void *context)
+{
+	SMTreeNode *node = context;
+
+	atomic_fetch_add(&node->tree->count, 1);
+
+	for (unsigned i = 0; node->depth > 0 && i < 3; i++)
+	{
+		SMTreeNode *child = malloc(sizeof(SMTreeNode));
+
+		child->tree = node->tree;
+		child->depth = node->depth - 1;
+
+		SMThreadPoolAddTask(pool, SMTreeVisit, child);
+	}
+
+	free(node);
+}
@@ -0,0 +1,176 @@
+/*
+ *  SMVMwareCacheTests.m
+ *
+ *  Copyright 2022 Avérous Julien-Pierre
+ *
+ *  This file is part of vm-config.
+ *
+ *  vm-config is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vm-config is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vm-config.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#import <XCTest/XCTest.h>
+
+#import "SMVMwareCache.h"
+
+#import "SMTestsTools.h"
+#import "SMTestCase.h"
+
+
+/*
+** SMVMwareCacheTests
+*/
+#pragma mark - SMVMwareCacheTests
+
+@interface SMVMwareCacheTests : SMTestCase
+
+@end
+
+@implementation SMVMwareCacheTests
+
+#pragma mark - Tests
+
+- (void)testCacheHit
+{
+	SMVMwareCache	*cache = SMVMwareCacheCreate(4);
+	NSString		*vmxPath = [self temporaryCopyOfResourceFile:@"basic-1" ofType:@"vmx"];
+	NSString		*nvramPath = [self temporaryCopyOfResourceFile:@"basic-1" ofType:@"nvram"];
+	SMError			*error = NULL;
+
+	_onExit {
+		SMVMwareCacheFree(cache);
+	};
+
+	// Open & reopen.
+	SMVMwareVMX		*vmx1 = SMVMwareCacheGetVMX(cache, vmxPath.fileSystemRepresentation, &error);
+	SMVMwareNVRAM	*nvram1 = SMVMwareCacheGetNVRAM(cache, nvramPath.fileSystemRepresentation, &error);
+
+	XCTAssertNotEqual(vmx1, NULL);
+	XCTAssertNotEqual(nvram1, NULL);
+
+	SMVMwareVMX		*vmx2 = SMVMwareCacheGetVMX(cache, vmxPath.fileSystemRepresentation, &error);
+	SMVMwareNVRAM	*nvram2 = SMVMwareCacheGetNVRAM(cache, nvramPath.fileSystemRepresentation, &error);
+
+	XCTAssertEqual(vmx1, vmx2);
+	XCTAssertEqual(nvram1, nvram2);
+
+	XCTAssertEqual(SMVMwareCacheHitsCount(cache), 2);
+	XCTAssertEqual(SMVMwareCacheMissesCount(cache), 2);
+
+	// > Same path, other kind: not a hit.
+	XCTAssertEqual(SMVMwareCacheGetNVRAM(cache, vmxPath.fileSystemRepresentation, &error), NULL);
+	XCTAssertEqual(SMVMwareCacheMissesCount(cache), 3);
+
+	SMErrorFree(error);
+}
+
+- (void)testCacheInvalidation
+{
+	SMVMwareCache	*cache = SMVMwareCacheCreate(4);
+	NSString		*vmxPath = [self temporaryCopyOfResourceFile:@"basic-1" ofType:@"vmx"];
+	SMError			*error = NULL;
+
+	_onExit {
+		SMVMwareCacheFree(cache);
+	};
+
+	SMVMwareVMX *vmx = SMVMwareCacheGetVMX(cache, vmxPath.fileSystemRepresentation, &error);
+
+	XCTAssertNotEqual(vmx, NULL);
+	XCTAssertEqual(SMVMwareVMXEntriesCount(vmx), 10);
+
+	// Replace file.
+	// > New inode, size and modification time: the cached instance is stale.
+	XCTAssertTrue([@"key1 = \"value1\"\n" writeToFile:vmxPath atomically:YES encoding:NSUTF8StringEncoding error:nil]);
+
+	vmx = SMVMwareCacheGetVMX(cache, vmxPath.fileSystemRepresentation, &error);
+
+	XCTAssertNotEqual(vmx, NULL);
+	XCTAssertEqual(SMVMwareVMXEntriesCount(vmx), 1);
+	XCTAssertEqual(SMVMwareCacheHitsCount(cache), 0);
+	XCTAssertEqual(SMVMwareCacheMissesCount(cache), 2);
+
+	// Remove file.
+	XCTAssertTrue([[NSFileManager defaultManager] removeItemAtPath:vmxPath error:nil]);
+
+	XCTAssertEqual(SMVMwareCacheGetVMX(cache, vmxPath.fileSystemRepresentation, &error), NULL);
+	XCTAssertNotEqual(error, NULL);
+
+	SMErrorFree(error);
+}
+
+- (void)testCacheEviction
+{
+	SMVMwareCache	*cache = SMVMwareCacheCreate(2);
+	NSString		*paths[3];
+
+	_onExit {
+		SMVMwareCacheFree(cache);
+	};
+
+	for (size_t i = 0; i < 3; i++)
+		paths[i] = [self temporaryCopyOfResourceFile:@"basic-1" ofType:@"vmx"];
+
+	// Fill cache, and use first entry again: second one is the least recently used.
+	XCTAssertNotEqual(SMVMwareCacheGetVMX(cache, paths[0].fileSystemRepresentation, NULL), NULL);
+	XCTAssertNotEqual(SMVMwareCacheGetVMX(cache, paths[1].fileSystemRepresentation, NULL), NULL);
+	XCTAssertNotEqual(SMVMwareCacheGetVMX(cache, paths[0].fileSystemRepresentation, NULL), NULL);
+
+	// Evict.
+	XCTAssertNotEqual(SMVMwareCacheGetVMX(cache, paths[2].fileSystemRepresentation, NULL), NULL);
+	XCTAssertNotEqual(SMVMwareCacheGetVMX(cache, paths[0].fileSystemRepresentation, NULL), NULL);
+
+	XCTAssertEqual(SMVMwareCacheHitsCount(cache), 2);
+	XCTAssertEqual(SMVMwareCacheMissesCount(cache), 3);
+
+	XCTAssertNotEqual(SMVMwareCacheGetVMX(cache, paths[1].fileSystemRepresentation, NULL), NULL);
+
+	XCTAssertEqual(SMVMwareCacheMissesCount(cache), 4);
+}
+
+- (void)testPerformanceCacheHit
+{
+	SMVMwareCache	*cache = SMVMwareCacheCreate(64);
+	NSString		*nvramPath = [self temporaryCopyOfResourceFile:@"basic-1" ofType:@"nvram"];
+
+	_onExit {
+		SMVMwareCacheFree(cache);
+	};
+
+	[self measureBlock:^{
+		for (unsigned i = 0; i < 10000; i++)
+			XCTAssertNotEqual(SMVMwareCacheGetNVRAM(cache, nvramPath.fileSystemRepresentation, NULL), NULL);
+	}];
+}
+
+
+#pragma mark - Helpers
+
+- (NSString *)temporaryCopyOfResourceFile:(NSString *)file ofType:(NSString *)type
+{
+	NSBundle *bundle = [NSBundle bundleForClass:self.class];
+	NSString *path = [bundle pathForResource:file ofType:type];
+	NSString *copyPath = [SMGenerateTemporaryTestPath() stringByAppendingPathExtension:type];
+
+	NSAssert(path, @"cannot find resource file '%@.%@'", file, type);
+	NSAssert([[NSFileManager defaultManager] copyItemAtPath:path toPath:copyPath error:nil], @"cannot copy resource file");
+
+	[self addTeardownBlock:^{
+		[[NSFileManager defaultManager] removeItemAtPath:copyPath error:nil];
+	}];
+
+	return copyPath;
+}
+
+@end
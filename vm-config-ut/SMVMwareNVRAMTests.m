@@ -42,6 +42,16 @@ typedef NS_ENUM(NSUInteger, SMModificationPhase)
 };
 
 
+/*
+** Prototypes
+*/
+#pragma mark - Prototypes
+
+static bool SMVariableIsPanicInfo(SMVMwareNVRAMEFIVariable *variable, void *context);
+static bool SMVariableIsAny(SMVMwareNVRAMEFIVariable *variable, void *context);
+static void SMBytesReleaseCount(const void *bytes, size_t size, void *context);
+
+
 /*
 ** SMVMwareNVRAMTests
 */
@@ -218,6 +228,20 @@ typedef NS_ENUM(NSUInteger, SMModificationPhase)
 	SMErrorFree(error);
 }
 
+- (void)testFail5Parsing
+{
+	// Parse file.
+	// > EFI_NV data size smaller than its own headers.
+	SMError			*error = NULL;
+	SMVMwareNVRAM	*nvram = [self nvramForFile:@"fail-5" error:&error];
+
+	XCTAssertEqual(nvram, NULL, "succeeded in parsing an invalid nvram (%s)", SMErrorGetUserInfo(error));
+
+	// Clean.
+	SMVMwareNVRAMFree(nvram);
+	SMErrorFree(error);
+}
+
 - (void)testParserStability
 {
 	// Parse file.
@@ -251,6 +275,86 @@ typedef NS_ENUM(NSUInteger, SMModificationPhase)
 	SMErrorFree(error);
 }
 
+- (void)testOpenWithBytes
+{
+	NSData *data = [NSData dataWithContentsOfFile:[self pathForFile:@"basic-1"]];
+	
+	XCTAssertNotNil(data);
+	
+	// Borrowed.
+	SMError			*error = NULL;
+	SMVMwareNVRAM	*nvram = SMVMwareNVRAMOpenWithBytes(data.bytes, data.length, SMVMwareNVRAMBytesBorrowed, &error);
+	
+	XCTAssert(nvram, @"failed to parse bytes: %s", SMErrorGetUserInfo(error));
+	XCTAssertEqual(SMVMwareNVRAMGetPath(nvram), NULL);
+	XCTAssertEqual(SMVMwareNVRAMEntriesCount(nvram), 3);
+	XCTAssertEqual(SMVMwareNVRAMEntryVariablesCount(SMVMwareNVRAMGetEntryAtIndex(nvram, 2)), 2);
+	
+	// > Write back.
+	NSString *tempOutput = SMGenerateTemporaryTestPath();
+	
+	XCTAssertTrue(SMVMwareNVRAMWriteToFile(nvram, tempOutput.fileSystemRepresentation, &error), @"failed to write file: %s", SMErrorGetUserInfo(error));
+	XCTAssertEqualObjects([NSData dataWithContentsOfFile:tempOutput], data);
+	
+	SMVMwareNVRAMFree(nvram);
+	
+	// Owned.
+	void *bytes = malloc(data.length);
+	
+	memcpy(bytes, data.bytes, data.length);
+	
+	nvram = SMVMwareNVRAMOpenWithBytes(bytes, data.length, SMVMwareNVRAMBytesOwned, &error);
+	
+	XCTAssert(nvram, @"failed to parse bytes: %s", SMErrorGetUserInfo(error));
+	XCTAssertEqualStrings(SMVMwareNVRAMVariableGetUTF8Name(SMVMwareNVRAMEntryGetVariableAtIndex(SMVMwareNVRAMGetEntryAtIndex(nvram, 2), 1), NULL), "HELLOWORLD");
+	
+	SMVMwareNVRAMFree(nvram);
+	
+	// Invalid.
+	nvram = SMVMwareNVRAMOpenWithBytes(data.bytes, 0, SMVMwareNVRAMBytesBorrowed, &error);
+	
+	XCTAssertEqual(nvram, NULL);
+	XCTAssertNotEqual(error, NULL);
+	
+	SMErrorFree(error);
+}
+
+- (void)testOpenWithFileDescriptor
+{
+	NSData *data = [NSData dataWithContentsOfFile:[self pathForFile:@"basic-1"]];
+	
+	XCTAssertNotNil(data);
+	
+	// Feed a pipe in chunks.
+	NSPipe *pipe = [NSPipe pipe];
+	
+	dispatch_async(dispatch_get_global_queue(QOS_CLASS_DEFAULT, 0), ^{
+		for (NSUInteger offset = 0; offset < data.length; offset += 1000)
+			[pipe.fileHandleForWriting writeData:[data subdataWithRange:NSMakeRange(offset, MIN(1000, data.length - offset))]];
+		
+		[pipe.fileHandleForWriting closeFile];
+	});
+	
+	// Parse.
+	SMError			*error = NULL;
+	SMVMwareNVRAM	*nvram = SMVMwareNVRAMOpenWithFileDescriptor(pipe.fileHandleForReading.fileDescriptor, &error);
+	
+	XCTAssert(nvram, @"failed to parse stream: %s", SMErrorGetUserInfo(error));
+	
+	_onExit {
+		SMVMwareNVRAMFree(nvram);
+	};
+	
+	XCTAssertEqual(SMVMwareNVRAMEntriesCount(nvram), 3);
+	XCTAssertEqualStrings(SMVMwareNVRAMVariableGetUTF8Name(SMVMwareNVRAMEntryGetVariableAtIndex(SMVMwareNVRAMGetEntryAtIndex(nvram, 2), 0), NULL), "PROP1");
+	
+	// Write back.
+	NSString *tempOutput = SMGenerateTemporaryTestPath();
+	
+	XCTAssertTrue(SMVMwareNVRAMWriteToFile(nvram, tempOutput.fileSystemRepresentation, &error), @"failed to write file: %s", SMErrorGetUserInfo(error));
+	XCTAssertEqualObjects([NSData dataWithContentsOfFile:tempOutput], data);
+}
+
 - (void)testModificationsBootArgs
 {
 	[self handleTestModificationOfNVRAMFile:@"basic-1" phaseBlock:^(SMModificationPhase phase, SMVMwareNVRAM *nvram) {
@@ -480,17 +584,741 @@ typedef NS_ENUM(NSUInteger, SMModificationPhase)
 	}];
 }
 
+- (void)testModificationsLargeVariable
+{
+	// A variable bigger than an EFI_NV block, to check padding spans several blocks.
+	NSMutableData	*value = [NSMutableData dataWithLength:0x40000 + 123];
+	efi_guid_t		guid = Apple_NVRAM_Variable_Guid;
+	
+	memset(value.mutableBytes, 0x42, value.length);
+	
+	[self handleTestModificationOfNVRAMFile:@"basic-1" phaseBlock:^(SMModificationPhase phase, SMVMwareNVRAM *nvram) {
+		
+		SMVMwareNVRAMEntry *entry = SMVMwareNVRAMVariablesEntry(nvram, NULL);
+		
+		XCTAssertNotEqual(entry, NULL);
+		
+		switch (phase)
+		{
+			case SMModificationPhaseOriginal:
+			{
+				XCTAssertNotEqual(SMVMwareNVRAMEntryAddVariable(entry, guid, 0x7, "large-variable", value.bytes, value.length, NULL), NULL);
+				break;
+			}
+				
+			case SMModificationPhaseReopen1:
+			{
+				XCTAssertEqual(SMVMwareNVRAMEntryVariablesCount(entry), 3);
+				[self validateEFIVariableOfNVRAM:nvram guid:guid name:"large-variable" value:value.bytes size:value.length];
+				
+				// Update an original variable, so the large one is written from the mapping.
+				SMVMwareNVRAMVariableSetAttributes(SMVMwareNVRAMEntryGetVariableAtIndex(entry, 0), 0x43);
+				
+				break;
+			}
+				
+			case SMModificationPhaseReopen2:
+			{
+				size_t content_size = 0;
+				
+				SMVMwareNVRAMEntryGetContentBytes(entry, &content_size);
+				
+				XCTAssertEqual(content_size, 2 * 0x40000);
+				XCTAssertEqual(SMVMwareNVRAMVariableGetAttributes(SMVMwareNVRAMEntryGetVariableAtIndex(entry, 0)), 0x43);
+				[self validateEFIVariableOfNVRAM:nvram guid:guid name:"large-variable" value:value.bytes size:value.length];
+				
+				break;
+			}
+		}
+	}];
+}
+
+- (void)testModificationsRemoveVariables
+{
+	// Panic info variables make the store span two EFI_NV blocks: removing them should shrink it back to one.
+	NSMutableData	*value = [NSMutableData dataWithLength:100 * 1024];
+	efi_guid_t		guid = Apple_NVRAM_Variable_Guid;
+	
+	memset(value.mutableBytes, 0x42, value.length);
+	
+	[self handleTestModificationOfNVRAMFile:@"basic-1" phaseBlock:^(SMModificationPhase phase, SMVMwareNVRAM *nvram) {
+		
+		SMVMwareNVRAMEntry	*entry = SMVMwareNVRAMVariablesEntry(nvram, NULL);
+		size_t				content_size = 0;
+		
+		XCTAssertNotEqual(entry, NULL);
+		
+		switch (phase)
+		{
+			case SMModificationPhaseOriginal:
+			{
+				for (unsigned i = 0; i < 3; i++)
+				{
+					char name[32];
+					
+					snprintf(name, sizeof(name), "AAPL,PanicInfo%04u", i);
+					
+					XCTAssertNotEqual(SMVMwareNVRAMEntryAddVariable(entry, guid, 0x7, name, value.bytes, value.length, NULL), NULL);
+				}
+				
+				XCTAssertNotEqual(SMVMwareNVRAMEntryAddVariable(entry, guid, 0x7, "removed", "x", 1, NULL), NULL);
+				
+				// Remove one variable.
+				SMVMwareNVRAMEFIVariable *var = SMVMwareNVRAMVariableForGUIDAndName(nvram, &guid, "removed", NULL);
+				
+				XCTAssertNotEqual(var, NULL);
+				
+				SMVMwareNVRAMEntryRemoveVariable(entry, var);
+				
+				XCTAssertEqual(SMVMwareNVRAMEntryVariablesCount(entry), 5);
+				XCTAssertEqual(SMVMwareNVRAMEntryGetVariableForGUIDAndUTF8Name(entry, &guid, "removed"), NULL);
+				XCTAssertEqualStrings(SMVMwareNVRAMVariableGetUTF8Name(var, NULL), "removed");
+				
+				break;
+			}
+				
+			case SMModificationPhaseReopen1:
+			{
+				SMVMwareNVRAMEntryGetContentBytes(entry, &content_size);
+				
+				XCTAssertEqual(content_size, 2 * 0x40000);
+				XCTAssertEqual(SMVMwareNVRAMEntryVariablesCount(entry), 5);
+				
+				// Remove matching variables.
+				XCTAssertEqual(SMVMwareNVRAMEntryRemoveVariablesMatching(entry, SMVariableIsPanicInfo, NULL), 3);
+				
+				XCTAssertEqual(SMVMwareNVRAMEntryVariablesCount(entry), 2);
+				XCTAssertEqual(SMVMwareNVRAMEntryGetVariableForGUIDAndUTF8Name(entry, &guid, "AAPL,PanicInfo0001"), NULL);
+				
+				break;
+			}
+				
+			case SMModificationPhaseReopen2:
+			{
+				SMVMwareNVRAMEntryGetContentBytes(entry, &content_size);
+				
+				XCTAssertEqual(content_size, 0x40000);
+				XCTAssertEqual(SMVMwareNVRAMEntryVariablesCount(entry), 2);
+				
+				XCTAssertEqualStrings(SMVMwareNVRAMVariableGetUTF8Name(SMVMwareNVRAMEntryGetVariableAtIndex(entry, 0), NULL), "PROP1");
+				XCTAssertEqualStrings(SMVMwareNVRAMVariableGetUTF8Name(SMVMwareNVRAMEntryGetVariableAtIndex(entry, 1), NULL), "HELLOWORLD");
+				
+				break;
+			}
+		}
+	}];
+	
+	// Removing all variables should keep a valid empty store.
+	[self handleTestModificationOfNVRAMFile:@"basic-1" phaseBlock:^(SMModificationPhase phase, SMVMwareNVRAM *nvram) {
+		
+		SMVMwareNVRAMEntry	*entry = SMVMwareNVRAMVariablesEntry(nvram, NULL);
+		size_t				content_size = 0;
+		
+		XCTAssertNotEqual(entry, NULL);
+		
+		if (phase == SMModificationPhaseOriginal)
+		{
+			XCTAssertEqual(SMVMwareNVRAMEntryRemoveVariablesMatching(entry, SMVariableIsAny, NULL), 2);
+		}
+		else
+		{
+			SMVMwareNVRAMEntryGetContentBytes(entry, &content_size);
+			
+			XCTAssertEqual(content_size, 0x40000);
+		}
+		
+		XCTAssertEqual(SMVMwareNVRAMEntryVariablesCount(entry), 0);
+	}];
+}
+
+- (void)testModificationsGenericEntryName
+{
+	// Renamed generic entries keep their content.
+	[self handleTestModificationOfNVRAMFile:@"basic-1" phaseBlock:^(SMModificationPhase phase, SMVMwareNVRAM *nvram) {
+		
+		SMVMwareNVRAMEntry	*entry = SMVMwareNVRAMGetEntryAtIndex(nvram, 1);
+		const void			*bytes = NULL;
+		size_t				size = 0;
+		
+		if (phase == SMModificationPhaseOriginal)
+		{
+			XCTAssertTrue(SMVMwareNVRAMEntrySetName(entry, "KEYX", NULL));
+			XCTAssertTrue(SMVMwareNVRAMEntrySetSubname(entry, "SUBX", NULL));
+		}
+		
+		XCTAssertEqual(SMVMwareNVRAMEntriesCount(nvram), 3);
+		
+		XCTAssertEqualStrings(SMVMwareNVRAMEntryGetName(entry), "KEYX");
+		XCTAssertEqualStrings(SMVMwareNVRAMEntryGetSubname(entry), "SUBX");
+		XCTAssertEqual(SMVMwareNVRAMEntryGetType(entry), SMVMwareNVRAMEntryTypeGeneric);
+		
+		bytes = SMVMwareNVRAMEntryGetContentBytes(entry, &size);
+		
+		XCTAssertEqual(size, 4);
+		XCTAssertEqual(memcmp(bytes, "\xca\xfe\xba\xbe", 4), 0);
+		
+		XCTAssertEqual(SMVMwareNVRAMEntryVariablesCount(SMVMwareNVRAMGetEntryAtIndex(nvram, 2)), 2);
+	}];
+}
+
+- (void)testModificationsBeforeVariablesAccess
+{
+	// Variables are parsed on first access: adding one before any access should keep original variables first.
+	efi_guid_t				guid = Apple_NVRAM_Variable_Guid;
+	static const uint8_t	value[] = { 0x01, 0x02, 0x03 };
+
+	[self handleTestModificationOfNVRAMFile:@"basic-1" phaseBlock:^(SMModificationPhase phase, SMVMwareNVRAM *nvram) {
+
+		SMVMwareNVRAMEntry *entry = SMVMwareNVRAMGetEntryAtIndex(nvram, 2);
+
+		if (phase == SMModificationPhaseOriginal)
+			XCTAssertNotEqual(SMVMwareNVRAMEntryAddVariable(entry, guid, 0x7, "added", value, sizeof(value), NULL), NULL);
+
+		XCTAssertEqual(SMVMwareNVRAMEntryVariablesCount(entry), 3);
+
+		XCTAssertEqualStrings(SMVMwareNVRAMVariableGetUTF8Name(SMVMwareNVRAMEntryGetVariableAtIndex(entry, 0), NULL), "PROP1");
+		XCTAssertEqualStrings(SMVMwareNVRAMVariableGetUTF8Name(SMVMwareNVRAMEntryGetVariableAtIndex(entry, 1), NULL), "HELLOWORLD");
+
+		[self validateEFIVariableOfNVRAM:nvram guid:guid name:"added" value:value size:sizeof(value)];
+	}];
+}
+
+- (void)testModificationsNoCopyValue
+{
+	NSMutableData	*golden = [NSMutableData dataWithLength:512 * 1024];
+	efi_guid_t		guid = Apple_NVRAM_Variable_Guid;
+	unsigned		released = 0;
+	unsigned		*releasedPtr = &released;
+	
+	memset(golden.mutableBytes, 0x42, golden.length);
+	
+	[self handleTestModificationOfNVRAMFile:@"basic-1" phaseBlock:^(SMModificationPhase phase, SMVMwareNVRAM *nvram) {
+		
+		SMVMwareNVRAMEntry *entry = SMVMwareNVRAMGetEntryAtIndex(nvram, 2);
+		
+		switch (phase)
+		{
+			case SMModificationPhaseOriginal:
+			{
+				SMVMwareNVRAMEFIVariable *var = SMVMwareNVRAMEntryAddVariable(entry, guid, 0x7, "golden", NULL, 0, NULL);
+				
+				XCTAssertNotEqual(var, NULL);
+				
+				// > Replaced bytes are released, re-set ones are not.
+				SMVMwareNVRAMVariableSetValueNoCopy(var, "tmp", 3, SMBytesReleaseCount, releasedPtr);
+				SMVMwareNVRAMVariableSetValueNoCopy(var, golden.bytes, golden.length, SMBytesReleaseCount, releasedPtr);
+				SMVMwareNVRAMVariableSetValueNoCopy(var, golden.bytes, golden.length, SMBytesReleaseCount, releasedPtr);
+				
+				XCTAssertEqual(*releasedPtr, 1);
+				
+				// > Bytes are referenced as-is.
+				size_t size = 0;
+				
+				XCTAssertEqual(SMVMwareNVRAMVariableGetValue(var, &size), golden.bytes);
+				XCTAssertEqual(size, golden.length);
+				break;
+			}
+				
+			case SMModificationPhaseReopen1:
+			{
+				// > Bytes released when the modified instance was freed.
+				XCTAssertEqual(*releasedPtr, 2);
+				
+				SMVMwareNVRAMEFIVariable	*var = SMVMwareNVRAMEntryGetVariableForGUIDAndUTF8Name(entry, &guid, "golden");
+				size_t						size = 0;
+				const void					*bytes = SMVMwareNVRAMVariableGetValue(var, &size);
+				
+				XCTAssertEqual(size, golden.length);
+				XCTAssertEqual(memcmp(bytes, golden.bytes, size), 0);
+				break;
+			}
+				
+			case SMModificationPhaseReopen2:
+				break;
+		}
+	}];
+}
+
+- (void)testModificationsInPlace
+{
+	// Parse file.
+	SMError			*error = NULL;
+	SMVMwareNVRAM	*nvram = [self nvramForFile:@"basic-1" error:&error];
+
+	XCTAssert(nvram, @"failed to parse file: %s", SMErrorGetUserInfo(error));
+
+	SMErrorFree(error);
+	error = NULL;
+
+	// Touch a variable, so the EFI entry is re-serialized with padded blocks.
+	NSString *tempOutput1 = SMGenerateTemporaryTestPath();
+
+	SMVMwareNVRAMVariableSetAttributes(SMVMwareNVRAMEntryGetVariableAtIndex(SMVMwareNVRAMVariablesEntry(nvram, NULL), 1), 0x51);
+
+	XCTAssertTrue(SMVMwareNVRAMWriteToFile(nvram, tempOutput1.fileSystemRepresentation, &error), @"failed to write file 1: %s", SMErrorGetUserInfo(error));
+
+	SMVMwareNVRAMFree(nvram);
+
+	nvram = SMVMwareNVRAMOpen(tempOutput1.fileSystemRepresentation, &error);
+
+	XCTAssertNotEqual(nvram, NULL, "failed to re-open file 1: %s", SMErrorGetUserInfo(error));
+
+	// Size-preserving edit: the file is copied, then patched.
+	SMVMwareNVRAMVariableSetAttributes(SMVMwareNVRAMEntryGetVariableAtIndex(SMVMwareNVRAMVariablesEntry(nvram, NULL), 1), 0x52);
+
+	NSString *tempOutput2 = SMGenerateTemporaryTestPath();
+
+	XCTAssertTrue(SMVMwareNVRAMWriteToFile(nvram, tempOutput2.fileSystemRepresentation, &error), @"failed to write file 2: %s", SMErrorGetUserInfo(error));
+
+	SMVMwareNVRAMFree(nvram);
+
+	// Compare: only the attributes byte should differ.
+	NSData *refData = [NSData dataWithContentsOfFile:tempOutput1];
+	NSData *writtenData = [NSData dataWithContentsOfFile:tempOutput2];
+
+	XCTAssertEqual(refData.length, writtenData.length);
+
+	const uint8_t	*refBytes = refData.bytes;
+	const uint8_t	*writtenBytes = writtenData.bytes;
+	NSUInteger		diffCount = 0;
+
+	for (NSUInteger i = 0; i < MIN(refData.length, writtenData.length); i++)
+	{
+		if (refBytes[i] == writtenBytes[i])
+			continue;
+
+		XCTAssertEqual(refBytes[i], 0x51);
+		XCTAssertEqual(writtenBytes[i], 0x52);
+
+		diffCount++;
+	}
+
+	XCTAssertEqual(diffCount, 1);
+
+	// Reopen.
+	nvram = SMVMwareNVRAMOpen(tempOutput2.fileSystemRepresentation, &error);
+
+	XCTAssertNotEqual(nvram, NULL, "failed to re-open file 2: %s", SMErrorGetUserInfo(error));
+	XCTAssertEqual(SMVMwareNVRAMVariableGetAttributes(SMVMwareNVRAMEntryGetVariableAtIndex(SMVMwareNVRAMVariablesEntry(nvram, NULL), 1)), 0x52);
+
+	// Clean.
+	SMVMwareNVRAMFree(nvram);
+	SMErrorFree(error);
+
+	[[NSFileManager defaultManager] removeItemAtPath:tempOutput1 error:nil];
+	[[NSFileManager defaultManager] removeItemAtPath:tempOutput2 error:nil];
+}
+
+- (void)testVariableLookup
+{
+	// Parse file.
+	SMError			*error = NULL;
+	SMVMwareNVRAM	*nvram = [self nvramForFile:@"basic-1" error:&error];
+	
+	XCTAssert(nvram, @"failed to parse file: %s", SMErrorGetUserInfo(error));
+	
+	_onExit {
+		SMVMwareNVRAMFree(nvram);
+	};
+	
+	SMVMwareNVRAMEntry			*entry = SMVMwareNVRAMGetEntryAtIndex(nvram, 2);
+	SMVMwareNVRAMEFIVariable	*var1 = SMVMwareNVRAMEntryGetVariableAtIndex(entry, 0);
+	efi_guid_t					guid1 = { 0x4CE8598D, 0xD539, 0x8043, { 0xB6, 0xCB, 0x76, 0x0E, 0xA6, 0x66, 0x55, 0x2E } };
+	efi_guid_t					guid2 = { 0x311EEF73, 0x98C3, 0x924C, { 0xB0, 0x94, 0x2A, 0x97, 0x3F, 0xB1, 0xD3, 0xA8 } };
+	uint8_t						name1[] = { 0x50, 0x00, 0x52, 0x00, 0x4F, 0x00, 0x50, 0x00, 0x31, 0x00, 0x00, 0x00 };
+	
+	// Lookup existing variables.
+	XCTAssertEqual(SMVMwareNVRAMEntryGetVariableForGUIDAndName(entry, &guid1, name1, sizeof(name1)), var1);
+	XCTAssertEqual(SMVMwareNVRAMEntryGetVariableForGUIDAndUTF8Name(entry, &guid1, "PROP1"), var1);
+	XCTAssertEqual(SMVMwareNVRAMEntryGetVariableForGUIDAndUTF8Name(entry, &guid2, "HELLOWORLD"), SMVMwareNVRAMEntryGetVariableAtIndex(entry, 1));
+	
+	XCTAssertEqual(SMVMwareNVRAMEntryGetVariableForGUIDAndUTF8Name(entry, &guid2, "PROP1"), NULL);
+	XCTAssertEqual(SMVMwareNVRAMEntryGetVariableForGUIDAndUTF8Name(entry, &guid1, "PROP"), NULL);
+	
+	// Rename & change GUID.
+	XCTAssertTrue(SMVMwareNVRAMVariableSetUTF8Name(var1, "PROP1-renamed", NULL));
+	
+	XCTAssertEqual(SMVMwareNVRAMEntryGetVariableForGUIDAndUTF8Name(entry, &guid1, "PROP1"), NULL);
+	XCTAssertEqual(SMVMwareNVRAMEntryGetVariableForGUIDAndUTF8Name(entry, &guid1, "PROP1-renamed"), var1);
+	
+	SMVMwareNVRAMVariableSetGUID(var1, &guid2);
+	
+	XCTAssertEqual(SMVMwareNVRAMEntryGetVariableForGUIDAndUTF8Name(entry, &guid1, "PROP1-renamed"), NULL);
+	XCTAssertEqual(SMVMwareNVRAMEntryGetVariableForGUIDAndUTF8Name(entry, &guid2, "PROP1-renamed"), var1);
+	
+	// Add variables: first one in order wins.
+	SMVMwareNVRAMEFIVariable *var3 = SMVMwareNVRAMEntryAddVariable(entry, guid2, 0, "PROP1-renamed", "", 0, NULL);
+	SMVMwareNVRAMEFIVariable *var4 = SMVMwareNVRAMEntryAddVariable(entry, guid2, 0, "r\xc3\xa9sum\xc3\xa9", "", 0, NULL);
+	
+	XCTAssertNotEqual(var3, NULL);
+	XCTAssertEqual(SMVMwareNVRAMEntryGetVariableForGUIDAndUTF8Name(entry, &guid2, "PROP1-renamed"), var1);
+	XCTAssertEqual(SMVMwareNVRAMEntryGetVariableForGUIDAndUTF8Name(entry, &guid2, "r\xc3\xa9sum\xc3\xa9"), var4);
+	
+	SMVMwareNVRAMVariableSetGUID(var1, &guid1);
+	
+	XCTAssertEqual(SMVMwareNVRAMEntryGetVariableForGUIDAndUTF8Name(entry, &guid2, "PROP1-renamed"), var3);
+}
+
+- (void)testQueries
+{
+	// Parse file.
+	SMError			*error = NULL;
+	SMVMwareNVRAM	*nvram = [self nvramForFile:@"basic-1" error:&error];
+	
+	XCTAssert(nvram, @"failed to parse file: %s", SMErrorGetUserInfo(error));
+	
+	_onExit {
+		SMVMwareNVRAMFree(nvram);
+	};
+	
+	// Add variables.
+	SMVMwareNVRAMEntry	*entry = SMVMwareNVRAMGetEntryAtIndex(nvram, 2);
+	efi_guid_t			guid = Apple_NVRAM_Variable_Guid;
+	efi_guid_t			guid1 = SMVMwareNVRAMVariableGetGUID(SMVMwareNVRAMEntryGetVariableAtIndex(entry, 0));
+	
+	for (unsigned i = 0; i < 100; i++)
+	{
+		char name[32];
+		
+		snprintf(name, sizeof(name), "variable-%u", i);
+		
+		XCTAssertNotEqual(SMVMwareNVRAMEntryAddVariable(entry, guid, 0, name, &i, sizeof(i), NULL), NULL);
+	}
+	
+	// Create queries.
+	SMVMwareNVRAMQuery **queries = calloc(20, sizeof(*queries));
+	
+	XCTAssertNotEqual(queries, NULL);
+	
+	queries[0] = SMVMwareNVRAMQueryCreate(&guid1, "PROP1", NULL);
+	queries[1] = SMVMwareNVRAMQueryCreate(&guid, "PROP1", NULL); // Wrong GUID.
+	queries[2] = SMVMwareNVRAMQueryCreate(&guid, "variable", NULL); // Prefix only.
+	
+	for (unsigned i = 3; i < 20; i++)
+	{
+		char name[32];
+		
+		snprintf(name, sizeof(name), "variable-%u", i * 7);
+		
+		queries[i] = SMVMwareNVRAMQueryCreate(&guid, name, NULL);
+	}
+	
+	_onExit {
+		for (unsigned i = 0; i < 20; i++)
+			SMVMwareNVRAMQueryFree(queries[i]);
+		
+		free(queries);
+	};
+	
+	// Check single queries.
+	XCTAssertEqual(SMVMwareNVRAMEntryGetVariableForQuery(entry, queries[0]), SMVMwareNVRAMEntryGetVariableAtIndex(entry, 0));
+	XCTAssertEqual(SMVMwareNVRAMEntryGetVariableForQuery(entry, queries[1]), NULL);
+	XCTAssertEqual(SMVMwareNVRAMEntryGetVariableForQuery(entry, queries[2]), NULL);
+	
+	// Check multi-queries, with few (compared) & many (hashed) queries, without & with the index.
+	for (unsigned pass = 0; pass < 2; pass++)
+	{
+		SMVMwareNVRAMEFIVariable *variables[20];
+		
+		for (size_t count = 5; count <= 20; count += 15)
+		{
+			SMVMwareNVRAMEntryGetVariablesForQueries(entry, (const SMVMwareNVRAMQuery * const *)queries, count, variables);
+			
+			XCTAssertEqual(variables[0], SMVMwareNVRAMEntryGetVariableAtIndex(entry, 0));
+			XCTAssertEqual(variables[1], NULL);
+			XCTAssertEqual(variables[2], NULL);
+			
+			for (unsigned i = 3; i < count; i++)
+			{
+				char name[32];
+				
+				snprintf(name, sizeof(name), "variable-%u", i * 7);
+				
+				XCTAssertEqual(variables[i], SMVMwareNVRAMEntryGetVariableAtIndex(entry, 2 + i * 7));
+				XCTAssertEqualStrings(SMVMwareNVRAMVariableGetUTF8Name(variables[i], NULL), name);
+			}
+		}
+		
+		// > Build the index.
+		XCTAssertNotEqual(SMVMwareNVRAMEntryGetVariableForGUIDAndUTF8Name(entry, &guid, "variable-0"), NULL);
+	}
+}
+
+- (void)testQueriesNameTail
+{
+	// Parse file.
+	SMError			*error = NULL;
+	SMVMwareNVRAM	*nvram = [self nvramForFile:@"basic-1" error:&error];
+	
+	XCTAssert(nvram, @"failed to parse file: %s", SMErrorGetUserInfo(error));
+	
+	_onExit {
+		SMVMwareNVRAMFree(nvram);
+	};
+	
+	// Add variables with raw names.
+	SMVMwareNVRAMEntry			*entry = SMVMwareNVRAMGetEntryAtIndex(nvram, 2);
+	efi_guid_t					guid = Apple_NVRAM_Variable_Guid;
+	SMVMwareNVRAMEFIVariable	*odd = SMVMwareNVRAMEntryAddVariable(entry, guid, 0, "odd", "", 0, NULL);
+	SMVMwareNVRAMEFIVariable	*even = SMVMwareNVRAMEntryAddVariable(entry, guid, 0, "even", "", 0, NULL);
+	
+	XCTAssertNotEqual(odd, NULL);
+	XCTAssertNotEqual(even, NULL);
+	
+	// > A name followed by a single byte, and a name followed by a zero unit & garbage.
+	SMVMwareNVRAMVariableSetName(odd, "o\0d\0d\0x", 7);
+	SMVMwareNVRAMVariableSetName(even, "e\0v\0e\0n\0\0\0x\0", 12);
+	
+	SMVMwareNVRAMQuery *odd_query = SMVMwareNVRAMQueryCreate(&guid, "odd", NULL);
+	SMVMwareNVRAMQuery *even_query = SMVMwareNVRAMQueryCreate(&guid, "even", NULL);
+	
+	_onExit {
+		SMVMwareNVRAMQueryFree(odd_query);
+		SMVMwareNVRAMQueryFree(even_query);
+	};
+	
+	// Check without & with the index.
+	for (unsigned pass = 0; pass < 2; pass++)
+	{
+		XCTAssertEqual(SMVMwareNVRAMEntryGetVariableForQuery(entry, odd_query), NULL);
+		XCTAssertEqual(SMVMwareNVRAMEntryGetVariableForQuery(entry, even_query), even);
+		
+		// > Build the index.
+		XCTAssertEqual(SMVMwareNVRAMEntryGetVariableForGUIDAndUTF8Name(entry, &guid, "even"), even);
+	}
+	
+	// Check error.
+	SMError *query_error = NULL;
+	
+	_onExit {
+		SMErrorFree(query_error);
+	};
+	
+	XCTAssertEqual(SMVMwareNVRAMVariableForQuery(nvram, odd_query, &query_error), NULL);
+	XCTAssertEqualStrings(SMErrorGetUserInfo(query_error), "variable 'odd' not found");
+}
+
+- (void)testPerformanceVariableLookup
+{
+	// Parse file.
+	SMVMwareNVRAM *nvram = [self nvramForFile:@"basic-1" error:NULL];
+	
+	XCTAssert(nvram);
+	
+	_onExit {
+		SMVMwareNVRAMFree(nvram);
+	};
+	
+	// Add variables.
+	SMVMwareNVRAMEntry	*entry = SMVMwareNVRAMGetEntryAtIndex(nvram, 2);
+	efi_guid_t			guid = Apple_NVRAM_Variable_Guid;
+	
+	for (unsigned i = 0; i < 2000; i++)
+	{
+		char name[32];
+		
+		snprintf(name, sizeof(name), "variable-%u", i);
+		
+		XCTAssertNotEqual(SMVMwareNVRAMEntryAddVariable(entry, guid, 0, name, &i, sizeof(i), NULL), NULL);
+	}
+	
+	// Measure.
+	[self measureBlock:^{
+		for (unsigned i = 0; i < 100000; i++)
+			SMVMwareNVRAMVariableForGUIDAndName(nvram, &guid, "variable-1999", NULL);
+	}];
+}
+
+- (void)testPerformanceRemoveVariables
+{
+	efi_guid_t guid = Apple_NVRAM_Variable_Guid;
+	
+	[self measureMetrics:[[self class] defaultPerformanceMetrics] automaticallyStartMeasuring:NO forBlock:^{
+		SMVMwareNVRAM		*nvram = [self nvramForFile:@"basic-1" error:NULL];
+		SMVMwareNVRAMEntry	*entry = SMVMwareNVRAMGetEntryAtIndex(nvram, 2);
+		
+		for (unsigned i = 0; i < 20000; i++)
+		{
+			char name[32];
+			
+			snprintf(name, sizeof(name), (i % 2 ? "AAPL,PanicInfo%04u" : "variable-%u"), i);
+			
+			SMVMwareNVRAMEntryAddVariable(entry, guid, 0, name, &i, sizeof(i), NULL);
+		}
+		
+		// Build the index, so it's maintained by removals.
+		SMVMwareNVRAMEntryGetVariableForGUIDAndUTF8Name(entry, &guid, "variable-0");
+		
+		// Remove every other variable: this should stay linear.
+		[self startMeasuring];
+		
+		XCTAssertEqual(SMVMwareNVRAMEntryRemoveVariablesMatching(entry, SMVariableIsPanicInfo, NULL), 10000);
+		XCTAssertEqual(SMVMwareNVRAMEntryVariablesCount(entry), 10002);
+		
+		SMVMwareNVRAMEntryGetVariableAtIndex(entry, 0);
+		
+		[self stopMeasuring];
+		
+		SMVMwareNVRAMFree(nvram);
+	}];
+}
+
+- (void)testPerformanceQueries
+{
+	// Generate a file with variables.
+	SMVMwareNVRAM	*nvram = [self nvramForFile:@"basic-1" error:NULL];
+	efi_guid_t		guid = Apple_NVRAM_Variable_Guid;
+	
+	XCTAssert(nvram);
+	
+	for (unsigned i = 0; i < 200; i++)
+	{
+		char name[32];
+		
+		snprintf(name, sizeof(name), "variable-%u", i);
+		
+		XCTAssertNotEqual(SMVMwareNVRAMEntryAddVariable(SMVMwareNVRAMGetEntryAtIndex(nvram, 2), guid, 0, name, &i, sizeof(i), NULL), NULL);
+	}
+	
+	NSString *path = SMGenerateTemporaryTestPath();
+	
+	XCTAssertTrue(SMVMwareNVRAMWriteToFile(nvram, path.fileSystemRepresentation, NULL));
+	
+	SMVMwareNVRAMFree(nvram);
+	
+	// Create queries.
+	const char			*names[] = { "variable-3", "variable-42", "variable-199", "variable-100", "missing" };
+	SMVMwareNVRAMQuery	**queries = calloc(5, sizeof(*queries));
+	
+	XCTAssertNotEqual(queries, NULL);
+	
+	for (unsigned i = 0; i < 5; i++)
+		queries[i] = SMVMwareNVRAMQueryCreate(&guid, names[i], NULL);
+	
+	_onExit {
+		for (unsigned i = 0; i < 5; i++)
+			SMVMwareNVRAMQueryFree(queries[i]);
+		
+		free(queries);
+		
+		[[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+	};
+	
+	// Measure: resolve the same 5 variables in many files.
+	[self measureBlock:^{
+		for (unsigned i = 0; i < 1000; i++)
+		{
+			SMVMwareNVRAM				*qnvram = SMVMwareNVRAMOpen(path.fileSystemRepresentation, NULL);
+			SMVMwareNVRAMEFIVariable	*variables[5];
+			
+			SMVMwareNVRAMVariablesForQueries(qnvram, (const SMVMwareNVRAMQuery * const *)queries, 5, variables, NULL);
+			SMVMwareNVRAMFree(qnvram);
+		}
+	}];
+}
+
+- (void)testPerformanceOpenWithBytes
+{
+	NSData *data = [NSData dataWithContentsOfFile:[self pathForFile:@"basic-1"]];
+	
+	XCTAssertNotNil(data);
+	
+	[self measureBlock:^{
+		for (unsigned i = 0; i < 10000; i++)
+			SMVMwareNVRAMFree(SMVMwareNVRAMOpenWithBytes(data.bytes, data.length, SMVMwareNVRAMBytesBorrowed, NULL));
+	}];
+}
+
+- (void)testPerformanceParse50Variables
+{
+	[self measureParseWithVariablesCount:50];
+}
+
+- (void)testPerformanceParse500Variables
+{
+	[self measureParseWithVariablesCount:500];
+}
+
+- (void)testPerformanceParse2000Variables
+{
+	[self measureParseWithVariablesCount:2000];
+}
+
 
 #pragma mark - Helpers
 
-- (SMVMwareNVRAM *)nvramForFile:(NSString *)file error:(SMError **)error
+- (NSString *)pathForFile:(NSString *)file
 {
 	NSBundle *bundle = [NSBundle bundleForClass:self.class];
 	NSString *path = [bundle pathForResource:file ofType:@"nvram"];
 	
 	NSAssert(path, @"cannot find NVRAM file '%@'", file);
+	
+	return path;
+}
 
-	return SMVMwareNVRAMOpen(path.fileSystemRepresentation, error);
+- (SMVMwareNVRAM *)nvramForFile:(NSString *)file error:(SMError **)error
+{
+	return SMVMwareNVRAMOpen([self pathForFile:file].fileSystemRepresentation, error);
+}
+
+- (void)measureParseWithVariablesCount:(unsigned)count
+{
+	// Generate a file with variables.
+	SMVMwareNVRAM *nvram = [self nvramForFile:@"basic-1" error:NULL];
+	
+	XCTAssert(nvram);
+	
+	SMVMwareNVRAMEntry	*entry = SMVMwareNVRAMGetEntryAtIndex(nvram, 2);
+	efi_guid_t			guid = Apple_NVRAM_Variable_Guid;
+	
+	for (unsigned i = 0; i < count; i++)
+	{
+		char name[32];
+		
+		snprintf(name, sizeof(name), "variable-%u", i);
+		
+		XCTAssertNotEqual(SMVMwareNVRAMEntryAddVariable(entry, guid, 0, name, &i, sizeof(i), NULL), NULL);
+	}
+	
+	NSString *path = SMGenerateTemporaryTestPath();
+	
+	XCTAssertTrue(SMVMwareNVRAMWriteToFile(nvram, path.fileSystemRepresentation, NULL));
+	
+	SMVMwareNVRAMFree(nvram);
+	
+	_onExit {
+		[[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+	};
+	
+	// Parse & scan.
+	void (^parse)(void) = ^{
+		SMVMwareNVRAM		*pnvram = SMVMwareNVRAMOpen(path.fileSystemRepresentation, NULL);
+		SMVMwareNVRAMEntry	*pentry = SMVMwareNVRAMGetEntryAtIndex(pnvram, 2);
+		size_t				pcount = SMVMwareNVRAMEntryVariablesCount(pentry);
+		
+		for (size_t i = 0; i < pcount; i++)
+			SMVMwareNVRAMVariableGetAttributes(SMVMwareNVRAMEntryGetVariableAtIndex(pentry, i));
+		
+		SMVMwareNVRAMFree(pnvram);
+	};
+	
+	// Measure throughput.
+	NSUInteger		rounds = 200000 / count;
+	CFAbsoluteTime	start = CFAbsoluteTimeGetCurrent();
+	
+	for (NSUInteger i = 0; i < rounds; i++)
+		parse();
+	
+	CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - start;
+	
+	NSLog(@"parse %u variables: %.1f us/file, %.1f ns/variable", count, elapsed / rounds * 1000000.0, elapsed / (rounds * count) * 1000000000.0);
+	
+	// Measure.
+	[self measureBlock:^{
+		for (NSUInteger i = 0; i < rounds; i++)
+			parse();
+	}];
 }
 
 - (void)validateEFIVariableOfNVRAM:(SMVMwareNVRAM *)nvram guid:(efi_guid_t)guid name:(const char *)name value:(const void *)value size:(size_t)size
@@ -580,3 +1408,26 @@ typedef NS_ENUM(NSUInteger, SMModificationPhase)
 }
 
 @end
+
+
+/*
+** C Helpers
+*/
+#pragma mark - C Helpers
+
+static bool SMVariableIsPanicInfo(SMVMwareNVRAMEFIVariable *variable, void *context)
+{
+	const char *name = SMVMwareNVRAMVariableGetUTF8Name(variable, NULL);
+	
+	return (name && strncmp(name, "AAPL,PanicInfo", strlen("AAPL,PanicInfo")) == 0);
+}
+
+static bool SMVariableIsAny(SMVMwareNVRAMEFIVariable *variable, void *context)
+{
+	return true;
+}
+
+static void SMBytesReleaseCount(const void *bytes, size_t size, void *context)
+{
+	(*(unsigned *)context)++;
+}
@@ -0,0 +1,155 @@
+/*
+ *  SMVMwareVMXScannerTests.m
+ *
+ *  Copyright 2022 Avérous Julien-Pierre
+ *
+ *  This file is part of vm-config.
+ *
+ *  vm-config is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vm-config is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vm-config.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#import <XCTest/XCTest.h>
+
+#import "SMVMwareVMXScanner.h"
+
+#import "SMTestsTools.h"
+#import "SMTestCase.h"
+
+
+/*
+** SMVMwareVMXScannerTests
+*/
+#pragma mark - SMVMwareVMXScannerTests
+
+@interface SMVMwareVMXScannerTests : SMTestCase
+
+@end
+
+@implementation SMVMwareVMXScannerTests
+
+#pragma mark - Tests
+
+- (void)testScan
+{
+	const char	*bytes = "key = \"va\\\"lue\"\n# comment = \"x\"\nkey2=\"\"";
+	size_t		size = strlen(bytes);
+	size_t		count = 0;
+	uint32_t	*positions = SMVMwareVMXScannerScan(bytes, size, &count);
+
+	_onExit {
+		free(positions);
+	};
+
+	uint32_t expected[] = { 4, 6, 9, 10, 14, 15, 26, 28, 30, 31, 36, 37, 38 };
+
+	XCTAssertEqual(count, sizeof(expected) / sizeof(*expected));
+	XCTAssertEqual(memcmp(positions, expected, sizeof(expected)), 0);
+	XCTAssertEqual(positions[count], size);
+}
+
+- (void)testScanISAConsistency
+{
+	const char	alphabet[] = { 'a', ' ', '=', '"', '\\', '\n', '\t', '#' };
+
+	srandom(42);
+
+	for (unsigned i = 0; i < 2000; i++)
+	{
+		// Generate random buffer.
+		size_t	size = (size_t)(random() % 300);
+		char	*bytes = malloc(size + 1);
+
+		for (size_t j = 0; j < size; j++)
+			bytes[j] = alphabet[random() % sizeof(alphabet)];
+
+		// Scan with reference implementation.
+		size_t		ref_count = 0;
+		uint32_t	*ref_positions = SMVMwareVMXScannerScanWithISA(SMVMwareVMXScannerISAScalar, bytes, size, &ref_count);
+
+		// Compare with available SIMD implementations.
+		for (SMVMwareVMXScannerISA isa = SMVMwareVMXScannerISASSE2; isa <= SMVMwareVMXScannerISANEON; isa++)
+		{
+			if (!SMVMwareVMXScannerISAIsAvailable(isa))
+				continue;
+
+			size_t		count = 0;
+			uint32_t	*positions = SMVMwareVMXScannerScanWithISA(isa, bytes, size, &count);
+
+			XCTAssertEqual(count, ref_count, "invalid count for %s", SMVMwareVMXScannerISAGetName(isa));
+			XCTAssertEqual(memcmp(positions, ref_positions, (count + 1) * sizeof(uint32_t)), 0, "invalid positions for %s", SMVMwareVMXScannerISAGetName(isa));
+
+			free(positions);
+		}
+
+		free(ref_positions);
+		free(bytes);
+	}
+}
+
+- (void)testPerformanceScanScalar
+{
+	[self measureScanWithISA:SMVMwareVMXScannerISAScalar];
+}
+
+- (void)testPerformanceScanBest
+{
+	[self measureScanWithISA:SMVMwareVMXScannerGetBestISA()];
+}
+
+
+#pragma mark - Helpers
+
+- (NSData *)guestInfoVMXDataWithSize:(NSUInteger)size
+{
+	NSMutableData *data = [NSMutableData dataWithCapacity:size];
+
+	for (NSUInteger i = 0; data.length < size; i++)
+	{
+		NSString *line = [NSString stringWithFormat:@"guestinfo.key%lu = \"some guest info value number %lu with \\\"quotes\\\" inside\"\n", (unsigned long)i, (unsigned long)i];
+
+		[data appendData:[line dataUsingEncoding:NSUTF8StringEncoding]];
+	}
+
+	return data;
+}
+
+- (void)measureScanWithISA:(SMVMwareVMXScannerISA)isa
+{
+	NSData		*data = [self guestInfoVMXDataWithSize:8 * 1024 * 1024];
+	NSUInteger	rounds = 10;
+
+	// Measure throughput.
+	CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+
+	for (NSUInteger i = 0; i < rounds; i++)
+	{
+		size_t count = 0;
+
+		free(SMVMwareVMXScannerScanWithISA(isa, data.bytes, data.length, &count));
+	}
+
+	CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - start;
+
+	NSLog(@"scanner %s: %.0f MB/s", SMVMwareVMXScannerISAGetName(isa), (double)(data.length * rounds) / elapsed / 1000000.0);
+
+	// Measure.
+	[self measureBlock:^{
+		size_t count = 0;
+
+		free(SMVMwareVMXScannerScanWithISA(isa, data.bytes, data.length, &count));
+	}];
+}
+
+@end
@@ -42,6 +42,14 @@ typedef struct
 } SMVMXEntryTest;
 
 
+/*
+** Prototypes
+*/
+#pragma mark - Prototypes
+
+static bool SMVMXEntryIsGuestInfo(SMVMwareVMXEntry *entry, void *context);
+
+
 /*
 ** SMVMwareVMXTests
 */
@@ -191,6 +199,52 @@ typedef struct
 	SMErrorFree(error);
 }
 
+- (void)testLazyValuesParsing
+{
+	NSBundle	*bundle = [NSBundle bundleForClass:self.class];
+	SMError		*error = NULL;
+	
+	// Values are the same than in strict mode.
+	SMVMwareVMX *vmxStrict = [self vmxForFile:@"chaotic-1" error:&error];
+	SMVMwareVMX *vmxLazy = SMVMwareVMXOpenWithOptions([bundle pathForResource:@"chaotic-1" ofType:@"vmx"].fileSystemRepresentation, SMVMwareVMXOpenOptionLazyValues, &error);
+	
+	XCTAssert(vmxStrict, @"failed to parse file: %s", SMErrorGetUserInfo(error));
+	XCTAssert(vmxLazy, @"failed to parse file: %s", SMErrorGetUserInfo(error));
+	
+	_onExit {
+		SMVMwareVMXFree(vmxStrict);
+		SMVMwareVMXFree(vmxLazy);
+	};
+	
+	XCTAssertEqual(SMVMwareVMXEntriesCount(vmxStrict), SMVMwareVMXEntriesCount(vmxLazy));
+	
+	for (size_t i = 0; i < SMVMwareVMXEntriesCount(vmxStrict); i++)
+	{
+		SMVMwareVMXEntry *entryStrict = SMVMwareVMXGetEntryAtIndex(vmxStrict, i);
+		SMVMwareVMXEntry *entryLazy = SMVMwareVMXGetEntryAtIndex(vmxLazy, i);
+		
+		XCTAssertEqual(SMVMwareVMXEntryGetType(entryStrict), SMVMwareVMXEntryGetType(entryLazy));
+		
+		if (SMVMwareVMXEntryGetType(entryStrict) != SMVMwareVMXEntryTypeKeyValue)
+			continue;
+		
+		XCTAssertEqualStrings(SMVMwareVMXEntryGetValue(entryLazy, NULL), SMVMwareVMXEntryGetValue(entryStrict, NULL));
+	}
+	
+	// Malformed values are reported on read.
+	SMVMwareVMX *vmxFail = SMVMwareVMXOpenWithOptions([bundle pathForResource:@"fail-1" ofType:@"vmx"].fileSystemRepresentation, SMVMwareVMXOpenOptionLazyValues, &error);
+	
+	XCTAssert(vmxFail, @"failed to parse file: %s", SMErrorGetUserInfo(error));
+	
+	_onExit {
+		SMVMwareVMXFree(vmxFail);
+		SMErrorFree(error);
+	};
+	
+	XCTAssertEqual(SMVMwareVMXEntryGetValue(SMVMwareVMXGetEntryForKey(vmxFail, "key1"), &error), NULL);
+	XCTAssertNotEqual(error, NULL);
+}
+
 - (void)testParserStability
 {
 	// Parse file.
@@ -398,6 +452,316 @@ typedef struct
 	[[NSFileManager defaultManager] removeItemAtPath:modifiedFile error:nil];
 }
 
+- (void)testKeyIndex
+{
+	SMError *error = NULL;
+
+	// Parse file.
+	SMVMwareVMX *vmx = [self vmxForFile:@"chaotic-1" error:&error];
+	
+	XCTAssert(vmx, @"failed to parse file: %s", SMErrorGetUserInfo(error));
+	
+	_onExit {
+		SMVMwareVMXFree(vmx);
+	};
+	
+	// Duplicated keys: first entry in file order wins.
+	SMVMwareVMXEntry *entry6 = SMVMwareVMXGetEntryForKey(vmx, "key6");
+
+	XCTAssertEqual(entry6, SMVMwareVMXGetEntryAtIndex(vmx, 6));
+	XCTAssertEqual(SMVMwareVMXGetEntryForKey(vmx, "unknown-key"), NULL);
+	
+	// Rename key.
+	XCTAssertTrue(SMVMwareVMXEntrySetKey(entry6, "key6-renamed", NULL));
+	
+	XCTAssertEqual(SMVMwareVMXGetEntryForKey(vmx, "key6"), SMVMwareVMXGetEntryAtIndex(vmx, 7));
+	XCTAssertEqual(SMVMwareVMXGetEntryForKey(vmx, "key6-renamed"), entry6);
+	
+	// Restore key.
+	XCTAssertTrue(SMVMwareVMXEntrySetKey(entry6, "key6", NULL));
+	
+	XCTAssertEqual(SMVMwareVMXGetEntryForKey(vmx, "key6"), entry6);
+	XCTAssertEqual(SMVMwareVMXGetEntryForKey(vmx, "key6-renamed"), NULL);
+	
+	// Add key.
+	SMVMwareVMXEntry *entry11 = SMVMwareVMXAddEntryKeyValue(vmx, "key11", "value11", NULL);
+	
+	XCTAssertNotEqual(entry11, NULL);
+	XCTAssertEqual(SMVMwareVMXGetEntryForKey(vmx, "key11"), entry11);
+}
+
+- (void)testKeyIndexCaseInsensitive
+{
+	SMError *error = NULL;
+
+	// Parse file.
+	SMVMwareVMX *vmx = [self vmxForFile:@"chaotic-1" error:&error];
+	
+	XCTAssert(vmx, @"failed to parse file: %s", SMErrorGetUserInfo(error));
+	
+	_onExit {
+		SMVMwareVMXFree(vmx);
+	};
+	
+	// Lookup with different cases.
+	SMVMwareVMXEntry *entry6 = SMVMwareVMXGetEntryForKey(vmx, "key6");
+	
+	XCTAssertNotEqual(entry6, NULL);
+	XCTAssertEqual(SMVMwareVMXGetEntryForKey(vmx, "KEY6"), entry6);
+	XCTAssertEqual(SMVMwareVMXGetEntryForKey(vmx, "Key6"), entry6);
+	
+	// Original case is preserved.
+	XCTAssertEqualStrings(SMVMwareVMXEntryGetKey(entry6, NULL), "key6");
+	
+	// Rename with a different case.
+	XCTAssertTrue(SMVMwareVMXEntrySetKey(entry6, "Key6.Renamed", NULL));
+	
+	XCTAssertEqual(SMVMwareVMXGetEntryForKey(vmx, "key6.renamed"), entry6);
+	XCTAssertEqual(SMVMwareVMXNamespaceEntriesCount(vmx, "KEY6"), 1);
+	XCTAssertEqualStrings(SMVMwareVMXEntryGetKey(entry6, NULL), "Key6.Renamed");
+}
+
+- (void)testNamespaces
+{
+	// Generate & parse file.
+	NSString *path = SMGenerateTemporaryTestPath();
+	NSString *content = @"ethernet0.present = \"TRUE\"\n"
+						 "# A comment\n"
+						 "ethernet0.virtualDev = \"e1000\"\n"
+						 "ethernet1.present = \"TRUE\"\n"
+						 "ethernet0.pciSlotNumber = \"33\"\n"
+						 "sata0:1.fileName = \"disk.vmdk\"\n"
+						 "ethernet00.present = \"FALSE\"\n";
+	
+	[content writeToFile:path atomically:NO encoding:NSUTF8StringEncoding error:nil];
+	
+	SMError		*error = NULL;
+	SMVMwareVMX	*vmx = SMVMwareVMXOpen(path.fileSystemRepresentation, &error);
+	
+	XCTAssert(vmx, @"failed to parse file: %s", SMErrorGetUserInfo(error));
+	
+	_onExit {
+		SMVMwareVMXFree(vmx);
+		[[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+	};
+	
+	// Count.
+	XCTAssertEqual(SMVMwareVMXNamespaceEntriesCount(vmx, ""), 6);
+	XCTAssertEqual(SMVMwareVMXNamespaceEntriesCount(vmx, "ethernet0"), 3);
+	XCTAssertEqual(SMVMwareVMXNamespaceEntriesCount(vmx, "ethernet0.present"), 1);
+	XCTAssertEqual(SMVMwareVMXNamespaceEntriesCount(vmx, "sata0:1"), 1);
+	XCTAssertEqual(SMVMwareVMXNamespaceEntriesCount(vmx, "ethernet2"), 0);
+	
+	// Enumerate.
+	size_t				count = 0;
+	SMVMwareVMXEntry	**entries = SMVMwareVMXNamespaceCopyEntries(vmx, "ethernet0", &count);
+	
+	XCTAssertEqual(count, 3);
+	XCTAssertEqualStrings(SMVMwareVMXEntryGetKey(entries[0], NULL), "ethernet0.present");
+	XCTAssertEqualStrings(SMVMwareVMXEntryGetKey(entries[1], NULL), "ethernet0.virtualDev");
+	XCTAssertEqualStrings(SMVMwareVMXEntryGetKey(entries[2], NULL), "ethernet0.pciSlotNumber");
+	
+	free(entries);
+	
+	// Track keys changes.
+	SMVMwareVMXEntry *entry = SMVMwareVMXAddEntryKeyValue(vmx, "ethernet0.addressType", "generated", NULL);
+	
+	XCTAssertEqual(SMVMwareVMXNamespaceEntriesCount(vmx, "ethernet0"), 4);
+	XCTAssertTrue(SMVMwareVMXEntrySetKey(entry, "ethernet1.addressType", NULL));
+	XCTAssertEqual(SMVMwareVMXNamespaceEntriesCount(vmx, "ethernet0"), 3);
+	XCTAssertEqual(SMVMwareVMXNamespaceEntriesCount(vmx, "ethernet1"), 2);
+	
+	// Remove.
+	XCTAssertEqual(SMVMwareVMXNamespaceRemoveEntries(vmx, "ethernet0"), 3);
+	XCTAssertEqual(SMVMwareVMXNamespaceEntriesCount(vmx, "ethernet0"), 0);
+	XCTAssertEqual(SMVMwareVMXGetEntryForKey(vmx, "ethernet0.present"), NULL);
+	XCTAssertEqual(SMVMwareVMXEntriesCount(vmx), 5);
+	XCTAssertEqualStrings(SMVMwareVMXEntryGetKey(SMVMwareVMXGetEntryAtIndex(vmx, 1), NULL), "ethernet1.present");
+}
+
+- (void)testRemoveEntries
+{
+	SMError *error = NULL;
+	
+	// Generate & parse file.
+	NSString	*path = [self generateVMXWithEntriesCount:10];
+	SMVMwareVMX	*vmx = SMVMwareVMXOpen(path.fileSystemRepresentation, &error);
+	
+	XCTAssert(vmx, @"failed to parse file: %s", SMErrorGetUserInfo(error));
+	
+	_onExit {
+		SMVMwareVMXFree(vmx);
+		[[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+	};
+	
+	SMVMwareVMXAddEntryKeyValue(vmx, "displayName", "test", NULL);
+	
+	// Remove one entry.
+	SMVMwareVMXEntry *entry = SMVMwareVMXGetEntryForKey(vmx, "guestinfo.key3");
+	
+	SMVMwareVMXRemoveEntry(vmx, entry);
+	
+	XCTAssertEqual(SMVMwareVMXGetEntryForKey(vmx, "guestinfo.key3"), NULL);
+	XCTAssertEqual(SMVMwareVMXEntriesCount(vmx), 10);
+	XCTAssertEqualStrings(SMVMwareVMXEntryGetKey(SMVMwareVMXGetEntryAtIndex(vmx, 3), NULL), "guestinfo.key4");
+	
+	// Remove matching entries.
+	XCTAssertEqual(SMVMwareVMXRemoveEntriesMatching(vmx, SMVMXEntryIsGuestInfo, NULL), 9);
+	XCTAssertEqual(SMVMwareVMXEntriesCount(vmx), 1);
+	XCTAssertEqual(SMVMwareVMXGetEntryForKey(vmx, "guestinfo.key0"), NULL);
+	
+	// Write & reparse.
+	NSString *output = SMGenerateTemporaryTestPath();
+	
+	XCTAssertTrue(SMVMwareVMXWriteToFile(vmx, output.fileSystemRepresentation, &error), @"failed to write file: %s", SMErrorGetUserInfo(error));
+	
+	_onExit {
+		[[NSFileManager defaultManager] removeItemAtPath:output error:nil];
+	};
+	
+	NSString *content = [NSString stringWithContentsOfFile:output encoding:NSUTF8StringEncoding error:nil];
+	
+	XCTAssertEqualObjects(content, @"displayName = \"test\"\n");
+}
+
+- (void)testPerformanceRemoveEntries
+{
+	NSString *path = [self generateVMXWithEntriesCount:100000];
+	
+	_onExit {
+		[[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+	};
+	
+	[self measureMetrics:[[self class] defaultPerformanceMetrics] automaticallyStartMeasuring:NO forBlock:^{
+		SMVMwareVMX *vmx = SMVMwareVMXOpen(path.fileSystemRepresentation, NULL);
+		
+		// Remove every other entry, one by one: this should stay linear.
+		[self startMeasuring];
+		
+		for (size_t i = 0; i < 100000; i += 2)
+		{
+			char key[64];
+			
+			snprintf(key, sizeof(key), "guestinfo.key%lu", (unsigned long)i);
+			
+			SMVMwareVMXRemoveEntry(vmx, SMVMwareVMXGetEntryForKey(vmx, key));
+		}
+		
+		XCTAssertEqual(SMVMwareVMXEntriesCount(vmx), 50000);
+		
+		[self stopMeasuring];
+		
+		SMVMwareVMXFree(vmx);
+	}];
+}
+
+- (void)testPerformanceKeyLookup100
+{
+	[self measureKeyLookupWithEntriesCount:100];
+}
+
+- (void)testPerformanceKeyLookup1000
+{
+	[self measureKeyLookupWithEntriesCount:1000];
+}
+
+- (void)testPerformanceKeyLookup10000
+{
+	[self measureKeyLookupWithEntriesCount:10000];
+}
+
+- (void)testPerformanceKeyLookup100000
+{
+	[self measureKeyLookupWithEntriesCount:100000];
+}
+
+- (void)testPerformanceParsing10000
+{
+	[self measureParsingWithEntriesCount:10000];
+}
+
+- (void)testPerformanceParsing100000
+{
+	[self measureParsingWithEntriesCount:100000];
+}
+
+- (void)testPerformanceWriting10000
+{
+	[self measureWritingWithEntriesCount:10000];
+}
+
+- (void)testWritingUnchanged
+{
+	// > Original lines are written as slices of the mapped file, joined when contiguous. Lines are trimmed.
+	NSString *content = @"# comment\n\nkey1 = \"value1\"\n  key2=\"value2\"  \nkey3 = \"value3\"\n";
+	
+	[self checkWritingOfContent:content modifications:nil expectedContent:@"# comment\n\nkey1 = \"value1\"\nkey2=\"value2\"\nkey3 = \"value3\"\n"];
+	[self checkWritingOfContent:@"key1 = \"value1\"\nkey2 = \"value2\"" modifications:nil expectedContent:@"key1 = \"value1\"\nkey2 = \"value2\"\n"];
+	[self checkWritingOfContent:@"" modifications:nil expectedContent:@""];
+}
+
+- (void)testWritingEdited
+{
+	NSString *content = @"key1 = \"value1\"\n  key2=\"value2\"  \nkey3 = \"value3\"\nkey4 = \"value4\"";
+	
+	[self checkWritingOfContent:content modifications:^(SMVMwareVMX *vmx) {
+		XCTAssertTrue(SMVMwareVMXEntrySetValue(SMVMwareVMXGetEntryForKey(vmx, "key2"), "new2", NULL));
+		XCTAssertTrue(SMVMwareVMXEntrySetValue(SMVMwareVMXGetEntryForKey(vmx, "key4"), "new4", NULL));
+	} expectedContent:@"key1 = \"value1\"\nkey2 = \"new2\"\nkey3 = \"value3\"\nkey4 = \"new4\"\n"];
+}
+
+- (void)testWritingRemovedAndAdded
+{
+	NSString *content = @"key1 = \"value1\"\nkey2 = \"value2\"\n# comment\nkey3 = \"value3\"\nkey4 = \"value4\"";
+	
+	[self checkWritingOfContent:content modifications:^(SMVMwareVMX *vmx) {
+		SMVMwareVMXRemoveEntry(vmx, SMVMwareVMXGetEntryForKey(vmx, "key2"));
+		SMVMwareVMXRemoveEntry(vmx, SMVMwareVMXGetEntryForKey(vmx, "key4"));
+		
+		XCTAssertNotEqual(SMVMwareVMXAddEntryKeyValue(vmx, "key5", "value5", NULL), NULL);
+	} expectedContent:@"key1 = \"value1\"\n# comment\nkey3 = \"value3\"\nkey5 = \"value5\"\n"];
+	
+	// > Last line without new line kept, and followed by an added one.
+	[self checkWritingOfContent:content modifications:^(SMVMwareVMX *vmx) {
+		SMVMwareVMXRemoveEntry(vmx, SMVMwareVMXGetEntryForKey(vmx, "key1"));
+		
+		XCTAssertNotEqual(SMVMwareVMXAddEntryKeyValue(vmx, "key5", "value5", NULL), NULL);
+	} expectedContent:@"key2 = \"value2\"\n# comment\nkey3 = \"value3\"\nkey4 = \"value4\"\nkey5 = \"value5\"\n"];
+}
+
+- (void)testWritingBigFile
+{
+	// > More vectors than a single writev() call accepts, with edits, removals & additions in the middle.
+	NSMutableString *content = [NSMutableString string];
+	NSMutableString *expected = [NSMutableString string];
+	
+	for (NSUInteger i = 0; i < 5000; i++)
+	{
+		[content appendFormat:@"key%lu = \"value%lu\"\n", (unsigned long)i, (unsigned long)i];
+		
+		if (i % 3 == 0)
+			[expected appendFormat:@"key%lu = \"edited\"\n", (unsigned long)i];
+		else if (i % 3 == 1)
+			[expected appendFormat:@"key%lu = \"value%lu\"\n", (unsigned long)i, (unsigned long)i];
+	}
+	
+	[expected appendString:@"added = \"1\"\n"];
+	
+	[self checkWritingOfContent:content modifications:^(SMVMwareVMX *vmx) {
+		for (NSUInteger i = 0; i < 5000; i++)
+		{
+			SMVMwareVMXEntry *entry = SMVMwareVMXGetEntryForKey(vmx, [NSString stringWithFormat:@"key%lu", (unsigned long)i].UTF8String);
+			
+			if (i % 3 == 0)
+				XCTAssertTrue(SMVMwareVMXEntrySetValue(entry, "edited", NULL));
+			else if (i % 3 == 2)
+				SMVMwareVMXRemoveEntry(vmx, entry);
+		}
+		
+		XCTAssertNotEqual(SMVMwareVMXAddEntryKeyValue(vmx, "added", "1", NULL), NULL);
+	} expectedContent:expected];
+}
+
 - (void)testDetailedDataParsing
 {
 	// Valid 1.
@@ -505,6 +869,146 @@ typedef struct
 	return SMVMwareVMXOpen(path.fileSystemRepresentation, error);
 }
 
+- (NSString *)generateVMXWithEntriesCount:(NSUInteger)count
+{
+	NSString		*path = SMGenerateTemporaryTestPath();
+	NSMutableString	*content = [NSMutableString string];
+	
+	for (NSUInteger i = 0; i < count; i++)
+		[content appendFormat:@"guestinfo.key%lu = \"value%lu\"\n", (unsigned long)i, (unsigned long)i];
+	
+	[content writeToFile:path atomically:NO encoding:NSUTF8StringEncoding error:nil];
+	
+	return path;
+}
+
+- (void)measureKeyLookupWithEntriesCount:(NSUInteger)count
+{
+	// Generate & parse file.
+	NSString	*path = [self generateVMXWithEntriesCount:count];
+	SMError		*error = NULL;
+	SMVMwareVMX	*vmx = SMVMwareVMXOpen(path.fileSystemRepresentation, &error);
+	
+	XCTAssert(vmx, @"failed to parse file: %s", SMErrorGetUserInfo(error));
+	
+	_onExit {
+		SMVMwareVMXFree(vmx);
+		[[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+	};
+	
+	// Forge keys to lookup.
+	const size_t	lookups_count = 100000;
+	char			**keys = calloc(lookups_count, sizeof(char *));
+	
+	for (size_t i = 0; i < lookups_count; i++)
+		asprintf(&keys[i], "guestinfo.key%lu", (unsigned long)((i * 7919) % count));
+	
+	_onExit {
+		for (size_t i = 0; i < lookups_count; i++)
+			free(keys[i]);
+		
+		free(keys);
+	};
+	
+	// Measure: the cost should stay flat whatever the number of entries.
+	[self measureBlock:^{
+		size_t found = 0;
+		
+		for (size_t i = 0; i < lookups_count; i++)
+			found += (SMVMwareVMXGetEntryForKey(vmx, keys[i]) != NULL);
+		
+		XCTAssertEqual(found, lookups_count);
+	}];
+}
+
+- (void)measureParsingWithEntriesCount:(NSUInteger)count
+{
+	// Generate file.
+	NSString *path = [self generateVMXWithEntriesCount:count];
+	
+	_onExit {
+		[[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+	};
+	
+	// Measure: entries are only referenced in the mapping, nothing is materialized.
+	[self measureBlock:^{
+		SMError		*error = NULL;
+		SMVMwareVMX	*vmx = SMVMwareVMXOpen(path.fileSystemRepresentation, &error);
+		
+		XCTAssert(vmx, @"failed to parse file: %s", SMErrorGetUserInfo(error));
+		XCTAssertEqual(SMVMwareVMXEntriesCount(vmx), count);
+		
+		SMVMwareVMXFree(vmx);
+	}];
+}
+
+- (void)measureWritingWithEntriesCount:(NSUInteger)count
+{
+	// Generate & parse file.
+	NSString	*path = [self generateVMXWithEntriesCount:count];
+	SMError		*error = NULL;
+	SMVMwareVMX	*vmx = SMVMwareVMXOpen(path.fileSystemRepresentation, &error);
+	
+	XCTAssert(vmx, @"failed to parse file: %s", SMErrorGetUserInfo(error));
+	
+	_onExit {
+		SMVMwareVMXFree(vmx);
+		[[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+	};
+	
+	// Update some entries, so we mix original slices and serialized lines.
+	for (NSUInteger i = 0; i < count; i += 100)
+	{
+		char key[64];
+		
+		snprintf(key, sizeof(key), "guestinfo.key%lu", (unsigned long)i);
+		
+		XCTAssertTrue(SMVMwareVMXEntrySetValue(SMVMwareVMXGetEntryForKey(vmx, key), "updated", NULL));
+	}
+	
+	// Measure.
+	[self measureBlock:^{
+		NSString *output = SMGenerateTemporaryTestPath();
+		
+		XCTAssertTrue(SMVMwareVMXWriteToFile(vmx, output.fileSystemRepresentation, NULL));
+		
+		[[NSFileManager defaultManager] removeItemAtPath:output error:nil];
+	}];
+}
+
+- (void)checkWritingOfContent:(NSString *)content modifications:(void (^)(SMVMwareVMX *vmx))modifications expectedContent:(NSString *)expectedContent
+{
+	NSString	*inputPath = SMGenerateTemporaryTestPath();
+	NSString	*outputPath = SMGenerateTemporaryTestPath();
+	SMError		*error = NULL;
+	
+	_onExit {
+		[[NSFileManager defaultManager] removeItemAtPath:inputPath error:nil];
+		[[NSFileManager defaultManager] removeItemAtPath:outputPath error:nil];
+	};
+	
+	XCTAssertTrue([content writeToFile:inputPath atomically:NO encoding:NSUTF8StringEncoding error:nil]);
+	
+	// Open, modify & write.
+	SMVMwareVMX *vmx = SMVMwareVMXOpen(inputPath.fileSystemRepresentation, &error);
+	
+	XCTAssertNotEqual(vmx, NULL, "failed to open file: %s", SMErrorGetUserInfo(error));
+	
+	if (modifications)
+		modifications(vmx);
+	
+	XCTAssertTrue(SMVMwareVMXWriteToFile(vmx, outputPath.fileSystemRepresentation, &error), "failed to write file: %s", SMErrorGetUserInfo(error));
+	
+	SMVMwareVMXFree(vmx);
+	SMErrorFree(error);
+	
+	// Compare bytes.
+	NSData *output = [NSData dataWithContentsOfFile:outputPath];
+	NSData *expected = [expectedContent dataUsingEncoding:NSUTF8StringEncoding];
+	
+	XCTAssertEqualObjects(output, expected, "'%@' != '%@'", [[NSString alloc] initWithData:output encoding:NSUTF8StringEncoding], expectedContent);
+}
+
 - (NSDictionary *)dictionaryFromFields:(SMDetailedField *)fields freeFields:(BOOL)freeFields
 {
 	if (!fields)
@@ -581,3 +1085,16 @@ typedef struct
 }
 
 @end
+
+
+/*
+** C Helpers
+*/
+#pragma mark - C Helpers
+
+static bool SMVMXEntryIsGuestInfo(SMVMwareVMXEntry *entry, void *context)
+{
+	const char *key = SMVMwareVMXEntryGetKey(entry, NULL);
+	
+	return (key && strncmp(key, "guestinfo.", strlen("guestinfo.")) == 0);
+}
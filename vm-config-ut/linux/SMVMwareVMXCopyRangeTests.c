@@ -0,0 +1,415 @@
+/*
+ *  SMVMwareVMXCopyRangeTests.c
+ *
+ *  Copyright 2022 Avérous Julien-Pierre
+ *
+ *  This file is part of vm-config.
+ *
+ *  vm-config is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vm-config is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vm-config.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+// Rewrites of big VMX files copy unchanged slices kernel-side (FICLONERANGE, copy_file_range), which only exists on Linux.
+// > XCTest based unit tests run on macOS, so these paths are tested here, with ctest.
+// > writev() and ioctl() are interposed to force short writes, and to emulate cloning on file systems which don't support it.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <dlfcn.h>
+
+#include <sys/uio.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+
+#include "SMVMwareVMX.h"
+
+
+/*
+** Defines
+*/
+#pragma mark - Defines
+
+#define SMTestAssert(Condition) do {												\
+	if (!(Condition))																\
+	{																				\
+		fprintf(stderr, "%s:%d: assertion failed: %s\n", __FILE__, __LINE__, #Condition);	\
+		g_failures++;																\
+	}																				\
+} while (0)
+
+#define SMTestShortWriteSize	4096
+#define SMTestLineFormat		"key%06zu.sub = \"value number %zu, with some padding to make lines longer\""
+
+
+/*
+** Globals
+*/
+#pragma mark - Globals
+
+static size_t	g_failures = 0;
+
+static bool		g_short_writes = false;
+static bool		g_emulate_clone = false;
+
+static size_t	g_clones_cnt = 0;
+static size_t	g_copies_cnt = 0;
+
+
+/*
+** Prototypes
+*/
+#pragma mark - Prototypes
+
+static void test_round_trip(const char *directory, size_t lines_cnt, bool trailing_new_line);
+static void test_aligned_clone_after_short_write(const char *directory);
+
+static void SMTestCheckFile(const char *path, const char *expected, size_t expected_size);
+
+
+/*
+** Main
+*/
+#pragma mark - Main
+
+int main(int argc, const char *argv[])
+{
+	char directory[] = "/tmp/vm-config-tests-XXXXXX";
+
+	if (!mkdtemp(directory))
+	{
+		perror("mkdtemp");
+		return 1;
+	}
+
+	// Kernel copies, as supported by the file system.
+	for (int trailing = 0; trailing < 2; trailing++)
+	{
+		test_round_trip(directory, 5, trailing);
+		test_round_trip(directory, 3000, trailing);
+	}
+
+	SMTestAssert(g_copies_cnt + g_clones_cnt > 0);
+
+	// Short writes & cloning.
+	g_short_writes = true;
+	g_emulate_clone = true;
+
+	for (int trailing = 0; trailing < 2; trailing++)
+		test_round_trip(directory, 3000, trailing);
+
+	test_aligned_clone_after_short_write(directory);
+
+	SMTestAssert(g_clones_cnt > 0);
+
+	// Clean.
+	rmdir(directory);
+
+	if (g_failures > 0)
+	{
+		fprintf(stderr, "%zu failure(s)\n", g_failures);
+		return 1;
+	}
+
+	return 0;
+}
+
+
+/*
+** Tests
+*/
+#pragma mark - Tests
+
+static void test_round_trip(const char *directory, size_t lines_cnt, bool trailing_new_line)
+{
+	char src_path[PATH_MAX];
+	char dst_path[PATH_MAX];
+
+	snprintf(src_path, sizeof(src_path), "%s/src.vmx", directory);
+	snprintf(dst_path, sizeof(dst_path), "%s/dst.vmx", directory);
+
+	// Write source.
+	char	**lines = calloc(lines_cnt, sizeof(char *));
+	FILE	*file = fopen(src_path, "w");
+
+	SMTestAssert(lines && file);
+
+	for (size_t i = 0; i < lines_cnt; i++)
+	{
+		asprintf(&lines[i], SMTestLineFormat, i, i);
+
+		fputs(lines[i], file);
+
+		if (i + 1 < lines_cnt || trailing_new_line)
+			fputc('\n', file);
+	}
+
+	fclose(file);
+
+	// Edit before, between and after copied slices.
+	SMVMwareVMX *vmx = SMVMwareVMXOpen(src_path, NULL);
+
+	SMTestAssert(vmx);
+
+	size_t edited[] = { 0, lines_cnt / 3, lines_cnt / 2, lines_cnt - 1 };
+	size_t removed[] = { 1, lines_cnt / 3 + 1, 2 * lines_cnt / 3 };
+
+	for (size_t i = 0; i < sizeof(edited) / sizeof(*edited); i++)
+	{
+		char key[32];
+
+		snprintf(key, sizeof(key), "key%06zu.sub", edited[i]);
+
+		SMTestAssert(SMVMwareVMXEntrySetValue(SMVMwareVMXGetEntryForKey(vmx, key), "edited", NULL));
+
+		free(lines[edited[i]]);
+		asprintf(&lines[edited[i]], "%s = \"edited\"", key);
+	}
+
+	for (size_t i = 0; i < sizeof(removed) / sizeof(*removed); i++)
+	{
+		char				key[32];
+		SMVMwareVMXEntry	*entry;
+
+		snprintf(key, sizeof(key), "key%06zu.sub", removed[i]);
+
+		// > Some indexes are the same on small files.
+		if ((entry = SMVMwareVMXGetEntryForKey(vmx, key)))
+			SMVMwareVMXRemoveEntry(vmx, entry);
+
+		free(lines[removed[i]]);
+		lines[removed[i]] = NULL;
+	}
+
+	SMTestAssert(SMVMwareVMXAddEntryKeyValue(vmx, "added", "1", NULL));
+
+	// Write & check.
+	unlink(dst_path);
+
+	SMTestAssert(SMVMwareVMXWriteToFile(vmx, dst_path, NULL));
+
+	char	*expected = NULL;
+	size_t	expected_size = 0;
+	FILE	*output = open_memstream(&expected, &expected_size);
+
+	for (size_t i = 0; i < lines_cnt; i++)
+	{
+		if (lines[i])
+			fprintf(output, "%s\n", lines[i]);
+	}
+
+	fprintf(output, "added = \"1\"\n");
+	fclose(output);
+
+	SMTestCheckFile(dst_path, expected, expected_size);
+
+	// Clean.
+	for (size_t i = 0; i < lines_cnt; i++)
+		free(lines[i]);
+
+	free(lines);
+	free(expected);
+
+	SMVMwareVMXFree(vmx);
+
+	unlink(src_path);
+	unlink(dst_path);
+}
+
+static void test_aligned_clone_after_short_write(const char *directory)
+{
+	// > A first line of 8191 bytes + new line, replaced by a line of the same size: the next slice is block aligned
+	// > in both files, and is cloned once the first line is written in two short writes.
+	char src_path[PATH_MAX];
+	char dst_path[PATH_MAX];
+
+	snprintf(src_path, sizeof(src_path), "%s/src.vmx", directory);
+	snprintf(dst_path, sizeof(dst_path), "%s/dst.vmx", directory);
+
+	size_t	value_size = 8191 - strlen("key = \"\"");
+	char	*value = malloc(value_size + 1);
+	char	*new_value = malloc(value_size + 1);
+
+	SMTestAssert(value && new_value);
+
+	memset(value, 'a', value_size);
+	memset(new_value, 'b', value_size);
+
+	value[value_size] = 0;
+	new_value[value_size] = 0;
+
+	// Write source.
+	FILE *file = fopen(src_path, "w");
+
+	SMTestAssert(file);
+
+	fprintf(file, "key = \"%s\"\n", value);
+
+	for (size_t i = 0; i < 2000; i++)
+		fprintf(file, SMTestLineFormat "\n", i, i);
+
+	fclose(file);
+
+	// Edit & write.
+	SMVMwareVMX *vmx = SMVMwareVMXOpen(src_path, NULL);
+	size_t		clones_cnt = g_clones_cnt;
+
+	SMTestAssert(vmx);
+	SMTestAssert(SMVMwareVMXEntrySetValue(SMVMwareVMXGetEntryForKey(vmx, "key"), new_value, NULL));
+
+	unlink(dst_path);
+
+	SMTestAssert(SMVMwareVMXWriteToFile(vmx, dst_path, NULL));
+	SMTestAssert(g_clones_cnt > clones_cnt);
+
+	// Check.
+	char	*expected = NULL;
+	size_t	expected_size = 0;
+	FILE	*output = open_memstream(&expected, &expected_size);
+
+	fprintf(output, "key = \"%s\"\n", new_value);
+
+	for (size_t i = 0; i < 2000; i++)
+		fprintf(output, SMTestLineFormat "\n", i, i);
+
+	fclose(output);
+
+	SMTestCheckFile(dst_path, expected, expected_size);
+
+	// Clean.
+	free(value);
+	free(new_value);
+	free(expected);
+
+	SMVMwareVMXFree(vmx);
+
+	unlink(src_path);
+	unlink(dst_path);
+}
+
+
+/*
+** Interposed
+*/
+#pragma mark - Interposed
+
+ssize_t writev(int fd, const struct iovec *iov, int iovcnt)
+{
+	static ssize_t (*real_writev)(int, const struct iovec *, int) = NULL;
+
+	if (!real_writev)
+		real_writev = (ssize_t (*)(int, const struct iovec *, int))dlsym(RTLD_NEXT, "writev");
+
+	if (!g_short_writes)
+		return real_writev(fd, iov, iovcnt);
+
+	// > Write at most SMTestShortWriteSize bytes.
+	struct iovec	short_iov[16];
+	int				short_iovcnt = 0;
+	size_t			remaining = SMTestShortWriteSize;
+
+	for (int i = 0; i < iovcnt && i < 16 && remaining > 0; i++)
+	{
+		short_iov[i] = iov[i];
+
+		if (short_iov[i].iov_len > remaining)
+			short_iov[i].iov_len = remaining;
+
+		remaining -= short_iov[i].iov_len;
+		short_iovcnt++;
+	}
+
+	return real_writev(fd, short_iov, short_iovcnt);
+}
+
+int ioctl(int fd, unsigned long request, ...)
+{
+	static int (*real_ioctl)(int, unsigned long, ...) = NULL;
+
+	va_list	ap;
+	void	*arg;
+
+	va_start(ap, request);
+	arg = va_arg(ap, void *);
+	va_end(ap);
+
+	if (request == FICLONERANGE && g_emulate_clone)
+	{
+		// > Put bytes at the destination offset, as a file system supporting reflinks would.
+		const struct file_clone_range	*range = arg;
+		char							*bytes = malloc(range->src_length);
+
+		if (!bytes || pread((int)range->src_fd, bytes, range->src_length, (off_t)range->src_offset) != (ssize_t)range->src_length)
+			abort();
+
+		if (pwrite(fd, bytes, range->src_length, (off_t)range->dest_offset) != (ssize_t)range->src_length)
+			abort();
+
+		free(bytes);
+
+		g_clones_cnt++;
+
+		return 0;
+	}
+
+	if (!real_ioctl)
+		real_ioctl = (int (*)(int, unsigned long, ...))dlsym(RTLD_NEXT, "ioctl");
+
+	int result = real_ioctl(fd, request, arg);
+
+	if (request == FICLONERANGE && result == 0)
+		g_clones_cnt++;
+
+	return result;
+}
+
+ssize_t copy_file_range(int fd_in, off_t *off_in, int fd_out, off_t *off_out, size_t len, unsigned int flags)
+{
+	static ssize_t (*real_copy_file_range)(int, off_t *, int, off_t *, size_t, unsigned int) = NULL;
+
+	if (!real_copy_file_range)
+		real_copy_file_range = (ssize_t (*)(int, off_t *, int, off_t *, size_t, unsigned int))dlsym(RTLD_NEXT, "copy_file_range");
+
+	ssize_t result = real_copy_file_range(fd_in, off_in, fd_out, off_out, len, flags);
+
+	if (result > 0)
+		g_copies_cnt++;
+
+	return result;
+}
+
+
+/*
+** Helpers
+*/
+#pragma mark - Helpers
+
+static void SMTestCheckFile(const char *path, const char *expected, size_t expected_size)
+{
+	FILE	*file = fopen(path, "r");
+	char	*bytes = malloc(expected_size + 1);
+
+	SMTestAssert(file && bytes);
+
+	size_t size = fread(bytes, 1, expected_size + 1, file);
+
+	SMTestAssert(size == expected_size);
+	SMTestAssert(memcmp(bytes, expected, expected_size) == 0);
+
+	fclose(file);
+	free(bytes);
+}
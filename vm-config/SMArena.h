@@ -0,0 +1,203 @@
+/*
+ *  SMArena.h
+ *
+ *  Copyright 2022 Avérous Julien-Pierre
+ *
+ *  This file is part of vm-config.
+ *
+ *  vm-config is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vm-config is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vm-config.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+
+
+/*
+** Defines
+*/
+#pragma mark - Defines
+
+#define SMArenaInit() { 0 }
+
+#define SMArenaAlignment		16
+#define SMArenaMinChunkSize		(4 * 1024)
+#define SMArenaMaxChunkSize		(1024 * 1024)
+
+
+/*
+** Types
+*/
+#pragma mark - Types
+
+typedef struct SMArenaChunk SMArenaChunk;
+
+struct SMArenaChunk
+{
+	SMArenaChunk	*next;
+
+	size_t			size;
+	size_t			used;
+
+	_Alignas(SMArenaAlignment) char bytes[];
+};
+
+typedef struct SMArena
+{
+	SMArenaChunk	*chunk; // Current chunk, linked to previous ones.
+	size_t			chunk_size;
+} SMArena;
+
+
+/*
+** Functions
+*/
+#pragma mark - Functions
+
+#pragma mark > Helpers
+
+static inline
+void * SMArenaAllocSlow(SMArena *arena, size_t size)
+{
+	// Forge chunk size: grow geometrically to limit the number of chunks on big documents.
+	if (arena->chunk_size == 0)
+		arena->chunk_size = SMArenaMinChunkSize;
+	else if (arena->chunk_size < SMArenaMaxChunkSize)
+		arena->chunk_size *= 2;
+
+	size_t chunk_size = (size > arena->chunk_size ? size : arena->chunk_size);
+
+	// Allocate chunk.
+	SMArenaChunk *chunk = malloc(sizeof(SMArenaChunk) + chunk_size);
+
+	assert(chunk);
+
+	chunk->size = chunk_size;
+	chunk->used = size;
+
+	// Link chunk.
+	// > Oversized allocation: keep the current chunk as the bump target.
+	if (arena->chunk && size > arena->chunk_size)
+	{
+		chunk->next = arena->chunk->next;
+		arena->chunk->next = chunk;
+	}
+
+	// > Regular allocation: the new chunk becomes the bump target.
+	else
+	{
+		chunk->next = arena->chunk;
+		arena->chunk = chunk;
+	}
+
+	return chunk->bytes;
+}
+
+
+#pragma mark > Instance
+
+static __attribute__((always_inline)) inline
+void SMArenaFree(SMArena *arena)
+{
+	SMArenaChunk *chunk = arena->chunk;
+
+	while (chunk)
+	{
+		SMArenaChunk *next = chunk->next;
+
+		free(chunk);
+		chunk = next;
+	}
+
+	arena->chunk = NULL;
+	arena->chunk_size = 0;
+}
+
+
+#pragma mark > Allocation
+
+static __attribute__((always_inline)) inline
+void * SMArenaAlloc(SMArena *arena, size_t size)
+{
+	SMArenaChunk	*chunk = arena->chunk;
+	size_t			asize = (size + (SMArenaAlignment - 1)) & ~(size_t)(SMArenaAlignment - 1);
+
+	if (chunk && chunk->size - chunk->used >= asize)
+	{
+		void *result = chunk->bytes + chunk->used;
+
+		chunk->used += asize;
+
+		return result;
+	}
+
+	return SMArenaAllocSlow(arena, asize);
+}
+
+static __attribute__((always_inline)) inline
+void * SMArenaCalloc(SMArena *arena, size_t size)
+{
+	void *result = SMArenaAlloc(arena, size);
+
+	memset(result, 0, size);
+
+	return result;
+}
+
+
+#pragma mark > Strings
+
+static __attribute__((always_inline)) inline
+char * SMArenaStringDuplicate(SMArena *arena, const char *str, size_t len)
+{
+	char *result = SMArenaAlloc(arena, len + 1);
+
+	memcpy(result, str, len);
+	result[len] = 0;
+
+	return result;
+}
+
+static inline
+int SMArenaStringPrintf(SMArena *arena, char **str, const char *format, ...)
+{
+	va_list ap;
+
+	// Compute size.
+	va_start(ap, format);
+	int len = vsnprintf(NULL, 0, format, ap);
+	va_end(ap);
+
+	if (len < 0)
+	{
+		*str = NULL;
+		return len;
+	}
+
+	// Print.
+	*str = SMArenaAlloc(arena, (size_t)len + 1);
+
+	va_start(ap, format);
+	vsnprintf(*str, (size_t)len + 1, format, ap);
+	va_end(ap);
+
+	return len;
+}
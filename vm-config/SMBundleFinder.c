@@ -0,0 +1,169 @@
+/*
+ *  SMBundleFinder.c
+ *
+ *  Copyright 2022 Avérous Julien-Pierre
+ *
+ *  This file is part of vm-config.
+ *
+ *  vm-config is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vm-config is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vm-config.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <dirent.h>
+
+#include <sys/stat.h>
+
+#include "SMBundleFinder.h"
+
+#include "SMStringHelper.h"
+
+
+/*
+** Types
+*/
+#pragma mark - Types
+
+typedef struct
+{
+	const char				*extension;
+	SMBundleFinderHandler	handler;
+	void					*context;
+} SMBundleFinder;
+
+typedef struct
+{
+	SMBundleFinder	*finder;
+	char			*path;
+} SMBundleFinderDirectory;
+
+
+/*
+** Prototypes
+*/
+#pragma mark - Prototypes
+
+static void SMBundleFinderWalkDirectory(SMThreadPool *pool, void *context);
+static void SMBundleFinderAddDirectory(SMThreadPool *pool, SMBundleFinder *finder, char *path);
+
+
+
+/*
+** Functions
+*/
+#pragma mark - Functions
+
+bool SMBundleFinderWalk(SMThreadPool *pool, const char *root_path, const char *extension, SMBundleFinderHandler handler, void *context, SMError **error)
+{
+	SMBundleFinder finder = { .extension = extension, .handler = handler, .context = context };
+
+	// Check root.
+	struct stat st;
+
+	if (stat(root_path, &st) == -1)
+	{
+		SMSetErrorPtr(error, "bundle-finder", -1, "can't access library '%s' (%d - %s)", root_path, errno, strerror(errno));
+		return false;
+	}
+
+	if (!S_ISDIR(st.st_mode))
+	{
+		SMSetErrorPtr(error, "bundle-finder", -1, "library '%s' is not a directory", root_path);
+		return false;
+	}
+
+	// Walk.
+	char *path = strdup(root_path);
+
+	assert(path);
+
+	if (SMStringPathHasExtension(root_path, extension))
+		handler(pool, path, context);
+	else
+		SMBundleFinderAddDirectory(pool, &finder, path);
+
+	SMThreadPoolWait(pool);
+
+	return true;
+}
+
+static void SMBundleFinderAddDirectory(SMThreadPool *pool, SMBundleFinder *finder, char *path)
+{
+	SMBundleFinderDirectory *directory = malloc(sizeof(SMBundleFinderDirectory));
+
+	assert(directory);
+
+	directory->finder = finder;
+	directory->path = path;
+
+	SMThreadPoolAddTask(pool, SMBundleFinderWalkDirectory, directory);
+}
+
+static void SMBundleFinderWalkDirectory(SMThreadPool *pool, void *context)
+{
+	SMBundleFinderDirectory	*directory = context;
+	SMBundleFinder			*finder = directory->finder;
+
+	// Open directory.
+	// > readdir() fills its entries buffer with large getdents64 / getdirentries64 batches, and d_type saves a stat() per entry.
+	DIR *dir = opendir(directory->path);
+
+	if (!dir)
+		goto clean;
+
+	// Handle entries.
+	struct dirent *dp;
+
+	while ((dp = readdir(dir)) != NULL)
+	{
+		const char *name = dp->d_name;
+
+		if (name[0] == '.' && (name[1] == 0 || (name[1] == '.' && name[2] == 0)))
+			continue;
+
+		// > Keep directories only, without following symbolic links.
+		unsigned char type = dp->d_type;
+
+		if (type == DT_UNKNOWN)
+		{
+			struct stat st;
+
+			if (fstatat(dirfd(dir), name, &st, AT_SYMLINK_NOFOLLOW) == -1)
+				continue;
+
+			type = (S_ISDIR(st.st_mode) ? DT_DIR : DT_REG);
+		}
+
+		if (type != DT_DIR)
+			continue;
+
+		// > Bundle: give it to handler right away. Else walk it in its own task.
+		char *path = SMStringPathAppendComponent(directory->path, name);
+
+		if (SMStringPathHasExtension(name, finder->extension))
+			finder->handler(pool, path, finder->context);
+		else
+			SMBundleFinderAddDirectory(pool, finder, path);
+	}
+
+	closedir(dir);
+
+clean:
+	free(directory->path);
+	free(directory);
+}
@@ -0,0 +1,47 @@
+/*
+ *  SMBundleFinder.h
+ *
+ *  Copyright 2022 Avérous Julien-Pierre
+ *
+ *  This file is part of vm-config.
+ *
+ *  vm-config is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vm-config is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vm-config.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+#include "SMError.h"
+#include "SMThreadPool.h"
+
+
+/*
+** Types
+*/
+#pragma mark - Types
+
+// > Called concurrently (from pool workers) as soon as a bundle is found. The handler owns bundle_path (to free).
+typedef void (*SMBundleFinderHandler)(SMThreadPool *pool, char *bundle_path, void *context);
+
+
+/*
+** Functions
+*/
+#pragma mark - Functions
+
+// > Walks root_path in parallel on pool, one task per directory, and calls handler for each directory with this extension (not walked).
+// > Symbolic links are not followed, and unreadable sub-directories are skipped. Returns once the walk and tasks added by handler are done.
+bool SMBundleFinderWalk(SMThreadPool *pool, const char *root_path, const char *extension, SMBundleFinderHandler handler, void *context, SMError **error);
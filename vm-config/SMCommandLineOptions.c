@@ -66,6 +66,7 @@ typedef struct
 	uint64_t identifier;
 	
 	bool optional;
+	bool variadic; // Values only.
 	
 	char	*name;
 	char	short_name;
@@ -235,6 +236,19 @@ void SMCLOptionsVerbAddValue(SMCLOptionsVerb *verb, uint64_t identifier, const c
 	parameter->description =strdup(description);
 }
 
+void SMCLOptionsVerbAddVariadicValue(SMCLOptionsVerb *verb, uint64_t identifier, bool optional, const char *name, const char *description)
+{
+	SMCLOptionsParameter *parameter = SMCLVerbAddParameter(verb);
+	
+	parameter->type = SMCLOptionsParameterTypeValue;
+	
+	parameter->identifier = identifier;
+	parameter->optional = optional;
+	parameter->variadic = true;
+	parameter->name = strdup(name);
+	parameter->description = strdup(description);
+}
+
 void SMCLOptionsVerbAddOption(SMCLOptionsVerb *verb, uint64_t identifier, bool optional, const char *name, char short_name, const char *description)
 {
 	SMCLOptionsParameter *parameter = SMCLVerbAddParameter(verb);
@@ -381,7 +395,12 @@ static char * SMCLFormatParameterName(SMCLOptionsParameter *parameter)
 	{
 		case SMCLOptionsParameterTypeValue:
 		{
-			asprintf(&result, "%s", parameter->name);
+			if (parameter->variadic && parameter->optional)
+				asprintf(&result, "[%s...]", parameter->name);
+			else if (parameter->variadic)
+				asprintf(&result, "%s...", parameter->name);
+			else
+				asprintf(&result, "%s", parameter->name);
 			break;
 		}
 			
@@ -487,7 +506,9 @@ SMCLOptionsResult * SMCLOptionsParse(SMCLOptions *options, int argc, const char
 	memcpy(parameters, verb->parameters, verb->parameters_count * sizeof(SMCLOptionsParameter));
 	
 	// Handle arguments.
-	size_t param_idx = 0;
+	size_t					param_idx = 0;
+	SMCLOptionsParameter	*variadic_parameter = NULL; // Variadic value, once matched, takes all following values.
+	bool					options_ended = false; // After '--', all arguments are values.
 
 	for (int arg_idx = 2; arg_idx < argc; arg_idx++)
 	{
@@ -496,9 +517,16 @@ SMCLOptionsResult * SMCLOptionsParse(SMCLOptions *options, int argc, const char
 		const char		*param_value = NULL;
 		uint64_t		param_identifier = 0;
 		
+		// > Handle end of options.
+		if (!options_ended && strcmp(arg, "--") == 0)
+		{
+			options_ended = true;
+			continue;
+		}
+		
 		// > Sense type of argument.
 		const char 				*arg_content = NULL;
-		SMCLOptionsArgumentType	arg_type = SMCLOptionsSenseArgument(arg, &arg_content);
+		SMCLOptionsArgumentType	arg_type = (options_ended ? SMCLOptionsArgumentTypeValue : SMCLOptionsSenseArgument(arg, &arg_content));
 				
 		switch (arg_type)
 		{
@@ -512,8 +540,16 @@ SMCLOptionsResult * SMCLOptionsParse(SMCLOptions *options, int argc, const char
 			// > Value: valid if we still have a value to match, after pre-optional paramaters.
 			case SMCLOptionsArgumentTypeValue:
 			{
-				// > Skip optionals.
-				for (; param_idx < verb->parameters_count && parameters[param_idx].optional; param_idx++)
+				// > Append to variadic value.
+				if (variadic_parameter)
+				{
+					param_value = arg;
+					param_identifier = variadic_parameter->identifier;
+					break;
+				}
+				
+				// > Skip optional options.
+				for (; param_idx < verb->parameters_count && parameters[param_idx].optional && parameters[param_idx].type == SMCLOptionsParameterTypeOption; param_idx++)
 					;
 				
 				// > Check we still have parameters to handle.
@@ -534,6 +570,9 @@ SMCLOptionsResult * SMCLOptionsParse(SMCLOptions *options, int argc, const char
 				// > Mark parameter as handled.
 				parameters[param_idx].handled = true;
 				
+				if (parameters[param_idx].variadic)
+					variadic_parameter = &parameters[param_idx];
+				
 				break;
 			}
 			
@@ -554,6 +593,10 @@ SMCLOptionsResult * SMCLOptionsParse(SMCLOptions *options, int argc, const char
 				for (size_t i = param_idx; i < verb->parameters_count; i++)
 				{
 					// > Stop on first value: options are valid between values parameter, to enforce values ordering relatively to parameters.
+					// > Optional variadic values are passed over, as they may never be provided.
+					if (parameters[i].type == SMCLOptionsParameterTypeValue && parameters[i].variadic && parameters[i].optional)
+						continue;
+					
 					if (parameters[i].type == SMCLOptionsParameterTypeValue)
 						break;
 					
@@ -783,7 +826,8 @@ static SMCLOptionsArgumentType SMCLOptionsSenseArgument(const char *argument, co
 {
 	size_t len = strlen(argument);
 	
-	if (len > 0 && argument[0] == '-')
+	// > A lone '-' is a value (standard input, by convention).
+	if (len > 1 && argument[0] == '-')
 	{
 		if (len == 2 && isprint(argument[1]) && argument[1] != '-')
 		{
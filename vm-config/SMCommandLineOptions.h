@@ -85,6 +85,7 @@ SMCLOptionsVerb * SMCLOptionsAddVerb(SMCLOptions *options, uint64_t identifier,
 
 // > Parameters.
 void SMCLOptionsVerbAddValue(SMCLOptionsVerb *verb, uint64_t identifier, const char *name, const char *description);
+void SMCLOptionsVerbAddVariadicValue(SMCLOptionsVerb *verb, uint64_t identifier, bool optional, const char *name, const char *description); // Takes all remaining values, one result parameter per value. Should be the last value.
 
 void SMCLOptionsVerbAddOption(SMCLOptionsVerb *verb, uint64_t identifier, bool optional, const char *name, char short_name, const char *description);
 void SMCLOptionsVerbAddOptionWithArgument(SMCLOptionsVerb *verb, uint64_t identifier, bool optional, const char *name, char short_name, SMCLValueType argument_type, const char *argument_name, const char *description);
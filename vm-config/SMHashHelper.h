@@ -0,0 +1,80 @@
+/*
+ *  SMHashHelper.h
+ *
+ *  Copyright 2022 Avérous Julien-Pierre
+ *
+ *  This file is part of vm-config.
+ *
+ *  vm-config is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vm-config is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vm-config.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+
+/*
+** Defines
+*/
+#pragma mark - Defines
+
+#define SMHashFNV1aInit		0xcbf29ce484222325ULL
+#define SMHashFNV1aPrime	0x100000001b3ULL
+
+
+/*
+** Functions
+*/
+#pragma mark - Functions
+
+#pragma mark > Hash
+
+static __attribute__((always_inline)) inline
+uint64_t SMHashBytesAppend(uint64_t hash, const void *bytes, size_t size)
+{
+	const uint8_t *ubytes = bytes;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= ubytes[i];
+		hash *= SMHashFNV1aPrime;
+	}
+
+	return hash;
+}
+
+static __attribute__((always_inline)) inline
+uint64_t SMHashBytes(const void *bytes, size_t size)
+{
+	return SMHashBytesAppend(SMHashFNV1aInit, bytes, size);
+}
+
+
+#pragma mark > Table
+
+static __attribute__((always_inline)) inline
+size_t SMHashTableSizeForCount(size_t count)
+{
+	// Keep load factor under 50%, with a power-of-2 size so we can mask instead of modulo.
+	size_t size = 16;
+
+	while (size < count * 2)
+		size *= 2;
+
+	return size;
+}
@@ -0,0 +1,106 @@
+/*
+ *  SMIOHelper.c
+ *
+ *  Copyright 2022 Avérous Julien-Pierre
+ *
+ *  This file is part of vm-config.
+ *
+ *  vm-config is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vm-config is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vm-config.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <stdbool.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+
+#include <sys/param.h>
+#include <sys/socket.h>
+
+#include "SMIOHelper.h"
+
+
+/*
+** Prototypes
+*/
+#pragma mark - Prototypes
+
+static ssize_t SMIOTransferVector(int fd, struct iovec *iov, size_t iov_cnt, bool send, int flags);
+
+
+
+/*
+** Functions
+*/
+#pragma mark - Functions
+
+#pragma mark Vectors
+
+ssize_t SMIOWriteVector(int fd, struct iovec *iov, size_t iov_cnt)
+{
+	return SMIOTransferVector(fd, iov, iov_cnt, false, 0);
+}
+
+ssize_t SMIOSendVector(int fd, struct iovec *iov, size_t iov_cnt, int flags)
+{
+	return SMIOTransferVector(fd, iov, iov_cnt, true, flags);
+}
+
+static ssize_t SMIOTransferVector(int fd, struct iovec *iov, size_t iov_cnt, bool send, int flags)
+{
+	size_t total = 0;
+	
+	while (iov_cnt > 0)
+	{
+		int		cnt = (int)MIN(iov_cnt, (size_t)IOV_MAX);
+		ssize_t	written;
+		
+		if (send)
+		{
+			struct msghdr msg = { .msg_iov = iov, .msg_iovlen = cnt };
+			
+			written = sendmsg(fd, &msg, flags);
+		}
+		else
+			written = writev(fd, iov, cnt);
+		
+		if (written < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			
+			return -1;
+		}
+		
+		total += (size_t)written;
+		
+		// Skip fully written vectors, and adjust partially written one.
+		while (iov_cnt > 0 && (size_t)written >= iov->iov_len)
+		{
+			written -= iov->iov_len;
+			
+			iov++;
+			iov_cnt--;
+		}
+		
+		if (iov_cnt > 0)
+		{
+			iov->iov_base = (char *)iov->iov_base + written;
+			iov->iov_len -= (size_t)written;
+		}
+	}
+	
+	return (ssize_t)total;
+}
@@ -0,0 +1,41 @@
+/*
+ *  SMIOHelper.h
+ *
+ *  Copyright 2022 Avérous Julien-Pierre
+ *
+ *  This file is part of vm-config.
+ *
+ *  vm-config is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vm-config is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vm-config.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <stddef.h>
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+
+/*
+** Functions
+*/
+#pragma mark - Functions
+
+// Vectors.
+// > Write all the bytes of the vectors, retrying on interruptions and partial writes. Vectors are modified in place.
+// > Return the number of bytes written, or -1 with errno set.
+ssize_t SMIOWriteVector(int fd, struct iovec *iov, size_t iov_cnt);
+ssize_t SMIOSendVector(int fd, struct iovec *iov, size_t iov_cnt, int flags); // With sendmsg(), for sockets.
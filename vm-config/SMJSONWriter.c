@@ -0,0 +1,479 @@
+/*
+ *  SMJSONWriter.c
+ *
+ *  Copyright 2022 Avérous Julien-Pierre
+ *
+ *  This file is part of vm-config.
+ *
+ *  vm-config is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vm-config is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vm-config.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "SMJSONWriter.h"
+
+
+/*
+** Defines
+*/
+#pragma mark - Defines
+
+#define SMJSONWriterMemoryInitialSize	4096
+#define SMJSONWriterHexChunkSize		4096
+
+
+/*
+** Types
+*/
+#pragma mark - Types
+
+struct SMJSONWriter
+{
+	FILE	*output;
+	bool	failed;
+
+	// Buffer.
+	uint8_t	*bytes;
+	size_t	size;
+	size_t	capacity;
+
+	// State.
+	unsigned	depth;
+	uint64_t	has_items;	// Bit per depth: current container at this depth already has an item.
+	bool		after_key;	// Next value is the value of a key: no comma.
+	char		closers[SMJSONWriterMaxDepth + 1];
+};
+
+
+/*
+** Globals
+*/
+#pragma mark - Globals
+
+static const char g_hex_digits[] = "0123456789abcdef";
+
+// > Escape character for each byte, 'u' for \u00XX escapes, 'm' for non-ASCII bytes (UTF-8 sequences to validate), 0 if the byte is written as is.
+static const uint8_t g_escapes[256] = {
+	'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'b', 't', 'n', 'u', 'f', 'r', 'u', 'u',
+	'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
+	['"'] = '"',
+	['\\'] = '\\',
+	[0x80] = 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm',
+	'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm',
+	'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm',
+	'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm',
+	'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm',
+	'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm',
+	'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm',
+	'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm', 'm',
+};
+
+static const uint8_t g_replacement_character[] = { 0xEF, 0xBF, 0xBD }; // U+FFFD, in UTF-8.
+
+
+/*
+** Prototypes
+*/
+#pragma mark - Prototypes
+
+static void SMJSONWriterReserve(SMJSONWriter *writer, size_t size);
+static void SMJSONWriterAppend(SMJSONWriter *writer, const void *bytes, size_t size);
+static void SMJSONWriterAppendByte(SMJSONWriter *writer, uint8_t byte);
+static void SMJSONWriterAppendEscaped(SMJSONWriter *writer, const uint8_t *str, size_t size);
+
+static size_t SMJSONWriterUTF8SequenceSize(const uint8_t *bytes, size_t size);
+
+static void SMJSONWriterSeparate(SMJSONWriter *writer);
+static void SMJSONWriterBegin(SMJSONWriter *writer, char opener, char closer);
+static void SMJSONWriterEnd(SMJSONWriter *writer);
+
+
+
+/*
+** Functions
+*/
+#pragma mark - Functions
+
+#pragma mark Instance
+
+SMJSONWriter * SMJSONWriterCreate(FILE *output)
+{
+	SMJSONWriter *writer = calloc(1, sizeof(SMJSONWriter));
+
+	assert(writer);
+
+	writer->output = output;
+	writer->capacity = (output ? SMJSONWriterFlushSize : SMJSONWriterMemoryInitialSize);
+	writer->bytes = malloc(writer->capacity);
+
+	assert(writer->bytes);
+
+	return writer;
+}
+
+void SMJSONWriterFree(SMJSONWriter *writer)
+{
+	if (!writer)
+		return;
+
+	SMJSONWriterFlush(writer);
+
+	free(writer->bytes);
+	free(writer);
+}
+
+
+#pragma mark Output
+
+bool SMJSONWriterFlush(SMJSONWriter *writer)
+{
+	if (writer->output && writer->size > 0)
+	{
+		if (fwrite(writer->bytes, 1, writer->size, writer->output) != writer->size)
+			writer->failed = true;
+
+		writer->size = 0;
+	}
+
+	return !writer->failed;
+}
+
+const void * SMJSONWriterGetBytes(SMJSONWriter *writer, size_t *size)
+{
+	*size = writer->size;
+
+	return writer->bytes;
+}
+
+void SMJSONWriterReset(SMJSONWriter *writer)
+{
+	writer->size = 0;
+	writer->depth = 0;
+	writer->has_items = 0;
+	writer->after_key = false;
+}
+
+
+#pragma mark Containers
+
+void SMJSONWriterBeginObject(SMJSONWriter *writer)
+{
+	SMJSONWriterBegin(writer, '{', '}');
+}
+
+void SMJSONWriterEndObject(SMJSONWriter *writer)
+{
+	assert(writer->depth > 0 && writer->closers[writer->depth] == '}');
+
+	SMJSONWriterEnd(writer);
+}
+
+void SMJSONWriterBeginArray(SMJSONWriter *writer)
+{
+	SMJSONWriterBegin(writer, '[', ']');
+}
+
+void SMJSONWriterEndArray(SMJSONWriter *writer)
+{
+	assert(writer->depth > 0 && writer->closers[writer->depth] == ']');
+
+	SMJSONWriterEnd(writer);
+}
+
+unsigned SMJSONWriterDepth(SMJSONWriter *writer)
+{
+	return writer->depth;
+}
+
+void SMJSONWriterEndToDepth(SMJSONWriter *writer, unsigned depth)
+{
+	// > A key without value gets a null one, to keep the document valid.
+	if (writer->after_key && writer->depth > depth)
+		SMJSONWriterNull(writer);
+
+	while (writer->depth > depth)
+		SMJSONWriterEnd(writer);
+}
+
+static void SMJSONWriterBegin(SMJSONWriter *writer, char opener, char closer)
+{
+	SMJSONWriterSeparate(writer);
+	SMJSONWriterAppendByte(writer, (uint8_t)opener);
+
+	assert(writer->depth < SMJSONWriterMaxDepth);
+
+	writer->depth++;
+	writer->has_items &= ~(1ULL << writer->depth);
+	writer->closers[writer->depth] = closer;
+}
+
+static void SMJSONWriterEnd(SMJSONWriter *writer)
+{
+	SMJSONWriterAppendByte(writer, (uint8_t)writer->closers[writer->depth]);
+
+	writer->depth--;
+}
+
+
+#pragma mark Values
+
+void SMJSONWriterKey(SMJSONWriter *writer, const char *key)
+{
+	assert(!writer->after_key && writer->depth > 0 && writer->closers[writer->depth] == '}');
+
+	SMJSONWriterSeparate(writer);
+	SMJSONWriterAppendEscaped(writer, (const uint8_t *)key, strlen(key));
+	SMJSONWriterAppendByte(writer, ':');
+
+	writer->after_key = true;
+}
+
+void SMJSONWriterString(SMJSONWriter *writer, const char *str)
+{
+	SMJSONWriterStringBytes(writer, str, strlen(str));
+}
+
+void SMJSONWriterStringBytes(SMJSONWriter *writer, const void *bytes, size_t size)
+{
+	SMJSONWriterSeparate(writer);
+	SMJSONWriterAppendEscaped(writer, bytes, size);
+}
+
+void SMJSONWriterHexString(SMJSONWriter *writer, const void *bytes, size_t size)
+{
+	const uint8_t *ubytes = bytes;
+
+	SMJSONWriterSeparate(writer);
+	SMJSONWriterAppendByte(writer, '"');
+
+	// > By chunks, so a big value doesn't need a buffer twice its size.
+	while (size > 0)
+	{
+		size_t chunk_size = (size < SMJSONWriterHexChunkSize ? size : SMJSONWriterHexChunkSize);
+
+		SMJSONWriterReserve(writer, 2 * chunk_size);
+
+		uint8_t *hex = writer->bytes + writer->size;
+
+		for (size_t i = 0; i < chunk_size; i++)
+		{
+			hex[2 * i] = (uint8_t)g_hex_digits[ubytes[i] >> 4];
+			hex[2 * i + 1] = (uint8_t)g_hex_digits[ubytes[i] & 0xf];
+		}
+
+		writer->size += 2 * chunk_size;
+		ubytes += chunk_size;
+		size -= chunk_size;
+	}
+
+	SMJSONWriterAppendByte(writer, '"');
+}
+
+void SMJSONWriterUInt(SMJSONWriter *writer, uint64_t value)
+{
+	char	digits[20];
+	size_t	idx = sizeof(digits);
+
+	do {
+		digits[--idx] = (char)('0' + (value % 10));
+		value /= 10;
+	} while (value > 0);
+
+	SMJSONWriterSeparate(writer);
+	SMJSONWriterAppend(writer, digits + idx, sizeof(digits) - idx);
+}
+
+void SMJSONWriterBool(SMJSONWriter *writer, bool value)
+{
+	SMJSONWriterSeparate(writer);
+
+	if (value)
+		SMJSONWriterAppend(writer, "true", 4);
+	else
+		SMJSONWriterAppend(writer, "false", 5);
+}
+
+void SMJSONWriterNull(SMJSONWriter *writer)
+{
+	SMJSONWriterSeparate(writer);
+	SMJSONWriterAppend(writer, "null", 4);
+}
+
+
+#pragma mark Records
+
+void SMJSONWriterNewline(SMJSONWriter *writer)
+{
+	assert(writer->depth == 0);
+
+	SMJSONWriterAppendByte(writer, '\n');
+
+	writer->has_items = 0;
+}
+
+
+#pragma mark Helpers
+
+static void SMJSONWriterSeparate(SMJSONWriter *writer)
+{
+	uint64_t bit = (1ULL << writer->depth);
+
+	if (writer->after_key)
+		writer->after_key = false;
+	else if (writer->has_items & bit)
+		SMJSONWriterAppendByte(writer, (writer->depth > 0 ? ',' : '\n'));
+
+	writer->has_items |= bit;
+}
+
+static void SMJSONWriterReserve(SMJSONWriter *writer, size_t size)
+{
+	if (writer->size + size <= writer->capacity)
+		return;
+
+	// > Streaming: make room by writing pending bytes.
+	if (writer->output)
+	{
+		SMJSONWriterFlush(writer);
+
+		if (size <= writer->capacity)
+			return;
+	}
+
+	// > Grow.
+	size_t capacity = writer->capacity * 2;
+
+	while (capacity < writer->size + size)
+		capacity *= 2;
+
+	writer->bytes = reallocf(writer->bytes, capacity);
+	writer->capacity = capacity;
+
+	assert(writer->bytes);
+}
+
+static void SMJSONWriterAppend(SMJSONWriter *writer, const void *bytes, size_t size)
+{
+	SMJSONWriterReserve(writer, size);
+
+	memcpy(writer->bytes + writer->size, bytes, size);
+	writer->size += size;
+}
+
+static void SMJSONWriterAppendByte(SMJSONWriter *writer, uint8_t byte)
+{
+	if (writer->size == writer->capacity)
+		SMJSONWriterReserve(writer, 1);
+
+	writer->bytes[writer->size++] = byte;
+}
+
+static void SMJSONWriterAppendEscaped(SMJSONWriter *writer, const uint8_t *str, size_t size)
+{
+	size_t start = 0;
+
+	SMJSONWriterAppendByte(writer, '"');
+
+	// > Copy runs of bytes which don't need escaping at once.
+	for (size_t i = 0; i < size; i++)
+	{
+		uint8_t escape = g_escapes[str[i]];
+
+		if (escape == 0)
+			continue;
+
+		// > Valid multi-bytes sequences are written as is.
+		if (escape == 'm')
+		{
+			size_t sequence_size = SMJSONWriterUTF8SequenceSize(str + i, size - i);
+
+			if (sequence_size > 0)
+			{
+				i += sequence_size - 1;
+				continue;
+			}
+		}
+
+		SMJSONWriterAppend(writer, str + start, i - start);
+
+		if (escape == 'm')
+		{
+			// > Invalid UTF-8 (e.g. raw bytes in a vmx value): replace each invalid byte, so the output stays valid JSON.
+			SMJSONWriterAppend(writer, g_replacement_character, sizeof(g_replacement_character));
+		}
+		else if (escape == 'u')
+		{
+			uint8_t sequence[6] = { '\\', 'u', '0', '0', (uint8_t)g_hex_digits[str[i] >> 4], (uint8_t)g_hex_digits[str[i] & 0xf] };
+
+			SMJSONWriterAppend(writer, sequence, sizeof(sequence));
+		}
+		else
+		{
+			uint8_t sequence[2] = { '\\', escape };
+
+			SMJSONWriterAppend(writer, sequence, sizeof(sequence));
+		}
+
+		start = i + 1;
+	}
+
+	SMJSONWriterAppend(writer, str + start, size - start);
+	SMJSONWriterAppendByte(writer, '"');
+}
+
+static size_t SMJSONWriterUTF8SequenceSize(const uint8_t *bytes, size_t size)
+{
+	// > Well-formed sequences only (Unicode table 3-7): no overlong forms, no surrogates, nothing after U+10FFFF.
+	uint8_t	lead = bytes[0];
+	uint8_t	second_min = 0x80;
+	uint8_t	second_max = 0xBF;
+	size_t	sequence_size;
+
+	if (lead >= 0xC2 && lead <= 0xDF)
+		sequence_size = 2;
+	else if (lead >= 0xE0 && lead <= 0xEF)
+	{
+		sequence_size = 3;
+
+		if (lead == 0xE0)
+			second_min = 0xA0;
+		else if (lead == 0xED)
+			second_max = 0x9F;
+	}
+	else if (lead >= 0xF0 && lead <= 0xF4)
+	{
+		sequence_size = 4;
+
+		if (lead == 0xF0)
+			second_min = 0x90;
+		else if (lead == 0xF4)
+			second_max = 0x8F;
+	}
+	else
+		return 0;
+
+	if (sequence_size > size || bytes[1] < second_min || bytes[1] > second_max)
+		return 0;
+
+	for (size_t i = 2; i < sequence_size; i++)
+	{
+		if ((bytes[i] & 0xC0) != 0x80)
+			return 0;
+	}
+
+	return sequence_size;
+}
@@ -0,0 +1,85 @@
+/*
+ *  SMJSONWriter.h
+ *
+ *  Copyright 2022 Avérous Julien-Pierre
+ *
+ *  This file is part of vm-config.
+ *
+ *  vm-config is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vm-config is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vm-config.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+
+/*
+** Defines
+*/
+#pragma mark - Defines
+
+#define SMJSONWriterFlushSize	(64 * 1024)
+#define SMJSONWriterMaxDepth	63
+
+
+/*
+** Types
+*/
+#pragma mark - Types
+
+typedef struct SMJSONWriter SMJSONWriter;
+
+
+/*
+** Functions
+*/
+#pragma mark - Functions
+
+// Instance.
+// > With an output, bytes are written to it each time the buffer reaches SMJSONWriterFlushSize, and on flush.
+// > Without output, bytes are kept in the buffer, and can be taken with SMJSONWriterGetBytes().
+SMJSONWriter *	SMJSONWriterCreate(FILE *output);
+void			SMJSONWriterFree(SMJSONWriter *writer); // Flushes.
+
+// Output.
+bool			SMJSONWriterFlush(SMJSONWriter *writer); // False if any write to output failed.
+const void *	SMJSONWriterGetBytes(SMJSONWriter *writer, size_t *size);
+void			SMJSONWriterReset(SMJSONWriter *writer); // Drops pending bytes & state, keeps buffer.
+
+// Containers.
+// > Commas are inserted as needed. In objects, each value must be preceded by its key.
+void SMJSONWriterBeginObject(SMJSONWriter *writer);
+void SMJSONWriterEndObject(SMJSONWriter *writer);
+void SMJSONWriterBeginArray(SMJSONWriter *writer);
+void SMJSONWriterEndArray(SMJSONWriter *writer);
+
+unsigned	SMJSONWriterDepth(SMJSONWriter *writer);
+void		SMJSONWriterEndToDepth(SMJSONWriter *writer, unsigned depth); // Ends containers deeper than depth (e.g. after an error).
+
+// Values.
+// > Strings are expected to be UTF-8: '"', '\' and control characters are escaped, and bytes of invalid UTF-8 sequences are replaced by U+FFFD.
+void SMJSONWriterKey(SMJSONWriter *writer, const char *key);
+void SMJSONWriterString(SMJSONWriter *writer, const char *str);
+void SMJSONWriterStringBytes(SMJSONWriter *writer, const void *bytes, size_t size);
+void SMJSONWriterHexString(SMJSONWriter *writer, const void *bytes, size_t size); // Lowercase hexadecimal string of bytes.
+void SMJSONWriterUInt(SMJSONWriter *writer, uint64_t value);
+void SMJSONWriterBool(SMJSONWriter *writer, bool value);
+void SMJSONWriterNull(SMJSONWriter *writer);
+
+// Records.
+// > Ends a top-level value with a new line, as in newline delimited JSON.
+void SMJSONWriterNewline(SMJSONWriter *writer);
@@ -0,0 +1,607 @@
+/*
+ *  SMServer.c
+ *
+ *  Copyright 2022 Avérous Julien-Pierre
+ *
+ *  This file is part of vm-config.
+ *
+ *  vm-config is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vm-config is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vm-config.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+
+#include "SMServer.h"
+
+#include "SMIOHelper.h"
+
+
+/*
+** Defines
+*/
+#pragma mark - Defines
+
+#define SMServerMaxConnections	64
+#define SMServerTimeout			5 // seconds
+
+#if defined(MSG_NOSIGNAL)
+#  define SMSocketSendFlags MSG_NOSIGNAL
+#else
+#  define SMSocketSendFlags 0
+#endif
+
+
+/*
+** Types
+*/
+#pragma mark - Types
+
+struct SMServer
+{
+	char *socket_path;
+
+	int listen_fd;
+	int stop_fds[2];
+
+	int		connections[SMServerMaxConnections];
+	size_t	connections_cnt;
+
+	SMServerHandler	handler;
+	void			*context;
+};
+
+struct SMServerClient
+{
+	int fd;
+};
+
+
+/*
+** Prototypes
+*/
+#pragma mark - Prototypes
+
+// Server.
+static bool SMServerHandleRequest(SMServer *server, int fd);
+
+// Sockets.
+static bool SMSocketFillAddress(struct sockaddr_un *addr, const char *socket_path, SMError **error);
+static void SMSocketConfigure(int fd);
+
+static bool SMSocketRead(int fd, void *bytes, size_t size);
+static bool SMSocketReadString(int fd, char **string);
+
+
+
+/*
+** Functions
+*/
+#pragma mark - Functions
+
+#pragma mark Server
+
+SMServer * SMServerCreate(const char *socket_path, SMServerHandler handler, void *context, SMError **error)
+{
+	SMServer			*server = calloc(1, sizeof(SMServer));
+	struct sockaddr_un	addr;
+	struct stat			st;
+
+	assert(server);
+
+	server->listen_fd = -1;
+	server->stop_fds[0] = -1;
+	server->stop_fds[1] = -1;
+	server->handler = handler;
+	server->context = context;
+
+	if (!SMSocketFillAddress(&addr, socket_path, error))
+		goto fail;
+
+	// Replace stale socket.
+	// > Left by a server which didn't exit cleanly: nobody accepts connections on it anymore.
+	if (lstat(socket_path, &st) == 0)
+	{
+		if (!S_ISSOCK(st.st_mode))
+		{
+			SMSetErrorPtr(error, "server", -1, "'%s' exists and is not a socket", socket_path);
+			goto fail;
+		}
+
+		SMServerClient *client = SMServerClientConnect(socket_path, NULL);
+
+		if (client)
+		{
+			SMServerClientFree(client);
+			SMSetErrorPtr(error, "server", -1, "socket '%s' is already used by a running server", socket_path);
+			goto fail;
+		}
+
+		unlink(socket_path);
+	}
+
+	// Create listening socket.
+	server->listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+	if (server->listen_fd == -1)
+	{
+		SMSetErrorPtr(error, "server", errno, "can't create socket (%d - %s)", errno, strerror(errno));
+		goto fail;
+	}
+
+	fcntl(server->listen_fd, F_SETFD, FD_CLOEXEC);
+
+	if (bind(server->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) == -1)
+	{
+		SMSetErrorPtr(error, "server", errno, "can't bind socket to '%s' (%d - %s)", socket_path, errno, strerror(errno));
+		goto fail;
+	}
+
+	server->socket_path = strdup(socket_path);
+
+	assert(server->socket_path);
+
+	// > Restrict to current user before accepting anything.
+	if (chmod(socket_path, S_IRUSR | S_IWUSR) == -1 || listen(server->listen_fd, SOMAXCONN) == -1)
+	{
+		SMSetErrorPtr(error, "server", errno, "can't listen on '%s' (%d - %s)", socket_path, errno, strerror(errno));
+		goto fail;
+	}
+
+	// Create stop pipe.
+	if (pipe(server->stop_fds) == -1)
+	{
+		SMSetErrorPtr(error, "server", errno, "can't create pipe (%d - %s)", errno, strerror(errno));
+		goto fail;
+	}
+
+	fcntl(server->stop_fds[0], F_SETFD, FD_CLOEXEC);
+	fcntl(server->stop_fds[1], F_SETFD, FD_CLOEXEC);
+	fcntl(server->stop_fds[1], F_SETFL, O_NONBLOCK);
+
+	return server;
+
+fail:
+	SMServerFree(server);
+
+	return NULL;
+}
+
+void SMServerFree(SMServer *server)
+{
+	if (!server)
+		return;
+
+	for (size_t i = 0; i < server->connections_cnt; i++)
+		close(server->connections[i]);
+
+	if (server->listen_fd != -1)
+		close(server->listen_fd);
+
+	if (server->stop_fds[0] != -1)
+		close(server->stop_fds[0]);
+
+	if (server->stop_fds[1] != -1)
+		close(server->stop_fds[1]);
+
+	if (server->socket_path)
+	{
+		unlink(server->socket_path);
+		free(server->socket_path);
+	}
+
+	free(server);
+}
+
+void SMServerRun(SMServer *server)
+{
+	struct pollfd pfds[2 + SMServerMaxConnections];
+
+	while (1)
+	{
+		// Wait for stop, connection, or request.
+		// > Stop listening while all connection slots are used: pending connections wait in the backlog.
+		nfds_t pfds_cnt = 0;
+
+		pfds[pfds_cnt++] = (struct pollfd){ .fd = server->stop_fds[0], .events = POLLIN };
+		pfds[pfds_cnt++] = (struct pollfd){ .fd = (server->connections_cnt < SMServerMaxConnections ? server->listen_fd : -1), .events = POLLIN };
+
+		for (size_t i = 0; i < server->connections_cnt; i++)
+			pfds[pfds_cnt++] = (struct pollfd){ .fd = server->connections[i], .events = POLLIN };
+
+		if (poll(pfds, pfds_cnt, -1) == -1)
+		{
+			if (errno == EINTR)
+				continue;
+
+			return;
+		}
+
+		// Handle stop.
+		if (pfds[0].revents)
+		{
+			char byte;
+
+			while (read(server->stop_fds[0], &byte, 1) == -1 && errno == EINTR)
+				;
+
+			return;
+		}
+
+		// Handle requests.
+		// > Iterate backward, as a closed connection is replaced by the last one.
+		for (size_t i = server->connections_cnt; i > 0; i--)
+		{
+			if (pfds[2 + i - 1].revents == 0)
+				continue;
+
+			if (!SMServerHandleRequest(server, server->connections[i - 1]))
+			{
+				close(server->connections[i - 1]);
+				server->connections[i - 1] = server->connections[--server->connections_cnt];
+			}
+		}
+
+		// Handle connection.
+		if (pfds[1].revents)
+		{
+			int fd = accept(server->listen_fd, NULL, NULL);
+
+			if (fd == -1)
+				continue;
+
+			fcntl(fd, F_SETFD, FD_CLOEXEC);
+			SMSocketConfigure(fd);
+
+			server->connections[server->connections_cnt++] = fd;
+		}
+	}
+}
+
+void SMServerStop(SMServer *server)
+{
+	char	byte = 0;
+	int		saved_errno = errno;
+
+	// > Non-blocking: if the pipe is full, a stop is already pending.
+	while (write(server->stop_fds[1], &byte, 1) == -1 && errno == EINTR)
+		;
+
+	errno = saved_errno;
+}
+
+static bool SMServerHandleRequest(SMServer *server, int fd)
+{
+	bool		result = false;
+	char		*working_directory = NULL;
+	uint32_t	argc = 0;
+	char		**argv = NULL;
+
+	// Read request.
+	// > Also fails at end of file, once the client closed the connection.
+	if (!SMSocketReadString(fd, &working_directory))
+		return false;
+
+	if (!SMSocketRead(fd, &argc, sizeof(argc)) || argc == 0 || argc > SMServerMaxArgumentsCount)
+		goto clean;
+
+	argv = calloc(argc + 1, sizeof(char *));
+
+	assert(argv);
+
+	for (uint32_t i = 0; i < argc; i++)
+	{
+		if (!SMSocketReadString(fd, &argv[i]))
+			goto clean;
+	}
+
+	// > An empty working directory is an unknown one.
+	if (working_directory[0] == 0)
+	{
+		free(working_directory);
+		working_directory = NULL;
+	}
+
+	// Handle request.
+	char	*out_bytes = NULL, *err_bytes = NULL;
+	size_t	out_size = 0, err_size = 0;
+	FILE	*fout = open_memstream(&out_bytes, &out_size);
+	FILE	*ferr = open_memstream(&err_bytes, &err_size);
+
+	assert(fout && ferr);
+
+	int32_t exit_code = server->handler(working_directory, (int)argc, (const char **)argv, fout, ferr, server->context);
+
+	fclose(fout);
+	fclose(ferr);
+
+	// Send response.
+	uint32_t		out_size32 = (uint32_t)out_size;
+	uint32_t		err_size32 = (uint32_t)err_size;
+	struct iovec	iov[] = {
+		{ .iov_base = &exit_code, .iov_len = sizeof(exit_code) },
+		{ .iov_base = &out_size32, .iov_len = sizeof(out_size32) },
+		{ .iov_base = out_bytes, .iov_len = out_size },
+		{ .iov_base = &err_size32, .iov_len = sizeof(err_size32) },
+		{ .iov_base = err_bytes, .iov_len = err_size },
+	};
+
+	result = (SMIOSendVector(fd, iov, sizeof(iov) / sizeof(*iov), SMSocketSendFlags) >= 0);
+
+	free(out_bytes);
+	free(err_bytes);
+
+clean:
+	for (uint32_t i = 0; argv && i < argc; i++)
+		free(argv[i]);
+
+	free(argv);
+	free(working_directory);
+
+	return result;
+}
+
+
+#pragma mark Client
+
+SMServerClient * SMServerClientConnect(const char *socket_path, SMError **error)
+{
+	struct sockaddr_un addr;
+
+	if (!SMSocketFillAddress(&addr, socket_path, error))
+		return NULL;
+
+	// Connect.
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+	if (fd == -1)
+	{
+		SMSetErrorPtr(error, "server", errno, "can't create socket (%d - %s)", errno, strerror(errno));
+		return NULL;
+	}
+
+	if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1)
+	{
+		SMSetErrorPtr(error, "server", errno, "can't connect to '%s' (%d - %s)", socket_path, errno, strerror(errno));
+		close(fd);
+		return NULL;
+	}
+
+	fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+#if defined(SO_NOSIGPIPE)
+	int on = 1;
+
+	setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+
+	// Create client.
+	SMServerClient *client = calloc(1, sizeof(SMServerClient));
+
+	assert(client);
+
+	client->fd = fd;
+
+	return client;
+}
+
+void SMServerClientFree(SMServerClient *client)
+{
+	if (!client)
+		return;
+
+	close(client->fd);
+	free(client);
+}
+
+bool SMServerClientRun(SMServerClient *client, int argc, const char *argv[], int *exit_code, char **out_bytes, size_t *out_size, char **err_bytes, size_t *err_size, SMError **error)
+{
+	bool		result = false;
+	char		*outputs[2] = { NULL, NULL };
+	uint32_t	sizes[2] = { 0, 0 };
+
+	// Check request.
+	if (argc <= 0 || argc > SMServerMaxArgumentsCount)
+	{
+		SMSetErrorPtr(error, "server", -1, "invalid count of arguments (%d)", argc);
+		return false;
+	}
+
+	// Get working directory.
+	// > Relative paths in arguments are resolved by the server against it.
+	char working_directory[PATH_MAX];
+
+	if (!getcwd(working_directory, sizeof(working_directory)))
+	{
+		SMSetErrorPtr(error, "server", errno, "can't get working directory (%d - %s)", errno, strerror(errno));
+		return false;
+	}
+
+	// Send request.
+	// > One write for the whole request: sizes are stored alongside their argument.
+	uint32_t		wd_size32 = (uint32_t)strlen(working_directory);
+	uint32_t		argc32 = (uint32_t)argc;
+	uint32_t		*args_sizes = malloc((size_t)argc * sizeof(uint32_t));
+	struct iovec	*iov = malloc((3 + 2 * (size_t)argc) * sizeof(struct iovec));
+
+	assert(args_sizes && iov);
+
+	iov[0] = (struct iovec){ .iov_base = &wd_size32, .iov_len = sizeof(wd_size32) };
+	iov[1] = (struct iovec){ .iov_base = working_directory, .iov_len = wd_size32 };
+	iov[2] = (struct iovec){ .iov_base = &argc32, .iov_len = sizeof(argc32) };
+
+	for (int i = 0; i < argc; i++)
+	{
+		size_t size = strlen(argv[i]);
+
+		if (size > SMServerMaxArgumentSize)
+		{
+			SMSetErrorPtr(error, "server", -1, "argument %d is too big (%zu bytes)", i, size);
+			goto clean;
+		}
+
+		args_sizes[i] = (uint32_t)size;
+
+		iov[3 + 2 * i] = (struct iovec){ .iov_base = &args_sizes[i], .iov_len = sizeof(uint32_t) };
+		iov[4 + 2 * i] = (struct iovec){ .iov_base = (void *)argv[i], .iov_len = size };
+	}
+
+	if (SMIOSendVector(client->fd, iov, 3 + 2 * (size_t)argc, SMSocketSendFlags) < 0)
+	{
+		SMSetErrorPtr(error, "server", errno, "can't send request (%d - %s)", errno, strerror(errno));
+		goto clean;
+	}
+
+	// Receive response.
+	int32_t code = 0;
+
+	if (!SMSocketRead(client->fd, &code, sizeof(code)))
+	{
+		SMSetErrorPtr(error, "server", -1, "can't receive response");
+		goto clean;
+	}
+
+	for (size_t i = 0; i < 2; i++)
+	{
+		if (!SMSocketRead(client->fd, &sizes[i], sizeof(sizes[i])))
+		{
+			SMSetErrorPtr(error, "server", -1, "can't receive response");
+			goto clean;
+		}
+
+		outputs[i] = malloc(sizes[i] + 1);
+
+		assert(outputs[i]);
+
+		if (!SMSocketRead(client->fd, outputs[i], sizes[i]))
+		{
+			SMSetErrorPtr(error, "server", -1, "can't receive response");
+			goto clean;
+		}
+
+		outputs[i][sizes[i]] = 0;
+	}
+
+	// Give results.
+	*exit_code = code;
+
+	*out_bytes = outputs[0];
+	*out_size = sizes[0];
+	*err_bytes = outputs[1];
+	*err_size = sizes[1];
+
+	outputs[0] = NULL;
+	outputs[1] = NULL;
+
+	result = true;
+
+clean:
+	free(outputs[0]);
+	free(outputs[1]);
+	free(args_sizes);
+	free(iov);
+
+	return result;
+}
+
+
+#pragma mark Sockets
+
+static bool SMSocketFillAddress(struct sockaddr_un *addr, const char *socket_path, SMError **error)
+{
+	memset(addr, 0, sizeof(*addr));
+
+	if (strlen(socket_path) >= sizeof(addr->sun_path))
+	{
+		SMSetErrorPtr(error, "server", -1, "socket path '%s' is too long", socket_path);
+		return false;
+	}
+
+	addr->sun_family = AF_UNIX;
+	strcpy(addr->sun_path, socket_path);
+
+	return true;
+}
+
+static void SMSocketConfigure(int fd)
+{
+	// > A slow or stuck client can't hold the server more than the timeout.
+	struct timeval timeout = { .tv_sec = SMServerTimeout };
+
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+#if defined(SO_NOSIGPIPE)
+	int on = 1;
+
+	setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+}
+
+static bool SMSocketRead(int fd, void *bytes, size_t size)
+{
+	uint8_t *ubytes = bytes;
+
+	while (size > 0)
+	{
+		ssize_t rsize = recv(fd, ubytes, size, 0);
+
+		if (rsize == -1 && errno == EINTR)
+			continue;
+
+		if (rsize <= 0)
+			return false;
+
+		ubytes += rsize;
+		size -= (size_t)rsize;
+	}
+
+	return true;
+}
+
+static bool SMSocketReadString(int fd, char **string)
+{
+	// > Size, then bytes: NUL terminated on success, to be freed.
+	uint32_t size = 0;
+
+	if (!SMSocketRead(fd, &size, sizeof(size)) || size > SMServerMaxArgumentSize)
+		return false;
+
+	char *bytes = malloc(size + 1);
+
+	assert(bytes);
+
+	if (!SMSocketRead(fd, bytes, size))
+	{
+		free(bytes);
+		return false;
+	}
+
+	bytes[size] = 0;
+	*string = bytes;
+
+	return true;
+}
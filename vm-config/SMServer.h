@@ -0,0 +1,79 @@
+/*
+ *  SMServer.h
+ *
+ *  Copyright 2022 Avérous Julien-Pierre
+ *
+ *  This file is part of vm-config.
+ *
+ *  vm-config is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vm-config is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vm-config.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "SMError.h"
+
+
+/*
+** Defines
+*/
+#pragma mark - Defines
+
+// Protocol.
+// > Local socket only: integers are in host byte order.
+// > Request: uint32 size of the client working directory followed by its bytes (empty if unknown), uint32 count of arguments,
+// > then for each argument an uint32 size followed by its bytes.
+// > Response: int32 exit code, uint32 output size, output bytes, uint32 error output size, error output bytes.
+// > A connection can send requests one after the other, each one waiting for its response.
+#define SMServerMaxArgumentsCount	1024
+#define SMServerMaxArgumentSize		(64 * 1024)
+
+
+/*
+** Types
+*/
+#pragma mark - Types
+
+typedef struct SMServer			SMServer;
+typedef struct SMServerClient	SMServerClient;
+
+// > Arguments are the request ones, NULL terminated. Output written to fout & ferr is sent back with the returned exit code.
+// > The working directory is the client one (NULL if unknown): relative paths in arguments are relative to it.
+typedef int (*SMServerHandler)(const char *working_directory, int argc, const char *argv[], FILE *fout, FILE *ferr, void *context);
+
+
+/*
+** Functions
+*/
+#pragma mark - Functions
+
+// Server.
+// > Listens on socket_path, only reachable by the current user. A stale socket at this path is replaced, a live one is an error.
+SMServer *	SMServerCreate(const char *socket_path, SMServerHandler handler, void *context, SMError **error);
+void		SMServerFree(SMServer *server);
+
+// > Handles requests of all connections one at a time, on the calling thread, until SMServerStop() is called.
+// > A request which doesn't arrive entirely within a few seconds closes its connection.
+void SMServerRun(SMServer *server);
+void SMServerStop(SMServer *server); // Thread-safe & async-signal-safe.
+
+// Client.
+SMServerClient *	SMServerClientConnect(const char *socket_path, SMError **error);
+void				SMServerClientFree(SMServerClient *client);
+
+// > The request carries the current working directory. On success, out_bytes & err_bytes are NUL terminated, and should be freed.
+bool SMServerClientRun(SMServerClient *client, int argc, const char *argv[], int *exit_code, char **out_bytes, size_t *out_size, char **err_bytes, size_t *err_size, SMError **error);
@@ -25,11 +25,40 @@
 #include <string.h>
 #include <assert.h>
 
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#  define SM_STRING_SSE2 1
+#elif defined(__aarch64__)
+#  include <arm_neon.h>
+#  define SM_STRING_NEON 1
+#endif
+
+// > iconv is only used by unit tests, as a reference for UTF-16 conversions (SM_ICONV is defined by their build).
+#if SM_ICONV
+#  include <iconv.h>
+#  define HAS_ICONV 1
+#endif
+
+#if __has_include(<os/lock.h>)
+#  include <os/lock.h>
+#  define HAS_LOCK 1
+#endif
+
 #include "SMStringHelper.h"
 
 #include "SMBytesWritter.h"
 
 
+/*
+** Prototypes
+*/
+#pragma mark - Prototypes
+
+// Encoding.
+static size_t SMStringUTF16LEToUTF8ASCII(const uint8_t *utf16bytes, size_t units, uint8_t *output);
+static size_t SMStringUTF8ToUTF16LEASCII(const uint8_t *utf8bytes, size_t len, uint8_t *output);
+
+
 /*
 ** Functionss
 */
@@ -146,6 +175,77 @@ char * SMStringReplaceString(char *str, const char *value, const char *replaceme
 	return SMBytesWritterPtr(&writter);
 }
 
+char ** SMStringSplitArguments(const char *str, size_t *count)
+{
+	// Unquote arguments in a buffer, zero separated.
+	// > Unquoting only shrinks arguments, and each one but the last is followed by at least one blank: input size is enough.
+	size_t	len = strlen(str);
+	char	*buffer = malloc(len + 1);
+	size_t	buffer_size = 0;
+	size_t	args_cnt = 0;
+	
+	assert(buffer);
+	
+	while (*str)
+	{
+		// > Skip blanks.
+		if (*str == ' ' || *str == '\t')
+		{
+			str++;
+			continue;
+		}
+		
+		// > Unquote argument.
+		char quote = 0;
+		
+		for (; *str && (quote || (*str != ' ' && *str != '\t')); str++)
+		{
+			if (quote && *str == quote)
+				quote = 0;
+			else if (!quote && (*str == '\'' || *str == '"'))
+				quote = *str;
+			else if (*str == '\\' && quote != '\'' && str[1] && (quote == 0 || str[1] == '"' || str[1] == '\\'))
+				buffer[buffer_size++] = *(++str);
+			else
+				buffer[buffer_size++] = *str;
+		}
+		
+		if (quote)
+		{
+			free(buffer);
+			return NULL;
+		}
+		
+		buffer[buffer_size++] = 0;
+		args_cnt++;
+	}
+	
+	// Forge result: pointers, followed by arguments.
+	char **result = malloc((args_cnt + 1) * sizeof(char *) + buffer_size);
+	
+	assert(result);
+	
+	char *args = (char *)(result + args_cnt + 1);
+	
+	memcpy(args, buffer, buffer_size);
+	
+	for (size_t i = 0; i < args_cnt; i++)
+	{
+		result[i] = args;
+		args += strlen(args) + 1;
+	}
+	
+	result[args_cnt] = NULL;
+	
+	// Clean.
+	free(buffer);
+	
+	if (count)
+		*count = args_cnt;
+	
+	return result;
+}
+
 
 #pragma mark Path
 
@@ -202,3 +302,425 @@ bool SMStringPathHasExtension(const char *path, const char *ext)
 
 	return (path[path_len - ext_len - 1] == '.') && (memcmp(path + path_len - ext_len, ext, ext_len) == 0);
 }
+
+
+#pragma mark Encoding
+
+char * SMStringUTF16LEToUTF8(const void *utf16bytes, size_t size, size_t *utf8_len)
+{
+	// Check size.
+	if (size % 2 != 0)
+		return NULL;
+	
+	// Convert.
+	const uint8_t	*input = utf16bytes;
+	size_t			units = size / 2;
+	uint8_t			*result = malloc(units * 3 + 1); // A code unit is at most 3 bytes (a surrogates pair is 4 bytes).
+	uint8_t			*output = result;
+	
+	assert(result);
+	
+	for (size_t i = 0; i < units; )
+	{
+		// > ASCII fast path.
+		size_t ascii_cnt = SMStringUTF16LEToUTF8ASCII(input + i * 2, units - i, output);
+		
+		i += ascii_cnt;
+		output += ascii_cnt;
+		
+		if (i >= units)
+			break;
+		
+		// > Slow path.
+		uint32_t unit = (uint32_t)input[i * 2] | ((uint32_t)input[i * 2 + 1] << 8);
+		
+		i++;
+		
+		if (unit < 0x80)
+			*output++ = (uint8_t)unit;
+		else if (unit < 0x800)
+		{
+			*output++ = (uint8_t)(0xC0 | (unit >> 6));
+			*output++ = (uint8_t)(0x80 | (unit & 0x3F));
+		}
+		else if (unit >= 0xD800 && unit <= 0xDFFF)
+		{
+			// >> Surrogates pair: need a high surrogate followed by a low surrogate.
+			if (unit >= 0xDC00 || i >= units)
+				goto fail;
+			
+			uint32_t low = (uint32_t)input[i * 2] | ((uint32_t)input[i * 2 + 1] << 8);
+			
+			if (low < 0xDC00 || low > 0xDFFF)
+				goto fail;
+			
+			i++;
+			
+			uint32_t code_point = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+			
+			*output++ = (uint8_t)(0xF0 | (code_point >> 18));
+			*output++ = (uint8_t)(0x80 | ((code_point >> 12) & 0x3F));
+			*output++ = (uint8_t)(0x80 | ((code_point >> 6) & 0x3F));
+			*output++ = (uint8_t)(0x80 | (code_point & 0x3F));
+		}
+		else
+		{
+			*output++ = (uint8_t)(0xE0 | (unit >> 12));
+			*output++ = (uint8_t)(0x80 | ((unit >> 6) & 0x3F));
+			*output++ = (uint8_t)(0x80 | (unit & 0x3F));
+		}
+	}
+	
+	// Add terminal zero.
+	*output = 0;
+	
+	if (utf8_len)
+		*utf8_len = (size_t)(output - result);
+	
+	return (char *)result;
+	
+fail:
+	free(result);
+	return NULL;
+}
+
+void * SMStringUTF8ToUTF16LE(const char *utf8str, size_t len, bool terminal_zero, size_t *utf16_size)
+{
+	// Convert.
+	const uint8_t	*input = (const uint8_t *)utf8str;
+	uint8_t			*result = malloc(len * 2 + 2); // A byte is at most a code unit.
+	uint8_t			*output = result;
+	
+	assert(result);
+	
+	for (size_t i = 0; i < len; )
+	{
+		// > ASCII fast path.
+		size_t ascii_cnt = SMStringUTF8ToUTF16LEASCII(input + i, len - i, output);
+		
+		i += ascii_cnt;
+		output += ascii_cnt * 2;
+		
+		if (i >= len)
+			break;
+		
+		// > Slow path: decode one sequence.
+		uint8_t		lead = input[i];
+		size_t		seq_len;
+		uint32_t	code_point, min_code_point;
+		
+		if (lead < 0x80)
+		{
+			seq_len = 1;
+			code_point = lead;
+			min_code_point = 0;
+		}
+		else if ((lead & 0xE0) == 0xC0)
+		{
+			seq_len = 2;
+			code_point = lead & 0x1F;
+			min_code_point = 0x80;
+		}
+		else if ((lead & 0xF0) == 0xE0)
+		{
+			seq_len = 3;
+			code_point = lead & 0x0F;
+			min_code_point = 0x800;
+		}
+		else if ((lead & 0xF8) == 0xF0)
+		{
+			seq_len = 4;
+			code_point = lead & 0x07;
+			min_code_point = 0x10000;
+		}
+		else
+			goto fail;
+		
+		if (seq_len > len - i)
+			goto fail;
+		
+		for (size_t j = 1; j < seq_len; j++)
+		{
+			uint8_t cont = input[i + j];
+			
+			if ((cont & 0xC0) != 0x80)
+				goto fail;
+			
+			code_point = (code_point << 6) | (cont & 0x3F);
+		}
+		
+		i += seq_len;
+		
+		// > Validate (overlong, surrogates, range).
+		if (code_point < min_code_point || (code_point >= 0xD800 && code_point <= 0xDFFF) || code_point > 0x10FFFF)
+			goto fail;
+		
+		// > Encode.
+		if (code_point < 0x10000)
+		{
+			*output++ = (uint8_t)(code_point & 0xFF);
+			*output++ = (uint8_t)(code_point >> 8);
+		}
+		else
+		{
+			uint32_t high = 0xD800 + ((code_point - 0x10000) >> 10);
+			uint32_t low = 0xDC00 + ((code_point - 0x10000) & 0x3FF);
+			
+			*output++ = (uint8_t)(high & 0xFF);
+			*output++ = (uint8_t)(high >> 8);
+			*output++ = (uint8_t)(low & 0xFF);
+			*output++ = (uint8_t)(low >> 8);
+		}
+	}
+	
+	// Add terminal zero.
+	if (terminal_zero)
+	{
+		*output++ = 0;
+		*output++ = 0;
+	}
+	
+	if (utf16_size)
+		*utf16_size = (size_t)(output - result);
+	
+	return result;
+	
+fail:
+	free(result);
+	return NULL;
+}
+
+static size_t SMStringUTF16LEToUTF8ASCII(const uint8_t *utf16bytes, size_t units, uint8_t *output)
+{
+	// Narrow the longest ASCII prefix. Return the count of converted code units.
+	size_t i = 0;
+	
+#if SM_STRING_SSE2
+	const __m128i non_ascii = _mm_set1_epi16((short)0xFF80);
+	const __m128i zero = _mm_setzero_si128();
+	
+	for (; i + 8 <= units; i += 8)
+	{
+		__m128i chunk = _mm_loadu_si128((const __m128i *)(utf16bytes + i * 2));
+		
+		if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(chunk, non_ascii), zero)) != 0xFFFF)
+			break;
+		
+		_mm_storel_epi64((__m128i *)(output + i), _mm_packus_epi16(chunk, chunk));
+	}
+#elif SM_STRING_NEON
+	for (; i + 8 <= units; i += 8)
+	{
+		uint16x8_t chunk = vreinterpretq_u16_u8(vld1q_u8(utf16bytes + i * 2));
+		
+		if (vmaxvq_u16(chunk) >= 0x80)
+			break;
+		
+		vst1_u8(output + i, vmovn_u16(chunk));
+	}
+#endif
+	
+	for (; i < units; i++)
+	{
+		if (utf16bytes[i * 2] >= 0x80 || utf16bytes[i * 2 + 1] != 0)
+			break;
+		
+		output[i] = utf16bytes[i * 2];
+	}
+	
+	return i;
+}
+
+static size_t SMStringUTF8ToUTF16LEASCII(const uint8_t *utf8bytes, size_t len, uint8_t *output)
+{
+	// Widen the longest ASCII prefix. Return the count of converted bytes.
+	size_t i = 0;
+	
+#if SM_STRING_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	
+	for (; i + 16 <= len; i += 16)
+	{
+		__m128i chunk = _mm_loadu_si128((const __m128i *)(utf8bytes + i));
+		
+		if (_mm_movemask_epi8(chunk) != 0)
+			break;
+		
+		_mm_storeu_si128((__m128i *)(output + i * 2), _mm_unpacklo_epi8(chunk, zero));
+		_mm_storeu_si128((__m128i *)(output + i * 2 + 16), _mm_unpackhi_epi8(chunk, zero));
+	}
+#elif SM_STRING_NEON
+	for (; i + 16 <= len; i += 16)
+	{
+		uint8x16_t chunk = vld1q_u8(utf8bytes + i);
+		
+		if (vmaxvq_u8(chunk) >= 0x80)
+			break;
+		
+		vst1q_u8(output + i * 2, vreinterpretq_u8_u16(vmovl_u8(vget_low_u8(chunk))));
+		vst1q_u8(output + i * 2 + 16, vreinterpretq_u8_u16(vmovl_u8(vget_high_u8(chunk))));
+	}
+#endif
+	
+	for (; i < len; i++)
+	{
+		if (utf8bytes[i] >= 0x80)
+			break;
+		
+		output[i * 2] = utf8bytes[i];
+		output[i * 2 + 1] = 0;
+	}
+	
+	return i;
+}
+
+
+#if HAS_ICONV
+
+#pragma mark Encoding (iconv)
+
+char * SMStringUTF16LEToUTF8Iconv(const void *utf16bytes, size_t size, size_t *utf8_len)
+{
+	char *result = NULL;
+	
+	// Create converter.
+#ifdef HAS_LOCK
+	static os_unfair_lock	lock = OS_UNFAIR_LOCK_INIT;
+	static iconv_t			conv = NULL;
+
+	os_unfair_lock_lock(&lock);
+	
+#else
+	iconv_t conv = NULL;
+#endif
+	
+	if (!conv)
+		conv = iconv_open("UTF-8", "UTF-16LE");
+	
+	if (conv == (iconv_t)-1)
+	{
+		conv = NULL;
+		goto finish;
+	}
+	
+	// Convert.
+	size_t	strInputSize = size;
+	char	*strInput = (char *)utf16bytes;
+
+	size_t	strResultLenMax = strInputSize * 3 + 1;
+	char	*strResultBuffer = malloc(strResultLenMax);
+	char	*strResult = strResultBuffer;
+	
+	assert(strResultBuffer);
+
+	if (iconv(conv, (char **)&strInput, &strInputSize, &strResult, &strResultLenMax) == (size_t)(-1) || strInputSize != 0)
+	{
+		free(strResultBuffer);
+		goto finish;
+	}
+	
+	// Add terminal zero.
+	if (strResultLenMax < 1)
+	{
+		free(strResultBuffer);
+		goto finish;
+	}
+	
+	*strResult = 0;
+	
+	// Finish.
+	result = strResultBuffer;
+	
+	if (utf8_len)
+		*utf8_len = (size_t)(strResult - strResultBuffer);
+	
+finish:
+#ifdef HAS_LOCK
+	if (conv)
+		iconv(conv, NULL, NULL, NULL, NULL);
+	
+	os_unfair_lock_unlock(&lock);
+#else
+	if (conv)
+		iconv_close(conv);
+#endif
+	
+	return result;
+}
+
+void * SMStringUTF8ToUTF16LEIconv(const char *utf8str, size_t len, bool terminal_zero, size_t *utf16_size)
+{
+	char *result = NULL;
+	
+	// Create converter.
+#ifdef HAS_LOCK
+	static os_unfair_lock	lock = OS_UNFAIR_LOCK_INIT;
+	static iconv_t			conv = NULL;
+
+	os_unfair_lock_lock(&lock);
+	
+#else
+	iconv_t conv = NULL;
+#endif
+	
+	if (!conv)
+		conv = iconv_open("UTF-16LE", "UTF-8");
+	
+	if (conv == (iconv_t)-1)
+	{
+		conv = NULL;
+		goto finish;
+	}
+	
+	// Convert.
+	size_t	strInputSize = len;
+	char	*strInput = (char *)utf8str;
+
+	size_t	strResultLenMax = strInputSize * 2 + 2;
+	char	*strResultBuffer = malloc(strResultLenMax);
+	char	*strResult = strResultBuffer;
+	
+	assert(strResultBuffer);
+
+	if (iconv(conv, (char **)&strInput, &strInputSize, &strResult, &strResultLenMax) == (size_t)(-1) || strInputSize != 0)
+	{
+		free(strResultBuffer);
+		goto finish;
+	}
+	
+	// Add terminal zero.
+	if (terminal_zero)
+	{
+		if (strResultLenMax < 2)
+		{
+			free(strResultBuffer);
+			goto finish;
+		}
+		
+		strResult[0] = 0;
+		strResult[1] = 0;
+
+		strResult += 2;
+	}
+	
+	// Finish.
+	result = strResultBuffer;
+	
+	if (utf16_size)
+		*utf16_size = (size_t)(strResult - strResultBuffer);
+	
+finish:
+#ifdef HAS_LOCK
+	if (conv)
+		iconv(conv, NULL, NULL, NULL, NULL);
+	
+	os_unfair_lock_unlock(&lock);
+#else
+	if (conv)
+		iconv_close(conv);
+#endif
+	
+	return result;
+}
+
+#endif
@@ -23,6 +23,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <stddef.h>
 #include <stdbool.h>
 
 
@@ -30,7 +31,20 @@
 char * SMStringDuplicate(const void *str, size_t len);
 char * SMStringTrimCharacter(char *str, const char *chars, size_t chars_cnt, bool free_str);
 char * SMStringReplaceString(char *str, const char *value, const char *replacement, bool free_str);
+char ** SMStringSplitArguments(const char *str, size_t *count); // Shell-like: blank separated, '' and "" quotes, \ escapes. NULL terminated, freed with a single free(). NULL on unterminated quote.
 
 // Path.
 char *	SMStringPathAppendComponent(const char *path, const char *component);
 bool	SMStringPathHasExtension(const char *path, const char *ext);
+
+// Encoding.
+// > Strict conversions: unpaired surrogates, overlong / truncated sequences and out of range code points fail (NULL).
+// > Zero code units are converted like any other character. Results must be freed by the caller.
+char * SMStringUTF16LEToUTF8(const void *utf16bytes, size_t size, size_t *utf8_len);								// Zero-terminated.
+void * SMStringUTF8ToUTF16LE(const char *utf8str, size_t len, bool terminal_zero, size_t *utf16_size);
+
+#if SM_ICONV
+// > iconv based versions, kept as a reference for unit tests (build with SM_ICONV=1, and link to iconv).
+char * SMStringUTF16LEToUTF8Iconv(const void *utf16bytes, size_t size, size_t *utf8_len);
+void * SMStringUTF8ToUTF16LEIconv(const char *utf8str, size_t len, bool terminal_zero, size_t *utf16_size);
+#endif
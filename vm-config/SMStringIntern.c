@@ -0,0 +1,193 @@
+/*
+ *  SMStringIntern.c
+ *
+ *  Copyright 2022 Avérous Julien-Pierre
+ *
+ *  This file is part of vm-config.
+ *
+ *  vm-config is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vm-config is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vm-config.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+#include "SMStringIntern.h"
+
+#include "SMHashHelper.h"
+
+
+/*
+** Prototypes
+*/
+#pragma mark - Prototypes
+
+static const SMInternedString *	SMStringInternSearch(SMStringInternTable *table, const char *str, size_t size, uint64_t hash, size_t *slot);
+static void						SMStringInternResize(SMStringInternTable *table, size_t size);
+
+static bool SMStringInternEqual(const SMInternedString *interned, const char *str, size_t size);
+
+
+
+/*
+** Functions
+*/
+#pragma mark - Functions
+
+#pragma mark Table
+
+void SMStringInternTableFree(SMStringInternTable *table)
+{
+	// > Interned strings are freed with the arena.
+	free(table->slots);
+
+	table->slots = NULL;
+	table->size = 0;
+	table->count = 0;
+}
+
+
+#pragma mark Interning
+
+const SMInternedString * SMStringIntern(SMStringInternTable *table, const char *str, size_t size)
+{
+	uint64_t	hash = SMStringInternHash(str, size);
+	size_t		slot = 0;
+
+	// Already interned.
+	const SMInternedString *result = SMStringInternSearch(table, str, size, hash, &slot);
+
+	if (result)
+		return result;
+
+	// Insert.
+	if ((table->count + 1) * 2 > table->size)
+	{
+		SMStringInternResize(table, SMHashTableSizeForCount(table->count + 1));
+		SMStringInternSearch(table, str, size, hash, &slot);
+	}
+
+	SMInternedString *interned = SMArenaAlloc(table->arena, sizeof(SMInternedString) + size + 1);
+
+	interned->hash = hash;
+	interned->size = size;
+
+	for (size_t i = 0; i < size; i++)
+		interned->string[i] = (str[i] >= 'A' && str[i] <= 'Z') ? str[i] + ('a' - 'A') : str[i];
+
+	interned->string[size] = 0;
+
+	table->slots[slot] = interned;
+	table->count++;
+
+	return interned;
+}
+
+const SMInternedString * SMStringInternLookup(SMStringInternTable *table, const char *str, size_t size)
+{
+	return SMStringInternSearch(table, str, size, SMStringInternHash(str, size), NULL);
+}
+
+static const SMInternedString * SMStringInternSearch(SMStringInternTable *table, const char *str, size_t size, uint64_t hash, size_t *slot)
+{
+	if (table->size == 0)
+		return NULL;
+
+	size_t mask = table->size - 1;
+	size_t i = hash & mask;
+
+	for (; table->slots[i]; i = (i + 1) & mask)
+	{
+		if (table->slots[i]->hash == hash && SMStringInternEqual(table->slots[i], str, size))
+			return table->slots[i];
+	}
+
+	if (slot)
+		*slot = i;
+
+	return NULL;
+}
+
+static void SMStringInternResize(SMStringInternTable *table, size_t size)
+{
+	SMInternedString	**old_slots = table->slots;
+	size_t				old_size = table->size;
+
+	table->slots = calloc(size, sizeof(SMInternedString *));
+	table->size = size;
+
+	assert(table->slots);
+
+	size_t mask = size - 1;
+
+	for (size_t i = 0; i < old_size; i++)
+	{
+		if (!old_slots[i])
+			continue;
+
+		size_t j = old_slots[i]->hash & mask;
+
+		while (table->slots[j])
+			j = (j + 1) & mask;
+
+		table->slots[j] = old_slots[i];
+	}
+
+	free(old_slots);
+}
+
+
+#pragma mark Hash
+
+uint64_t SMStringInternHash(const char *str, size_t size)
+{
+	uint64_t hash = SMHashFNV1aInit;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		char c = str[i];
+
+		if (c >= 'A' && c <= 'Z')
+			c += ('a' - 'A');
+
+		hash ^= (uint8_t)c;
+		hash *= SMHashFNV1aPrime;
+	}
+
+	return hash;
+}
+
+
+#pragma mark Helpers
+
+static bool SMStringInternEqual(const SMInternedString *interned, const char *str, size_t size)
+{
+	if (interned->size != size)
+		return false;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		char c = str[i];
+
+		if (c >= 'A' && c <= 'Z')
+			c += ('a' - 'A');
+
+		if (interned->string[i] != c)
+			return false;
+	}
+
+	return true;
+}
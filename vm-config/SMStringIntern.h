@@ -0,0 +1,77 @@
+/*
+ *  SMStringIntern.h
+ *
+ *  Copyright 2022 Avérous Julien-Pierre
+ *
+ *  This file is part of vm-config.
+ *
+ *  vm-config is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vm-config is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vm-config.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "SMArena.h"
+
+
+/*
+** Defines
+*/
+#pragma mark - Defines
+
+#define SMStringInternTableInit(Arena) { .arena = (Arena) }
+
+
+/*
+** Types
+*/
+#pragma mark - Types
+
+typedef struct SMInternedString
+{
+	uint64_t	hash;
+	size_t		size;
+	char		string[]; // ASCII lowercase, zero-terminated.
+} SMInternedString;
+
+typedef struct SMStringInternTable
+{
+	SMArena				*arena; // Storage of interned strings (not owned).
+
+	SMInternedString	**slots; // Open addressing, linear probing.
+	size_t				size;
+	size_t				count;
+} SMStringInternTable;
+
+
+/*
+** Functions
+*/
+#pragma mark - Functions
+
+// Table.
+// > Interned strings are allocated in the table arena, and live as long as it. Tables are not thread-safe.
+void SMStringInternTableFree(SMStringInternTable *table);
+
+// Interning.
+// > Strings are interned in ASCII lowercase form, so two strings differing only by case share the same instance.
+const SMInternedString *	SMStringIntern(SMStringInternTable *table, const char *str, size_t size);
+const SMInternedString *	SMStringInternLookup(SMStringInternTable *table, const char *str, size_t size); // NULL if the string was never interned.
+
+// Hash.
+uint64_t SMStringInternHash(const char *str, size_t size); // Hash of the ASCII lowercase form.
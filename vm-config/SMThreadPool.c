@@ -0,0 +1,417 @@
+/*
+ *  SMThreadPool.c
+ *
+ *  Copyright 2022 Avérous Julien-Pierre
+ *
+ *  This file is part of vm-config.
+ *
+ *  vm-config is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vm-config is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vm-config.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "SMThreadPool.h"
+
+
+/*
+** Defines
+*/
+#pragma mark - Defines
+
+#define SMThreadPoolQueueMinCapacity	64
+
+
+/*
+** Types
+*/
+#pragma mark - Types
+
+typedef struct
+{
+	SMThreadPoolTask	task;
+	void				*context;
+} SMThreadPoolItem;
+
+typedef struct
+{
+	SMThreadPool	*pool;
+	pthread_t		thread;
+
+	// Queue (ring buffer): the owner pushes & pops at the tail, thieves steal at the head.
+	pthread_mutex_t		mutex;
+	SMThreadPoolItem	*items;
+	size_t				head;
+	size_t				count;
+	size_t				capacity;
+} SMThreadPoolWorker;
+
+typedef struct
+{
+	void	(*function)(size_t idx, void *context);
+	void	*context;
+	size_t	idx;
+} SMThreadPoolApplyItem;
+
+struct SMThreadPool
+{
+	SMThreadPoolWorker	*workers;
+	size_t				workers_cnt;
+	size_t				next_worker; // Round-robin for tasks added from outside the pool.
+
+	size_t queued;	// Tasks waiting in queues.
+	size_t pending;	// Tasks added & not yet finished.
+	bool	stopping;
+
+	pthread_mutex_t	mutex;
+	pthread_cond_t	work_cond;
+	pthread_cond_t	done_cond;
+};
+
+
+/*
+** Globals
+*/
+#pragma mark - Globals
+
+static __thread SMThreadPoolWorker *g_current_worker;
+
+
+/*
+** Prototypes
+*/
+#pragma mark - Prototypes
+
+// Workers.
+static void *	SMThreadPoolWorkerMain(void *context);
+static bool		SMThreadPoolWorkerNextItem(SMThreadPoolWorker *worker, SMThreadPoolItem *item);
+
+// Queues.
+static void SMThreadPoolQueuePush(SMThreadPoolWorker *worker, SMThreadPoolItem item);
+static bool SMThreadPoolQueuePopTail(SMThreadPoolWorker *worker, SMThreadPoolItem *item);
+static bool SMThreadPoolQueuePopHead(SMThreadPoolWorker *worker, SMThreadPoolItem *item);
+
+// Helpers.
+static void SMThreadPoolApplyTask(SMThreadPool *pool, void *context);
+
+
+
+/*
+** Functions
+*/
+#pragma mark - Functions
+
+#pragma mark Instance
+
+SMThreadPool * SMThreadPoolCreate(size_t threads_count)
+{
+	SMThreadPool *pool = calloc(1, sizeof(SMThreadPool));
+
+	assert(pool);
+
+	// Size.
+	if (threads_count == 0)
+		threads_count = SMThreadPoolDefaultThreadsCount();
+
+	// Synchronization.
+	pthread_mutex_init(&pool->mutex, NULL);
+	pthread_cond_init(&pool->work_cond, NULL);
+	pthread_cond_init(&pool->done_cond, NULL);
+
+	// Workers.
+	pool->workers = calloc(threads_count, sizeof(SMThreadPoolWorker));
+	pool->workers_cnt = threads_count;
+
+	assert(pool->workers);
+
+	for (size_t i = 0; i < threads_count; i++)
+	{
+		pool->workers[i].pool = pool;
+		pthread_mutex_init(&pool->workers[i].mutex, NULL);
+	}
+
+	for (size_t i = 0; i < threads_count; i++)
+	{
+		int err = pthread_create(&pool->workers[i].thread, NULL, SMThreadPoolWorkerMain, &pool->workers[i]);
+
+		assert(err == 0);
+		(void)err;
+	}
+
+	return pool;
+}
+
+void SMThreadPoolFree(SMThreadPool *pool)
+{
+	if (!pool)
+		return;
+
+	// Finish work.
+	SMThreadPoolWait(pool);
+
+	// Stop workers.
+	pthread_mutex_lock(&pool->mutex);
+	pool->stopping = true;
+	pthread_cond_broadcast(&pool->work_cond);
+	pthread_mutex_unlock(&pool->mutex);
+
+	for (size_t i = 0; i < pool->workers_cnt; i++)
+		pthread_join(pool->workers[i].thread, NULL);
+
+	// Free.
+	for (size_t i = 0; i < pool->workers_cnt; i++)
+	{
+		pthread_mutex_destroy(&pool->workers[i].mutex);
+		free(pool->workers[i].items);
+	}
+
+	free(pool->workers);
+
+	pthread_cond_destroy(&pool->done_cond);
+	pthread_cond_destroy(&pool->work_cond);
+	pthread_mutex_destroy(&pool->mutex);
+
+	free(pool);
+}
+
+
+#pragma mark Properties
+
+size_t SMThreadPoolThreadsCount(SMThreadPool *pool)
+{
+	return pool->workers_cnt;
+}
+
+size_t SMThreadPoolDefaultThreadsCount(void)
+{
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return (cpus > 0 ? (size_t)cpus : 1);
+}
+
+
+#pragma mark Tasks
+
+void SMThreadPoolAddTask(SMThreadPool *pool, SMThreadPoolTask task, void *context)
+{
+	SMThreadPoolWorker *worker = g_current_worker;
+
+	// > Note: counters are updated under the pool lock while pushing, so a worker can't account for the task before they are.
+	pthread_mutex_lock(&pool->mutex);
+
+	// Select queue.
+	if (!worker || worker->pool != pool)
+	{
+		worker = &pool->workers[pool->next_worker];
+		pool->next_worker = (pool->next_worker + 1) % pool->workers_cnt;
+	}
+
+	// Queue.
+	SMThreadPoolQueuePush(worker, (SMThreadPoolItem){ .task = task, .context = context });
+
+	pool->queued++;
+	pool->pending++;
+
+	// Wake up a worker.
+	pthread_cond_signal(&pool->work_cond);
+	pthread_mutex_unlock(&pool->mutex);
+}
+
+void SMThreadPoolWait(SMThreadPool *pool)
+{
+	// > Note: must not be called from a task of the pool.
+	pthread_mutex_lock(&pool->mutex);
+
+	while (pool->pending > 0)
+		pthread_cond_wait(&pool->done_cond, &pool->mutex);
+
+	pthread_mutex_unlock(&pool->mutex);
+}
+
+
+#pragma mark Helpers
+
+void SMThreadPoolApply(SMThreadPool *pool, size_t count, void (*function)(size_t idx, void *context), void *context)
+{
+	SMThreadPoolApplyItem *items = malloc(count * sizeof(SMThreadPoolApplyItem));
+
+	assert(items || count == 0);
+
+	// Add tasks in reverse order, so each worker starts with its lowest indexes.
+	for (size_t i = count; i > 0; i--)
+	{
+		items[i - 1] = (SMThreadPoolApplyItem){ .function = function, .context = context, .idx = i - 1 };
+		SMThreadPoolAddTask(pool, SMThreadPoolApplyTask, &items[i - 1]);
+	}
+
+	SMThreadPoolWait(pool);
+
+	free(items);
+}
+
+static void SMThreadPoolApplyTask(SMThreadPool *pool, void *context)
+{
+	SMThreadPoolApplyItem *item = context;
+
+	item->function(item->idx, item->context);
+}
+
+
+
+/*
+** Workers
+*/
+#pragma mark - Workers
+
+static void * SMThreadPoolWorkerMain(void *context)
+{
+	SMThreadPoolWorker	*worker = context;
+	SMThreadPool		*pool = worker->pool;
+
+	g_current_worker = worker;
+
+	while (1)
+	{
+		// Wait for work.
+		pthread_mutex_lock(&pool->mutex);
+
+		while (pool->queued == 0 && !pool->stopping)
+			pthread_cond_wait(&pool->work_cond, &pool->mutex);
+
+		bool stopping = (pool->queued == 0 && pool->stopping);
+
+		pthread_mutex_unlock(&pool->mutex);
+
+		if (stopping)
+			break;
+
+		// Run tasks while we find some.
+		SMThreadPoolItem item;
+
+		while (SMThreadPoolWorkerNextItem(worker, &item))
+		{
+			pthread_mutex_lock(&pool->mutex);
+			pool->queued--;
+			pthread_mutex_unlock(&pool->mutex);
+
+			item.task(pool, item.context);
+
+			pthread_mutex_lock(&pool->mutex);
+
+			if (--pool->pending == 0)
+				pthread_cond_broadcast(&pool->done_cond);
+
+			pthread_mutex_unlock(&pool->mutex);
+		}
+	}
+
+	return NULL;
+}
+
+static bool SMThreadPoolWorkerNextItem(SMThreadPoolWorker *worker, SMThreadPoolItem *item)
+{
+	SMThreadPool *pool = worker->pool;
+
+	// Own queue first, most recent task.
+	if (SMThreadPoolQueuePopTail(worker, item))
+		return true;
+
+	// Steal oldest task of other workers.
+	size_t idx = (size_t)(worker - pool->workers);
+
+	for (size_t i = 1; i < pool->workers_cnt; i++)
+	{
+		if (SMThreadPoolQueuePopHead(&pool->workers[(idx + i) % pool->workers_cnt], item))
+			return true;
+	}
+
+	return false;
+}
+
+
+
+/*
+** Queues
+*/
+#pragma mark - Queues
+
+static void SMThreadPoolQueuePush(SMThreadPoolWorker *worker, SMThreadPoolItem item)
+{
+	pthread_mutex_lock(&worker->mutex);
+
+	// Grow.
+	if (worker->count == worker->capacity)
+	{
+		size_t				capacity = (worker->capacity ? worker->capacity * 2 : SMThreadPoolQueueMinCapacity);
+		SMThreadPoolItem	*items = malloc(capacity * sizeof(SMThreadPoolItem));
+
+		assert(items);
+
+		for (size_t i = 0; i < worker->count; i++)
+			items[i] = worker->items[(worker->head + i) % worker->capacity];
+
+		free(worker->items);
+
+		worker->items = items;
+		worker->head = 0;
+		worker->capacity = capacity;
+	}
+
+	// Push at tail.
+	worker->items[(worker->head + worker->count) % worker->capacity] = item;
+	worker->count++;
+
+	pthread_mutex_unlock(&worker->mutex);
+}
+
+static bool SMThreadPoolQueuePopTail(SMThreadPoolWorker *worker, SMThreadPoolItem *item)
+{
+	bool result = false;
+
+	pthread_mutex_lock(&worker->mutex);
+
+	if (worker->count > 0)
+	{
+		worker->count--;
+		*item = worker->items[(worker->head + worker->count) % worker->capacity];
+		result = true;
+	}
+
+	pthread_mutex_unlock(&worker->mutex);
+
+	return result;
+}
+
+static bool SMThreadPoolQueuePopHead(SMThreadPoolWorker *worker, SMThreadPoolItem *item)
+{
+	bool result = false;
+
+	pthread_mutex_lock(&worker->mutex);
+
+	if (worker->count > 0)
+	{
+		*item = worker->items[worker->head];
+		worker->head = (worker->head + 1) % worker->capacity;
+		worker->count--;
+		result = true;
+	}
+
+	pthread_mutex_unlock(&worker->mutex);
+
+	return result;
+}
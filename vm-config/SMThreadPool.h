@@ -0,0 +1,58 @@
+/*
+ *  SMThreadPool.h
+ *
+ *  Copyright 2022 Avérous Julien-Pierre
+ *
+ *  This file is part of vm-config.
+ *
+ *  vm-config is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vm-config is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vm-config.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+
+/*
+** Types
+*/
+#pragma mark - Types
+
+typedef struct SMThreadPool SMThreadPool;
+
+typedef void (*SMThreadPoolTask)(SMThreadPool *pool, void *context);
+
+
+/*
+** Functions
+*/
+#pragma mark - Functions
+
+// Instance.
+// > Each worker owns a task queue: it runs its most recent tasks first, and steals the oldest tasks of other workers when its own queue is empty.
+SMThreadPool *	SMThreadPoolCreate(size_t threads_count); // 0 for the number of online CPUs.
+void			SMThreadPoolFree(SMThreadPool *pool); // Waits for pending tasks.
+
+// Properties.
+size_t SMThreadPoolThreadsCount(SMThreadPool *pool);
+size_t SMThreadPoolDefaultThreadsCount(void); // Number of online CPUs.
+
+// Tasks.
+// > Tasks can add other tasks. Added from a worker, they are queued on this worker.
+void SMThreadPoolAddTask(SMThreadPool *pool, SMThreadPoolTask task, void *context);
+void SMThreadPoolWait(SMThreadPool *pool); // Waits for all tasks, including those added in the meantime.
+
+// Helpers.
+void SMThreadPoolApply(SMThreadPool *pool, size_t count, void (*function)(size_t idx, void *context), void *context); // Runs function for each index in [0, count), and waits.
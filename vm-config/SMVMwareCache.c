@@ -0,0 +1,278 @@
+/*
+ *  SMVMwareCache.c
+ *
+ *  Copyright 2022 Avérous Julien-Pierre
+ *
+ *  This file is part of vm-config.
+ *
+ *  vm-config is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vm-config is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vm-config.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+
+#include <sys/stat.h>
+
+#include "SMVMwareCache.h"
+
+#include "SMHashHelper.h"
+
+
+/*
+** Defines
+*/
+#pragma mark - Defines
+
+#if defined(__APPLE__)
+#  define SMStatMTime(St) ((St).st_mtimespec)
+#else
+#  define SMStatMTime(St) ((St).st_mtim)
+#endif
+
+
+/*
+** Types
+*/
+#pragma mark - Types
+
+typedef enum
+{
+	SMVMwareCacheKindVMX,
+	SMVMwareCacheKindNVRAM,
+} SMVMwareCacheKind;
+
+typedef struct
+{
+	// Key.
+	SMVMwareCacheKind	kind;
+	char				*path;
+	uint64_t			hash;
+
+	// Validity.
+	struct stat st;
+
+	// Content.
+	void		*instance;
+	uint64_t	last_use;
+} SMVMwareCacheEntry;
+
+struct SMVMwareCache
+{
+	SMVMwareCacheEntry	*entries;
+	size_t				entries_cnt;
+	size_t				capacity;
+
+	uint64_t clock;
+
+	size_t hits;
+	size_t misses;
+};
+
+
+/*
+** Prototypes
+*/
+#pragma mark - Prototypes
+
+static void *	SMVMwareCacheGet(SMVMwareCache *cache, SMVMwareCacheKind kind, const char *path, SMError **error);
+static void		SMVMwareCacheEntryRelease(SMVMwareCacheEntry *entry);
+
+static bool SMVMwareCacheSameFile(const struct stat *st1, const struct stat *st2);
+
+
+
+/*
+** Functions
+*/
+#pragma mark - Functions
+
+#pragma mark Instance
+
+SMVMwareCache * SMVMwareCacheCreate(size_t capacity)
+{
+	SMVMwareCache *cache = calloc(1, sizeof(SMVMwareCache));
+
+	assert(cache);
+
+	// > Returned instances must survive the next call (e.g. a VMX while getting its NVRAM).
+	cache->capacity = (capacity < 2 ? 2 : capacity);
+	cache->entries = calloc(cache->capacity, sizeof(SMVMwareCacheEntry));
+
+	assert(cache->entries);
+
+	return cache;
+}
+
+void SMVMwareCacheFree(SMVMwareCache *cache)
+{
+	if (!cache)
+		return;
+
+	for (size_t i = 0; i < cache->entries_cnt; i++)
+		SMVMwareCacheEntryRelease(&cache->entries[i]);
+
+	free(cache->entries);
+	free(cache);
+}
+
+
+#pragma mark Instances
+
+SMVMwareVMX * SMVMwareCacheGetVMX(SMVMwareCache *cache, const char *vmx_file_path, SMError **error)
+{
+	return SMVMwareCacheGet(cache, SMVMwareCacheKindVMX, vmx_file_path, error);
+}
+
+SMVMwareNVRAM * SMVMwareCacheGetNVRAM(SMVMwareCache *cache, const char *nvram_file_path, SMError **error)
+{
+	return SMVMwareCacheGet(cache, SMVMwareCacheKindNVRAM, nvram_file_path, error);
+}
+
+static void * SMVMwareCacheGet(SMVMwareCache *cache, SMVMwareCacheKind kind, const char *path, SMError **error)
+{
+	// Stat file.
+	// > Done before opening: if the file is replaced in-between, the key is older than the content, and the next call opens it again.
+	struct stat st;
+
+	if (stat(path, &st) == -1)
+	{
+		SMSetErrorPtr(error, "vmware-cache", errno, "can't stat the file (%d - %s)", errno, strerror(errno));
+		return NULL;
+	}
+
+	// Search entry.
+	uint64_t			hash = SMHashBytes(path, strlen(path));
+	SMVMwareCacheEntry	*entry = NULL;
+
+	for (size_t i = 0; i < cache->entries_cnt; i++)
+	{
+		SMVMwareCacheEntry *candidate = &cache->entries[i];
+
+		if (candidate->hash == hash && candidate->kind == kind && strcmp(candidate->path, path) == 0)
+		{
+			entry = candidate;
+			break;
+		}
+	}
+
+	// Hit.
+	if (entry && SMVMwareCacheSameFile(&entry->st, &st))
+	{
+		cache->hits++;
+		entry->last_use = ++cache->clock;
+
+		return entry->instance;
+	}
+
+	cache->misses++;
+
+	// Open instance.
+	void *instance = NULL;
+
+	switch (kind)
+	{
+		case SMVMwareCacheKindVMX:
+			instance = SMVMwareVMXOpen(path, error);
+			break;
+
+		case SMVMwareCacheKindNVRAM:
+			instance = SMVMwareNVRAMOpen(path, error);
+			break;
+	}
+
+	// Select entry: stale one, free one, or least recently used one.
+	if (entry)
+		SMVMwareCacheEntryRelease(entry);
+	else if (cache->entries_cnt < cache->capacity)
+		entry = &cache->entries[cache->entries_cnt++];
+	else
+	{
+		entry = &cache->entries[0];
+
+		for (size_t i = 1; i < cache->entries_cnt; i++)
+		{
+			if (cache->entries[i].last_use < entry->last_use)
+				entry = &cache->entries[i];
+		}
+
+		SMVMwareCacheEntryRelease(entry);
+	}
+
+	// Store instance.
+	// > On failure, fill the released slot with the last entry, so entries stay packed.
+	if (!instance)
+	{
+		*entry = cache->entries[--cache->entries_cnt];
+		return NULL;
+	}
+
+	entry->kind = kind;
+	entry->path = strdup(path);
+	entry->hash = hash;
+	entry->st = st;
+	entry->instance = instance;
+	entry->last_use = ++cache->clock;
+
+	assert(entry->path);
+
+	return instance;
+}
+
+static void SMVMwareCacheEntryRelease(SMVMwareCacheEntry *entry)
+{
+	switch (entry->kind)
+	{
+		case SMVMwareCacheKindVMX:
+			SMVMwareVMXFree(entry->instance);
+			break;
+
+		case SMVMwareCacheKindNVRAM:
+			SMVMwareNVRAMFree(entry->instance);
+			break;
+	}
+
+	free(entry->path);
+
+	memset(entry, 0, sizeof(*entry));
+}
+
+
+#pragma mark Statistics
+
+size_t SMVMwareCacheHitsCount(SMVMwareCache *cache)
+{
+	return cache->hits;
+}
+
+size_t SMVMwareCacheMissesCount(SMVMwareCache *cache)
+{
+	return cache->misses;
+}
+
+
+#pragma mark Helpers
+
+static bool SMVMwareCacheSameFile(const struct stat *st1, const struct stat *st2)
+{
+	return st1->st_dev == st2->st_dev &&
+		st1->st_ino == st2->st_ino &&
+		st1->st_size == st2->st_size &&
+		SMStatMTime(*st1).tv_sec == SMStatMTime(*st2).tv_sec &&
+		SMStatMTime(*st1).tv_nsec == SMStatMTime(*st2).tv_nsec;
+}
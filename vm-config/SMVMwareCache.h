@@ -0,0 +1,60 @@
+/*
+ *  SMVMwareCache.h
+ *
+ *  Copyright 2022 Avérous Julien-Pierre
+ *
+ *  This file is part of vm-config.
+ *
+ *  vm-config is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vm-config is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vm-config.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include "SMError.h"
+
+#include "SMVMwareVMX.h"
+#include "SMVMwareNVRAM.h"
+
+
+/*
+** Types
+*/
+#pragma mark - Types
+
+typedef struct SMVMwareCache SMVMwareCache;
+
+
+/*
+** Functions
+*/
+#pragma mark - Functions
+
+// Instance.
+// > Keeps up to capacity (at least 2) least recently used VMX & NVRAM instances, keyed by path.
+// > Not thread-safe. Cached instances must not be modified: they are shared by all the callers of the same path.
+SMVMwareCache *	SMVMwareCacheCreate(size_t capacity);
+void			SMVMwareCacheFree(SMVMwareCache *cache);
+
+// Instances.
+// > A cached instance is reused while its file keeps the same device, inode, modification time and size, else it's opened again.
+// > Returned instances are owned by the cache, and stay valid until one of the next 'capacity - 1' calls.
+SMVMwareVMX *	SMVMwareCacheGetVMX(SMVMwareCache *cache, const char *vmx_file_path, SMError **error);
+SMVMwareNVRAM *	SMVMwareCacheGetNVRAM(SMVMwareCache *cache, const char *nvram_file_path, SMError **error);
+
+// Statistics.
+size_t SMVMwareCacheHitsCount(SMVMwareCache *cache);
+size_t SMVMwareCacheMissesCount(SMVMwareCache *cache);
@@ -27,20 +27,27 @@
 #include <assert.h>
 #include <fcntl.h>
 #include <errno.h>
-#include <iconv.h>
+
+#include <limits.h>
 
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/param.h>
+#include <sys/uio.h>
 
-#if __has_include(<os/lock.h>)
-#  include <os/lock.h>
-#  define HAS_LOCK 1
+#if defined(__APPLE__)
+#  include <sys/clonefile.h>
+#elif defined(__linux__)
+#  include <sys/ioctl.h>
+#  include <linux/fs.h>
 #endif
 
 #include "SMVMwareNVRAM.h"
 
-#include "SMBytesWritter.h"
+#include "SMStringHelper.h"
+#include "SMIOHelper.h"
+#include "SMHashHelper.h"
+#include "SMArena.h"
 
 
 /*
@@ -67,19 +74,120 @@
 #define SMFileMagic		{ 'M', 'R', 'V', 'N' }
 #define SMEFINVMagic	{ 'V', 'M', 'W', 'N', 'V', 'R', 'A', 'M' }
 
+#define SMEFINVBlockSize	0x40000
+#define SMFileReadMinCapacity	(64 * 1024) // Streams.
+
+// Serialization.
+#define SMPaddingPageSize	4096
+
+#if defined(__APPLE__)
+#  define SMStatMTime(St) ((St).st_mtimespec)
+#else
+#  define SMStatMTime(St) ((St).st_mtim)
+#endif
+
+// Variables.
+#define SMVariablesMinCapacity	16
+
+// Queries.
+#define SMQueriesLinearMaxCount	8 // Above this count, a multi-query pass hashes variables names instead of comparing them to each query.
+
 
 /*
 ** Types
 */
 #pragma mark - Types
 
+// File.
+typedef struct
+{
+	uint8_t		name[4];
+	uint8_t		subname[4];
+	uint32_t	len;
+} __attribute__((packed)) nvram_entry_t;
+
+typedef struct
+{
+	efi_guid_t	guid;
+	uint32_t	attributes;
+	uint32_t	data_size;
+	uint32_t	name_size;
+} __attribute__((packed)) efi_var_t;
+
+typedef struct
+{
+	nvram_entry_t	entry;
+	uint8_t			magic[8];
+	uint32_t		zero;
+	uint32_t		data_size;
+} __attribute__((packed)) efi_nv_header_t;
+
+// Serialization.
+typedef struct
+{
+	struct iovec	*iov;
+	size_t			iov_cnt;
+	size_t			iov_size;
+} SMIOVecChain;
+
+// Index.
+typedef struct
+{
+	uint64_t					hash;
+	SMVMwareNVRAMEFIVariable	*head; // NULL if the slot is empty.
+	SMVMwareNVRAMEFIVariable	*tail;
+} SMVMwareNVRAMIndexSlot;
+
+// Variables.
+typedef struct
+{
+	const void					*bytes; // NULL if not updated.
+	size_t						size;
+	SMVMwareNVRAMBytesRelease	release;
+	void						*context;
+} SMUpdatedBytes;
+
+typedef struct
+{
+	SMVMwareNVRAMEntry			*parent_entry;
+	size_t						idx;
+	
+	// Variables index.
+	uint64_t					key_hash;
+	SMVMwareNVRAMEFIVariable	*key_next; // Next variable with the same GUID & name.
+	
+	// UTF-8 name (generated on demand).
+	char *utf8_name;
+	
+	// Original bytes.
+	const void	*original_bytes;
+	size_t		original_size;
+	
+	// Serialization (header generated for updated variable).
+	efi_var_t serialized_header;
+	
+	// Updated bytes.
+	SMUpdatedBytes updated_name;
+	SMUpdatedBytes updated_value;
+} SMVMwareNVRAMEFIVariableCold;
+
+// Storage.
+typedef enum
+{
+	SMBytesStorageBorrowed,
+	SMBytesStorageOwned,
+	SMBytesStorageMapped
+} SMBytesStorage;
+
 // API.
 struct SMVMwareNVRAM
 {
 	char *path;
 	
-	char	*bytes;
-	size_t	size;
+	const char		*bytes;
+	size_t			size;
+	SMBytesStorage	bytes_storage;
+	struct stat		bytes_stat; // Only meaningful when opened from a path.
 	
 	uint32_t unknown_value;
 	
@@ -102,9 +210,28 @@ struct SMVMwareNVRAMEntry
 	char	subname[4];
 	char	csubname[5];
 	
-	// Variables.
+	// Variables (parsed on first access).
+	bool						vars_parsed;
+	const void					*vars_bytes;
+	size_t						vars_size;
+	size_t						vars_original_cnt;
+	
+	SMArena						vars_pool;		// SMVMwareNVRAMEFIVariable, packed.
+	SMArena						vars_cold_pool;	// SMVMwareNVRAMEFIVariableCold.
+	
 	SMVMwareNVRAMEFIVariable	**vars;
 	size_t						vars_cnt;
+	size_t						vars_capacity;
+	size_t						vars_removed_cnt; // Removed variables not yet compacted.
+	
+	SMVMwareNVRAMEFIVariable	**vars_detached; // Removed & compacted variables, kept until the entry is freed.
+	size_t						vars_detached_cnt;
+	
+	// Variables index (GUID + UTF-16 name, built on first lookup).
+	bool					index_built;
+	SMVMwareNVRAMIndexSlot	*index;
+	size_t					index_size;
+	size_t					index_cnt;
 	
 	// Original bytes.
 	const void	*original_bytes;
@@ -113,60 +240,40 @@ struct SMVMwareNVRAMEntry
 	const void	*original_content_bytes;
 	size_t		original_content_size;
 	
-	// Serialization.
-	void	*serialized_bytes;
-	size_t	serialized_size;
+	// Serialization (header generated for updated entry).
+	efi_nv_header_t serialized_header;
 };
 
 struct SMVMwareNVRAMEFIVariable
 {
-	SMVMwareNVRAMEntry *parent_entry;
-	
-	// Updated variable.
-	bool updated;
-	
-	// Properties.
+	// Hot fields, used by scans & lookups. Cold ones are stored apart.
 	efi_guid_t	guid;
 	uint32_t	attributes;
-	char		*utf8_name;
-
-	// Original bytes.
-	const void	*original_bytes;
-	size_t		original_size;
 	
-	const void	*original_name_bytes;
-	size_t		original_name_size;
+	uint32_t	name_size;
+	uint32_t	value_size;
 	
-	const void	*original_value_bytes;
-	size_t		original_value_size;
-
-	// Serialization.
-	void		*serialized_bytes;
-	size_t		serialized_size;
+	bool		updated;
+	bool		indexed;
+	bool		removed;
 	
-	// Updated bytes.
-	void		*updated_name_bytes;
-	size_t		updated_name_size;
+	const void	*name_bytes;	// Original bytes, or cold->updated_name.bytes.
+	const void	*value_bytes;	// Original bytes, or cold->updated_value.bytes.
 	
-	void		*updated_value_bytes;
-	size_t		updated_value_size;
+	SMVMwareNVRAMEFIVariableCold *cold;
 };
 
-// File.
-typedef struct
-{
-	uint8_t		name[4];
-	uint8_t		subname[4];
-	uint32_t	len;
-} __attribute__((packed)) nvram_entry_t;
-
-typedef struct
+struct SMVMwareNVRAMQuery
 {
 	efi_guid_t	guid;
-	uint32_t	attributes;
-	uint32_t	data_size;
-	uint32_t	name_size;
-} __attribute__((packed)) efi_var_t;
+	uint64_t	hash; // Variables index hash.
+	
+	char		*utf8_name; // Zero-terminated, stored after name.
+	
+	size_t		name_size;
+	uint8_t		name[]; // UTF-16LE, without terminal zero.
+};
+
 
 
 /*
@@ -177,6 +284,9 @@ typedef struct
 // Errors.
 const char * SMVMwareNVRAMErrorDomain = "com.sourcemac.vmware-nvram.error";
 
+// Serialization.
+static const uint8_t g_padding_page[SMPaddingPageSize] = { [0 ... SMPaddingPageSize - 1] = 0xff };
+
 
 /*
 ** Prototypes
@@ -184,6 +294,12 @@ const char * SMVMwareNVRAMErrorDomain = "com.sourcemac.vmware-nvram.error";
 #pragma mark - Prototypes
 
 // NVRAM.
+// > Instance.
+static SMVMwareNVRAM * SMVMwareNVRAMCreateWithBytes(const void *bytes, size_t size, SMBytesStorage storage, SMError **error);
+
+// > Serialization.
+static int SMVMwareNVRAMWritePatchedCopy(SMVMwareNVRAM *nvram, SMIOVecChain *chain, const char *path, SMError **error);
+
 // > Entries.
 static void SMVMwareNVRAMAddEntry(SMVMwareNVRAM *nvram, SMVMwareNVRAMEntry *entry);
 
@@ -194,27 +310,53 @@ static SMVMwareNVRAMEntry *	SMVMwareNVRAMEntryCreateFromBytes(SMVMwareNVRAM *nvr
 static void					SMVMwareNVRAMEntryFree(SMVMwareNVRAMEntry *entry);
 
 // > Serialization.
-static const void *	SMVMwareNVRAMEntryGetSerializedBytes(SMVMwareNVRAMEntry *entry, size_t *size);
-static void			SMVMwareNVRAMEntryMarkUpdated(SMVMwareNVRAMEntry *entry);
+static void SMVMwareNVRAMEntrySerialize(SMVMwareNVRAMEntry *entry, SMIOVecChain *chain);
+static void SMVMwareNVRAMEntryMarkUpdated(SMVMwareNVRAMEntry *entry);
 
 // > Variables.
-static void SMVMwareNVRAMEntryAddVariableInternal(SMVMwareNVRAMEntry *entry, SMVMwareNVRAMEFIVariable *var);
+static SMVMwareNVRAMEFIVariable *	SMVMwareNVRAMEntryAllocVariable(SMVMwareNVRAMEntry *entry);
+static void							SMVMwareNVRAMEntryAddVariableInternal(SMVMwareNVRAMEntry *entry, SMVMwareNVRAMEFIVariable *var);
+static void							SMVMwareNVRAMEntryReserveVariables(SMVMwareNVRAMEntry *entry, size_t count);
+static void							SMVMwareNVRAMEntryParseVariables(SMVMwareNVRAMEntry *entry);
+static void							SMVMwareNVRAMEntryDetachVariable(SMVMwareNVRAMEntry *entry, SMVMwareNVRAMEFIVariable *var);
+static void							SMVMwareNVRAMEntryCompactVariables(SMVMwareNVRAMEntry *entry);
+
+// > Index.
+static void						SMVMwareNVRAMIndexBuild(SMVMwareNVRAMEntry *entry);
+static void						SMVMwareNVRAMIndexAddVariable(SMVMwareNVRAMEntry *entry, SMVMwareNVRAMEFIVariable *var);
+static void						SMVMwareNVRAMIndexRemoveVariable(SMVMwareNVRAMEntry *entry, SMVMwareNVRAMEFIVariable *var);
+static SMVMwareNVRAMIndexSlot *	SMVMwareNVRAMIndexSearchSlot(SMVMwareNVRAMEntry *entry, const efi_guid_t *guid, const void *name, size_t name_size, uint64_t hash);
+static void						SMVMwareNVRAMIndexResize(SMVMwareNVRAMEntry *entry, size_t size);
+
+static uint64_t		SMVMwareNVRAMIndexHash(const efi_guid_t *guid, const void *name, size_t name_size);
+static const void *	SMVMwareNVRAMVariableGetIndexName(SMVMwareNVRAMEFIVariable *variable, size_t *size);
+
+// > Queries.
+static bool SMVMwareNVRAMQueryMatchVariable(const SMVMwareNVRAMQuery *query, SMVMwareNVRAMEFIVariable *variable);
 
 
 // Variables.
 // > Instance.
-static SMVMwareNVRAMEFIVariable *	SMVMwareNVRAMEFIVariableCreate(efi_guid_t guid, uint32_t attributes, const char *utf8_name, const void *value, size_t value_size, SMError **error);
-static SMVMwareNVRAMEFIVariable *	SMVMwareNVRAMEFIVariableCreateFromBytes(SMVMwareNVRAM *nvram, const void **bytes, size_t *size, SMError **error);
+static SMVMwareNVRAMEFIVariable *	SMVMwareNVRAMEFIVariableCreate(SMVMwareNVRAMEntry *entry, efi_guid_t guid, uint32_t attributes, const char *utf8_name, const void *value, size_t value_size, SMError **error);
+static SMVMwareNVRAMEFIVariable *	SMVMwareNVRAMEFIVariableCreateFromBytes(SMVMwareNVRAMEntry *entry, const void **bytes, size_t *size);
+static bool							SMVMwareNVRAMEFIVariableValidateBytes(SMVMwareNVRAM *nvram, const void **bytes, size_t *size, SMError **error);
 static void							SMVMwareNVRAMEFIVariableFree(SMVMwareNVRAMEFIVariable *var);
 
 // > Serialization.
-static const void *	SMVMwareNVRAMVariableGetSerializedBytes(SMVMwareNVRAMEFIVariable *entry, size_t *size);
-static void SMVMwareNVRAMVariableMarkUpdated(SMVMwareNVRAMEFIVariable *variable);
+static size_t	SMVMwareNVRAMVariableSerialize(SMVMwareNVRAMEFIVariable *variable, SMIOVecChain *chain);
+static void		SMVMwareNVRAMVariableMarkUpdated(SMVMwareNVRAMEFIVariable *variable);
 
 
 // Helpers.
 // File.
-static bool SMFileWriteBytes(int fd, const void *bytes, size_t len, SMError **error);
+static void *	SMFileReadAll(int fd, size_t size_hint, size_t *size, SMError **error);
+static bool		SMFilePWriteBytes(int fd, const void *bytes, size_t size, off_t offset, SMError **error);
+static int		SMFileClone(int src_fd, off_t size, const char *path);
+
+// IO vectors.
+static void		SMIOVecChainAppend(SMIOVecChain *chain, const void *bytes, size_t size);
+static void		SMIOVecChainAppendPadding(SMIOVecChain *chain, size_t size);
+static size_t	SMIOVecChainSize(SMIOVecChain *chain);
 
 // Bytes.
 // > Read.
@@ -225,9 +367,15 @@ static bool SMReadMatchingBytes(SMVMwareNVRAM *nvram, const void **bytes, size_t
 static bool			SMIsBufferAscii(const uint8_t *buffer, size_t size, const char *ascii);
 static const char *	SMBytesDescription(const void *bytes, size_t size);
 
+// > Updated.
+static void *	SMBytesCopy(const void *bytes, size_t size);
+static void		SMBytesReleaseFree(const void *bytes, size_t size, void *context);
+
+static void SMUpdatedBytesSet(SMUpdatedBytes *updated, const void *bytes, size_t size, SMVMwareNVRAMBytesRelease release, void *context);
+static void SMUpdatedBytesRelease(SMUpdatedBytes *updated);
+
 // Strings.
-static char * SMStringUTF16ToUTF8(const void *utf16bytes, size_t len);
-static void * SMStringUTF8ToUTF16(const char *utf8str, bool terminal_zero, size_t *len);
+static size_t SMStringUTF16Length(const void *utf16bytes, size_t len);
 
 
 /*
@@ -239,70 +387,122 @@ static void * SMStringUTF8ToUTF16(const char *utf8str, bool terminal_zero, size_
 
 SMVMwareNVRAM * SMVMwareNVRAMOpen(const char *nvram_file_path, SMError **error)
 {
-	SMVMwareNVRAM *result = calloc(1, sizeof(SMVMwareNVRAM));
-	
-	assert(result);
-	
-	// Copy path.
-	result->path = strdup(nvram_file_path);
-	
-	assert(result->path);
-	
 	// Open the file.
 	int fd = open(nvram_file_path, O_RDONLY);
 	
 	if (fd == -1)
 	{
 		SMSetErrorPtr(error, SMVMwareNVRAMErrorDomain, errno, "can't open the file (%d - %s)", errno, strerror(errno));
-		goto fail;
+		return NULL;
 	}
-		
+	
+	// Open content.
+	SMVMwareNVRAM *result = SMVMwareNVRAMOpenWithFileDescriptor(fd, error);
+	
+	close(fd);
+	
+	if (!result)
+		return NULL;
+	
+	// Copy path.
+	result->path = strdup(nvram_file_path);
+	
+	assert(result->path);
+	
+	return result;
+}
+
+SMVMwareNVRAM * SMVMwareNVRAMOpenWithFileDescriptor(int fd, SMError **error)
+{
 	// Stat the file.
 	struct stat st;
 	
 	if (fstat(fd, &st) == -1)
 	{
 		SMSetErrorPtr(error, SMVMwareNVRAMErrorDomain, errno, "can't stat the file (%d - %s)", errno, strerror(errno));
-		close(fd);
-		goto fail;
+		return NULL;
 	}
 	
-	// Check size.
-	if (st.st_size == 0)
+	// Map regular files read from their start.
+	if (S_ISREG(st.st_mode) && lseek(fd, 0, SEEK_CUR) == 0)
 	{
-		SMSetErrorPtr(error, SMVMwareNVRAMErrorDomain, 0, "empty file");
-		close(fd);
-		goto fail;
+		// > Check size.
+		if (st.st_size == 0)
+		{
+			SMSetErrorPtr(error, SMVMwareNVRAMErrorDomain, 0, "empty file");
+			return NULL;
+		}
+		
+		// > Forge flags.
+		int	flags = MAP_PRIVATE | MAP_FILE;
+		
+#if defined(MAP_RESILIENT_MEDIA)
+		flags |= MAP_RESILIENT_MEDIA;
+#endif
+		
+		// > Map.
+		void *mbytes = mmap(NULL, st.st_size, PROT_READ, flags, fd, 0);
+		
+		if (mbytes != MAP_FAILED)
+		{
+			SMVMwareNVRAM *result = SMVMwareNVRAMCreateWithBytes(mbytes, st.st_size, SMBytesStorageMapped, error);
+			
+			if (result)
+				result->bytes_stat = st;
+			
+			return result;
+		}
 	}
 	
-	// Map the file.
-	// > Forge flags.
-	int	flags = MAP_PRIVATE | MAP_FILE;
+	// Read other ones (streams, files not mappable) up to the end.
+	size_t	size = 0;
+	void	*bytes = SMFileReadAll(fd, S_ISREG(st.st_mode) ? (size_t)st.st_size : 0, &size, error);
+	
+	if (!bytes)
+		return NULL;
+	
+	SMVMwareNVRAM *result = SMVMwareNVRAMCreateWithBytes(bytes, size, SMBytesStorageOwned, error);
+	
+	if (result)
+		result->bytes_stat = st;
+	
+	return result;
+}
 
-#if defined(MAP_RESILIENT_MEDIA)
-	flags |= MAP_RESILIENT_MEDIA;
-#endif
+SMVMwareNVRAM * SMVMwareNVRAMOpenWithBytes(const void *bytes, size_t size, SMVMwareNVRAMBytesOwnership ownership, SMError **error)
+{
+	switch (ownership)
+	{
+		case SMVMwareNVRAMBytesBorrowed:
+			return SMVMwareNVRAMCreateWithBytes(bytes, size, SMBytesStorageBorrowed, error);
+			
+		case SMVMwareNVRAMBytesOwned:
+			return SMVMwareNVRAMCreateWithBytes(bytes, size, SMBytesStorageOwned, error);
+	}
+	
+	return NULL;
+}
 
-	// > Map.
-	void	*mbytes = mmap(NULL, st.st_size, PROT_READ, flags, fd, 0);
-	int		err = errno;
+static SMVMwareNVRAM * SMVMwareNVRAMCreateWithBytes(const void *bytes, size_t size, SMBytesStorage storage, SMError **error)
+{
+	// Note: the instance takes charge of the bytes, even on failure.
+	SMVMwareNVRAM *result = calloc(1, sizeof(SMVMwareNVRAM));
 	
-	close(fd);
+	assert(result);
+	
+	// Hold parameters.
+	result->bytes = bytes;
+	result->size = size;
+	result->bytes_storage = storage;
 	
-	if (mbytes == MAP_FAILED)
+	// Check size.
+	if (size == 0)
 	{
-		SMSetErrorPtr(error, SMVMwareNVRAMErrorDomain, errno, "can't map the file (%d - %s)", err, strerror(err));
+		SMSetErrorPtr(error, SMVMwareNVRAMErrorDomain, 0, "empty file");
 		goto fail;
 	}
 	
-	// Hold parameters.
-	result->bytes = mbytes;
-	result->size = st.st_size;
-	
 	// Parse content.
-	const void	*bytes = mbytes;
-	size_t		size = st.st_size;
-	
 	// > Read magic.
 	uint8_t magic[] = SMFileMagic;
 	
@@ -349,9 +549,20 @@ void SMVMwareNVRAMFree(SMVMwareNVRAM *nvram)
 	
 	free(nvram->entries);
 	
-	// Unmap bytes.
-	if (nvram->bytes)
-		munmap(nvram->bytes, nvram->size);
+	// Release bytes.
+	switch (nvram->bytes_storage)
+	{
+		case SMBytesStorageBorrowed:
+			break;
+			
+		case SMBytesStorageOwned:
+			free((void *)nvram->bytes);
+			break;
+			
+		case SMBytesStorageMapped:
+			munmap((void *)nvram->bytes, nvram->size);
+			break;
+	}
 	
 	// Free root.
 	free(nvram);
@@ -370,8 +581,37 @@ const char * SMVMwareNVRAMGetPath(SMVMwareNVRAM *nvram)
 
 bool SMVMwareNVRAMWriteToFile(SMVMwareNVRAM *nvram, const char *path, SMError **error)
 {
+	SMIOVecChain	chain = { 0 };
+	int				fd = -1;
+	
+	// Serialize.
+	// > Magic.
+	static const uint8_t magic[] = SMFileMagic;
+	
+	SMIOVecChainAppend(&chain, magic, sizeof(magic));
+	
+	// > Unknown value.
+	SMIOVecChainAppend(&chain, &nvram->unknown_value, sizeof(nvram->unknown_value));
+	
+	// > Entries.
+	size_t entries_count = SMVMwareNVRAMEntriesCount(nvram);
+	
+	for (size_t i = 0; i < entries_count; i++)
+		SMVMwareNVRAMEntrySerialize(SMVMwareNVRAMGetEntryAtIndex(nvram, i), &chain);
+	
+	// Size-preserving edits: patch a copy of the original file.
+	int patched = SMVMwareNVRAMWritePatchedCopy(nvram, &chain, path, error);
+	
+	if (patched == 1)
+	{
+		free(chain.iov);
+		return true;
+	}
+	else if (patched == -1)
+		goto fail;
+	
 	// Open file.
-	int fd = open(path, O_WRONLY | O_CREAT | O_EXCL, 0644);
+	fd = open(path, O_WRONLY | O_CREAT | O_EXCL, 0644);
 	
 	if (fd == -1)
 	{
@@ -379,45 +619,93 @@ bool SMVMwareNVRAMWriteToFile(SMVMwareNVRAM *nvram, const char *path, SMError **
 		goto fail;
 	}
 	
-	// Write magic.
-	uint8_t magic[] = SMFileMagic;
-	
-	if (!SMFileWriteBytes(fd, magic, sizeof(magic), error))
-		goto fail;
-	
-	// Write unknown value.
-	if (!SMFileWriteBytes(fd, &nvram->unknown_value, sizeof(nvram->unknown_value), error))
-		goto fail;
-	
-	// Write entries.
-	size_t entries_count = SMVMwareNVRAMEntriesCount(nvram);
-	
-	for (size_t i = 0; i < entries_count; i++)
+	// Write.
+	if (SMIOWriteVector(fd, chain.iov, chain.iov_cnt) < 0)
 	{
-		SMVMwareNVRAMEntry *entry = SMVMwareNVRAMGetEntryAtIndex(nvram, i);
-		
-		size_t		bytes_size = 0;
-		const void	*bytes = SMVMwareNVRAMEntryGetSerializedBytes(entry, &bytes_size);
-		
-		// Write.
-		if (!SMFileWriteBytes(fd, bytes, bytes_size, error))
-			goto fail;
+		SMSetErrorPtr(error, SMVMwareNVRAMErrorDomain, errno, "can't write bytes (%d - %s)", errno, strerror(errno));
+		goto fail;
 	}
 	
 	// Close.
+	free(chain.iov);
 	close(fd);
 	
 	return true;
 	
 fail:
+	free(chain.iov);
+	
 	if (fd >= 0)
+	{
 		close(fd);
-	
-	unlink(path);
+		unlink(path);
+	}
 	
 	return false;
 }
 
+static int SMVMwareNVRAMWritePatchedCopy(SMVMwareNVRAM *nvram, SMIOVecChain *chain, const char *path, SMError **error)
+{
+	// Note: returns 1 on success, 0 if not applicable (nothing was created), and -1 on error.
+	
+	// Check we have an original file, and the layout is preserved.
+	if (!nvram->path || SMIOVecChainSize(chain) != nvram->size)
+		return 0;
+	
+	// Open source & check it's still the file we mapped.
+	int src_fd = open(nvram->path, O_RDONLY);
+	
+	if (src_fd == -1)
+		return 0;
+	
+	struct stat st;
+	
+	if (fstat(src_fd, &st) == -1 ||
+		st.st_dev != nvram->bytes_stat.st_dev ||
+		st.st_ino != nvram->bytes_stat.st_ino ||
+		st.st_size != nvram->bytes_stat.st_size ||
+		SMStatMTime(st).tv_sec != SMStatMTime(nvram->bytes_stat).tv_sec ||
+		SMStatMTime(st).tv_nsec != SMStatMTime(nvram->bytes_stat).tv_nsec)
+	{
+		close(src_fd);
+		return 0;
+	}
+	
+	// Clone or copy the source.
+	int fd = SMFileClone(src_fd, st.st_size, path);
+	
+	close(src_fd);
+	
+	if (fd == -1)
+		return 0;
+	
+	// Write changed ranges only.
+	off_t offset = 0;
+	
+	for (size_t i = 0; i < chain->iov_cnt; i++)
+	{
+		const char	*bytes = chain->iov[i].iov_base;
+		size_t		size = chain->iov[i].iov_len;
+		const char	*original = nvram->bytes + offset;
+		
+		if (bytes != original && memcmp(bytes, original, size) != 0)
+		{
+			if (!SMFilePWriteBytes(fd, bytes, size, offset, error))
+			{
+				close(fd);
+				unlink(path);
+				return -1;
+			}
+		}
+		
+		offset += (off_t)size;
+	}
+	
+	close(fd);
+	
+	return 1;
+}
+
 
 #pragma mark > Entries
 
@@ -523,30 +811,35 @@ static SMVMwareNVRAMEntry *	SMVMwareNVRAMEntryCreateFromBytes(SMVMwareNVRAM *nvr
 			goto fail;
 		}
 
-		if (contentSize < sizeof(magic) + sizeof(zero))
+		if (contentSize < sizeof(magic) + sizeof(zero) + sizeof(contentSize))
 		{
-			SMSetParseErrorPtr(error, nvram, bytes_bck, "found an EFI_NV data too small (%u < %lu)", contentSize, sizeof(magic) + sizeof(zero));
+			SMSetParseErrorPtr(error, nvram, bytes_bck, "found an EFI_NV data too small (%u < %lu)", contentSize, sizeof(magic) + sizeof(zero) + sizeof(contentSize));
 			goto fail;
 		}
 		
 		// > Skip headers size from content size.
 		contentSize -= sizeof(magic) + sizeof(zero) + sizeof(contentSize);
 		
-		// > Parse variables.
-		size_t lContentSize = contentSize;
+		// > Validate variables headers (variables are parsed on first access).
+		const void	*varsBytes = innerBytes;
+		size_t		varsSize = contentSize;
+		
+		entry->vars_bytes = innerBytes;
+		entry->vars_size = contentSize;
 		
-		while (lContentSize)
+		while (varsSize)
 		{
-			SMVMwareNVRAMEFIVariable *var = SMVMwareNVRAMEFIVariableCreateFromBytes(nvram, &innerBytes, &lContentSize, error);
-			
-			if (!var)
+			if (!SMVMwareNVRAMEFIVariableValidateBytes(nvram, &varsBytes, &varsSize, error))
 				goto fail;
 			
-			SMVMwareNVRAMEntryAddVariableInternal(entry, var);
+			entry->vars_original_cnt++;
 		}
 	}
 	else
+	{
 		entry->type = SMVMwareNVRAMEntryTypeGeneric;
+		entry->vars_parsed = true;
+	}
 	
 	// Consumed bytes.
 	*bytes += nvram_entry.len;
@@ -569,10 +862,17 @@ static void SMVMwareNVRAMEntryFree(SMVMwareNVRAMEntry *entry)
 	for (size_t i = 0; i < entry->vars_cnt; i++)
 		SMVMwareNVRAMEFIVariableFree(entry->vars[i]);
 	
+	for (size_t i = 0; i < entry->vars_detached_cnt; i++)
+		SMVMwareNVRAMEFIVariableFree(entry->vars_detached[i]);
+	
 	free(entry->vars);
+	free(entry->vars_detached);
 	
-	// Serialization.
-	free(entry->serialized_bytes);
+	SMArenaFree(&entry->vars_pool);
+	SMArenaFree(&entry->vars_cold_pool);
+	
+	// Index.
+	free(entry->index);
 	
 	// Free root.
 	free(entry);
@@ -581,108 +881,63 @@ static void SMVMwareNVRAMEntryFree(SMVMwareNVRAMEntry *entry)
 
 #pragma mark > Serialization
 
-static const void * SMVMwareNVRAMEntryGetSerializedBytes(SMVMwareNVRAMEntry *entry, size_t *size)
+static void SMVMwareNVRAMEntrySerialize(SMVMwareNVRAMEntry *entry, SMIOVecChain *chain)
 {
-	// Return cached serialized bytes.
-	if (entry->serialized_bytes)
+	// Reference original bytes if the entry wasn't updated.
+	if (!entry->updated)
 	{
-		if (size)
-			*size = entry->serialized_size;
-		
-		return entry->serialized_bytes;
+		SMIOVecChainAppend(chain, entry->original_bytes, entry->original_size);
+		return;
 	}
 	
-	// Return original bytes if the entry wasn't updated.
-	if (!entry->updated)
+	// Generate header.
+	efi_nv_header_t *hdr = &entry->serialized_header;
+	
+	memset(hdr, 0, sizeof(*hdr));
+	
+	memcpy(hdr->entry.name, entry->name, sizeof(hdr->entry.name));
+	memcpy(hdr->entry.subname, entry->subname, sizeof(hdr->entry.subname));
+	
+	// Generic entries keep their original content.
+	if (entry->type == SMVMwareNVRAMEntryTypeGeneric)
 	{
-		if (size)
-			*size = entry->original_size;
+		hdr->entry.len = (uint32_t)entry->original_content_size;
 		
-		return entry->original_bytes;
+		SMIOVecChainAppend(chain, &hdr->entry, sizeof(hdr->entry));
+		SMIOVecChainAppend(chain, entry->original_content_bytes, entry->original_content_size);
+		
+		return;
 	}
 	
-	// Serialize bytes & return them.
-	SMBytesWritter writter = SMBytesWritterInit();
+	// Generate variables.
+	// > An empty store keeps its headers & padding, so it can be parsed again.
+	size_t	cnt = SMVMwareNVRAMEntryVariablesCount(entry);
+	uint8_t	magic[] = SMEFINVMagic;
+	
+	memcpy(hdr->magic, magic, sizeof(hdr->magic));
+	
+	SMIOVecChainAppend(chain, hdr, sizeof(*hdr));
 	
-	// > Write header.
-	off_t 			nvram_entry_offset = SMBytesWritterAppendSpace(&writter, sizeof(nvram_entry_t));
-	nvram_entry_t	*hdr = SMBytesWritterPtrOff(nvram_entry_t, &writter, nvram_entry_offset);
+	// > Variables: unchanged ones reference original bytes.
+	size_t data_size = sizeof(hdr->magic) + sizeof(hdr->zero) + sizeof(hdr->data_size);
 	
-	memcpy(hdr->name, entry->name, sizeof(hdr->name));
-	memcpy(hdr->subname, entry->subname, sizeof(hdr->subname));
-	hdr->len = 0;
+	for (size_t i = 0; i < cnt; i++)
+		data_size += SMVMwareNVRAMVariableSerialize(SMVMwareNVRAMEntryGetVariableAtIndex(entry, i), chain);
+	
+	// > Padding. XXX: I'm not sure if 0x40000 is a maxium, or a "block" size. Consider it's a block size for now.
+	size_t content_size = SMRoundUp(data_size, SMEFINVBlockSize);
+	
+	SMIOVecChainAppendPadding(chain, content_size - data_size);
+	
+	// > Update sizes (the header is referenced by the chain, not copied).
+	hdr->entry.len = (uint32_t)content_size;
+	hdr->data_size = (uint32_t)data_size;
+}
 
-	// > Write variables.
-	size_t cnt = SMVMwareNVRAMEntryVariablesCount(entry);
-
-	if (cnt > 0)
-	{
-		size_t data_size = 0;
-		size_t content_size = 0;
-		
-		// > Write magic.
-		uint8_t magic[] = SMEFINVMagic;
-		
-		SMBytesWritterAppendBytes(&writter, magic, sizeof(magic));
-		
-		// > Write zero.
-		SMBytesWritterAppendRepeatedByte(&writter, 0, 4);
-		
-		// > Write size (zero for now).
-		off_t data_size_offset = SMBytesWritterAppendRepeatedByte(&writter, 0, 4);
-		
-		// > Writes variables.
-		for (size_t i = 0; i < cnt; i++)
-		{
-			SMVMwareNVRAMEFIVariable *variable = SMVMwareNVRAMEntryGetVariableAtIndex(entry, i);
-			
-			size_t 		var_size = 0;
-			const void	*var_bytes = SMVMwareNVRAMVariableGetSerializedBytes(variable, &var_size);
-			
-			SMBytesWritterAppendBytes(&writter, var_bytes, var_size);
-			
-			data_size += var_size;
-		}
-		
-		data_size += sizeof(magic) + 4 + 4; // magic + sizeof(zero) + sizeof(data_size).
-		
-		// > Compute & update content size. XXX: I'm not sure if 0x40000 is a maxium, or a "block" size. Consider it's a block size for now.
-		nvram_entry_t *update_hdr = SMBytesWritterPtrOff(nvram_entry_t, &writter, nvram_entry_offset);
-
-		content_size = SMRoundUp(data_size, 0x40000);
-		update_hdr->len = (uint32_t)content_size;
-		
-		SMBytesWritterAppendRepeatedByte(&writter, 0xff, content_size - data_size);
-		
-		// > Update data size.
-		uint32_t *data_size_ptr = SMBytesWritterPtrOff(uint32_t, &writter, data_size_offset);
-		
-		*data_size_ptr = (uint32_t)data_size;
-	}
-	
-	// > Hold result.
-	entry->serialized_bytes = writter.bytes;
-	entry->serialized_size = writter.size;
-	
-	// Result.
-	if (size)
-		*size = writter.size;
-	
-	return writter.bytes;
-}
-
-static void SMVMwareNVRAMEntryMarkUpdated(SMVMwareNVRAMEntry *entry)
-{
-	entry->updated = true;
-	
-	if (entry->serialized_bytes)
-	{
-		free(entry->serialized_bytes);
-		entry->serialized_bytes = NULL;
-		
-		entry->serialized_size = 0;
-	}
-}
+static void SMVMwareNVRAMEntryMarkUpdated(SMVMwareNVRAMEntry *entry)
+{
+	entry->updated = true;
+}
 
 
 #pragma mark > Properties
@@ -757,8 +1012,11 @@ const void * SMVMwareNVRAMEntryGetContentBytes(SMVMwareNVRAMEntry *entry, size_t
 
 SMVMwareNVRAMEFIVariable * SMVMwareNVRAMEntryAddVariable(SMVMwareNVRAMEntry *entry, efi_guid_t guid, uint32_t attributes, const char *utf8_name, const void *bytes, size_t size, SMError **error)
 {
+	// Parse original variables first, to keep them in front.
+	SMVMwareNVRAMEntryParseVariables(entry);
+	
 	// Create instance.
-	SMVMwareNVRAMEFIVariable *var = SMVMwareNVRAMEFIVariableCreate(guid, attributes, utf8_name, bytes, size, error);
+	SMVMwareNVRAMEFIVariable *var = SMVMwareNVRAMEFIVariableCreate(entry, guid, attributes, utf8_name, bytes, size, error);
 
 	if (!var)
 		return NULL;
@@ -771,30 +1029,510 @@ SMVMwareNVRAMEFIVariable * SMVMwareNVRAMEntryAddVariable(SMVMwareNVRAMEntry *ent
 	return var;
 }
 
+static SMVMwareNVRAMEFIVariable * SMVMwareNVRAMEntryAllocVariable(SMVMwareNVRAMEntry *entry)
+{
+	// > Note: variables are owned by the entry pools, and stay at the same address until the entry is freed.
+	SMVMwareNVRAMEFIVariable *var = SMArenaCalloc(&entry->vars_pool, sizeof(SMVMwareNVRAMEFIVariable));
+	
+	var->cold = SMArenaCalloc(&entry->vars_cold_pool, sizeof(SMVMwareNVRAMEFIVariableCold));
+	
+	return var;
+}
+
 static void SMVMwareNVRAMEntryAddVariableInternal(SMVMwareNVRAMEntry *entry, SMVMwareNVRAMEFIVariable *var)
 {
 	// Append to array.
-	entry->vars = reallocf(entry->vars, (entry->vars_cnt + 1) * sizeof(*entry->vars));
-	
-	assert(entry->vars);
+	if (entry->vars_cnt == entry->vars_capacity)
+		SMVMwareNVRAMEntryReserveVariables(entry, MAX(entry->vars_capacity * 2, SMVariablesMinCapacity));
 	
 	entry->vars[entry->vars_cnt] = var;
 	entry->vars_cnt++;
 
 	// Link the variable to us.
-	var->parent_entry = entry;
+	var->cold->parent_entry = entry;
+	var->cold->idx = entry->vars_cnt - 1;
+	
+	// Index it.
+	if (entry->index_built)
+		SMVMwareNVRAMIndexAddVariable(entry, var);
+}
+
+static void SMVMwareNVRAMEntryReserveVariables(SMVMwareNVRAMEntry *entry, size_t count)
+{
+	if (count <= entry->vars_capacity)
+		return;
+	
+	entry->vars = reallocf(entry->vars, count * sizeof(*entry->vars));
+	entry->vars_capacity = count;
+	
+	assert(entry->vars);
+}
+
+static void SMVMwareNVRAMEntryParseVariables(SMVMwareNVRAMEntry *entry)
+{
+	if (entry->vars_parsed)
+		return;
+	
+	entry->vars_parsed = true;
+	
+	// Parse (headers were validated and counted at open time).
+	const void	*bytes = entry->vars_bytes;
+	size_t		size = entry->vars_size;
+	
+	SMVMwareNVRAMEntryReserveVariables(entry, entry->vars_original_cnt);
+	
+	while (size)
+		SMVMwareNVRAMEntryAddVariableInternal(entry, SMVMwareNVRAMEFIVariableCreateFromBytes(entry, &bytes, &size));
+}
+
+void SMVMwareNVRAMEntryRemoveVariable(SMVMwareNVRAMEntry *entry, SMVMwareNVRAMEFIVariable *variable)
+{
+	assert(variable->cold->parent_entry == entry);
+	
+	SMVMwareNVRAMEntryDetachVariable(entry, variable);
+}
+
+size_t SMVMwareNVRAMEntryRemoveVariablesMatching(SMVMwareNVRAMEntry *entry, SMVMwareNVRAMVariablePredicate predicate, void *context)
+{
+	size_t result = 0;
+	
+	SMVMwareNVRAMEntryParseVariables(entry);
+	
+	for (size_t i = 0; i < entry->vars_cnt; i++)
+	{
+		SMVMwareNVRAMEFIVariable *var = entry->vars[i];
+		
+		if (var->removed || !predicate(var, context))
+			continue;
+		
+		SMVMwareNVRAMEntryDetachVariable(entry, var);
+		result++;
+	}
+	
+	return result;
+}
+
+static void SMVMwareNVRAMEntryDetachVariable(SMVMwareNVRAMEntry *entry, SMVMwareNVRAMEFIVariable *var)
+{
+	if (var->removed)
+		return;
+	
+	// Unindex.
+	SMVMwareNVRAMIndexRemoveVariable(entry, var);
+	
+	// Mark as removed: the variables array is compacted lazily, on next positional access.
+	var->removed = true;
+	entry->vars_removed_cnt++;
+	
+	// The store is regenerated without the variable.
+	SMVMwareNVRAMEntryMarkUpdated(entry);
+}
+
+static void SMVMwareNVRAMEntryCompactVariables(SMVMwareNVRAMEntry *entry)
+{
+	if (entry->vars_removed_cnt == 0)
+		return;
+	
+	// Keep removed variables apart, so they stay valid until the entry is freed.
+	entry->vars_detached = reallocf(entry->vars_detached, (entry->vars_detached_cnt + entry->vars_removed_cnt) * sizeof(*entry->vars_detached));
+	
+	assert(entry->vars_detached);
+	
+	// Compact.
+	size_t cnt = 0;
+	
+	for (size_t i = 0; i < entry->vars_cnt; i++)
+	{
+		SMVMwareNVRAMEFIVariable *var = entry->vars[i];
+		
+		if (var->removed)
+		{
+			entry->vars_detached[entry->vars_detached_cnt++] = var;
+			continue;
+		}
+		
+		// Note: relative order is kept, so the index chains stay in variables order.
+		var->cold->idx = cnt;
+		entry->vars[cnt++] = var;
+	}
+	
+	entry->vars_cnt = cnt;
+	entry->vars_removed_cnt = 0;
 }
 
 size_t SMVMwareNVRAMEntryVariablesCount(SMVMwareNVRAMEntry *entry)
 {
-	return entry->vars_cnt;
+	SMVMwareNVRAMEntryParseVariables(entry);
+	
+	return entry->vars_cnt - entry->vars_removed_cnt;
+}
+
+SMVMwareNVRAMEFIVariable * SMVMwareNVRAMEntryGetVariableAtIndex(SMVMwareNVRAMEntry *entry, size_t idx)
+{
+	SMVMwareNVRAMEntryParseVariables(entry);
+	SMVMwareNVRAMEntryCompactVariables(entry);
+	
+	assert(idx < entry->vars_cnt);
+	
+	return entry->vars[idx];
+}
+
+SMVMwareNVRAMEFIVariable * SMVMwareNVRAMEntryGetVariableForGUIDAndName(SMVMwareNVRAMEntry *entry, const efi_guid_t *guid, const void *name, size_t name_size)
+{
+	SMVMwareNVRAMIndexBuild(entry);
+	
+	if (entry->index_cnt == 0)
+		return NULL;
+	
+	// Search.
+	name_size = SMStringUTF16Length(name, name_size);
+	
+	SMVMwareNVRAMIndexSlot *slot = SMVMwareNVRAMIndexSearchSlot(entry, guid, name, name_size, SMVMwareNVRAMIndexHash(guid, name, name_size));
+	
+	return slot->head;
+}
+
+SMVMwareNVRAMEFIVariable * SMVMwareNVRAMEntryGetVariableForGUIDAndUTF8Name(SMVMwareNVRAMEntry *entry, const efi_guid_t *guid, const char *utf8_name)
+{
+	// Widen ASCII names in place (nearly all EFI names are), else convert.
+	uint8_t	buffer[256];
+	size_t	len = strlen(utf8_name);
+	bool	ascii = (len * 2 <= sizeof(buffer));
+	
+	for (size_t i = 0; i < len && ascii; i++)
+	{
+		if ((uint8_t)utf8_name[i] >= 0x80)
+			ascii = false;
+		
+		buffer[i * 2] = (uint8_t)utf8_name[i];
+		buffer[i * 2 + 1] = 0;
+	}
+	
+	if (ascii)
+		return SMVMwareNVRAMEntryGetVariableForGUIDAndName(entry, guid, buffer, len * 2);
+	
+	size_t	utf16_size = 0;
+	void	*utf16_name = SMStringUTF8ToUTF16LE(utf8_name, len, false, &utf16_size);
+	
+	if (!utf16_name)
+		return NULL;
+	
+	SMVMwareNVRAMEFIVariable *result = SMVMwareNVRAMEntryGetVariableForGUIDAndName(entry, guid, utf16_name, utf16_size);
+	
+	free(utf16_name);
+	
+	return result;
+}
+
+SMVMwareNVRAMEFIVariable * SMVMwareNVRAMEntryGetVariableForQuery(SMVMwareNVRAMEntry *entry, const SMVMwareNVRAMQuery *query)
+{
+	// Use the index if it was already built.
+	if (entry->index_built)
+	{
+		if (entry->index_cnt == 0)
+			return NULL;
+		
+		return SMVMwareNVRAMIndexSearchSlot(entry, &query->guid, query->name, query->name_size, query->hash)->head;
+	}
+	
+	// Else scan variables, without building the index for a single lookup.
+	size_t count = SMVMwareNVRAMEntryVariablesCount(entry);
+	
+	SMVMwareNVRAMEntryCompactVariables(entry);
+	
+	for (size_t i = 0; i < count; i++)
+	{
+		if (SMVMwareNVRAMQueryMatchVariable(query, entry->vars[i]))
+			return entry->vars[i];
+	}
+	
+	return NULL;
+}
+
+void SMVMwareNVRAMEntryGetVariablesForQueries(SMVMwareNVRAMEntry *entry, const SMVMwareNVRAMQuery * const *queries, size_t count, SMVMwareNVRAMEFIVariable **variables)
+{
+	memset(variables, 0, count * sizeof(*variables));
+	
+	if (count == 0)
+		return;
+	
+	// Use the index if it was already built.
+	if (entry->index_built)
+	{
+		for (size_t i = 0; i < count; i++)
+			variables[i] = SMVMwareNVRAMEntryGetVariableForQuery(entry, queries[i]);
+		
+		return;
+	}
+	
+	// Else scan variables once.
+	size_t vars_count = SMVMwareNVRAMEntryVariablesCount(entry);
+	size_t pending = count;
+	
+	SMVMwareNVRAMEntryCompactVariables(entry);
+	
+	// > Few queries: compare each variable to each pending query (size & GUID mismatches are rejected first).
+	if (count <= SMQueriesLinearMaxCount)
+	{
+		for (size_t i = 0; i < vars_count && pending > 0; i++)
+		{
+			SMVMwareNVRAMEFIVariable *var = entry->vars[i];
+			
+			for (size_t j = 0; j < count; j++)
+			{
+				if (variables[j] || !SMVMwareNVRAMQueryMatchVariable(queries[j], var))
+					continue;
+				
+				variables[j] = var;
+				pending--;
+			}
+		}
+		
+		return;
+	}
+	
+	// > Many queries: hash each variable once, and probe a table of queries.
+	size_t	table_size = SMHashTableSizeForCount(count);
+	size_t	mask = table_size - 1;
+	size_t	*table = calloc(table_size, sizeof(size_t)); // Query index + 1, 0 if empty.
+	
+	assert(table);
+	
+	for (size_t j = 0; j < count; j++)
+	{
+		size_t k = queries[j]->hash & mask;
+		
+		while (table[k])
+			k = (k + 1) & mask;
+		
+		table[k] = j + 1;
+	}
+	
+	for (size_t i = 0; i < vars_count && pending > 0; i++)
+	{
+		SMVMwareNVRAMEFIVariable	*var = entry->vars[i];
+		size_t						name_size = 0;
+		const void					*name = SMVMwareNVRAMVariableGetIndexName(var, &name_size);
+		uint64_t					hash = SMVMwareNVRAMIndexHash(&var->guid, name, name_size);
+		
+		// > Note: the same query can be present several times, so probe the whole cluster.
+		for (size_t k = hash & mask; table[k]; k = (k + 1) & mask)
+		{
+			size_t j = table[k] - 1;
+			
+			if (variables[j] || queries[j]->hash != hash || !SMVMwareNVRAMQueryMatchVariable(queries[j], var))
+				continue;
+			
+			variables[j] = var;
+			pending--;
+		}
+	}
+	
+	free(table);
+}
+
+
+#pragma mark > Index
+
+static void SMVMwareNVRAMIndexBuild(SMVMwareNVRAMEntry *entry)
+{
+	if (entry->index_built)
+		return;
+	
+	SMVMwareNVRAMEntryParseVariables(entry);
+	SMVMwareNVRAMEntryCompactVariables(entry);
+	
+	entry->index_built = true;
+	
+	if (entry->vars_cnt == 0)
+		return;
+	
+	SMVMwareNVRAMIndexResize(entry, SMHashTableSizeForCount(entry->vars_cnt));
+	
+	for (size_t i = 0; i < entry->vars_cnt; i++)
+		SMVMwareNVRAMIndexAddVariable(entry, entry->vars[i]);
+}
+
+static void SMVMwareNVRAMIndexAddVariable(SMVMwareNVRAMEntry *entry, SMVMwareNVRAMEFIVariable *var)
+{
+	// Grow if needed.
+	if ((entry->index_cnt + 1) * 2 > entry->index_size)
+		SMVMwareNVRAMIndexResize(entry, SMHashTableSizeForCount(entry->index_cnt + 1));
+	
+	// Search slot.
+	size_t					name_size = 0;
+	const void				*name = SMVMwareNVRAMVariableGetIndexName(var, &name_size);
+	uint64_t				hash = SMVMwareNVRAMIndexHash(&var->guid, name, name_size);
+	SMVMwareNVRAMIndexSlot	*slot = SMVMwareNVRAMIndexSearchSlot(entry, &var->guid, name, name_size, hash);
+	
+	var->indexed = true;
+	var->cold->key_hash = hash;
+	var->cold->key_next = NULL;
+	
+	// New key.
+	if (!slot->head)
+	{
+		slot->hash = hash;
+		slot->head = var;
+		slot->tail = var;
+		
+		entry->index_cnt++;
+		
+		return;
+	}
+	
+	// Duplicated key: keep the chain in variables order, so the first variable is the one returned by lookups.
+	if (slot->tail->cold->idx < var->cold->idx)
+	{
+		slot->tail->cold->key_next = var;
+		slot->tail = var;
+		
+		return;
+	}
+	
+	SMVMwareNVRAMEFIVariable *prev = NULL;
+	SMVMwareNVRAMEFIVariable *current = slot->head;
+	
+	while (current && current->cold->idx < var->cold->idx)
+	{
+		prev = current;
+		current = current->cold->key_next;
+	}
+	
+	var->cold->key_next = current;
+	
+	if (prev)
+		prev->cold->key_next = var;
+	else
+		slot->head = var;
+}
+
+static void SMVMwareNVRAMIndexRemoveVariable(SMVMwareNVRAMEntry *entry, SMVMwareNVRAMEFIVariable *var)
+{
+	if (!var->indexed)
+		return;
+	
+	var->indexed = false;
+	
+	// Search slot.
+	size_t					name_size = 0;
+	const void				*name = SMVMwareNVRAMVariableGetIndexName(var, &name_size);
+	SMVMwareNVRAMIndexSlot	*slot = SMVMwareNVRAMIndexSearchSlot(entry, &var->guid, name, name_size, var->cold->key_hash);
+	
+	if (!slot->head)
+		return;
+	
+	// Unlink variable from the chain.
+	SMVMwareNVRAMEFIVariable *prev = NULL;
+	SMVMwareNVRAMEFIVariable *current = slot->head;
+	
+	while (current && current != var)
+	{
+		prev = current;
+		current = current->cold->key_next;
+	}
+	
+	if (!current)
+		return;
+	
+	if (prev)
+		prev->cold->key_next = var->cold->key_next;
+	else
+		slot->head = var->cold->key_next;
+	
+	if (slot->tail == var)
+		slot->tail = prev;
+	
+	var->cold->key_next = NULL;
+	
+	if (slot->head)
+		return;
+	
+	// Chain is empty: remove the slot by shifting back following slots of the cluster.
+	size_t mask = entry->index_size - 1;
+	size_t hole = (size_t)(slot - entry->index);
+	
+	for (size_t i = (hole + 1) & mask; entry->index[i].head; i = (i + 1) & mask)
+	{
+		size_t home = entry->index[i].hash & mask;
+		
+		// > Skip slots which are placed between their home and the hole.
+		if ((hole <= i) ? (hole < home && home <= i) : (hole < home || home <= i))
+			continue;
+		
+		entry->index[hole] = entry->index[i];
+		hole = i;
+	}
+	
+	memset(&entry->index[hole], 0, sizeof(SMVMwareNVRAMIndexSlot));
+	
+	entry->index_cnt--;
+}
+
+static SMVMwareNVRAMIndexSlot * SMVMwareNVRAMIndexSearchSlot(SMVMwareNVRAMEntry *entry, const efi_guid_t *guid, const void *name, size_t name_size, uint64_t hash)
+{
+	size_t mask = entry->index_size - 1;
+	
+	for (size_t i = hash & mask; ; i = (i + 1) & mask)
+	{
+		SMVMwareNVRAMIndexSlot *slot = &entry->index[i];
+		
+		if (!slot->head)
+			return slot;
+		
+		if (slot->hash != hash || memcmp(&slot->head->guid, guid, sizeof(efi_guid_t)) != 0)
+			continue;
+		
+		size_t		slot_name_size = 0;
+		const void	*slot_name = SMVMwareNVRAMVariableGetIndexName(slot->head, &slot_name_size);
+		
+		if (slot_name_size == name_size && memcmp(slot_name, name, name_size) == 0)
+			return slot;
+	}
+}
+
+static void SMVMwareNVRAMIndexResize(SMVMwareNVRAMEntry *entry, size_t size)
+{
+	SMVMwareNVRAMIndexSlot	*old_index = entry->index;
+	size_t					old_size = entry->index_size;
+	
+	entry->index = calloc(size, sizeof(SMVMwareNVRAMIndexSlot));
+	entry->index_size = size;
+	
+	assert(entry->index);
+	
+	// Re-insert slots. Keys are unique, so we just need to find an empty place.
+	size_t mask = size - 1;
+	
+	for (size_t i = 0; i < old_size; i++)
+	{
+		if (!old_index[i].head)
+			continue;
+		
+		size_t j = old_index[i].hash & mask;
+		
+		while (entry->index[j].head)
+			j = (j + 1) & mask;
+		
+		entry->index[j] = old_index[i];
+	}
+	
+	free(old_index);
+}
+
+static uint64_t SMVMwareNVRAMIndexHash(const efi_guid_t *guid, const void *name, size_t name_size)
+{
+	return SMHashBytesAppend(SMHashBytes(guid, sizeof(efi_guid_t)), name, name_size);
 }
 
-SMVMwareNVRAMEFIVariable * SMVMwareNVRAMEntryGetVariableAtIndex(SMVMwareNVRAMEntry *entry, size_t idx)
+static const void * SMVMwareNVRAMVariableGetIndexName(SMVMwareNVRAMEFIVariable *variable, size_t *size)
 {
-	assert(idx < entry->vars_cnt);
+	// > Names are compared up to their first UTF-16 zero, like the UTF-8 version does.
+	const void *name = SMVMwareNVRAMVariableGetName(variable, size);
 	
-	return entry->vars[idx];
+	*size = SMStringUTF16Length(name, *size);
+	
+	return name;
 }
 
 
@@ -805,12 +1543,10 @@ SMVMwareNVRAMEFIVariable * SMVMwareNVRAMEntryGetVariableAtIndex(SMVMwareNVRAMEnt
 
 #pragma mark > Instance
 
-static SMVMwareNVRAMEFIVariable * SMVMwareNVRAMEFIVariableCreate(efi_guid_t guid, uint32_t attributes, const char *utf8_name, const void *value, size_t value_size, SMError **error)
+static SMVMwareNVRAMEFIVariable * SMVMwareNVRAMEFIVariableCreate(SMVMwareNVRAMEntry *entry, efi_guid_t guid, uint32_t attributes, const char *utf8_name, const void *value, size_t value_size, SMError **error)
 {
 	// Create instance.
-	SMVMwareNVRAMEFIVariable *var = calloc(1, sizeof(SMVMwareNVRAMEFIVariable));
-
-	assert(var);
+	SMVMwareNVRAMEFIVariable *var = SMVMwareNVRAMEntryAllocVariable(entry);
 
 	// Fill content.
 	if (!SMVMwareNVRAMVariableSetUTF8Name(var, utf8_name, error))
@@ -829,58 +1565,71 @@ fail:
 	return NULL;
 }
 
-static SMVMwareNVRAMEFIVariable * SMVMwareNVRAMEFIVariableCreateFromBytes(SMVMwareNVRAM *nvram, const void **bytes, size_t *size, SMError **error)
+static SMVMwareNVRAMEFIVariable * SMVMwareNVRAMEFIVariableCreateFromBytes(SMVMwareNVRAMEntry *entry, const void **bytes, size_t *size)
 {
-	SMVMwareNVRAMEFIVariable *var = calloc(1, sizeof(SMVMwareNVRAMEFIVariable));
+	// > Note: bytes should have been validated by SMVMwareNVRAMEFIVariableValidateBytes.
+	SMVMwareNVRAMEFIVariable *var = SMVMwareNVRAMEntryAllocVariable(entry);
+
+	// Read var header.
+	efi_var_t efi_var;
+	
+	assert(*size >= sizeof(efi_var));
+	
+	memcpy(&efi_var, *bytes, sizeof(efi_var));
+	
+	assert(efi_var.data_size <= *size - sizeof(efi_var));
+	assert(efi_var.name_size <= efi_var.data_size);
+	
+	// Fill variable.
+	memcpy(&var->guid, &efi_var.guid, sizeof(efi_guid_t));
+	var->attributes = efi_var.attributes;
+	
+	var->name_bytes = *bytes + sizeof(efi_var);
+	var->name_size = efi_var.name_size;
+	
+	var->value_bytes = *bytes + sizeof(efi_var) + efi_var.name_size;
+	var->value_size = efi_var.data_size - efi_var.name_size;
 	
-	assert(var);
+	var->cold->original_bytes = *bytes;
+	var->cold->original_size = sizeof(efi_var) + efi_var.data_size;
+	
+	// Consumed bytes.
+	*bytes += var->cold->original_size;
+	*size -= var->cold->original_size;
+	
+	// Result.
+	return var;
+}
 
-	// Parse.
+static bool SMVMwareNVRAMEFIVariableValidateBytes(SMVMwareNVRAM *nvram, const void **bytes, size_t *size, SMError **error)
+{
 	const void *bytes_bck = *bytes;
 	
-	// > Read var header.
+	// Read var header.
 	efi_var_t efi_var;
 	
 	if (!SMReadBytes(nvram, bytes, size, &efi_var, sizeof(efi_var), error))
-		goto fail;
+		return false;
 	
-	// > Check var data size.
+	// Check var data size.
 	if (efi_var.data_size > *size)
 	{
 		SMSetParseErrorPtr(error, nvram, bytes_bck, "an EFI var is too huge (%u > %lu)", efi_var.data_size, *size);
-		goto fail;
+		return false;
 	}
 	
-	// > Check name data size.
+	// Check name data size.
 	if (efi_var.name_size > efi_var.data_size)
 	{
 		SMSetParseErrorPtr(error, nvram, bytes_bck, "an EFI var name is too huge (%u > %u)", efi_var.name_size, efi_var.data_size);
-		goto fail;
+		return false;
 	}
 	
-	// Fill variable.
-	memcpy(&var->guid, &efi_var.guid, sizeof(efi_guid_t));
-	var->attributes = efi_var.attributes;
-	
-	var->original_bytes = bytes_bck;
-	var->original_size = sizeof(efi_var) + efi_var.data_size;
-	
-	var->original_name_bytes = *bytes;
-	var->original_name_size = efi_var.name_size;
-	
-	var->original_value_bytes = *bytes + efi_var.name_size;
-	var->original_value_size = efi_var.data_size - efi_var.name_size;
-	
 	// Consumed bytes.
 	*bytes += efi_var.data_size;
 	*size -= efi_var.data_size;
 	
-	// Result.
-	return var;
-	
-fail:
-	SMVMwareNVRAMEFIVariableFree(var);
-	return NULL;
+	return true;
 }
 
 static void SMVMwareNVRAMEFIVariableFree(SMVMwareNVRAMEFIVariable *var)
@@ -888,70 +1637,46 @@ static void SMVMwareNVRAMEFIVariableFree(SMVMwareNVRAMEFIVariable *var)
 	if (!var)
 		return;
 	
-	free(var->utf8_name);
+	// > Note: the variable itself is owned by the entry pools.
+	free(var->cold->utf8_name);
 	
-	free(var->serialized_bytes);
-	free(var->updated_name_bytes);
-	free(var->updated_value_bytes);
-	
-	free(var);
+	SMUpdatedBytesRelease(&var->cold->updated_name);
+	SMUpdatedBytesRelease(&var->cold->updated_value);
 }
 
 
 #pragma mark > Serialization
 
-static const void *	SMVMwareNVRAMVariableGetSerializedBytes(SMVMwareNVRAMEFIVariable *variable, size_t *size)
+static size_t SMVMwareNVRAMVariableSerialize(SMVMwareNVRAMEFIVariable *variable, SMIOVecChain *chain)
 {
-	// Return cached serialized bytes.
-	if (variable->serialized_bytes)
-	{
-		if (size)
-			*size = variable->serialized_size;
-		
-		return variable->serialized_bytes;
-	}
-	
-	// Return original bytes if the variable wasn't updated.
+	// Reference original bytes if the variable wasn't updated.
 	if (!variable->updated)
 	{
-		if (size)
-			*size = variable->original_size;
-		
-		return variable->original_bytes;
+		SMIOVecChainAppend(chain, variable->cold->original_bytes, variable->cold->original_size);
+		return variable->cold->original_size;
 	}
 	
-	// Serialize bytes & return them.
-	SMBytesWritter writter = { 0 };
-	
-	// > Fetch content.
+	// Fetch content.
 	size_t		name_size = 0;
 	const void	*name_bytes = SMVMwareNVRAMVariableGetName(variable, &name_size);
 	
 	size_t		value_size = 0;
 	const void	*value_bytes = SMVMwareNVRAMVariableGetValue(variable, &value_size);
 	
-	// > Header.
-	off_t 		efi_var_offset = SMBytesWritterAppendSpace(&writter, sizeof(efi_var_t));
-	efi_var_t	*efi_var = SMBytesWritterPtrOff(efi_var_t, &writter, efi_var_offset);
+	// Generate header.
+	efi_var_t *efi_var = &variable->cold->serialized_header;
 	
 	memcpy(&efi_var->guid, &variable->guid, sizeof(efi_guid_t));
 	efi_var->attributes = variable->attributes;
 	efi_var->data_size = (uint32_t)name_size + (uint32_t)value_size;
 	efi_var->name_size = (uint32_t)name_size;
 	
-	// > Content.
-	SMBytesWritterAppendBytes(&writter, name_bytes, name_size);
-	SMBytesWritterAppendBytes(&writter, value_bytes, value_size);
-
-	// > Hold result.
-	variable->serialized_bytes = writter.bytes;
-	variable->serialized_size = writter.size;
-	
-	// Result.
-	if (size)
-		*size = writter.size;
+	// Reference header & content.
+	SMIOVecChainAppend(chain, efi_var, sizeof(*efi_var));
+	SMIOVecChainAppend(chain, name_bytes, name_size);
+	SMIOVecChainAppend(chain, value_bytes, value_size);
 	
-	return writter.bytes;
+	return sizeof(*efi_var) + name_size + value_size;
 }
 
 static void SMVMwareNVRAMVariableMarkUpdated(SMVMwareNVRAMEFIVariable *variable)
@@ -959,18 +1684,9 @@ static void SMVMwareNVRAMVariableMarkUpdated(SMVMwareNVRAMEFIVariable *variable)
 	// Flag as updated.
 	variable->updated = true;
 	
-	// Free serialized bytes.
-	if (variable->serialized_bytes)
-	{
-		free(variable->serialized_bytes);
-		variable->serialized_bytes = NULL;
-		
-		variable->serialized_size = 0;
-	}
-	
 	// Mark entry as updated.
-	if (variable->parent_entry)
-		SMVMwareNVRAMEntryMarkUpdated(variable->parent_entry);
+	if (variable->cold->parent_entry)
+		SMVMwareNVRAMEntryMarkUpdated(variable->cold->parent_entry);
 }
 
 
@@ -983,7 +1699,16 @@ efi_guid_t SMVMwareNVRAMVariableGetGUID(SMVMwareNVRAMEFIVariable *variable)
 
 void SMVMwareNVRAMVariableSetGUID(SMVMwareNVRAMEFIVariable *variable, const efi_guid_t *guid)
 {
+	bool indexed = variable->indexed;
+	
+	if (indexed)
+		SMVMwareNVRAMIndexRemoveVariable(variable->cold->parent_entry, variable);
+	
 	memcpy(&variable->guid, guid, sizeof(efi_guid_t));
+	
+	if (indexed)
+		SMVMwareNVRAMIndexAddVariable(variable->cold->parent_entry, variable);
+	
 	SMVMwareNVRAMVariableMarkUpdated(variable);
 }
 
@@ -1000,39 +1725,40 @@ void SMVMwareNVRAMVariableSetAttributes(SMVMwareNVRAMEFIVariable *variable, uint
 
 const void * SMVMwareNVRAMVariableGetName(SMVMwareNVRAMEFIVariable *variable, size_t *size)
 {
-	if (variable->updated_name_bytes)
-	{
-		if (size)
-			*size = variable->updated_name_size;
-		
-		return variable->updated_name_bytes;
-	}
-	else
-	{
-		if (size)
-			*size = variable->original_name_size;
-		
-		return variable->original_name_bytes;
-	}
+	if (size)
+		*size = variable->name_size;
+	
+	return variable->name_bytes;
 }
 
 void SMVMwareNVRAMVariableSetName(SMVMwareNVRAMEFIVariable *variable, const void *name, size_t size)
 {
+	SMVMwareNVRAMVariableSetNameNoCopy(variable, SMBytesCopy(name, size), size, SMBytesReleaseFree, NULL);
+}
+
+void SMVMwareNVRAMVariableSetNameNoCopy(SMVMwareNVRAMEFIVariable *variable, const void *name, size_t size, SMVMwareNVRAMBytesRelease release, void *context)
+{
+	// Unindex previous name.
+	bool indexed = variable->indexed;
+	
+	if (indexed)
+		SMVMwareNVRAMIndexRemoveVariable(variable->cold->parent_entry, variable);
+	
 	// Flush UTF-8 string.
-	free(variable->utf8_name);
-	variable->utf8_name = NULL;
+	free(variable->cold->utf8_name);
+	variable->cold->utf8_name = NULL;
 	
-	// Free previous name.
-	if (variable->updated_name_bytes)
-		free(variable->updated_name_bytes);
+	// Release previous name, and reference new one.
+	assert(size <= UINT32_MAX);
 	
-	// Copy new name.
-	variable->updated_name_bytes = malloc(size);
+	SMUpdatedBytesSet(&variable->cold->updated_name, name, size, release, context);
 	
-	assert(variable->updated_name_bytes);
+	variable->name_bytes = name;
+	variable->name_size = (uint32_t)size;
 	
-	memcpy(variable->updated_name_bytes, name, size);
-	variable->updated_name_size = size;
+	// Index new name.
+	if (indexed)
+		SMVMwareNVRAMIndexAddVariable(variable->cold->parent_entry, variable);
 	
 	// Mark as updated.
 	SMVMwareNVRAMVariableMarkUpdated(variable);
@@ -1040,35 +1766,26 @@ void SMVMwareNVRAMVariableSetName(SMVMwareNVRAMEFIVariable *variable, const void
 
 const void * SMVMwareNVRAMVariableGetValue(SMVMwareNVRAMEFIVariable *variable, size_t *size)
 {
-	if (variable->updated_value_bytes)
-	{
-		if (size)
-			*size = variable->updated_value_size;
-		
-		return variable->updated_value_bytes;
-	}
-	else
-	{
-		if (size)
-			*size = variable->original_value_size;
-		
-		return variable->original_value_bytes;
-	}
+	if (size)
+		*size = variable->value_size;
+	
+	return variable->value_bytes;
 }
 
 void SMVMwareNVRAMVariableSetValue(SMVMwareNVRAMEFIVariable *variable, const void *bytes, size_t size)
 {
-	// Free previous value.
-	if (variable->updated_value_bytes)
-		free(variable->updated_value_bytes);
-	
-	// Copy new value.
-	variable->updated_value_bytes = malloc(size);
+	SMVMwareNVRAMVariableSetValueNoCopy(variable, SMBytesCopy(bytes, size), size, SMBytesReleaseFree, NULL);
+}
+
+void SMVMwareNVRAMVariableSetValueNoCopy(SMVMwareNVRAMEFIVariable *variable, const void *bytes, size_t size, SMVMwareNVRAMBytesRelease release, void *context)
+{
+	// Release previous value, and reference new one.
+	assert(size <= UINT32_MAX);
 	
-	assert(variable->updated_value_bytes);
+	SMUpdatedBytesSet(&variable->cold->updated_value, bytes, size, release, context);
 	
-	memcpy(variable->updated_value_bytes, bytes, size);
-	variable->updated_value_size = size;
+	variable->value_bytes = bytes;
+	variable->value_size = (uint32_t)size;
 	
 	// Mark as updated.
 	SMVMwareNVRAMVariableMarkUpdated(variable);
@@ -1076,25 +1793,25 @@ void SMVMwareNVRAMVariableSetValue(SMVMwareNVRAMEFIVariable *variable, const voi
 
 const char * SMVMwareNVRAMVariableGetUTF8Name(SMVMwareNVRAMEFIVariable *variable, SMError **error)
 {
-	if (variable->utf8_name)
-		return variable->utf8_name;
+	if (variable->cold->utf8_name)
+		return variable->cold->utf8_name;
 
 	size_t		name_len = 0;
 	const void	*name_bytes = SMVMwareNVRAMVariableGetName(variable, &name_len);
 	
-	variable->utf8_name = SMStringUTF16ToUTF8(name_bytes, name_len);
+	variable->cold->utf8_name = SMStringUTF16LEToUTF8(name_bytes, name_len, NULL);
 	
-	if (!variable->utf8_name)
+	if (!variable->cold->utf8_name)
 		SMSetErrorPtr(error, SMVMwareNVRAMErrorDomain, -1, "unable to convert UTF-16 to UTF-8");
 	
-	return variable->utf8_name;
+	return variable->cold->utf8_name;
 }
 
 bool SMVMwareNVRAMVariableSetUTF8Name(SMVMwareNVRAMEFIVariable *variable, const char *utf8name, SMError **error)
 {
 	// Convert to UTF-16.
 	size_t	utf16_len = 0;
-	void	*utf16_bytes = SMStringUTF8ToUTF16(utf8name, true, &utf16_len);
+	void	*utf16_bytes = SMStringUTF8ToUTF16LE(utf8name, strlen(utf8name), true, &utf16_len);
 	
 	if (!utf16_bytes)
 	{
@@ -1102,16 +1819,29 @@ bool SMVMwareNVRAMVariableSetUTF8Name(SMVMwareNVRAMEFIVariable *variable, const
 		return false;
 	}
 	
+	// Unindex previous name.
+	bool indexed = variable->indexed;
+	
+	if (indexed)
+		SMVMwareNVRAMIndexRemoveVariable(variable->cold->parent_entry, variable);
+	
 	// Store UTF-16 bversion.
-	free(variable->updated_name_bytes);
-	variable->updated_name_bytes = utf16_bytes;
-	variable->updated_name_size = utf16_len;
+	assert(utf16_len <= UINT32_MAX);
+	
+	SMUpdatedBytesSet(&variable->cold->updated_name, utf16_bytes, utf16_len, SMBytesReleaseFree, NULL);
+	
+	variable->name_bytes = utf16_bytes;
+	variable->name_size = (uint32_t)utf16_len;
+	
+	// Index new name.
+	if (indexed)
+		SMVMwareNVRAMIndexAddVariable(variable->cold->parent_entry, variable);
 	
 	// Store UTF-8 version.
-	free(variable->utf8_name);
-	variable->utf8_name = strdup(utf8name);
+	free(variable->cold->utf8_name);
+	variable->cold->utf8_name = strdup(utf8name);
 	
-	assert(variable->utf8_name);
+	assert(variable->cold->utf8_name);
 	
 	// Mark as updated.
 	SMVMwareNVRAMVariableMarkUpdated(variable);
@@ -1120,6 +1850,74 @@ bool SMVMwareNVRAMVariableSetUTF8Name(SMVMwareNVRAMEFIVariable *variable, const
 }
 
 
+/*
+** Query
+*/
+#pragma mark - Query
+
+SMVMwareNVRAMQuery * SMVMwareNVRAMQueryCreate(const efi_guid_t *guid, const char *utf8_name, SMError **error)
+{
+	// Convert name to UTF-16.
+	size_t	name_size = 0;
+	void	*name = SMStringUTF8ToUTF16LE(utf8_name, strlen(utf8_name), false, &name_size);
+	
+	if (!name)
+	{
+		SMSetErrorPtr(error, SMVMwareNVRAMErrorDomain, -1, "unable to convert UTF-8 to UTF-16");
+		return NULL;
+	}
+	
+	// Create instance.
+	size_t				utf8_size = strlen(utf8_name) + 1;
+	SMVMwareNVRAMQuery	*query = malloc(sizeof(SMVMwareNVRAMQuery) + name_size + utf8_size);
+	
+	assert(query);
+	
+	memcpy(&query->guid, guid, sizeof(efi_guid_t));
+	memcpy(query->name, name, name_size);
+	
+	query->name_size = name_size;
+	query->utf8_name = (char *)query->name + name_size;
+	
+	memcpy(query->utf8_name, utf8_name, utf8_size);
+
+	query->hash = SMVMwareNVRAMIndexHash(guid, name, name_size);
+	
+	free(name);
+	
+	return query;
+}
+
+void SMVMwareNVRAMQueryFree(SMVMwareNVRAMQuery *query)
+{
+	free(query);
+}
+
+const char * SMVMwareNVRAMQueryGetUTF8Name(const SMVMwareNVRAMQuery *query)
+{
+	return query->utf8_name;
+}
+
+static bool SMVMwareNVRAMQueryMatchVariable(const SMVMwareNVRAMQuery *query, SMVMwareNVRAMEFIVariable *variable)
+{
+	// Names are compared up to their first UTF-16 zero, like the index does: the query name should be followed by nothing, or by a full zero unit.
+	if (variable->name_size < query->name_size || memcmp(&variable->guid, &query->guid, sizeof(efi_guid_t)) != 0)
+		return false;
+	
+	const uint8_t *name = variable->name_bytes;
+	
+	if (memcmp(name, query->name, query->name_size) != 0)
+		return false;
+	
+	size_t remaining = variable->name_size - query->name_size;
+	
+	if (remaining == 0)
+		return true;
+	
+	return (remaining >= 2 && name[query->name_size] == 0 && name[query->name_size + 1] == 0);
+}
+
+
 /*
 ** GUID
 */
@@ -1190,20 +1988,184 @@ void SMVMwareNVRAMGUIDToGUIDString(const efi_guid_t *guid, char *guid_str)
 
 #pragma mark File
 
-static bool SMFileWriteBytes(int fd, const void *bytes, size_t len, SMError **error)
+static void * SMFileReadAll(int fd, size_t size_hint, size_t *size, SMError **error)
 {
-	if (write(fd, bytes, len) != len)
+	// Read in a single growing buffer.
+	size_t	capacity = MAX(size_hint + 1, (size_t)SMFileReadMinCapacity);
+	size_t	length = 0;
+	char	*buffer = malloc(capacity);
+	
+	assert(buffer);
+	
+	while (1)
 	{
-		int err_bck = errno;
+		// > Grow.
+		if (length == capacity)
+		{
+			capacity *= 2;
+			buffer = reallocf(buffer, capacity);
+			
+			assert(buffer);
+		}
 		
-		SMSetErrorPtr(error, SMVMwareNVRAMErrorDomain, errno, "can't write bytes %s (%d - %s)", SMBytesDescription(bytes, len), err_bck, strerror(err_bck));
+		// > Read.
+		ssize_t result = read(fd, buffer + length, capacity - length);
 		
-		return false;
+		if (result < 0)
+		{
+			int err_bck = errno;
+			
+			if (err_bck == EINTR)
+				continue;
+			
+			SMSetErrorPtr(error, SMVMwareNVRAMErrorDomain, err_bck, "can't read the file (%d - %s)", err_bck, strerror(err_bck));
+			free(buffer);
+			
+			return NULL;
+		}
+		
+		if (result == 0)
+			break;
+		
+		length += (size_t)result;
+	}
+	
+	*size = length;
+	
+	return buffer;
+}
+
+static bool SMFilePWriteBytes(int fd, const void *bytes, size_t size, off_t offset, SMError **error)
+{
+	while (size > 0)
+	{
+		ssize_t written = pwrite(fd, bytes, size, offset);
+		
+		if (written < 0)
+		{
+			int err_bck = errno;
+			
+			if (err_bck == EINTR)
+				continue;
+			
+			SMSetErrorPtr(error, SMVMwareNVRAMErrorDomain, err_bck, "can't write bytes %s (%d - %s)", SMBytesDescription(bytes, size), err_bck, strerror(err_bck));
+			
+			return false;
+		}
+		
+		bytes += written;
+		size -= (size_t)written;
+		offset += written;
 	}
 	
 	return true;
 }
 
+static int SMFileClone(int src_fd, off_t size, const char *path)
+{
+	// Note: returns a writable descriptor on the copy, or -1 if the file can't be cloned or copied kernel-side (nothing is left behind).
+#if defined(__APPLE__)
+	if (fclonefileat(src_fd, AT_FDCWD, path, 0) == -1)
+		return -1;
+	
+	int fd = open(path, O_WRONLY);
+	
+	if (fd == -1)
+		unlink(path);
+	
+	return fd;
+#elif defined(__linux__)
+	int fd = open(path, O_WRONLY | O_CREAT | O_EXCL, 0644);
+	
+	if (fd == -1)
+		return -1;
+	
+	// > Reflink.
+	if (ioctl(fd, FICLONE, src_fd) == 0)
+		return fd;
+	
+	// > Copy kernel-side.
+	off_t src_offset = 0;
+	
+	while (src_offset < size)
+	{
+		ssize_t result = copy_file_range(src_fd, &src_offset, fd, NULL, (size_t)(size - src_offset), 0);
+		
+		if (result < 0 && errno == EINTR)
+			continue;
+		
+		if (result <= 0)
+		{
+			close(fd);
+			unlink(path);
+			return -1;
+		}
+	}
+	
+	return fd;
+#else
+	return -1;
+#endif
+}
+
+
+#pragma mark IO Vectors
+
+static void SMIOVecChainAppend(SMIOVecChain *chain, const void *bytes, size_t size)
+{
+	if (size == 0)
+		return;
+	
+	// Coalesce with previous vector if contiguous (unchanged regions of the mapping).
+	if (chain->iov_cnt > 0)
+	{
+		struct iovec *last = &chain->iov[chain->iov_cnt - 1];
+		
+		if ((const char *)last->iov_base + last->iov_len == (const char *)bytes)
+		{
+			last->iov_len += size;
+			return;
+		}
+	}
+	
+	// Append new vector.
+	if (chain->iov_cnt == chain->iov_size)
+	{
+		chain->iov_size = (chain->iov_size ? chain->iov_size * 2 : 32);
+		chain->iov = reallocf(chain->iov, chain->iov_size * sizeof(struct iovec));
+		
+		assert(chain->iov);
+	}
+	
+	chain->iov[chain->iov_cnt].iov_base = (void *)bytes;
+	chain->iov[chain->iov_cnt].iov_len = size;
+	
+	chain->iov_cnt++;
+}
+
+static size_t SMIOVecChainSize(SMIOVecChain *chain)
+{
+	size_t size = 0;
+	
+	for (size_t i = 0; i < chain->iov_cnt; i++)
+		size += chain->iov[i].iov_len;
+	
+	return size;
+}
+
+static void SMIOVecChainAppendPadding(SMIOVecChain *chain, size_t size)
+{
+	// > Reference the shared 0xff page as many times as needed.
+	while (size > 0)
+	{
+		size_t chunk = MIN(size, sizeof(g_padding_page));
+		
+		SMIOVecChainAppend(chain, g_padding_page, chunk);
+		
+		size -= chunk;
+	}
+}
+
 
 #pragma mark Bytes
 
@@ -1276,7 +2238,7 @@ static const char * SMBytesDescription(const void *bytes, size_t size)
 #define	max_size 5
 #define	max_result_size ((max_size * 2) + ((max_size - 1)) + 3 + 2 + 1)
 
-	static char buffer[max_result_size];
+	static __thread char buffer[max_result_size];
 
 	if (size == 0)
 		return "";
@@ -1319,129 +2281,57 @@ static const char * SMBytesDescription(const void *bytes, size_t size)
 }
 
 
-#pragma mark Strings
+#pragma mark Updated Bytes
 
-static char * SMStringUTF16ToUTF8(const void *utf16bytes, size_t len)
+static void * SMBytesCopy(const void *bytes, size_t size)
 {
-	char *result = NULL;
-	
-	// Create converter.
-#ifdef HAS_LOCK
-	static os_unfair_lock	lock = OS_UNFAIR_LOCK_INIT;
-	static iconv_t			conv = NULL;
-
-	os_unfair_lock_lock(&lock);
+	void *result = malloc(size);
 	
-#else
-	iconv_t conv = NULL;
-#endif
-	
-	if (!conv)
-		conv = iconv_open("UTF-8", "UTF-16LE");
+	assert(result);
 	
-	if (!conv)
-		goto finish;
+	memcpy(result, bytes, size);
 	
-	// Convert.
-	size_t	strInputSize = len;
-	char	*strInput = (char *)utf16bytes;
+	return result;
+}
 
-	size_t	strResultLenMax = strInputSize * 3 + 1;
-	char	*strResultBuffer = malloc(strResultLenMax);
-	char	*strResult = strResultBuffer;
-	
-	assert(strResultBuffer);
+static void SMBytesReleaseFree(const void *bytes, size_t size, void *context)
+{
+	free((void *)bytes);
+}
 
-	if (iconv(conv, (char **)&strInput, &strInputSize, &strResult, &strResultLenMax) == (size_t)(-1))
-		goto finish;
-		
-	// Add terminal zero.
-	if (strResultLenMax < 1)
-	{
-		free(strResultBuffer);
-		result = NULL;
-		goto finish;
-	}
-	
-	*strResult = 0;
-	
-	// Finish.
-	result = strResultBuffer;
-	
-finish:
-#ifdef HAS_LOCK
-	iconv(conv, NULL, NULL, NULL, NULL);
-	os_unfair_lock_unlock(&lock);
-#else
-	iconv_close(conv);
-#endif
-	
-	return result;
+static void SMUpdatedBytesSet(SMUpdatedBytes *updated, const void *bytes, size_t size, SMVMwareNVRAMBytesRelease release, void *context)
+{
+	// > Note: re-setting the same bytes doesn't release them.
+	if (updated->bytes != bytes)
+		SMUpdatedBytesRelease(updated);
+	
+	updated->bytes = bytes;
+	updated->size = size;
+	updated->release = release;
+	updated->context = context;
 }
 
-static void * SMStringUTF8ToUTF16(const char *utf8str, bool terminal_zero, size_t *len)
+static void SMUpdatedBytesRelease(SMUpdatedBytes *updated)
 {
-	char *result = NULL;
+	if (updated->bytes && updated->release)
+		updated->release(updated->bytes, updated->size, updated->context);
 	
-	// Create converter.
-#ifdef HAS_LOCK
-	static os_unfair_lock lock = OS_UNFAIR_LOCK_INIT;
-	static iconv_t conv = NULL;
+	memset(updated, 0, sizeof(*updated));
+}
 
-	os_unfair_lock_lock(&lock);
-	
-#else
-	iconv_t conv = NULL;
-#endif
-	
-	if (!conv)
-		conv = iconv_open("UTF-16LE", "UTF-8");
-	
-	if (!conv)
-		goto finish;
-	
-	// Convert.
-	size_t	strInputSize = strlen(utf8str);
-	char	*strInput = (char *)utf8str;
 
-	size_t	strResultLenMax = strInputSize * 3 + 2;
-	char	*strResultBuffer = malloc(strResultLenMax);
-	char	*strResult = strResultBuffer;
-	
-	assert(strResultBuffer);
+#pragma mark Strings
 
-	if (iconv(conv, (char **)&strInput, &strInputSize, &strResult, &strResultLenMax) == (size_t)(-1))
-		goto finish;
+static size_t SMStringUTF16Length(const void *utf16bytes, size_t len)
+{
+	// Size in bytes up to the first zero code unit (or the whole buffer).
+	const uint8_t *bytes = utf16bytes;
 	
-	// Add terminal zero.
-	if (terminal_zero)
+	for (size_t i = 0; i + 1 < len; i += 2)
 	{
-		if (strResultLenMax < 2)
-		{
-			free(strResultBuffer);
-			result = NULL;
-			goto finish;
-		}
-		
-		strResult[0] = 0;
-		strResult[1] = 0;
-
-		strResult += 2;
+		if (bytes[i] == 0 && bytes[i + 1] == 0)
+			return i;
 	}
 	
-	// Finish.
-	result = strResultBuffer;
-	
-	if (len)
-		*len = (strResult - strResultBuffer);
-	
-finish:
-#ifdef HAS_LOCK
-	iconv(conv, NULL, NULL, NULL, NULL);
-	os_unfair_lock_unlock(&lock);
-#else
-	iconv_close(conv);
-#endif
-	
-	return result;
+	return len;
 }
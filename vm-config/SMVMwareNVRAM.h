@@ -37,6 +37,7 @@
 typedef struct SMVMwareNVRAM 			SMVMwareNVRAM;
 typedef struct SMVMwareNVRAMEntry		SMVMwareNVRAMEntry;
 typedef struct SMVMwareNVRAMEFIVariable	SMVMwareNVRAMEFIVariable;
+typedef struct SMVMwareNVRAMQuery		SMVMwareNVRAMQuery;
 
 // EFI.
 typedef struct {
@@ -76,6 +77,15 @@ typedef enum
 	SMVMwareNVRAMEntryTypeEFIVariables
 } SMVMwareNVRAMEntryType;
 
+typedef enum
+{
+	SMVMwareNVRAMBytesBorrowed,	// Bytes are parsed in place, and must outlive the NVRAM instance.
+	SMVMwareNVRAMBytesOwned		// Bytes were malloc'ed, and are released by the NVRAM instance (even if opening fails).
+} SMVMwareNVRAMBytesOwnership;
+
+typedef bool (*SMVMwareNVRAMVariablePredicate)(SMVMwareNVRAMEFIVariable *variable, void *context);
+typedef void (*SMVMwareNVRAMBytesRelease)(const void *bytes, size_t size, void *context);
+
 
 /*
 ** Globals
@@ -93,10 +103,12 @@ extern const char * SMVMwareNVRAMErrorDomain;
 // NVRAM.
 // > Instance.
 SMVMwareNVRAM *	SMVMwareNVRAMOpen(const char *nvram_file_path, SMError **error);
+SMVMwareNVRAM *	SMVMwareNVRAMOpenWithBytes(const void *bytes, size_t size, SMVMwareNVRAMBytesOwnership ownership, SMError **error);
+SMVMwareNVRAM *	SMVMwareNVRAMOpenWithFileDescriptor(int fd, SMError **error); // Maps regular files, reads anything else (pipe, socket, ...) up to EOF. The descriptor is not closed.
 void			SMVMwareNVRAMFree(SMVMwareNVRAM *nvram);
 
 // > Properties.
-const char * SMVMwareNVRAMGetPath(SMVMwareNVRAM *nvram);
+const char * SMVMwareNVRAMGetPath(SMVMwareNVRAM *nvram); // NULL if not opened from a path.
 
 // > Serialization.
 bool SMVMwareNVRAMWriteToFile(SMVMwareNVRAM *nvram, const char *path, SMError **error);
@@ -121,9 +133,20 @@ const void *	SMVMwareNVRAMEntryGetContentBytes(SMVMwareNVRAMEntry *entry, size_t
 // > Variables.
 SMVMwareNVRAMEFIVariable *	SMVMwareNVRAMEntryAddVariable(SMVMwareNVRAMEntry *entry, efi_guid_t guid, uint32_t attributes, const char *utf8_name, const void *bytes, size_t size, SMError **error);
 
+void	SMVMwareNVRAMEntryRemoveVariable(SMVMwareNVRAMEntry *entry, SMVMwareNVRAMEFIVariable *variable); // Removed variables stay valid (but detached) until the entry is freed.
+size_t	SMVMwareNVRAMEntryRemoveVariablesMatching(SMVMwareNVRAMEntry *entry, SMVMwareNVRAMVariablePredicate predicate, void *context);
+
 size_t						SMVMwareNVRAMEntryVariablesCount(SMVMwareNVRAMEntry *entry);
 SMVMwareNVRAMEFIVariable *	SMVMwareNVRAMEntryGetVariableAtIndex(SMVMwareNVRAMEntry *entry, size_t idx);
 
+// > Lookup.
+// > Variables are indexed on GUID & UTF-16 name (compared up to the first zero code unit). The first matching variable is returned, or NULL.
+SMVMwareNVRAMEFIVariable *	SMVMwareNVRAMEntryGetVariableForGUIDAndName(SMVMwareNVRAMEntry *entry, const efi_guid_t *guid, const void *name, size_t name_size);
+SMVMwareNVRAMEFIVariable *	SMVMwareNVRAMEntryGetVariableForGUIDAndUTF8Name(SMVMwareNVRAMEntry *entry, const efi_guid_t *guid, const char *utf8_name);
+
+SMVMwareNVRAMEFIVariable *	SMVMwareNVRAMEntryGetVariableForQuery(SMVMwareNVRAMEntry *entry, const SMVMwareNVRAMQuery *query);
+void						SMVMwareNVRAMEntryGetVariablesForQueries(SMVMwareNVRAMEntry *entry, const SMVMwareNVRAMQuery * const *queries, size_t count, SMVMwareNVRAMEFIVariable **variables); // Single pass over the store. Unmatched queries get NULL.
+
 
 // Variables.
 efi_guid_t		SMVMwareNVRAMVariableGetGUID(SMVMwareNVRAMEFIVariable *variable);
@@ -138,10 +161,22 @@ void			SMVMwareNVRAMVariableSetName(SMVMwareNVRAMEFIVariable *variable, const vo
 const void *	SMVMwareNVRAMVariableGetValue(SMVMwareNVRAMEFIVariable *variable, size_t *len);
 void			SMVMwareNVRAMVariableSetValue(SMVMwareNVRAMEFIVariable *variable, const void *bytes, size_t size);
 
+// > No-copy setters: bytes are referenced as-is until replaced or until the NVRAM instance is freed, then handed to release (if not NULL).
+void			SMVMwareNVRAMVariableSetNameNoCopy(SMVMwareNVRAMEFIVariable *variable, const void *name, size_t size, SMVMwareNVRAMBytesRelease release, void *context);
+void			SMVMwareNVRAMVariableSetValueNoCopy(SMVMwareNVRAMEFIVariable *variable, const void *bytes, size_t size, SMVMwareNVRAMBytesRelease release, void *context);
+
 const char *	SMVMwareNVRAMVariableGetUTF8Name(SMVMwareNVRAMEFIVariable *variable, SMError **error);
 bool			SMVMwareNVRAMVariableSetUTF8Name(SMVMwareNVRAMEFIVariable *variable, const char *utf8name, SMError **error);
 
 
+// Query.
+// > A query encodes a GUID & name once, to be run against any number of NVRAM files. Queries are immutable, and can be shared between threads.
+SMVMwareNVRAMQuery *	SMVMwareNVRAMQueryCreate(const efi_guid_t *guid, const char *utf8_name, SMError **error);
+void					SMVMwareNVRAMQueryFree(SMVMwareNVRAMQuery *query);
+
+const char *			SMVMwareNVRAMQueryGetUTF8Name(const SMVMwareNVRAMQuery *query);
+
+
 // GUID.
 bool SMVMwareNVRAMGUIDStringToGUID(const char *guid_str, efi_guid_t *guid, SMError **error);
 void SMVMwareNVRAMGUIDToGUIDString(const efi_guid_t *guid, char *guid_str);
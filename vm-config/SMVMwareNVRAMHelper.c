@@ -373,33 +373,46 @@ SMVMwareNVRAMEFIVariable * SMVMwareNVRAMVariableForGUIDAndName(SMVMwareNVRAM *nv
 		return NULL;
 
 	// Search variable.
-	for (size_t i = 0; i < SMVMwareNVRAMEntryVariablesCount(entry); i++)
-	{
-		SMVMwareNVRAMEFIVariable *var = SMVMwareNVRAMEntryGetVariableAtIndex(entry, i);
+	SMVMwareNVRAMEFIVariable *var = SMVMwareNVRAMEntryGetVariableForGUIDAndUTF8Name(entry, guid, name);
 
-		// > Check GUID.
-		efi_guid_t iguid = SMVMwareNVRAMVariableGetGUID(var);
+	if (var)
+		return var;
 
-		if (memcmp(&iguid, guid, sizeof(efi_guid_t)) != 0)
-			continue;
+	SMSetErrorPtr(error, SMVMwareNVRAMErrorDomain, -1, "variable '%s' not found", name);
+	
+	return NULL;
+}
 
-		// > Check name.
-		const char *iname = SMVMwareNVRAMVariableGetUTF8Name(var, NULL);
+SMVMwareNVRAMEFIVariable * SMVMwareNVRAMVariableForQuery(SMVMwareNVRAM *nvram, const SMVMwareNVRAMQuery *query, SMError **error)
+{
+	SMVMwareNVRAMEntry *entry = SMVMwareNVRAMVariablesEntry(nvram, error);
 
-		if (!iname)
-			continue;
+	if (!entry)
+		return NULL;
 
-		if (strcmp(iname, name) != 0)
-			continue;
+	// Search variable.
+	SMVMwareNVRAMEFIVariable *var = SMVMwareNVRAMEntryGetVariableForQuery(entry, query);
 
+	if (var)
 		return var;
-	}
 
-	SMSetErrorPtr(error, SMVMwareNVRAMErrorDomain, -1, "variable '%s' not found", name);
-	
+	SMSetErrorPtr(error, SMVMwareNVRAMErrorDomain, -1, "variable '%s' not found", SMVMwareNVRAMQueryGetUTF8Name(query));
+
 	return NULL;
 }
 
+bool SMVMwareNVRAMVariablesForQueries(SMVMwareNVRAM *nvram, const SMVMwareNVRAMQuery * const *queries, size_t count, SMVMwareNVRAMEFIVariable **variables, SMError **error)
+{
+	SMVMwareNVRAMEntry *entry = SMVMwareNVRAMVariablesEntry(nvram, error);
+
+	if (!entry)
+		return false;
+
+	SMVMwareNVRAMEntryGetVariablesForQueries(entry, queries, count, variables);
+
+	return true;
+}
+
 
 #pragma mark Screen Resolution
 
@@ -145,3 +145,5 @@ bool SMVMwareNVRAMSetScreenResolution(SMVMwareNVRAM *nvram, uint32_t width, uint
 // Helpers.
 SMVMwareNVRAMEntry * SMVMwareNVRAMVariablesEntry(SMVMwareNVRAM *nvram, SMError **error);
 SMVMwareNVRAMEFIVariable * SMVMwareNVRAMVariableForGUIDAndName(SMVMwareNVRAM *nvram, const efi_guid_t *guid, const char *name, SMError **error);
+SMVMwareNVRAMEFIVariable * SMVMwareNVRAMVariableForQuery(SMVMwareNVRAM *nvram, const SMVMwareNVRAMQuery *query, SMError **error);
+bool SMVMwareNVRAMVariablesForQueries(SMVMwareNVRAM *nvram, const SMVMwareNVRAMQuery * const *queries, size_t count, SMVMwareNVRAMEFIVariable **variables, SMError **error);
@@ -26,14 +26,45 @@
 #include <assert.h>
 #include <fcntl.h>
 #include <string.h>
+#include <strings.h>
 #include <ctype.h>
+#include <limits.h>
 
 #include <sys/errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/param.h>
+#include <sys/uio.h>
+
+#if defined(__linux__)
+#  include <sys/ioctl.h>
+#  include <linux/fs.h>
+#endif
 
 #include "SMVMwareVMX.h"
 
 #include "SMStringHelper.h"
-#include "SMBytesWritter.h"
+#include "SMIOHelper.h"
+#include "SMHashHelper.h"
+#include "SMStringIntern.h"
+#include "SMArena.h"
+#include "SMVMwareVMXScanner.h"
+
+
+/*
+** Defines
+*/
+#pragma mark - Defines
+
+// Minimum size of an original slice to copy it kernel-side instead of writing it from the mapping.
+#define SMVMwareVMXCopyRangeMinSize	(16 * 1024)
+#define SMVMwareVMXEntriesMinCapacity	64
+
+#if defined(__APPLE__)
+#  define SMStatMTime(St) ((St).st_mtimespec)
+#else
+#  define SMStatMTime(St) ((St).st_mtim)
+#endif
 
 
 /*
@@ -41,35 +72,142 @@
 */
 #pragma mark - Types
 
+typedef struct SMVMwareVMXIndexSlot
+{
+	uint64_t			hash;
+	
+	SMVMwareVMXEntry	*head; // First entry with this key, in file order.
+	SMVMwareVMXEntry	*tail;
+} SMVMwareVMXIndexSlot;
+
+typedef struct SMVMwareVMXKeyNode SMVMwareVMXKeyNode;
+
+struct SMVMwareVMXKeyNode
+{
+	SMVMwareVMXKeyNode *parent;
+	
+	// Key component (not zero-terminated, points in an interned lowercase key).
+	const char	*component;
+	size_t		component_size;
+	uint64_t	hash;
+	
+	// Children.
+	SMVMwareVMXKeyNode *children_head;
+	SMVMwareVMXKeyNode *children_tail;
+	SMVMwareVMXKeyNode *next_sibling;
+	
+	// Entries whose key ends on this node.
+	SMVMwareVMXEntry *entries;
+	
+	// Count of entries in the whole subtree.
+	size_t subtree_cnt;
+};
+
 struct SMVMwareVMX
 {
-	char *path;
+	char					*path;
+	SMVMwareVMXOpenOptions	options;
+	
+	// Mapped file.
+	char		*bytes;
+	size_t		size;
+	struct stat	bytes_stat;
+	
+	// Storage for entries and their strings.
+	SMArena arena;
+	
+	// Interned keys (in arena).
+	SMStringInternTable keys;
 	
 	SMVMwareVMXEntry	**entries;
 	size_t				entries_cnt;
+	size_t				entries_capacity;
+	
+	size_t				removed_cnt; // Removed entries not yet compacted.
+	
+	// Keys index (open addressing, linear probing).
+	SMVMwareVMXIndexSlot	*index;
+	size_t					index_size;
+	size_t					index_cnt;
+	
+	// Keys tree (dotted components), built on first use.
+	bool				tree_built;
+	SMVMwareVMXKeyNode	tree_root;
+	
+	SMVMwareVMXKeyNode	**tree_nodes; // (parent, component) -> node (open addressing, linear probing).
+	size_t				tree_nodes_size;
+	size_t				tree_nodes_cnt;
 };
 
+typedef struct SMVMwareVMXWriter
+{
+	SMVMwareVMX *vmx;
+	
+	// Output.
+	int		fd;
+	off_t	offset;
+	
+	// Pending vectors.
+	struct iovec	iov[IOV_MAX];
+	int				iov_cnt;
+	
+	// Source file, to copy original slices kernel-side (-1 if not available).
+	int src_fd;
+} SMVMwareVMXWriter;
+
 struct SMVMwareVMXEntry
 {
 	SMVMwareVMXEntryType type;
 	
+	// Parent.
+	SMVMwareVMX	*vmx;
+	size_t		idx;
+	
+	// Keys index.
+	const SMInternedString	*key_interned; // Case-insensitive key, interned in the document.
+	SMVMwareVMXEntry		*key_next; // Next entry with the same key.
+	
+	// Keys tree.
+	SMVMwareVMXKeyNode	*key_node;
+	SMVMwareVMXEntry	*node_prev;
+	SMVMwareVMXEntry	*node_next;
+	
+	// Removed entry (tombstone, waiting compaction).
+	bool removed;
+	
 	// Updated entry.
 	bool updated;
 	
-	// Original bytes.
-	char *original_line;
+	// Original bytes (spans in the mapped file, not zero-terminated).
+	const char	*original_line;
+	size_t		original_line_size;
+	
+	const char	*original_key;
+	size_t		original_key_size;
+	
+	const char	*original_value;
+	size_t		original_value_size;
+	bool		original_value_escaped;
+	bool		original_value_pending; // Lazy mode: span runs up to end of line, closing delimiter not searched yet.
+	
+	const char	*original_comment;
+	size_t		original_comment_size;
 	
-	char *original_key;
-	char *original_value;
-	char *original_comment;
+	// Materialized original fields (arena).
+	char *original_key_str;
+	char *original_value_str;
+	char *original_comment_str;
 	
-	// Serialization.
-	char *serialized_line;
+	// Serialization (arena).
+	char	*serialized_line;
+	size_t	serialized_line_size;
 	
-	// Updated fields.
-	char *updated_key;
-	char *updated_value;
-	char *updated_comment;
+	// Updated fields (arena).
+	char	*updated_key;
+	size_t	updated_key_size;
+	
+	char	*updated_value;
+	char	*updated_comment;
 };
 
 
@@ -81,8 +219,6 @@ struct SMVMwareVMXEntry
 // Errors.
 const char * SMVMwareVMXErrorDomain = "com.sourcemac.vmware-vmx.error";
 
-static const char gBlanckCharacters[] = { ' ', '\t' };
-static const char gBlanckAndNewlineCharacters[] = { ' ', '\t', '\n' };
 
 
 /*
@@ -93,20 +229,53 @@ static const char gBlanckAndNewlineCharacters[] = { ' ', '\t', '\n' };
 // VMX.
 // > Entries.
 static void SMVMwareVMXAddEntry(SMVMwareVMX *vmx, SMVMwareVMXEntry *entry);
+static void SMVMwareVMXDetachEntry(SMVMwareVMX *vmx, SMVMwareVMXEntry *entry);
+static void SMVMwareVMXCompactEntries(SMVMwareVMX *vmx);
+
+// > Writer.
+static int	SMVMwareVMXWriterOpenSource(SMVMwareVMX *vmx);
+static bool	SMVMwareVMXWriterAppend(SMVMwareVMXWriter *writer, const void *bytes, size_t size, bool original, SMError **error);
+static bool	SMVMwareVMXWriterFlush(SMVMwareVMXWriter *writer, SMError **error);
+static bool	SMVMwareVMXWriterWriteVector(SMVMwareVMXWriter *writer, struct iovec *iov, int iov_cnt, SMError **error);
+
+// > Index.
+static void						SMVMwareVMXIndexAddEntry(SMVMwareVMX *vmx, SMVMwareVMXEntry *entry);
+static void						SMVMwareVMXIndexRemoveEntry(SMVMwareVMX *vmx, SMVMwareVMXEntry *entry);
+static SMVMwareVMXIndexSlot *	SMVMwareVMXIndexSearchSlot(SMVMwareVMX *vmx, const SMInternedString *key);
+static void						SMVMwareVMXIndexResize(SMVMwareVMX *vmx, size_t size);
+
+// > Tree.
+static void					SMVMwareVMXTreeBuild(SMVMwareVMX *vmx);
+static void					SMVMwareVMXTreeAddEntry(SMVMwareVMX *vmx, SMVMwareVMXEntry *entry);
+static void					SMVMwareVMXTreeRemoveEntry(SMVMwareVMX *vmx, SMVMwareVMXEntry *entry);
+static SMVMwareVMXKeyNode *	SMVMwareVMXTreeGetNode(SMVMwareVMX *vmx, const char *name_space);
+static SMVMwareVMXKeyNode *	SMVMwareVMXTreeGetChild(SMVMwareVMX *vmx, SMVMwareVMXKeyNode *parent, const char *component, size_t component_size, bool create);
+static size_t				SMVMwareVMXTreeCollectEntries(SMVMwareVMXKeyNode *node, SMVMwareVMXEntry **entries, size_t entries_cnt);
+static void					SMVMwareVMXTreeResize(SMVMwareVMX *vmx, size_t size);
 
 // Entry.
 // > Instance.
-static SMVMwareVMXEntry * 	SMVMwareVMXEntryCreateKeyValue(const char *key, const char *value, SMError **error);
-static SMVMwareVMXEntry *	SMVMwareVMXEntryCreateFromLine(const char *line, size_t line_idx, SMError **error);
-static void					SMVMwareVMXEntryFree(SMVMwareVMXEntry *entry);
+static SMVMwareVMXEntry * 	SMVMwareVMXEntryCreateKeyValue(SMVMwareVMX *vmx, const char *key, const char *value);
+static SMVMwareVMXEntry *	SMVMwareVMXEntryCreateFromLine(SMVMwareVMX *vmx, const char *line, size_t line_size, const uint32_t *structurals, size_t structurals_cnt, size_t line_idx, SMError **error);
 
 // > Serialization.
-static const char *	SMVMwareVMXEntryGetSerializedLine(SMVMwareVMXEntry *entry);
+static const char *	SMVMwareVMXEntryGetSerializedLine(SMVMwareVMXEntry *entry, size_t *size, SMError **error);
 static void			SMVMwareVMXEntryMarkUpdated(SMVMwareVMXEntry *entry);
 
+// > Key-Value.
+static const char *	SMVMwareVMXEntryGetKeyBytes(SMVMwareVMXEntry *entry, size_t *size);
+static bool			SMVMwareVMXEntryDelimitValue(SMVMwareVMXEntry *entry, SMError **error);
+
+// > Sort.
+static int SMVMwareVMXEntryCompareIndex(const void *a, const void *b);
+
 // Helpers.
 // > File.
-static bool SMFileWriteBytes(int fd, const void *bytes, size_t len, SMError **error);
+static int SMFileCopyRange(int src_fd, off_t src_offset, int dst_fd, off_t dst_offset, size_t size, SMError **error);
+
+// > Strings.
+static bool SMIsBlank(char c);
+static char * SMStringUnescapeValue(SMArena *arena, const char *value, size_t size);
 
 
 								   
@@ -119,71 +288,146 @@ static bool SMFileWriteBytes(int fd, const void *bytes, size_t len, SMError **er
 
 SMVMwareVMX * SMVMwareVMXOpen(const char *vmx_file_path, SMError **error)
 {
-	SMVMwareVMX *result = calloc(1, sizeof(SMVMwareVMX));
+	return SMVMwareVMXOpenWithOptions(vmx_file_path, SMVMwareVMXOpenOptionNone, error);
+}
+
+SMVMwareVMX * SMVMwareVMXOpenWithOptions(const char *vmx_file_path, SMVMwareVMXOpenOptions options, SMError **error)
+{
+	SMVMwareVMX	*result = calloc(1, sizeof(SMVMwareVMX));
+	uint32_t	*structurals = NULL;
 	
 	assert(result);
 	
+	result->keys = (SMStringInternTable)SMStringInternTableInit(&result->arena);
+	
 	// Copy path.
 	result->path = strdup(vmx_file_path);
 	
 	assert(result->path);
+	
+	// Hold options.
+	result->options = options;
 		
 	// Open the file.
-	FILE *file = fopen(vmx_file_path, "r");
+	int fd = open(vmx_file_path, O_RDONLY);
 	
-	if (!file)
+	if (fd == -1)
 	{
 		SMSetErrorPtr(error, SMVMwareVMXErrorDomain, errno, "can't open the file (%d - %s)", errno, strerror(errno));
 		goto fail;
 	}
 	
-	// Read lines.
-	char	*line = NULL;
-	size_t	linecap = 0;
-	size_t	line_idx = 0;
+	// Stat the file.
+	struct stat st;
+	
+	if (fstat(fd, &st) == -1)
+	{
+		SMSetErrorPtr(error, SMVMwareVMXErrorDomain, errno, "can't stat the file (%d - %s)", errno, strerror(errno));
+		close(fd);
+		goto fail;
+	}
+	
+	// Handle empty file.
+	if (st.st_size == 0)
+	{
+		close(fd);
+		return result;
+	}
+	
+	// Check size (structural offsets are 32 bits).
+	if ((uint64_t)st.st_size > UINT32_MAX)
+	{
+		SMSetErrorPtr(error, SMVMwareVMXErrorDomain, -1, "file is too big");
+		close(fd);
+		goto fail;
+	}
+	
+	// Map the file.
+	// > Forge flags.
+	int	flags = MAP_PRIVATE | MAP_FILE;
+
+#if defined(MAP_RESILIENT_MEDIA)
+	flags |= MAP_RESILIENT_MEDIA;
+#endif
+	
+	// > Map.
+	void	*mbytes = mmap(NULL, st.st_size, PROT_READ, flags, fd, 0);
+	int		err = errno;
+	
+	close(fd);
+	
+	if (mbytes == MAP_FAILED)
+	{
+		SMSetErrorPtr(error, SMVMwareVMXErrorDomain, err, "can't map the file (%d - %s)", err, strerror(err));
+		goto fail;
+	}
+	
+	// Hold parameters.
+	result->bytes = mbytes;
+	result->size = st.st_size;
+	result->bytes_stat = st;
+	
+	// Scan structural characters.
+	const char	*bytes = mbytes;
+	size_t		size = st.st_size;
+	size_t		structurals_cnt = 0;
+	
+	structurals = SMVMwareVMXScannerScan(bytes, size, &structurals_cnt);
+	
+	// Parse lines.
+	size_t line_start = 0;
+	size_t line_idx = 0;
+	size_t sidx = 0;
 	
-	while (1)
+	while (line_start < size)
 	{
-		// > Read line.
-		ssize_t linelen = getline(&line, &linecap, file);
+		// > Search end of line (the sentinel stops us at end of file).
+		size_t first_sidx = sidx;
 		
-		if (linelen == -1)
+		while (structurals[sidx] < size && bytes[structurals[sidx]] != '\n')
+			sidx++;
+		
+		size_t line_end = structurals[sidx];
+		
+		// > Trim line.
+		const char	*line = bytes + line_start;
+		size_t		line_size = line_end - line_start;
+		
+		while (line_size && SMIsBlank(*line))
 		{
-			if (!feof(file))
-			{
-				SMSetErrorPtr(error, SMVMwareVMXErrorDomain, errno, "can't read line (%d - %s)", errno, strerror(errno));
-				goto fail;
-			}
-			
-			break;
+			line++;
+			line_size--;
 		}
-				
-		// > Create entry.
-		char 				*clean_line = SMStringTrimCharacter(line, gBlanckAndNewlineCharacters, sizeof(gBlanckAndNewlineCharacters), false);
-		SMVMwareVMXEntry	*entry = SMVMwareVMXEntryCreateFromLine(clean_line, line_idx, error);
 		
-		free(clean_line);
+		while (line_size && SMIsBlank(line[line_size - 1]))
+			line_size--;
+		
+		// > Create entry.
+		SMVMwareVMXEntry *entry = SMVMwareVMXEntryCreateFromLine(result, line, line_size, structurals + first_sidx, sidx - first_sidx, line_idx, error);
 		
 		if (!entry)
-		{
-			free(line);
 			goto fail;
-		}
 		
 		// > Add entry.
 		SMVMwareVMXAddEntry(result, entry);
 		
-		// > Update line index.
+		// > Next line.
+		line_start = line_end + 1;
 		line_idx++;
+		
+		if (line_end < size)
+			sidx++;
 	}
-
-	free(line);
-			
+	
 	// Return.
+	free(structurals);
+	
 	return result;
 	
 fail:
+	free(structurals);
 	SMVMwareVMXFree(result);
+	
 	return NULL;
 }
 
@@ -196,132 +440,799 @@ void SMVMwareVMXFree(SMVMwareVMX *vmx)
 	free(vmx->path);
 
 	// Entries.
-	for (size_t i = 0; i < vmx->entries_cnt; i++)
-		SMVMwareVMXEntryFree(vmx->entries[i]);
-	
 	free(vmx->entries);
 	
+	// Interned keys.
+	SMStringInternTableFree(&vmx->keys);
+	
+	// Arena (entries content).
+	SMArenaFree(&vmx->arena);
+	
+	// Index.
+	free(vmx->index);
+	
+	// Tree (nodes are in arena).
+	free(vmx->tree_nodes);
+	
+	// Unmap bytes.
+	if (vmx->bytes)
+		munmap(vmx->bytes, vmx->size);
+	
 	// Root.
 	free(vmx);
 }
 
 
-#pragma mark > Properties
-
-const char * SMVMwareVMXGetPath(SMVMwareVMX *vmx)
+#pragma mark > Properties
+
+const char * SMVMwareVMXGetPath(SMVMwareVMX *vmx)
+{
+	return vmx->path;
+}
+
+
+#pragma mark > Serialization
+
+bool SMVMwareVMXWriteToFile(SMVMwareVMX *vmx, const char *path, SMError **error)
+{
+	SMVMwareVMXWriter *writer = NULL;
+	
+	// Open file.
+	int fd = open(path, O_WRONLY | O_CREAT | O_EXCL, 0644);
+	
+	if (fd == -1)
+	{
+		SMSetErrorPtr(error, SMVMwareVMXErrorDomain, errno, "can't create the file (%d - %s)", errno, strerror(errno));
+		goto fail;
+	}
+	
+	// Create writer.
+	writer = calloc(1, sizeof(SMVMwareVMXWriter));
+	
+	assert(writer);
+	
+	writer->vmx = vmx;
+	writer->fd = fd;
+	writer->src_fd = SMVMwareVMXWriterOpenSource(vmx);
+	
+	// Drop removed entries.
+	SMVMwareVMXCompactEntries(vmx);
+	
+	// Write entries.
+	static char new_line[] = { '\n' };
+	
+	size_t		entries_count = SMVMwareVMXEntriesCount(vmx);
+	const char	*bytes_end = vmx->bytes + vmx->size;
+	
+	for (size_t i = 0; i < entries_count; i++)
+	{
+		SMVMwareVMXEntry	*entry = SMVMwareVMXGetEntryAtIndex(vmx, i);
+		size_t				line_size = 0;
+		const char			*line = SMVMwareVMXEntryGetSerializedLine(entry, &line_size, error);
+		
+		if (!line)
+			goto fail;
+		
+		// Original line followed by its new line: use a slice of the original bytes.
+		if (!entry->updated && line + line_size < bytes_end && line[line_size] == '\n')
+		{
+			if (!SMVMwareVMXWriterAppend(writer, line, line_size + 1, true, error))
+				goto fail;
+			
+			continue;
+		}
+		
+		// Line and new line.
+		if (!SMVMwareVMXWriterAppend(writer, line, line_size, false, error))
+			goto fail;
+		
+		if (!SMVMwareVMXWriterAppend(writer, new_line, sizeof(new_line), false, error))
+			goto fail;
+	}
+	
+	// Flush remaining vectors.
+	if (!SMVMwareVMXWriterFlush(writer, error))
+		goto fail;
+	
+	// Close.
+	if (writer->src_fd >= 0)
+		close(writer->src_fd);
+	
+	free(writer);
+	close(fd);
+	
+	return true;
+	
+fail:
+	if (writer && writer->src_fd >= 0)
+		close(writer->src_fd);
+	
+	free(writer);
+	
+	if (fd >= 0)
+		close(fd);
+	
+	unlink(path);
+	
+	return false;
+}
+
+
+static int SMVMwareVMXWriterOpenSource(SMVMwareVMX *vmx)
+{
+#if defined(__linux__)
+	// Copy ranges are only worth it for big files.
+	if (vmx->size < SMVMwareVMXCopyRangeMinSize)
+		return -1;
+	
+	// Open source.
+	int fd = open(vmx->path, O_RDONLY);
+	
+	if (fd == -1)
+		return -1;
+	
+	// Check the file is still the one we mapped.
+	struct stat st;
+	
+	if (fstat(fd, &st) == -1 ||
+		st.st_dev != vmx->bytes_stat.st_dev ||
+		st.st_ino != vmx->bytes_stat.st_ino ||
+		st.st_size != vmx->bytes_stat.st_size ||
+		SMStatMTime(st).tv_sec != SMStatMTime(vmx->bytes_stat).tv_sec ||
+		SMStatMTime(st).tv_nsec != SMStatMTime(vmx->bytes_stat).tv_nsec)
+	{
+		close(fd);
+		return -1;
+	}
+	
+	return fd;
+#else
+	return -1;
+#endif
+}
+
+static bool SMVMwareVMXWriterAppend(SMVMwareVMXWriter *writer, const void *bytes, size_t size, bool original, SMError **error)
+{
+	// Extend the previous original slice if these original bytes directly follow it.
+	if (original && writer->iov_cnt > 0)
+	{
+		struct iovec *last = &writer->iov[writer->iov_cnt - 1];
+		
+		if ((const char *)last->iov_base + last->iov_len == bytes)
+		{
+			last->iov_len += size;
+			return true;
+		}
+	}
+	
+	// Flush vectors if we don't have room anymore.
+	if (writer->iov_cnt == IOV_MAX && !SMVMwareVMXWriterFlush(writer, error))
+		return false;
+	
+	// Add vector.
+	writer->iov[writer->iov_cnt++] = (struct iovec){ .iov_base = (void *)bytes, .iov_len = size };
+	
+	return true;
+}
+
+static bool SMVMwareVMXWriterFlush(SMVMwareVMXWriter *writer, SMError **error)
+{
+	SMVMwareVMX	*vmx = writer->vmx;
+	int			start = 0;
+	
+	for (int i = 0; i <= writer->iov_cnt; i++)
+	{
+		struct iovec	*iov = &writer->iov[i];
+		bool			copy_range = false;
+		
+		// Check if this vector is a big original slice we can copy kernel-side.
+		if (i < writer->iov_cnt && writer->src_fd >= 0 && iov->iov_len >= SMVMwareVMXCopyRangeMinSize)
+			copy_range = ((const char *)iov->iov_base >= vmx->bytes && (const char *)iov->iov_base < vmx->bytes + vmx->size);
+		
+		if (!copy_range && i < writer->iov_cnt)
+			continue;
+		
+		// Write pending vectors.
+		if (i > start && !SMVMwareVMXWriterWriteVector(writer, &writer->iov[start], i - start, error))
+			return false;
+		
+		start = i + 1;
+		
+		if (!copy_range)
+			continue;
+		
+		// Copy original slice.
+		off_t	src_offset = (off_t)((const char *)iov->iov_base - vmx->bytes);
+		int		result = SMFileCopyRange(writer->src_fd, src_offset, writer->fd, writer->offset, iov->iov_len, error);
+		
+		if (result < 0)
+			return false;
+		
+		if (result > 0)
+		{
+			writer->offset += (off_t)iov->iov_len;
+			continue;
+		}
+		
+		// > Not supported: write it from the mapping, and don't try again.
+		close(writer->src_fd);
+		writer->src_fd = -1;
+		
+		if (!SMVMwareVMXWriterWriteVector(writer, iov, 1, error))
+			return false;
+	}
+	
+	writer->iov_cnt = 0;
+	
+	return true;
+}
+
+static bool SMVMwareVMXWriterWriteVector(SMVMwareVMXWriter *writer, struct iovec *iov, int iov_cnt, SMError **error)
+{
+	ssize_t written = SMIOWriteVector(writer->fd, iov, (size_t)iov_cnt);
+	
+	if (written < 0)
+	{
+		SMSetErrorPtr(error, SMVMwareVMXErrorDomain, errno, "can't write bytes (%d - %s)", errno, strerror(errno));
+		return false;
+	}
+	
+	// > Vectors are shrunk in place by partial writes: advance by the bytes actually written.
+	writer->offset += (off_t)written;
+	
+	return true;
+}
+
+
+#pragma mark > Entries
+
+SMVMwareVMXEntry *	SMVMwareVMXAddEntryKeyValue(SMVMwareVMX *vmx, const char *key, const char *value, SMError **error)
+{
+	// Create instance.
+	SMVMwareVMXEntry *entry = SMVMwareVMXEntryCreateKeyValue(vmx, key, value);
+	
+	// Add to entries.
+	SMVMwareVMXAddEntry(vmx, entry);
+	SMVMwareVMXEntryMarkUpdated(entry);
+	
+	// Return added entry.
+	return entry;
+}
+
+static void SMVMwareVMXAddEntry(SMVMwareVMX *vmx, SMVMwareVMXEntry *entry)
+{
+	// Append to array.
+	if (vmx->entries_cnt == vmx->entries_capacity)
+	{
+		vmx->entries_capacity = MAX(vmx->entries_capacity * 2, SMVMwareVMXEntriesMinCapacity);
+		vmx->entries = reallocf(vmx->entries, vmx->entries_capacity * sizeof(*vmx->entries));
+		
+		assert(vmx->entries);
+	}
+	
+	vmx->entries[vmx->entries_cnt] = entry;
+	
+	// Link the entry to us.
+	entry->vmx = vmx;
+	entry->idx = vmx->entries_cnt;
+	
+	vmx->entries_cnt++;
+	
+	// Index key.
+	if (entry->type == SMVMwareVMXEntryTypeKeyValue)
+	{
+		SMVMwareVMXIndexAddEntry(vmx, entry);
+		
+		if (vmx->tree_built)
+			SMVMwareVMXTreeAddEntry(vmx, entry);
+	}
+}
+
+void SMVMwareVMXRemoveEntry(SMVMwareVMX *vmx, SMVMwareVMXEntry *entry)
+{
+	assert(entry->vmx == vmx);
+	
+	SMVMwareVMXDetachEntry(vmx, entry);
+}
+
+size_t SMVMwareVMXRemoveEntriesMatching(SMVMwareVMX *vmx, SMVMwareVMXEntryPredicate predicate, void *context)
+{
+	size_t result = 0;
+	
+	for (size_t i = 0; i < vmx->entries_cnt; i++)
+	{
+		SMVMwareVMXEntry *entry = vmx->entries[i];
+		
+		if (entry->removed || !predicate(entry, context))
+			continue;
+		
+		SMVMwareVMXDetachEntry(vmx, entry);
+		result++;
+	}
+	
+	return result;
+}
+
+static void SMVMwareVMXDetachEntry(SMVMwareVMX *vmx, SMVMwareVMXEntry *entry)
+{
+	if (entry->removed)
+		return;
+	
+	// Unindex key.
+	if (entry->type == SMVMwareVMXEntryTypeKeyValue)
+	{
+		SMVMwareVMXIndexRemoveEntry(vmx, entry);
+		
+		if (vmx->tree_built)
+			SMVMwareVMXTreeRemoveEntry(vmx, entry);
+	}
+	
+	// Mark as removed: the entries array is compacted lazily, on next positional access.
+	entry->removed = true;
+	vmx->removed_cnt++;
+}
+
+static void SMVMwareVMXCompactEntries(SMVMwareVMX *vmx)
+{
+	if (vmx->removed_cnt == 0)
+		return;
+	
+	size_t cnt = 0;
+	
+	for (size_t i = 0; i < vmx->entries_cnt; i++)
+	{
+		SMVMwareVMXEntry *entry = vmx->entries[i];
+		
+		if (entry->removed)
+			continue;
+		
+		// Note: relative order is kept, so the keys index chains stay in file order.
+		entry->idx = cnt;
+		vmx->entries[cnt++] = entry;
+	}
+	
+	vmx->entries_cnt = cnt;
+	vmx->removed_cnt = 0;
+}
+
+size_t SMVMwareVMXEntriesCount(SMVMwareVMX *vmx)
+{
+	return vmx->entries_cnt - vmx->removed_cnt;
+}
+
+SMVMwareVMXEntry * SMVMwareVMXGetEntryAtIndex(SMVMwareVMX *vmx, size_t idx)
+{
+	SMVMwareVMXCompactEntries(vmx);
+	
+	assert(idx < vmx->entries_cnt);
+	
+	return vmx->entries[idx];
+}
+
+SMVMwareVMXEntry * SMVMwareVMXGetEntryForKey(SMVMwareVMX *vmx, const char *key)
+{
+	if (vmx->index_cnt == 0)
+		return NULL;
+	
+	// > Keys are case-insensitive. If the key was never interned, no entry can have it.
+	const SMInternedString *interned = SMStringInternLookup(&vmx->keys, key, strlen(key));
+	
+	if (!interned)
+		return NULL;
+	
+	return SMVMwareVMXIndexSearchSlot(vmx, interned)->head;
+}
+
+
+#pragma mark > Namespaces
+
+size_t SMVMwareVMXNamespaceEntriesCount(SMVMwareVMX *vmx, const char *name_space)
+{
+	SMVMwareVMXKeyNode *node = SMVMwareVMXTreeGetNode(vmx, name_space);
+	
+	return (node ? node->subtree_cnt : 0);
+}
+
+SMVMwareVMXEntry ** SMVMwareVMXNamespaceCopyEntries(SMVMwareVMX *vmx, const char *name_space, size_t *count)
+{
+	SMVMwareVMXKeyNode *node = SMVMwareVMXTreeGetNode(vmx, name_space);
+	
+	*count = 0;
+	
+	if (!node || node->subtree_cnt == 0)
+		return NULL;
+	
+	// Collect entries.
+	SMVMwareVMXEntry **result = malloc(node->subtree_cnt * sizeof(SMVMwareVMXEntry *));
+	
+	assert(result);
+	
+	*count = SMVMwareVMXTreeCollectEntries(node, result, 0);
+	
+	assert(*count == node->subtree_cnt);
+	
+	// Sort them in file order.
+	qsort(result, *count, sizeof(SMVMwareVMXEntry *), SMVMwareVMXEntryCompareIndex);
+	
+	return result;
+}
+
+size_t SMVMwareVMXNamespaceRemoveEntries(SMVMwareVMX *vmx, const char *name_space)
+{
+	size_t				count = 0;
+	SMVMwareVMXEntry	**entries = SMVMwareVMXNamespaceCopyEntries(vmx, name_space, &count);
+	
+	for (size_t i = 0; i < count; i++)
+		SMVMwareVMXDetachEntry(vmx, entries[i]);
+	
+	free(entries);
+	
+	return count;
+}
+
+
+#pragma mark > Index
+
+static void SMVMwareVMXIndexAddEntry(SMVMwareVMX *vmx, SMVMwareVMXEntry *entry)
+{
+	// Grow if needed.
+	if ((vmx->index_cnt + 1) * 2 > vmx->index_size)
+		SMVMwareVMXIndexResize(vmx, SMHashTableSizeForCount(vmx->index_cnt + 1));
+	
+	// Search slot.
+	size_t					key_size = 0;
+	const char				*key = SMVMwareVMXEntryGetKeyBytes(entry, &key_size);
+	const SMInternedString	*interned = SMStringIntern(&vmx->keys, key, key_size);
+	uint64_t				hash = interned->hash;
+	SMVMwareVMXIndexSlot	*slot = SMVMwareVMXIndexSearchSlot(vmx, interned);
+	
+	entry->key_interned = interned;
+	entry->key_next = NULL;
+	
+	// New key.
+	if (!slot->head)
+	{
+		slot->hash = hash;
+		slot->head = entry;
+		slot->tail = entry;
+		
+		vmx->index_cnt++;
+		
+		return;
+	}
+	
+	// Duplicated key: keep the chain in file order, so the first entry is the one returned by lookups.
+	if (slot->tail->idx < entry->idx)
+	{
+		slot->tail->key_next = entry;
+		slot->tail = entry;
+		
+		return;
+	}
+	
+	SMVMwareVMXEntry *prev = NULL;
+	SMVMwareVMXEntry *current = slot->head;
+	
+	while (current && current->idx < entry->idx)
+	{
+		prev = current;
+		current = current->key_next;
+	}
+	
+	entry->key_next = current;
+	
+	if (prev)
+		prev->key_next = entry;
+	else
+		slot->head = entry;
+}
+
+static void SMVMwareVMXIndexRemoveEntry(SMVMwareVMX *vmx, SMVMwareVMXEntry *entry)
+{
+	if (vmx->index_cnt == 0)
+		return;
+	
+	// Search slot.
+	SMVMwareVMXIndexSlot *slot = SMVMwareVMXIndexSearchSlot(vmx, entry->key_interned);
+	
+	if (!slot->head)
+		return;
+	
+	// Unlink entry from the chain.
+	SMVMwareVMXEntry *prev = NULL;
+	SMVMwareVMXEntry *current = slot->head;
+	
+	while (current && current != entry)
+	{
+		prev = current;
+		current = current->key_next;
+	}
+	
+	if (!current)
+		return;
+	
+	if (prev)
+		prev->key_next = entry->key_next;
+	else
+		slot->head = entry->key_next;
+	
+	if (slot->tail == entry)
+		slot->tail = prev;
+	
+	entry->key_next = NULL;
+	
+	if (slot->head)
+		return;
+	
+	// Chain is empty: remove the slot by shifting back following slots of the cluster.
+	size_t mask = vmx->index_size - 1;
+	size_t hole = (size_t)(slot - vmx->index);
+	
+	for (size_t i = (hole + 1) & mask; vmx->index[i].head; i = (i + 1) & mask)
+	{
+		size_t home = vmx->index[i].hash & mask;
+		
+		// > Skip slots which are placed between their home and the hole.
+		if ((hole <= i) ? (hole < home && home <= i) : (hole < home || home <= i))
+			continue;
+		
+		vmx->index[hole] = vmx->index[i];
+		hole = i;
+	}
+	
+	memset(&vmx->index[hole], 0, sizeof(SMVMwareVMXIndexSlot));
+	
+	vmx->index_cnt--;
+}
+
+static SMVMwareVMXIndexSlot * SMVMwareVMXIndexSearchSlot(SMVMwareVMX *vmx, const SMInternedString *key)
+{
+	size_t mask = vmx->index_size - 1;
+	
+	// > Keys are interned: compare hash first, then pointer.
+	for (size_t i = key->hash & mask; ; i = (i + 1) & mask)
+	{
+		SMVMwareVMXIndexSlot *slot = &vmx->index[i];
+		
+		if (!slot->head)
+			return slot;
+		
+		if (slot->hash == key->hash && slot->head->key_interned == key)
+			return slot;
+	}
+}
+
+static void SMVMwareVMXIndexResize(SMVMwareVMX *vmx, size_t size)
 {
-	return vmx->path;
+	SMVMwareVMXIndexSlot	*old_index = vmx->index;
+	size_t					old_size = vmx->index_size;
+	
+	vmx->index = calloc(size, sizeof(SMVMwareVMXIndexSlot));
+	vmx->index_size = size;
+	
+	assert(vmx->index);
+	
+	// Re-insert slots. Keys are unique, so we just need to find an empty place.
+	size_t mask = size - 1;
+	
+	for (size_t i = 0; i < old_size; i++)
+	{
+		if (!old_index[i].head)
+			continue;
+		
+		size_t j = old_index[i].hash & mask;
+		
+		while (vmx->index[j].head)
+			j = (j + 1) & mask;
+		
+		vmx->index[j] = old_index[i];
+	}
+	
+	free(old_index);
 }
 
 
-#pragma mark > Serialization
+#pragma mark > Tree
 
-bool SMVMwareVMXWriteToFile(SMVMwareVMX *vmx, const char *path, SMError **error)
+static void SMVMwareVMXTreeBuild(SMVMwareVMX *vmx)
 {
-	// Open file.
-	int fd = open(path, O_WRONLY | O_CREAT | O_EXCL, 0644);
+	if (vmx->tree_built)
+		return;
 	
-	if (fd == -1)
+	vmx->tree_built = true;
+	
+	for (size_t i = 0; i < vmx->entries_cnt; i++)
 	{
-		SMSetErrorPtr(error, SMVMwareVMXErrorDomain, errno, "can't create the file (%d - %s)", errno, strerror(errno));
-		goto fail;
+		SMVMwareVMXEntry *entry = vmx->entries[i];
+		
+		if (entry->type == SMVMwareVMXEntryTypeKeyValue && !entry->removed)
+			SMVMwareVMXTreeAddEntry(vmx, entry);
 	}
+}
+
+static void SMVMwareVMXTreeAddEntry(SMVMwareVMX *vmx, SMVMwareVMXEntry *entry)
+{
+	// > Use the interned key: it's lowercase, so components are case-insensitive, and it's never freed.
+	const char	*key = entry->key_interned->string;
+	const char	*key_end = key + entry->key_interned->size;
 	
-	// Write entries.
-	size_t entries_count = SMVMwareVMXEntriesCount(vmx);
+	// Walk (and create) nodes for each dotted component.
+	SMVMwareVMXKeyNode *node = &vmx->tree_root;
 	
-	for (size_t i = 0; i < entries_count; i++)
+	while (true)
 	{
-		SMVMwareVMXEntry	*entry = SMVMwareVMXGetEntryAtIndex(vmx, i);
-		const char			*line = SMVMwareVMXEntryGetSerializedLine(entry);
+		const char *dot = memchr(key, '.', (size_t)(key_end - key));
+		const char *component_end = (dot ? dot : key_end);
 		
-		// Write line.
-		if (!SMFileWriteBytes(fd, line, strlen(line), error))
-			goto fail;
+		node = SMVMwareVMXTreeGetChild(vmx, node, key, (size_t)(component_end - key), true);
 		
-		// Write new line.
-		static uint8_t new_line[] = { '\n' };
-			
-		if (!SMFileWriteBytes(fd, new_line, sizeof(new_line), error))
-			goto fail;
+		if (!dot)
+			break;
+		
+		key = dot + 1;
 	}
 	
-	return true;
+	// Link entry to its node.
+	entry->key_node = node;
+	entry->node_prev = NULL;
+	entry->node_next = node->entries;
 	
-fail:
-	if (fd >= 0)
-		close(fd);
+	if (node->entries)
+		node->entries->node_prev = entry;
 	
-	unlink(path);
+	node->entries = entry;
 	
-	return false;
+	// Update counters.
+	for (; node; node = node->parent)
+		node->subtree_cnt++;
 }
 
-
-#pragma mark > Entries
-
-SMVMwareVMXEntry *	SMVMwareVMXAddEntryKeyValue(SMVMwareVMX *vmx, const char *key, const char *value, SMError **error)
+static void SMVMwareVMXTreeRemoveEntry(SMVMwareVMX *vmx, SMVMwareVMXEntry *entry)
 {
-	// Create instance.
-	SMVMwareVMXEntry *entry = SMVMwareVMXEntryCreateKeyValue(key, value, error);
+	SMVMwareVMXKeyNode *node = entry->key_node;
 	
-	if (!entry)
-		return NULL;
+	if (!node)
+		return;
 	
-	// Add to entries.
-	SMVMwareVMXAddEntry(vmx, entry);
-	SMVMwareVMXEntryMarkUpdated(entry);
+	// Unlink entry from its node. Empty nodes are kept, they will be reused if the key comes back.
+	if (entry->node_prev)
+		entry->node_prev->node_next = entry->node_next;
+	else
+		node->entries = entry->node_next;
 	
-	// Return added entry.
-	return entry;
+	if (entry->node_next)
+		entry->node_next->node_prev = entry->node_prev;
+	
+	entry->key_node = NULL;
+	entry->node_prev = NULL;
+	entry->node_next = NULL;
+	
+	// Update counters.
+	for (; node; node = node->parent)
+		node->subtree_cnt--;
 }
 
-static void SMVMwareVMXAddEntry(SMVMwareVMX *vmx, SMVMwareVMXEntry *entry)
+static SMVMwareVMXKeyNode * SMVMwareVMXTreeGetNode(SMVMwareVMX *vmx, const char *name_space)
 {
-	vmx->entries = reallocf(vmx->entries, (vmx->entries_cnt + 1) * sizeof(*vmx->entries));
+	SMVMwareVMXTreeBuild(vmx);
 	
-	assert(vmx->entries);
+	// Walk nodes for each dotted component.
+	SMVMwareVMXKeyNode *node = &vmx->tree_root;
 	
-	vmx->entries[vmx->entries_cnt] = entry;
-	vmx->entries_cnt++;
+	if (*name_space == 0)
+		return node;
+	
+	while (node)
+	{
+		const char *dot = strchr(name_space, '.');
+		size_t		component_size = (dot ? (size_t)(dot - name_space) : strlen(name_space));
+		
+		node = SMVMwareVMXTreeGetChild(vmx, node, name_space, component_size, false);
+		
+		if (!dot)
+			break;
+		
+		name_space = dot + 1;
+	}
+	
+	return node;
 }
 
-size_t SMVMwareVMXEntriesCount(SMVMwareVMX *vmx)
+static SMVMwareVMXKeyNode * SMVMwareVMXTreeGetChild(SMVMwareVMX *vmx, SMVMwareVMXKeyNode *parent, const char *component, size_t component_size, bool create)
 {
-	return vmx->entries_cnt;
+	// Search node.
+	uint64_t component_hash = SMStringInternHash(component, component_size);
+	uint64_t hash = SMHashBytesAppend(SMHashBytes(&parent, sizeof(parent)), &component_hash, sizeof(component_hash));
+	
+	if (vmx->tree_nodes_size)
+	{
+		size_t mask = vmx->tree_nodes_size - 1;
+		
+		for (size_t i = hash & mask; vmx->tree_nodes[i]; i = (i + 1) & mask)
+		{
+			SMVMwareVMXKeyNode *node = vmx->tree_nodes[i];
+			
+			if (node->hash == hash && node->parent == parent && node->component_size == component_size && strncasecmp(node->component, component, component_size) == 0)
+				return node;
+		}
+	}
+	
+	if (!create)
+		return NULL;
+	
+	// Create node.
+	SMVMwareVMXKeyNode *node = SMArenaCalloc(&vmx->arena, sizeof(SMVMwareVMXKeyNode));
+	
+	node->parent = parent;
+	node->component = component;
+	node->component_size = component_size;
+	node->hash = hash;
+	
+	if (parent->children_tail)
+		parent->children_tail->next_sibling = node;
+	else
+		parent->children_head = node;
+	
+	parent->children_tail = node;
+	
+	// Add it to nodes table (nodes are never removed).
+	if ((vmx->tree_nodes_cnt + 1) * 2 > vmx->tree_nodes_size)
+		SMVMwareVMXTreeResize(vmx, SMHashTableSizeForCount(vmx->tree_nodes_cnt + 1));
+	
+	size_t mask = vmx->tree_nodes_size - 1;
+	size_t i = hash & mask;
+	
+	while (vmx->tree_nodes[i])
+		i = (i + 1) & mask;
+	
+	vmx->tree_nodes[i] = node;
+	vmx->tree_nodes_cnt++;
+	
+	return node;
 }
 
-SMVMwareVMXEntry * SMVMwareVMXGetEntryAtIndex(SMVMwareVMX *vmx, size_t idx)
+static size_t SMVMwareVMXTreeCollectEntries(SMVMwareVMXKeyNode *node, SMVMwareVMXEntry **entries, size_t entries_cnt)
 {
-	assert(idx < vmx->entries_cnt);
+	// Entries of this node.
+	for (SMVMwareVMXEntry *entry = node->entries; entry; entry = entry->node_next)
+		entries[entries_cnt++] = entry;
 	
-	return vmx->entries[idx];
+	// Entries of children, skipping emptied subtrees.
+	for (SMVMwareVMXKeyNode *child = node->children_head; child; child = child->next_sibling)
+	{
+		if (child->subtree_cnt)
+			entries_cnt = SMVMwareVMXTreeCollectEntries(child, entries, entries_cnt);
+	}
+	
+	return entries_cnt;
 }
 
-SMVMwareVMXEntry * SMVMwareVMXGetEntryForKey(SMVMwareVMX *vmx, const char *key)
+static void SMVMwareVMXTreeResize(SMVMwareVMX *vmx, size_t size)
 {
-	// XXX Implement an hash table to speed up queries. Don't forget to update it from children if a key is changed, in this case.
+	SMVMwareVMXKeyNode	**old_nodes = vmx->tree_nodes;
+	size_t				old_size = vmx->tree_nodes_size;
 	
-	size_t entries_count = SMVMwareVMXEntriesCount(vmx);
+	vmx->tree_nodes = calloc(size, sizeof(SMVMwareVMXKeyNode *));
+	vmx->tree_nodes_size = size;
 	
-	for (size_t i = 0; i < entries_count; i++)
+	assert(vmx->tree_nodes);
+	
+	size_t mask = size - 1;
+	
+	for (size_t i = 0; i < old_size; i++)
 	{
-		SMVMwareVMXEntry		*entry = SMVMwareVMXGetEntryAtIndex(vmx, i);
-		SMVMwareVMXEntryType	entry_type = SMVMwareVMXEntryGetType(entry);
-		
-		if (entry_type != SMVMwareVMXEntryTypeKeyValue)
+		if (!old_nodes[i])
 			continue;
 		
-		const char *ekey = SMVMwareVMXEntryGetKey(entry, NULL);
+		size_t j = old_nodes[i]->hash & mask;
 		
-		if (!ekey)
-			continue;
+		while (vmx->tree_nodes[j])
+			j = (j + 1) & mask;
 		
-		if (strcmp(ekey, key) == 0)
-			return entry;
+		vmx->tree_nodes[j] = old_nodes[i];
 	}
 	
-	return NULL;
+	free(old_nodes);
 }
 
 
@@ -332,39 +1243,34 @@ SMVMwareVMXEntry * SMVMwareVMXGetEntryForKey(SMVMwareVMX *vmx, const char *key)
 
 #pragma mark > Instance
 
-static SMVMwareVMXEntry * SMVMwareVMXEntryCreateKeyValue(const char *key, const char *value, SMError **error)
+static SMVMwareVMXEntry * SMVMwareVMXEntryCreateKeyValue(SMVMwareVMX *vmx, const char *key, const char *value)
 {
-	SMVMwareVMXEntry *result = calloc(1, sizeof(SMVMwareVMXEntry));
-	
-	assert(result);
+	SMVMwareVMXEntry *result = SMArenaCalloc(&vmx->arena, sizeof(SMVMwareVMXEntry));
 
 	result->type = SMVMwareVMXEntryTypeKeyValue;
 	
-	if (!SMVMwareVMXEntrySetKey(result, key, error))
-		goto fail;
+	result->updated_key_size = strlen(key);
+	result->updated_key = SMArenaStringDuplicate(&vmx->arena, key, result->updated_key_size);
 	
-	if (!SMVMwareVMXEntrySetValue(result, value, error))
-		goto fail;
+	result->updated_value = SMArenaStringDuplicate(&vmx->arena, value, strlen(value));
 	
 	return result;
-	
-fail:
-	SMVMwareVMXEntryFree(result);
-	return NULL;
 }
 
-static SMVMwareVMXEntry * SMVMwareVMXEntryCreateFromLine(const char *line, size_t line_idx, SMError **error)
+static SMVMwareVMXEntry * SMVMwareVMXEntryCreateFromLine(SMVMwareVMX *vmx, const char *line, size_t line_size, const uint32_t *structurals, size_t structurals_cnt, size_t line_idx, SMError **error)
 {
-	SMVMwareVMXEntry *result = calloc(1, sizeof(SMVMwareVMXEntry));
-	
-	assert(result);
+	// Note: structurals are the offsets in the mapping of the '=', '"' and '\\' characters of the line.
+	// Note: on failure, the entry is simply abandoned in the arena.
+	SMVMwareVMXEntry *result = SMArenaCalloc(&vmx->arena, sizeof(SMVMwareVMXEntry));
 	
-	// Copy original line.
-	result->original_line = strdup(line);
-	assert(result->original_line);
+	// Reference original line.
+	result->original_line = line;
+	result->original_line_size = line_size;
 	
 	// Parse line.
-	if (*line == 0)
+	const char *line_end = line + line_size;
+	
+	if (line == line_end)
 	{
 		result->type = SMVMwareVMXEntryTypeEmpty;
 	}
@@ -374,55 +1280,62 @@ static SMVMwareVMXEntry * SMVMwareVMXEntryCreateFromLine(const char *line, size_
 
 		line++;
 		
-		result->original_comment = SMStringTrimCharacter((char *)line, gBlanckCharacters, sizeof(gBlanckCharacters), false);
+		while (line < line_end && SMIsBlank(*line))
+			line++;
+		
+		result->original_comment = line;
+		result->original_comment_size = (size_t)(line_end - line);
 	}
 	else
 	{
 		result->type = SMVMwareVMXEntryTypeKeyValue;
 		
 		// Extract key.
-		SMBytesWritter key_writter = SMBytesWritterInit();
+		const char	*key = line;
+		const char	*key_end = line_end;
+		size_t		sidx = 0;
 		
-		// > Extract until we find a character which can terminate a key.
-		while (*line && !isblank(*line) && *line != '=')
+		// > Search the first separator.
+		for (; sidx < structurals_cnt; sidx++)
 		{
-			SMBytesWritterAppendByte(&key_writter, *line);
-			line++;
+			if (vmx->bytes[structurals[sidx]] == '=')
+			{
+				key_end = vmx->bytes + structurals[sidx];
+				break;
+			}
 		}
 		
+		// > Search a blank character which can terminate the key before the separator.
+		while (line < key_end && !SMIsBlank(*line))
+			line++;
+		
 		// > Check we are not end-of-line.
-		if (*line == 0)
+		if (line == line_end)
 		{
-			SMBytesWritterFree(&key_writter);
 			SMSetErrorPtr(error, SMVMwareVMXErrorDomain, -1, "unexpected end-of-line when parsing key at line %lu", line_idx + 1);
-			
 			goto fail;
 		}
 		
-		// > Add terminal 0.
-		SMBytesWritterAppendByte(&key_writter, 0);
+		result->original_key = key;
+		result->original_key_size = (size_t)(line - key);
 		
 		
 		// Search key-value separator.
 		// > Skip potential white characters between end of key, and key-value separator.
-		while (*line && isblank(*line))
+		while (line < line_end && SMIsBlank(*line))
 			line++;
 		
 		// > Check we are not end-of-line.
-		if (*line == 0)
+		if (line == line_end)
 		{
-			SMBytesWritterFree(&key_writter);
 			SMSetErrorPtr(error, SMVMwareVMXErrorDomain, -1, "unexpected end-of-line when searching key-value separator at line %lu", line_idx + 1);
-			
 			goto fail;
 		}
 		
 		// > Check we are stopped at key-value separator.
 		if (*line != '=')
 		{
-			SMBytesWritterFree(&key_writter);
 			SMSetErrorPtr(error, SMVMwareVMXErrorDomain, -1, "unexpected character '%c' when searching key-value separator at line %lu", *line, line_idx + 1);
-			
 			goto fail;
 		}
 		
@@ -432,137 +1345,129 @@ static SMVMwareVMXEntry * SMVMwareVMXEntryCreateFromLine(const char *line, size_
 		
 		// Search value.
 		// > Skip potential white characters between key-value separator and value.
-		while (*line && isblank(*line))
+		while (line < line_end && SMIsBlank(*line))
 			line++;
 		
 		// > Check we are not end-of-line.
-		if (*line == 0)
+		if (line == line_end)
 		{
-			SMBytesWritterFree(&key_writter);
 			SMSetErrorPtr(error, SMVMwareVMXErrorDomain, -1, "unexpected end-of-line when searching value at line %lu", line_idx + 1);
-			
 			goto fail;
 		}
 		
 		// > Check we have value delimiter.
 		if (*line != '"')
 		{
-			SMBytesWritterFree(&key_writter);
 			SMSetErrorPtr(error, SMVMwareVMXErrorDomain, -1, "unexpected character '%c' when searching value at line %lu", *line, line_idx + 1);
-			
 			goto fail;
 		}
 		
 		// > Skip value delimiter.
 		line++;
 		
+		// > Lazy mode: the value will be delimited on first access.
+		if (vmx->options & SMVMwareVMXOpenOptionLazyValues)
+		{
+			result->original_value = line;
+			result->original_value_size = (size_t)(line_end - line);
+			result->original_value_pending = true;
+			
+			return result;
+		}
+		
 		
 		// Extract value.
-		SMBytesWritter value_writter = SMBytesWritterInit();
+		const char	*value = line;
+		const char	*value_end = NULL;
+		size_t		value_offset = (size_t)(value - vmx->bytes);
 		
-		bool last_escaped = false;
-		bool value_extracting = true;
+		// > Skip structurals before value.
+		while (sidx < structurals_cnt && structurals[sidx] < value_offset)
+			sidx++;
 		
-		for (; *line && value_extracting; line++)
+		// > Search closing delimiter, jumping over escaped characters.
+		for (; sidx < structurals_cnt && !value_end; sidx++)
 		{
-			if (last_escaped)
-			{
-				SMBytesWritterAppendByte(&value_writter, *line);
-				last_escaped = false;
-			}
-			else
+			const char *structural = vmx->bytes + structurals[sidx];
+			
+			if (*structural == '\\')
 			{
-				if (*line == '\\')
-					last_escaped = true;
-				else if (*line == '"')
-					value_extracting = false;
-				else
-					SMBytesWritterAppendByte(&value_writter, *line);
+				result->original_value_escaped = true;
+				
+				if (sidx + 1 < structurals_cnt && structurals[sidx + 1] == structurals[sidx] + 1)
+					sidx++;
 			}
+			else if (*structural == '"')
+				value_end = structural;
 		}
 		
-		if (*line == 0 && value_extracting)
+		if (!value_end)
 		{
 			SMSetErrorPtr(error, SMVMwareVMXErrorDomain, -1, "unexpected end-of-line when parsing value at line %lu", line_idx + 1);
-			
-			SMBytesWritterFree(&key_writter);
-			SMBytesWritterFree(&value_writter);
-			
 			goto fail;
 		}
 		
-		SMBytesWritterAppendByte(&value_writter, 0);
 		
-		
-		// Store result.
-		result->original_key = SMBytesWritterPtr(&key_writter);
-		result->original_value = SMBytesWritterPtr(&value_writter);
+		// Store result (without the closing delimiter).
+		result->original_value = value;
+		result->original_value_size = (size_t)(value_end - value);
 	}
 	
 	return result;
 	
 fail:
-	SMVMwareVMXEntryFree(result);
 	return NULL;
 }
 
-static void SMVMwareVMXEntryFree(SMVMwareVMXEntry *entry)
-{
-	if (!entry)
-		return;
-	
-	free(entry->original_line);
-	free(entry->original_key);
-	free(entry->original_value);
-	free(entry->original_comment);
-	
-	free(entry->serialized_line);
-	
-	free(entry->updated_key);
-	free(entry->updated_value);
-	free(entry->updated_comment);
-
-	free(entry);
-}
-
 
 #pragma mark > Serialization
 
-static const char *	SMVMwareVMXEntryGetSerializedLine(SMVMwareVMXEntry *entry)
+static const char *	SMVMwareVMXEntryGetSerializedLine(SMVMwareVMXEntry *entry, size_t *size, SMError **error)
 {
 	// Return cached serialized bytes.
 	if (entry->serialized_line)
+	{
+		*size = entry->serialized_line_size;
 		return entry->serialized_line;
+	}
 	
 	// Return original line if the entry wasn't updated.
 	if (!entry->updated)
+	{
+		*size = entry->original_line_size;
 		return entry->original_line;
+	}
 	
 	// Serialize line.
-	char *line = NULL;
+	SMArena	*arena = &entry->vmx->arena;
+	char	*line = NULL;
+	int		line_size = -1;
 	
 	switch (SMVMwareVMXEntryGetType(entry))
 	{
 		case SMVMwareVMXEntryTypeEmpty:
 		{
-			line = strdup("");
+			line_size = SMArenaStringPrintf(arena, &line, "%s", "");
 			break;
 		}
 			
 		case SMVMwareVMXEntryTypeComment:
 		{
-			asprintf(&line, "# %s", SMVMwareVMXEntryGetComment(entry, NULL));
+			line_size = SMArenaStringPrintf(arena, &line, "# %s", SMVMwareVMXEntryGetComment(entry, NULL));
 			break;
 		}
 			
 		case SMVMwareVMXEntryTypeKeyValue:
 		{
 			const char *key = SMVMwareVMXEntryGetKey(entry, NULL);
-			const char *value = SMVMwareVMXEntryGetValue(entry, NULL);
+			const char *value = SMVMwareVMXEntryGetValue(entry, error);
+			
+			if (!value)
+				return NULL;
 			
 			char *fixed_value = SMStringReplaceString((char *)value, "\"", "\\\"", false);
 			
-			asprintf(&line, "%s = \"%s\"", key, fixed_value);
+			line_size = SMArenaStringPrintf(arena, &line, "%s = \"%s\"", key, fixed_value);
 			
 			free(fixed_value);
 
@@ -570,9 +1475,12 @@ static const char *	SMVMwareVMXEntryGetSerializedLine(SMVMwareVMXEntry *entry)
 		}
 	}
 	
-	assert(line);
+	assert(line && line_size >= 0);
 	
 	entry->serialized_line = line;
+	entry->serialized_line_size = (size_t)line_size;
+	
+	*size = (size_t)line_size;
 	
 	return line;
 }
@@ -582,12 +1490,8 @@ static void SMVMwareVMXEntryMarkUpdated(SMVMwareVMXEntry *entry)
 	// Flag as updated.
 	entry->updated = true;
 	
-	// Free serialized bytes.
-	if (entry->serialized_line)
-	{
-		free(entry->serialized_line);
-		entry->serialized_line = NULL;
-	}
+	// Drop serialized bytes (abandoned in the arena).
+	entry->serialized_line = NULL;
 }
 
 
@@ -613,8 +1517,11 @@ const char * SMVMwareVMXEntryGetComment(SMVMwareVMXEntry *entry, SMError **error
 	// Return comment.
 	if (entry->updated_comment)
 		return entry->updated_comment;
-	else
-		return entry->original_comment;
+	
+	if (!entry->original_comment_str)
+		entry->original_comment_str = SMArenaStringDuplicate(&entry->vmx->arena, entry->original_comment, entry->original_comment_size);
+	
+	return entry->original_comment_str;
 }
 
 bool SMVMwareVMXEntrySetComment(SMVMwareVMXEntry *entry, const char *comment, SMError **error)
@@ -627,10 +1534,7 @@ bool SMVMwareVMXEntrySetComment(SMVMwareVMXEntry *entry, const char *comment, SM
 	}
 	
 	// Update comment.
-	free(entry->updated_comment);
-	entry->updated_comment = strdup(comment);
-	
-	assert(entry->updated_comment);
+	entry->updated_comment = SMArenaStringDuplicate(&entry->vmx->arena, comment, strlen(comment));
 	
 	// Mark as updated.
 	SMVMwareVMXEntryMarkUpdated(entry);
@@ -653,8 +1557,11 @@ const char * SMVMwareVMXEntryGetKey(SMVMwareVMXEntry *entry, SMError **error)
 	// Return key.
 	if (entry->updated_key)
 		return entry->updated_key;
-	else
-		return entry->original_key;
+	
+	if (!entry->original_key_str)
+		entry->original_key_str = SMArenaStringDuplicate(&entry->vmx->arena, entry->original_key, entry->original_key_size);
+	
+	return entry->original_key_str;
 }
 
 bool SMVMwareVMXEntrySetKey(SMVMwareVMXEntry *entry, const char *key, SMError **error)
@@ -668,11 +1575,31 @@ bool SMVMwareVMXEntrySetKey(SMVMwareVMXEntry *entry, const char *key, SMError **
 		return false;
 	}
 	
+	SMVMwareVMX *vmx = entry->vmx;
+	
+	// Unindex previous key.
+	bool indexed = !entry->removed;
+	
+	if (indexed)
+	{
+		SMVMwareVMXIndexRemoveEntry(vmx, entry);
+		
+		if (vmx->tree_built)
+			SMVMwareVMXTreeRemoveEntry(vmx, entry);
+	}
+	
 	// Update key.
-	free(entry->updated_key);
-	entry->updated_key = strdup(key);
+	entry->updated_key_size = strlen(key);
+	entry->updated_key = SMArenaStringDuplicate(&vmx->arena, key, entry->updated_key_size);
 	
-	assert(entry->updated_key);
+	// Index new key.
+	if (indexed)
+	{
+		SMVMwareVMXIndexAddEntry(vmx, entry);
+		
+		if (vmx->tree_built)
+			SMVMwareVMXTreeAddEntry(vmx, entry);
+	}
 	
 	// Mark as updated.
 	SMVMwareVMXEntryMarkUpdated(entry);
@@ -681,6 +1608,48 @@ bool SMVMwareVMXEntrySetKey(SMVMwareVMXEntry *entry, const char *key, SMError **
 }
 
 
+static const char * SMVMwareVMXEntryGetKeyBytes(SMVMwareVMXEntry *entry, size_t *size)
+{
+	// Give access to key without materializing the original one.
+	if (entry->updated_key)
+	{
+		*size = entry->updated_key_size;
+		return entry->updated_key;
+	}
+	
+	*size = entry->original_key_size;
+	
+	return entry->original_key;
+}
+
+
+static bool SMVMwareVMXEntryDelimitValue(SMVMwareVMXEntry *entry, SMError **error)
+{
+	// Search closing delimiter, jumping over escaped characters.
+	const char	*value = entry->original_value;
+	size_t		value_size = entry->original_value_size;
+	
+	for (size_t i = 0; i < value_size; i++)
+	{
+		if (value[i] == '\\')
+		{
+			entry->original_value_escaped = true;
+			i++;
+		}
+		else if (value[i] == '"')
+		{
+			entry->original_value_size = i;
+			entry->original_value_pending = false;
+			
+			return true;
+		}
+	}
+	
+	SMSetErrorPtr(error, SMVMwareVMXErrorDomain, -1, "unexpected end-of-line when parsing value");
+	
+	return false;
+}
+
 const char * SMVMwareVMXEntryGetValue(SMVMwareVMXEntry *entry, SMError **error)
 {
 	// Check type.
@@ -693,8 +1662,19 @@ const char * SMVMwareVMXEntryGetValue(SMVMwareVMXEntry *entry, SMError **error)
 	// Return value.
 	if (entry->updated_value)
 		return entry->updated_value;
-	else
-		return entry->original_value;
+	
+	if (entry->original_value_pending && !SMVMwareVMXEntryDelimitValue(entry, error))
+		return NULL;
+	
+	if (!entry->original_value_str)
+	{
+		if (entry->original_value_escaped)
+			entry->original_value_str = SMStringUnescapeValue(&entry->vmx->arena, entry->original_value, entry->original_value_size);
+		else
+			entry->original_value_str = SMArenaStringDuplicate(&entry->vmx->arena, entry->original_value, entry->original_value_size);
+	}
+	
+	return entry->original_value_str;
 }
 
 bool SMVMwareVMXEntrySetValue(SMVMwareVMXEntry *entry, const char *value, SMError **error)
@@ -707,10 +1687,7 @@ bool SMVMwareVMXEntrySetValue(SMVMwareVMXEntry *entry, const char *value, SMErro
 	}
 	
 	// Update value.
-	free(entry->updated_value);
-	entry->updated_value = strdup(value);
-	
-	assert(entry->updated_value);
+	entry->updated_value = SMArenaStringDuplicate(&entry->vmx->arena, value, strlen(value));
 	
 	// Mark as updated.
 	SMVMwareVMXEntryMarkUpdated(entry);
@@ -719,6 +1696,22 @@ bool SMVMwareVMXEntrySetValue(SMVMwareVMXEntry *entry, const char *value, SMErro
 }
 
 
+#pragma mark > Sort
+
+static int SMVMwareVMXEntryCompareIndex(const void *a, const void *b)
+{
+	const SMVMwareVMXEntry *entry_a = *(SMVMwareVMXEntry * const *)a;
+	const SMVMwareVMXEntry *entry_b = *(SMVMwareVMXEntry * const *)b;
+	
+	if (entry_a->idx < entry_b->idx)
+		return -1;
+	else if (entry_a->idx > entry_b->idx)
+		return 1;
+	
+	return 0;
+}
+
+
 /*
 ** Helpers
 */
@@ -726,16 +1719,105 @@ bool SMVMwareVMXEntrySetValue(SMVMwareVMXEntry *entry, const char *value, SMErro
 
 #pragma mark File
 
-static bool SMFileWriteBytes(int fd, const void *bytes, size_t len, SMError **error)
+static int SMFileCopyRange(int src_fd, off_t src_offset, int dst_fd, off_t dst_offset, size_t size, SMError **error)
 {
-	if (write(fd, bytes, len) != len)
+	// Note: returns 1 on success, 0 if not supported (nothing was copied), and -1 on error.
+	// Note: the destination file offset is expected at dst_offset, and is moved after the copied range.
+#if defined(__linux__)
+	// Try to clone blocks (reflink): needs block-aligned ranges, except for a range ending at end of source.
+	struct stat st;
+	
+	if (fstat(src_fd, &st) == 0 && st.st_blksize > 0)
+	{
+		off_t blksize = st.st_blksize;
+		bool aligned = (src_offset % blksize == 0 && dst_offset % blksize == 0);
+		bool aligned_end = ((off_t)size % blksize == 0 || src_offset + (off_t)size == st.st_size);
+		
+		if (aligned && aligned_end)
+		{
+			struct file_clone_range range = {
+				.src_fd = src_fd,
+				.src_offset = (uint64_t)src_offset,
+				.src_length = (uint64_t)size,
+				.dest_offset = (uint64_t)dst_offset,
+			};
+			
+			if (ioctl(dst_fd, FICLONERANGE, &range) == 0)
+			{
+				if (lseek(dst_fd, dst_offset + (off_t)size, SEEK_SET) == -1)
+				{
+					SMSetErrorPtr(error, SMVMwareVMXErrorDomain, errno, "can't seek file (%d - %s)", errno, strerror(errno));
+					return -1;
+				}
+				
+				return 1;
+			}
+		}
+	}
+	
+	// Copy range kernel-side.
+	size_t copied = 0;
+	
+	while (copied < size)
 	{
-		int err_bck = errno;
+		ssize_t result = copy_file_range(src_fd, &src_offset, dst_fd, NULL, size - copied, 0);
+		
+		if (result < 0)
+		{
+			int err_bck = errno;
+			
+			if (err_bck == EINTR)
+				continue;
+			
+			if (copied == 0 && (err_bck == ENOSYS || err_bck == EXDEV || err_bck == EINVAL || err_bck == EOPNOTSUPP))
+				return 0;
+			
+			SMSetErrorPtr(error, SMVMwareVMXErrorDomain, err_bck, "can't copy bytes (%d - %s)", err_bck, strerror(err_bck));
+			return -1;
+		}
 		
-		SMSetErrorPtr(error, SMVMwareVMXErrorDomain, errno, "can't write bytes (%d - %s)", err_bck, strerror(err_bck));
+		if (result == 0)
+		{
+			SMSetErrorPtr(error, SMVMwareVMXErrorDomain, -1, "can't copy bytes (unexpected end-of-file)");
+			return -1;
+		}
 		
-		return false;
+		copied += (size_t)result;
 	}
 	
-	return true;
+	return 1;
+#else
+	return 0;
+#endif
+}
+
+
+#pragma mark Strings
+
+static bool SMIsBlank(char c)
+{
+	return (c == ' ' || c == '\t');
+}
+
+static char * SMStringUnescapeValue(SMArena *arena, const char *value, size_t size)
+{
+	char	*result = SMArenaAlloc(arena, size + 1);
+	size_t	result_size = 0;
+	bool	last_escaped = false;
+	
+	for (size_t i = 0; i < size; i++)
+	{
+		if (!last_escaped && value[i] == '\\')
+		{
+			last_escaped = true;
+			continue;
+		}
+		
+		result[result_size++] = value[i];
+		last_escaped = false;
+	}
+	
+	result[result_size] = 0;
+	
+	return result;
 }
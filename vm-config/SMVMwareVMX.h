@@ -43,6 +43,14 @@ typedef enum
 	SMVMwareVMXEntryTypeKeyValue,
 } SMVMwareVMXEntryType;
 
+typedef enum
+{
+	SMVMwareVMXOpenOptionNone		= 0,
+	SMVMwareVMXOpenOptionLazyValues	= (1 << 0), // Only delimit keys at open: values are delimited and decoded on first read, and malformed values are reported there.
+} SMVMwareVMXOpenOptions;
+
+typedef bool (*SMVMwareVMXEntryPredicate)(SMVMwareVMXEntry *entry, void *context);
+
 
 /*
 ** Globals
@@ -60,6 +68,7 @@ extern const char * SMVMwareVMXErrorDomain;
 // VMX.
 // > Instance.
 SMVMwareVMX *	SMVMwareVMXOpen(const char *vmx_file_path, SMError **error);
+SMVMwareVMX *	SMVMwareVMXOpenWithOptions(const char *vmx_file_path, SMVMwareVMXOpenOptions options, SMError **error);
 void			SMVMwareVMXFree(SMVMwareVMX *vmx);
 
 // > Properties.
@@ -71,11 +80,21 @@ bool SMVMwareVMXWriteToFile(SMVMwareVMX *vmx, const char *path, SMError **error)
 // > Entries.
 SMVMwareVMXEntry *	SMVMwareVMXAddEntryKeyValue(SMVMwareVMX *vmx, const char *key, const char *value, SMError **error);
 
+void	SMVMwareVMXRemoveEntry(SMVMwareVMX *vmx, SMVMwareVMXEntry *entry); // Removed entries stay valid (but detached) until the VMX is freed.
+size_t	SMVMwareVMXRemoveEntriesMatching(SMVMwareVMX *vmx, SMVMwareVMXEntryPredicate predicate, void *context);
+
 size_t				SMVMwareVMXEntriesCount(SMVMwareVMX *vmx);
 SMVMwareVMXEntry *	SMVMwareVMXGetEntryAtIndex(SMVMwareVMX *vmx, size_t idx);
 
 SMVMwareVMXEntry *	SMVMwareVMXGetEntryForKey(SMVMwareVMX *vmx, const char *key);
 
+// > Namespaces.
+// > A namespace is a dotted key prefix ("ethernet0", "guestinfo.a"), matching the key itself and all keys below it ("ethernet0.present").
+// > The empty namespace matches all key-value entries.
+size_t				SMVMwareVMXNamespaceEntriesCount(SMVMwareVMX *vmx, const char *name_space);
+SMVMwareVMXEntry **	SMVMwareVMXNamespaceCopyEntries(SMVMwareVMX *vmx, const char *name_space, size_t *count); // In file order, free the returned array with free().
+size_t				SMVMwareVMXNamespaceRemoveEntries(SMVMwareVMX *vmx, const char *name_space);
+
 
 // Entry.
 // > Type.
@@ -0,0 +1,381 @@
+/*
+ *  SMVMwareVMXScanner.c
+ *
+ *  Copyright 2022 Avérous Julien-Pierre
+ *
+ *  This file is part of vm-config.
+ *
+ *  vm-config is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vm-config is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vm-config.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#  include <immintrin.h>
+#  define SM_SCANNER_X86 1
+#elif defined(__aarch64__)
+#  include <arm_neon.h>
+#  define SM_SCANNER_NEON 1
+#endif
+
+#include "SMVMwareVMXScanner.h"
+
+
+/*
+** Defines
+*/
+#pragma mark - Defines
+
+#define SMScannerBlockSize	64
+
+
+/*
+** Types
+*/
+#pragma mark - Types
+
+typedef uint64_t (*SMScannerBlockMask)(const uint8_t *block);
+
+typedef struct
+{
+	uint32_t	*positions;
+	size_t		count;
+	size_t		capacity;
+} SMScannerPositions;
+
+
+/*
+** Globals
+*/
+#pragma mark - Globals
+
+static SMVMwareVMXScannerISA	g_best_isa;
+static pthread_once_t			g_best_isa_once = PTHREAD_ONCE_INIT;
+
+
+/*
+** Prototypes
+*/
+#pragma mark - Prototypes
+
+// Scan.
+static uint32_t *	SMScannerScanScalar(const uint8_t *bytes, size_t size, size_t *count);
+static uint32_t *	SMScannerScanBlocks(SMScannerBlockMask block_mask, const uint8_t *bytes, size_t size, size_t *count);
+
+// Blocks.
+#if SM_SCANNER_X86
+static uint64_t	SMScannerBlockMaskSSE2(const uint8_t *block);
+static uint64_t	SMScannerBlockMaskAVX2(const uint8_t *block);
+#endif
+
+#if SM_SCANNER_NEON
+static uint64_t	SMScannerBlockMaskNEON(const uint8_t *block);
+#endif
+
+// ISA.
+static void SMScannerSelectBestISA(void);
+
+// Positions.
+static void SMScannerPositionsReserve(SMScannerPositions *positions, size_t count);
+
+
+
+/*
+** Functions
+*/
+#pragma mark - Functions
+
+#pragma mark Scan
+
+uint32_t * SMVMwareVMXScannerScan(const void *bytes, size_t size, size_t *count)
+{
+	return SMVMwareVMXScannerScanWithISA(SMVMwareVMXScannerGetBestISA(), bytes, size, count);
+}
+
+uint32_t * SMVMwareVMXScannerScanWithISA(SMVMwareVMXScannerISA isa, const void *bytes, size_t size, size_t *count)
+{
+	assert(size <= UINT32_MAX);
+	assert(SMVMwareVMXScannerISAIsAvailable(isa));
+
+	switch (isa)
+	{
+		case SMVMwareVMXScannerISAScalar:
+			return SMScannerScanScalar(bytes, size, count);
+
+#if SM_SCANNER_X86
+		case SMVMwareVMXScannerISASSE2:
+			return SMScannerScanBlocks(SMScannerBlockMaskSSE2, bytes, size, count);
+
+		case SMVMwareVMXScannerISAAVX2:
+			return SMScannerScanBlocks(SMScannerBlockMaskAVX2, bytes, size, count);
+#endif
+
+#if SM_SCANNER_NEON
+		case SMVMwareVMXScannerISANEON:
+			return SMScannerScanBlocks(SMScannerBlockMaskNEON, bytes, size, count);
+#endif
+
+		default:
+			return SMScannerScanScalar(bytes, size, count);
+	}
+}
+
+static uint32_t * SMScannerScanScalar(const uint8_t *bytes, size_t size, size_t *count)
+{
+	SMScannerPositions positions = { 0 };
+
+	SMScannerPositionsReserve(&positions, size / 16 + 1);
+
+	for (size_t i = 0; i < size; i++)
+	{
+		uint8_t c = bytes[i];
+
+		if (c != '\n' && c != '=' && c != '"' && c != '\\')
+			continue;
+
+		SMScannerPositionsReserve(&positions, 2);
+		positions.positions[positions.count++] = (uint32_t)i;
+	}
+
+	// Add sentinel.
+	positions.positions[positions.count] = (uint32_t)size;
+
+	*count = positions.count;
+
+	return positions.positions;
+}
+
+static uint32_t * SMScannerScanBlocks(SMScannerBlockMask block_mask, const uint8_t *bytes, size_t size, size_t *count)
+{
+	SMScannerPositions positions = { 0 };
+
+	SMScannerPositionsReserve(&positions, size / 16 + 1);
+
+	for (size_t offset = 0; offset < size; offset += SMScannerBlockSize)
+	{
+		uint64_t mask;
+
+		// Compute the structural characters mask of the block.
+		if (size - offset >= SMScannerBlockSize)
+			mask = block_mask(bytes + offset);
+		else
+		{
+			// > Last partial block: pad with zeros, which never match.
+			uint8_t block[SMScannerBlockSize] = { 0 };
+
+			memcpy(block, bytes + offset, size - offset);
+
+			mask = block_mask(block);
+		}
+
+		if (mask == 0)
+			continue;
+
+		// Extract positions.
+		SMScannerPositionsReserve(&positions, (size_t)__builtin_popcountll(mask) + 1);
+
+		while (mask)
+		{
+			positions.positions[positions.count++] = (uint32_t)(offset + (size_t)__builtin_ctzll(mask));
+			mask &= mask - 1;
+		}
+	}
+
+	// Add sentinel.
+	positions.positions[positions.count] = (uint32_t)size;
+
+	*count = positions.count;
+
+	return positions.positions;
+}
+
+
+#pragma mark ISA
+
+SMVMwareVMXScannerISA SMVMwareVMXScannerGetBestISA(void)
+{
+	pthread_once(&g_best_isa_once, SMScannerSelectBestISA);
+
+	return g_best_isa;
+}
+
+static void SMScannerSelectBestISA(void)
+{
+	if (SMVMwareVMXScannerISAIsAvailable(SMVMwareVMXScannerISAAVX2))
+		g_best_isa = SMVMwareVMXScannerISAAVX2;
+	else if (SMVMwareVMXScannerISAIsAvailable(SMVMwareVMXScannerISASSE2))
+		g_best_isa = SMVMwareVMXScannerISASSE2;
+	else if (SMVMwareVMXScannerISAIsAvailable(SMVMwareVMXScannerISANEON))
+		g_best_isa = SMVMwareVMXScannerISANEON;
+	else
+		g_best_isa = SMVMwareVMXScannerISAScalar;
+}
+
+bool SMVMwareVMXScannerISAIsAvailable(SMVMwareVMXScannerISA isa)
+{
+	switch (isa)
+	{
+		case SMVMwareVMXScannerISAScalar:
+			return true;
+
+#if SM_SCANNER_X86
+		case SMVMwareVMXScannerISASSE2:
+			return __builtin_cpu_supports("sse2");
+
+		case SMVMwareVMXScannerISAAVX2:
+			return __builtin_cpu_supports("avx2");
+#endif
+
+#if SM_SCANNER_NEON
+		case SMVMwareVMXScannerISANEON:
+			return true;
+#endif
+
+		default:
+			return false;
+	}
+}
+
+const char * SMVMwareVMXScannerISAGetName(SMVMwareVMXScannerISA isa)
+{
+	switch (isa)
+	{
+		case SMVMwareVMXScannerISAScalar:
+			return "scalar";
+		case SMVMwareVMXScannerISASSE2:
+			return "sse2";
+		case SMVMwareVMXScannerISAAVX2:
+			return "avx2";
+		case SMVMwareVMXScannerISANEON:
+			return "neon";
+	}
+
+	return "unknown";
+}
+
+
+
+/*
+** Blocks
+*/
+#pragma mark - Blocks
+
+#if SM_SCANNER_X86
+
+__attribute__((target("sse2")))
+static uint64_t SMScannerBlockMaskSSE2(const uint8_t *block)
+{
+	const __m128i newline = _mm_set1_epi8('\n');
+	const __m128i equal = _mm_set1_epi8('=');
+	const __m128i quote = _mm_set1_epi8('"');
+	const __m128i backslash = _mm_set1_epi8('\\');
+
+	uint64_t result = 0;
+
+	for (unsigned i = 0; i < 4; i++)
+	{
+		__m128i chunk = _mm_loadu_si128((const __m128i *)(block + i * 16));
+		__m128i match = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, newline), _mm_cmpeq_epi8(chunk, equal)),
+									 _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)));
+
+		result |= (uint64_t)(uint16_t)_mm_movemask_epi8(match) << (i * 16);
+	}
+
+	return result;
+}
+
+__attribute__((target("avx2")))
+static uint64_t SMScannerBlockMaskAVX2(const uint8_t *block)
+{
+	const __m256i newline = _mm256_set1_epi8('\n');
+	const __m256i equal = _mm256_set1_epi8('=');
+	const __m256i quote = _mm256_set1_epi8('"');
+	const __m256i backslash = _mm256_set1_epi8('\\');
+
+	uint64_t result = 0;
+
+	for (unsigned i = 0; i < 2; i++)
+	{
+		__m256i chunk = _mm256_loadu_si256((const __m256i *)(block + i * 32));
+		__m256i match = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, newline), _mm256_cmpeq_epi8(chunk, equal)),
+										_mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash)));
+
+		result |= (uint64_t)(uint32_t)_mm256_movemask_epi8(match) << (i * 32);
+	}
+
+	return result;
+}
+
+#endif
+
+#if SM_SCANNER_NEON
+
+static uint64_t SMScannerBlockMaskNEON(const uint8_t *block)
+{
+	const uint8x16_t newline = vdupq_n_u8('\n');
+	const uint8x16_t equal = vdupq_n_u8('=');
+	const uint8x16_t quote = vdupq_n_u8('"');
+	const uint8x16_t backslash = vdupq_n_u8('\\');
+	const uint8x16_t bits = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80 };
+
+	uint8x16_t matches[4];
+
+	for (unsigned i = 0; i < 4; i++)
+	{
+		uint8x16_t chunk = vld1q_u8(block + i * 16);
+		uint8x16_t match = vorrq_u8(vorrq_u8(vceqq_u8(chunk, newline), vceqq_u8(chunk, equal)),
+									vorrq_u8(vceqq_u8(chunk, quote), vceqq_u8(chunk, backslash)));
+
+		matches[i] = vandq_u8(match, bits);
+	}
+
+	// Fold the 4 x 16 bytes into 64 bits (no movemask on NEON).
+	uint8x16_t sum0 = vpaddq_u8(matches[0], matches[1]);
+	uint8x16_t sum1 = vpaddq_u8(matches[2], matches[3]);
+
+	sum0 = vpaddq_u8(sum0, sum1);
+	sum0 = vpaddq_u8(sum0, sum0);
+
+	return vgetq_lane_u64(vreinterpretq_u64_u8(sum0), 0);
+}
+
+#endif
+
+
+
+/*
+** Helpers
+*/
+#pragma mark - Helpers
+
+static void SMScannerPositionsReserve(SMScannerPositions *positions, size_t count)
+{
+	// Always keep room for the sentinel.
+	if (positions->capacity >= positions->count + count + 1)
+		return;
+
+	size_t capacity = (positions->capacity ? positions->capacity : 64);
+
+	while (capacity < positions->count + count + 1)
+		capacity *= 2;
+
+	positions->positions = reallocf(positions->positions, capacity * sizeof(uint32_t));
+	positions->capacity = capacity;
+
+	assert(positions->positions);
+}
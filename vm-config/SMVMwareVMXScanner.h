@@ -0,0 +1,59 @@
+/*
+ *  SMVMwareVMXScanner.h
+ *
+ *  Copyright 2022 Avérous Julien-Pierre
+ *
+ *  This file is part of vm-config.
+ *
+ *  vm-config is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vm-config is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vm-config.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+
+/*
+** Types
+*/
+#pragma mark - Types
+
+typedef enum
+{
+	SMVMwareVMXScannerISAScalar,
+	SMVMwareVMXScannerISASSE2,
+	SMVMwareVMXScannerISAAVX2,
+	SMVMwareVMXScannerISANEON,
+} SMVMwareVMXScannerISA;
+
+
+/*
+** Functions
+*/
+#pragma mark - Functions
+
+// Scan.
+// > Returns the sorted offsets of every structural character ('\n', '=', '"' and '\\') in bytes.
+// > The array is terminated by a sentinel equal to size (not included in count), and must be freed by the caller.
+// > Buffer size is limited to UINT32_MAX bytes.
+uint32_t * SMVMwareVMXScannerScan(const void *bytes, size_t size, size_t *count);
+uint32_t * SMVMwareVMXScannerScanWithISA(SMVMwareVMXScannerISA isa, const void *bytes, size_t size, size_t *count);
+
+// ISA.
+SMVMwareVMXScannerISA	SMVMwareVMXScannerGetBestISA(void);
+bool					SMVMwareVMXScannerISAIsAvailable(SMVMwareVMXScannerISA isa);
+const char *			SMVMwareVMXScannerISAGetName(SMVMwareVMXScannerISA isa);
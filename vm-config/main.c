@@ -28,6 +28,9 @@
 #include <dirent.h>
 #include <errno.h>
 #include <assert.h>
+#include <pthread.h>
+#include <signal.h>
+#include <fcntl.h>
 
 #include <uuid/uuid.h>
 
@@ -46,6 +49,13 @@
 #include "SMVMwareVMX.h"
 #include "SMVMwareVMXHelper.h"
 
+#include "SMVMwareCache.h"
+
+#include "SMThreadPool.h"
+#include "SMBundleFinder.h"
+#include "SMServer.h"
+#include "SMJSONWriter.h"
+
 
 /*
 ** Defines
@@ -55,6 +65,8 @@
 #define SMStringify(a) xSMStringify(a)
 #define xSMStringify(a) #a
 
+#define SMCountOf(array) (sizeof(array) / sizeof((array)[0]))
+
 
 /*
 ** Types
@@ -69,12 +81,18 @@ typedef enum
 {
 	SMMainVerbVersion,
 	SMMainVerbShow,
-	SMMainVerbChange
+	SMMainVerbChange,
+	SMMainVerbApply,
+	SMMainVerbServe,
+	SMMainVerbCall,
 } SMMainVerb;
 
 typedef enum
 {
 	SMMainShowVM,
+	SMMainShowLibrary,
+	SMMainShowJobs,
+	SMMainShowOutputFormat,
 
 	SMMainShowAll,
 	
@@ -85,9 +103,26 @@ typedef enum
 	SMMainShowNVRAMEFIVariable,
 } SMMainShow;
 
+typedef enum
+{
+	SMMainShowFormatText,
+	SMMainShowFormatJSON,
+	SMMainShowFormatNDJSON,
+} SMMainShowFormat;
+
+typedef struct
+{
+	bool		vmx;
+	bool		nvram;
+	bool		nvram_efi_variables;
+	const char	*nvram_efi_variable;
+} SMMainShowContent;
+
 typedef enum
 {
 	SMMainChangeVM,
+	SMMainChangeBundlesList,
+	SMMainChangeJobs,
 	
 	SMMainChangeBootArgs,
 	
@@ -104,25 +139,156 @@ typedef enum
 	SMMainChangeScreenResolution,
 } SMMainChange;
 
+typedef enum
+{
+	SMMainApplyManifest,
+} SMMainApply;
+
+typedef enum
+{
+	SMMainServeSocket,
+	SMMainServeCacheSize,
+} SMMainServe;
+
+typedef enum
+{
+	SMMainCallSocket,
+	SMMainCallArguments,
+} SMMainCall;
+
+typedef struct
+{
+	char	*vm_path;
+	int		result;
+	
+	// Output, collected while changing in parallel.
+	char	*out_bytes;
+	size_t	out_size;
+	char	*err_bytes;
+	size_t	err_size;
+} SMMainChangeBundle;
+
+typedef struct
+{
+	SMCLOptionsResult	*opt_result;
+	SMMainChangeBundle	*bundles;
+} SMMainChangeContext;
+
+typedef struct
+{
+	SMCLOptionsResult	*opt_result;
+	SMMainShowFormat	format;
+	
+	// Output, shared by bundles shown in parallel.
+	pthread_mutex_t	mutex;
+	FILE			*fout;
+	FILE			*ferr;
+	
+	size_t	found_cnt;
+	size_t	failed_cnt;
+	int		result;
+} SMMainShowLibraryContext;
+
+typedef struct
+{
+	SMMainShowLibraryContext	*library;
+	char						*vm_path;
+} SMMainShowLibraryBundle;
+
+typedef struct
+{
+	SMCLOptions		*options;
+	SMVMwareCache	*cache;
+	int				directory_fd; // Server working directory, restored after each request.
+} SMMainServeContext;
+
+typedef struct
+{
+	uint32_t	flag;
+	const char	*name;
+} SMMainFlagName;
+
+
+/*
+** Globals
+*/
+#pragma mark - Globals
+
+static SMServer *g_serve_server = NULL;
+
+static const SMMainFlagName g_efi_attributes_names[] = {
+	{ EFI_VARIABLE_NON_VOLATILE,							"efi-variable-non-volatile" },
+	{ EFI_VARIABLE_BOOTSERVICE_ACCESS,						"efi-variable-bootservice-access" },
+	{ EFI_VARIABLE_RUNTIME_ACCESS,							"efi-variable-runtime-access" },
+	{ EFI_VARIABLE_HARDWARE_ERROR_RECORD,					"efi-variable-hardware-error-record" },
+	{ EFI_VARIABLE_AUTHENTICATED_WRITE_ACCESS,				"efi-variable-authenticated-write-access" },
+	{ EFI_VARIABLE_TIME_BASED_AUTHENTICATED_WRITE_ACCESS,	"efi-variable-time-based-authenticated-write-access" },
+	{ EFI_VARIABLE_APPEND_WRITE,							"efi-variable-append-write" },
+};
+
+static const SMMainFlagName g_csr_flags_names[] = {
+	{ CSR_ALLOW_UNTRUSTED_KEXTS,			"allow-untrusted-kexts" },
+	{ CSR_ALLOW_UNRESTRICTED_FS,			"allow-unrestricted-fs" },
+	{ CSR_ALLOW_TASK_FOR_PID,				"allow-task-for-pid" },
+	{ CSR_ALLOW_KERNEL_DEBUGGER,			"allow-kernel-debugger" },
+	{ CSR_ALLOW_APPLE_INTERNAL,				"allow-apple-internal" },
+	{ CSR_ALLOW_UNRESTRICTED_DTRACE,		"allow-unrestricted-dtrace" },
+	{ CSR_ALLOW_UNRESTRICTED_NVRAM,			"allow-unrestricted-nvram" },
+	{ CSR_ALLOW_DEVICE_CONFIGURATION,		"allow-device-configuration" },
+	{ CSR_ALLOW_ANY_RECOVERY_OS,			"allow-any-recovery-os" },
+	{ CSR_ALLOW_UNAPPROVED_KEXTS,			"allow-unapproved-kexts" },
+	{ CSR_ALLOW_EXECUTABLE_POLICY_OVERRIDE,	"allow-executable-policy-override" },
+	{ CSR_ALLOW_UNAUTHENTICATED_ROOT,		"allow-unauthenticated-root" },
+};
+
 
 /*
 ** Prototypes
 */
 #pragma mark - Prototypes
 
+// Main.
+static SMCLOptions *	main_options(void);
+static int				main_run(SMCLOptions *options, SMVMwareCache *cache, int argc, const char *argv[], FILE *fout, FILE *ferr); // cache: set when serving a request.
+
 // Sub-mains.
-static int main_show(SMCLOptionsResult *opt_result, FILE *fout, FILE *ferr);
+static int main_show(SMCLOptionsResult *opt_result, SMVMwareCache *cache, FILE *fout, FILE *ferr);
+static void main_show_content(SMCLOptionsResult *opt_result, SMMainShowContent *content);
+static int main_show_bundle(const char *vm_path, SMVMwareCache *cache, SMCLOptionsResult *opt_result, FILE *fout, FILE *ferr);
+static int main_show_bundle_json(const char *vm_path, SMVMwareCache *cache, SMCLOptionsResult *opt_result, SMJSONWriter *writer, FILE *ferr);
+static int main_show_library(const char *library_path, size_t jobs, SMMainShowFormat format, SMCLOptionsResult *opt_result, FILE *fout, FILE *ferr);
+static void main_show_library_found(SMThreadPool *pool, char *bundle_path, void *context);
+static void main_show_library_bundle(SMThreadPool *pool, void *context);
 static int main_change(SMCLOptionsResult *opt_result, FILE *fout, FILE *ferr);
+static int main_change_bundle(const char *vm_path, SMCLOptionsResult *opt_result, FILE *fout, FILE *ferr);
+static void main_change_bundle_apply(size_t idx, void *context);
+static int main_apply(SMCLOptions *options, SMCLOptionsResult *opt_result, FILE *fout, FILE *ferr);
+static int main_apply_record(SMCLOptions *options, const char *record, size_t line_idx, FILE *fout, FILE *ferr);
+static int main_serve(SMCLOptions *options, SMCLOptionsResult *opt_result, FILE *fout, FILE *ferr);
+static int main_serve_request(const char *working_directory, int argc, const char *argv[], FILE *fout, FILE *ferr, void *context);
+static void main_serve_signal(int sig);
+static int main_call(SMCLOptionsResult *opt_result, FILE *fout, FILE *ferr);
 
 // Information.
 static void show_version(FILE *output);
 
 // VMware.
-static SMVMwareVMX *	SMGetVMXFromVM(const char *vm_path, SMVMwareVMX **inoutVMX, SMError **error);
-static SMVMwareNVRAM *	SMGetNVRAMFromVM(const char *vm_path, SMVMwareVMX **inoutVMX, SMVMwareNVRAM **inoutNVRAM, SMError **error);
+// > With a cache, returned instances are owned by the cache, and should not be modified.
+static SMVMwareVMX *	SMGetVMXFromVM(const char *vm_path, SMVMwareCache *cache, SMVMwareVMX **inoutVMX, SMError **error);
+static SMVMwareNVRAM *	SMGetNVRAMFromVM(const char *vm_path, SMVMwareCache *cache, SMVMwareVMX **inoutVMX, SMVMwareNVRAM **inoutNVRAM, SMError **error);
+
+// Bundles.
+static bool SMReadBundlesList(const char *list_path, SMMainChangeBundle **bundles, size_t *bundles_cnt, SMError **error);
+static void SMAddBundle(SMMainChangeBundle **bundles, size_t *bundles_cnt, const char *vm_path, size_t vm_path_len);
 
 // Output.
 static void SMDumpBytes(const void *bytes, size_t size, size_t padding, FILE *output);
+static void SMPrintPrefixedLines(const char *prefix, const char *bytes, size_t size, FILE *output);
+static void SMPrintFlagsNames(uint32_t flags, const SMMainFlagName *names, size_t count, FILE *output);
+
+// JSON.
+static void SMWriteEFIVariableJSON(SMVMwareNVRAMEFIVariable *var, SMJSONWriter *writer);
+static void SMWriteFlagsNamesJSON(uint32_t flags, const SMMainFlagName *names, size_t count, SMJSONWriter *writer);
 
 
 /*
@@ -136,6 +302,16 @@ int main(int argc, const char * argv[])
 }
 
 int internal_main(int argc, const char * argv[], FILE *fout, FILE *ferr)
+{
+	SMCLOptions	*options = main_options();
+	int			exit_code = main_run(options, NULL, argc, argv, fout, ferr);
+	
+	SMCLOptionsFree(options);
+	
+	return exit_code;
+}
+
+static SMCLOptions * main_options(void)
 {
 	// Configuration options parsing.
 	SMCLOptions *options = SMCLOptionsCreate();
@@ -149,6 +325,9 @@ int internal_main(int argc, const char * argv[], FILE *fout, FILE *ferr)
 	SMCLOptionsVerb *show_verb = SMCLOptionsAddVerb(options, SMMainVerbShow, "show", "Show configuration of a virtual machine bundle");
 
 	SMCLOptionsVerbAddValue(show_verb,				SMMainShowVM,								"vmwarevm",															"Path to the virtual machine .vmwarevm bundle");
+	SMCLOptionsVerbAddOption(show_verb, 			SMMainShowLibrary, 					true,	"library", 				0,											"Show all virtual machine bundles found in vmwarevm directory tree");
+	SMCLOptionsVerbAddOptionWithArgument(show_verb,	SMMainShowJobs,						true,	"jobs",					0, SMCLValueTypeUInt32,		"count",		"Count of library directories & bundles handled in parallel (default: count of CPUs)");
+	SMCLOptionsVerbAddOptionWithArgument(show_verb,	SMMainShowOutputFormat,				true,	"format",				0, SMCLValueTypeString,		"format",		"Output format: text (default), json or ndjson (one line per bundle)");
 	SMCLOptionsVerbAddOption(show_verb, 			SMMainShowAll, 						true,	"all", 					0,											"Show all possible content");
 	SMCLOptionsVerbAddOption(show_verb, 			SMMainShowVMX, 						true,	"vmx", 					0,											"Show vmx file content");
 	SMCLOptionsVerbAddOption(show_verb, 			SMMainShowNVRAM,					true,	"nvram", 				0,											"Show nvram file content");
@@ -156,9 +335,11 @@ int internal_main(int argc, const char * argv[], FILE *fout, FILE *ferr)
 	SMCLOptionsVerbAddOptionWithArgument(show_verb,	SMMainShowNVRAMEFIVariable,			true,	"nvram-efi-variable",	0, SMCLValueTypeString,		"name",			"Show nvram efi variable with this name");
 	
 	// > change.
-	SMCLOptionsVerb *change_verb = SMCLOptionsAddVerb(options, SMMainVerbChange, "change", "Change configuration of a virtual machine bundle");
+	SMCLOptionsVerb *change_verb = SMCLOptionsAddVerb(options, SMMainVerbChange, "change", "Change configuration of virtual machine bundles");
 
-	SMCLOptionsVerbAddValue(change_verb,				SMMainChangeVM,							"vmwarevm",															"Path to the virtual machine .vmwarevm bundle");
+	SMCLOptionsVerbAddVariadicValue(change_verb,		SMMainChangeVM,					true,	"vmwarevm",																"Paths to the virtual machine .vmwarevm bundles");
+	SMCLOptionsVerbAddOptionWithArgument(change_verb,	SMMainChangeBundlesList,		true,	"bundles-list",			0,  SMCLValueTypeString,	"path",			"Change bundles listed in this file too, one per line ('-' for standard input)");
+	SMCLOptionsVerbAddOptionWithArgument(change_verb,	SMMainChangeJobs,				true,	"jobs",					0,  SMCLValueTypeUInt32,	"count",		"Count of bundles changed in parallel (default: count of CPUs)");
 	SMCLOptionsVerbAddOptionWithArgument(change_verb,	SMMainChangeBootArgs, 			true,	"boot-args", 			0,  SMCLValueTypeString,	"key=value",	"Set boot arguments");
 	SMCLOptionsVerbAddOption(change_verb,				SMMainChangeCSREnable, 			true,	"csr-enable", 			0,											"Similar to 'csrutil enable'");
 	SMCLOptionsVerbAddOptionWithArgument(change_verb,	SMMainChangeCSREnableVersion, 	true,	"csr-enable-version", 	0,  SMCLValueTypeString,	"version",		"Similar to 'csrutil enable' for a specific macOS version");
@@ -168,6 +349,28 @@ int internal_main(int argc, const char * argv[], FILE *fout, FILE *ferr)
 	SMCLOptionsVerbAddOptionWithArgument(change_verb,	SMMainChangeMachineUUID, 		true,	"machine-uuid", 		0,  SMCLValueTypeString,	"uuid",			"Set machine UUID");
 	SMCLOptionsVerbAddOptionWithArgument(change_verb,	SMMainChangeScreenResolution, 	true,	"screen-resolution",	0,  SMCLValueTypeString,	"WxH",			"Set screen resolution, width x height, e.g. '1920x1080'");
 	
+	// > apply.
+	SMCLOptionsVerb *apply_verb = SMCLOptionsAddVerb(options, SMMainVerbApply, "apply", "Apply changes listed in a manifest, one virtual machine bundle per line");
+	
+	SMCLOptionsVerbAddValue(apply_verb,					SMMainApplyManifest,									"manifest",																"Path to the manifest ('-' for standard input), with lines like: path/to/vm.vmwarevm --boot-args '-v' --machine-uuid <uuid>");
+	
+	// > serve.
+	SMCLOptionsVerb *serve_verb = SMCLOptionsAddVerb(options, SMMainVerbServe, "serve", "Answer requests sent on a Unix socket, keeping parsed vmx & nvram files in memory");
+	
+	SMCLOptionsVerbAddValue(serve_verb,					SMMainServeSocket,										"socket",																"Path to the Unix socket to create");
+	SMCLOptionsVerbAddOptionWithArgument(serve_verb,	SMMainServeCacheSize,			true,	"cache-size",			0,  SMCLValueTypeUInt32,	"count",		"Count of parsed vmx & nvram files kept in memory (default: 64)");
+	
+	// > call.
+	SMCLOptionsVerb *call_verb = SMCLOptionsAddVerb(options, SMMainVerbCall, "call", "Send a request to a server started with the 'serve' verb");
+	
+	SMCLOptionsVerbAddValue(call_verb,					SMMainCallSocket,										"socket",																"Path to the Unix socket of the server");
+	SMCLOptionsVerbAddVariadicValue(call_verb,			SMMainCallArguments,			false,	"arguments",															"Arguments of the request, after '--', e.g. -- show path/to/vm.vmwarevm --all");
+	
+	return options;
+}
+
+static int main_run(SMCLOptions *options, SMVMwareCache *cache, int argc, const char *argv[], FILE *fout, FILE *ferr)
+{
 	// Parse options.
 	SMError				*error = NULL;
 	SMCLOptionsResult	*result = SMCLOptionsParse(options, argc, argv, &error);
@@ -178,32 +381,69 @@ int internal_main(int argc, const char * argv[], FILE *fout, FILE *ferr)
 		fprintf(ferr, "\n");
 		SMCLOptionsPrintUsage(options, ferr);
 		
-		SMCLOptionsFree(options);
 		SMErrorFree(error);
 
 		return SMMainExitInvalidArgs;
 	}
 	
 	// Dispatch verb handing.
-	int exit_code = 0;
+	SMMainVerb	verb = (SMMainVerb)SMCLOptionsResultVerbIdentifier(result);
+	int			exit_code = 0;
+	
+	// > Requests can't start or call servers.
+	if (cache && (verb == SMMainVerbServe || verb == SMMainVerbCall))
+	{
+		fprintf(ferr, "Error: Verb '%s' is not allowed in requests.\n", argv[1]);
+		SMCLOptionsResultFree(result);
+		
+		return SMMainExitInvalidArgs;
+	}
+	
+	// > Requests have no standard input: the server one is detached.
+	for (size_t i = 0; cache && i < SMCLOptionsResultParametersCount(result); i++)
+	{
+		uint64_t identifier = SMCLOptionsResultParameterIdentifierAtIndex(result, i);
+		
+		if ((verb == SMMainVerbApply && identifier == SMMainApplyManifest) || (verb == SMMainVerbChange && identifier == SMMainChangeBundlesList))
+		{
+			if (strcmp(SMCLOptionsResultParameterStringValueAtIndex(result, i), "-") == 0)
+			{
+				fprintf(ferr, "Error: Standard input ('-') is not available in requests.\n");
+				SMCLOptionsResultFree(result);
+				
+				return SMMainExitInvalidArgs;
+			}
+		}
+	}
 	
-	switch ((SMMainVerb)SMCLOptionsResultVerbIdentifier(result))
+	switch (verb)
 	{
 		case SMMainVerbVersion:
 			show_version(fout);
 			break;
 			
 		case SMMainVerbShow:
-			exit_code = main_show(result, fout, ferr);
+			exit_code = main_show(result, cache, fout, ferr);
 			break;
 			
 		case SMMainVerbChange:
 			exit_code = main_change(result, fout, ferr);
 			break;
+			
+		case SMMainVerbApply:
+			exit_code = main_apply(options, result, fout, ferr);
+			break;
+			
+		case SMMainVerbServe:
+			exit_code = main_serve(options, result, fout, ferr);
+			break;
+			
+		case SMMainVerbCall:
+			exit_code = main_call(result, fout, ferr);
+			break;
 	}
 	
 	SMCLOptionsResultFree(result);
-	SMCLOptionsFree(options);
 
 	return exit_code;
 }
@@ -211,21 +451,14 @@ int internal_main(int argc, const char * argv[], FILE *fout, FILE *ferr)
 
 #pragma mark > Show
 
-static int main_show(SMCLOptionsResult *opt_result, FILE *fout, FILE *ferr)
+static int main_show(SMCLOptionsResult *opt_result, SMVMwareCache *cache, FILE *fout, FILE *ferr)
 {
-	int 			result = SMMainExitSuccess;
-
-	SMVMwareVMX		*g_vmx = NULL;
-	SMVMwareNVRAM	*g_nvram = NULL;
-	SMError			*error = NULL;
+	const char			*vm_path = NULL;
+	bool				library = false;
+	size_t				jobs = 0;
+	SMMainShowFormat	format = SMMainShowFormatText;
 	
 	// Handle options.
-	const char	*vm_path = NULL;
-	bool		show_vmx = false;
-	bool		show_nvram = false;
-	bool		show_nvram_efi_variables = false;
-	const char	*show_nvram_efi_variable = NULL;
-
 	for (size_t i = 0; i < SMCLOptionsResultParametersCount(opt_result); i++)
 	{
 		SMMainShow mainShowOp = (SMMainShow)SMCLOptionsResultParameterIdentifierAtIndex(opt_result, i);
@@ -233,53 +466,281 @@ static int main_show(SMCLOptionsResult *opt_result, FILE *fout, FILE *ferr)
 		switch (mainShowOp)
 		{
 			case SMMainShowVM:
-			{
 				vm_path = SMCLOptionsResultParameterStringValueAtIndex(opt_result, i);
 				break;
+				
+			case SMMainShowLibrary:
+				library = true;
+				break;
+				
+			case SMMainShowJobs:
+				jobs = SMCLOptionsResultParameterUInt32ValueAtIndex(opt_result, i);
+				break;
+				
+			case SMMainShowOutputFormat:
+			{
+				const char *format_str = SMCLOptionsResultParameterStringValueAtIndex(opt_result, i);
+				
+				if (strcmp(format_str, "text") == 0)
+					format = SMMainShowFormatText;
+				else if (strcmp(format_str, "json") == 0)
+					format = SMMainShowFormatJSON;
+				else if (strcmp(format_str, "ndjson") == 0)
+					format = SMMainShowFormatNDJSON;
+				else
+				{
+					fprintf(ferr, "Error: Unknown output format '%s'.\n", format_str);
+					return SMMainExitInvalidArgs;
+				}
+				
+				break;
 			}
 				
+			default:
+				break;
+		}
+	}
+	
+	// Show library.
+	if (library)
+		return main_show_library(vm_path, jobs, format, opt_result, fout, ferr);
+	
+	// Show bundle.
+	if (format == SMMainShowFormatText)
+		return main_show_bundle(vm_path, cache, opt_result, fout, ferr);
+	
+	// > A single bundle is a single record: json and ndjson outputs are the same.
+	SMJSONWriter	*writer = SMJSONWriterCreate(fout);
+	int				result = main_show_bundle_json(vm_path, cache, opt_result, writer, ferr);
+	
+	SMJSONWriterNewline(writer);
+	
+	if (!SMJSONWriterFlush(writer))
+	{
+		fprintf(ferr, "Error: Can't write output.\n");
+		
+		if (result == SMMainExitSuccess)
+			result = SMMainExitUnknowError;
+	}
+	
+	SMJSONWriterFree(writer);
+	
+	return result;
+}
+
+static void main_show_content(SMCLOptionsResult *opt_result, SMMainShowContent *content)
+{
+	memset(content, 0, sizeof(*content));
+	
+	for (size_t i = 0; i < SMCLOptionsResultParametersCount(opt_result); i++)
+	{
+		SMMainShow mainShowOp = (SMMainShow)SMCLOptionsResultParameterIdentifierAtIndex(opt_result, i);
+		
+		switch (mainShowOp)
+		{
+			case SMMainShowVM:
+			case SMMainShowLibrary:
+			case SMMainShowJobs:
+			case SMMainShowOutputFormat:
+				break;
+				
 			case SMMainShowAll:
 			{
-				show_vmx = true;
-				show_nvram = true;
-				show_nvram_efi_variables = true;
+				content->vmx = true;
+				content->nvram = true;
+				content->nvram_efi_variables = true;
 				
 				break;
 			}
 				
 			case SMMainShowVMX:
 			{
-				show_vmx = true;
+				content->vmx = true;
 				break;
 			}
 				
 			case SMMainShowNVRAM:
 			{
-				show_nvram = true;
-				show_nvram_efi_variables = true;
+				content->nvram = true;
+				content->nvram_efi_variables = true;
 				
 				break;
 			}
 				
 			case SMMainShowNVRAMEFIVariables:
 			{
-				show_nvram_efi_variables = true;
+				content->nvram_efi_variables = true;
 				break;
 			}
 				
 			case SMMainShowNVRAMEFIVariable:
 			{
-				show_nvram_efi_variable = SMCLOptionsResultParameterStringValueAtIndex(opt_result, i);
+				content->nvram_efi_variable = SMCLOptionsResultParameterStringValueAtIndex(opt_result, i);
 				break;
 			}
 		}
 	}
+}
+
+static int main_show_library(const char *library_path, size_t jobs, SMMainShowFormat format, SMCLOptionsResult *opt_result, FILE *fout, FILE *ferr)
+{
+	int							result = SMMainExitSuccess;
+	SMError						*error = NULL;
+	SMMainShowLibraryContext	context = { .opt_result = opt_result, .format = format, .fout = fout, .ferr = ferr, .result = SMMainExitSuccess };
+	
+	pthread_mutex_init(&context.mutex, NULL);
+	
+	// Walk library & show bundles as soon as they are found.
+	// > Directories and bundles are both pool tasks: bundles are parsed while the walk goes on.
+	SMThreadPool *pool = SMThreadPoolCreate(jobs);
+	
+	if (!SMBundleFinderWalk(pool, library_path, "vmwarevm", main_show_library_found, &context, &error))
+	{
+		fprintf(ferr, "Error: %s\n", SMErrorGetSentencizedUserInfo(error));
+		result = SMMainExitInvalidVM;
+		goto clean;
+	}
+	
+	// Close JSON array.
+	if (format == SMMainShowFormatJSON)
+		fputs(context.found_cnt > 0 ? "\n]\n" : "[]\n", fout);
+	
+	// Check results.
+	if (context.found_cnt == 0)
+	{
+		fprintf(ferr, "Error: Can't find virtual machine bundle in library.\n");
+		result = SMMainExitInvalidVM;
+	}
+	else if (context.failed_cnt > 0)
+	{
+		fprintf(ferr, "Error: Failed to show %zu of %zu virtual machines.\n", context.failed_cnt, context.found_cnt);
+		result = context.result;
+	}
+	
+clean:
+	SMThreadPoolFree(pool);
+	pthread_mutex_destroy(&context.mutex);
+	SMErrorFree(error);
+	
+	return result;
+}
+
+static void main_show_library_found(SMThreadPool *pool, char *bundle_path, void *context)
+{
+	SMMainShowLibraryBundle *bundle = malloc(sizeof(SMMainShowLibraryBundle));
+	
+	assert(bundle);
+	
+	bundle->library = context;
+	bundle->vm_path = bundle_path;
+	
+	SMThreadPoolAddTask(pool, main_show_library_bundle, bundle);
+}
+
+static void main_show_library_bundle(SMThreadPool *pool, void *context)
+{
+	SMMainShowLibraryBundle		*bundle = context;
+	SMMainShowLibraryContext	*library = bundle->library;
+	
+	// Show bundle.
+	char			*out_bytes = NULL, *err_bytes = NULL;
+	size_t			out_size = 0, err_size = 0;
+	FILE			*fout = NULL;
+	FILE			*ferr = open_memstream(&err_bytes, &err_size);
+	SMJSONWriter	*writer = NULL;
+	int				result;
+	
+	assert(ferr);
+	
+	// > Bundles are shown in parallel: no shared cache.
+	if (library->format == SMMainShowFormatText)
+	{
+		fout = open_memstream(&out_bytes, &out_size);
+		
+		assert(fout);
+		
+		result = main_show_bundle(bundle->vm_path, NULL, library->opt_result, fout, ferr);
+		
+		fclose(fout);
+	}
+	else
+	{
+		// > Records already hold the bundle path: rendered in memory, then written without prefix.
+		writer = SMJSONWriterCreate(NULL);
+		result = main_show_bundle_json(bundle->vm_path, NULL, library->opt_result, writer, ferr);
+		out_bytes = (char *)SMJSONWriterGetBytes(writer, &out_size);
+	}
+	
+	fclose(ferr);
+	
+	// Output as a whole, in completion order.
+	pthread_mutex_lock(&library->mutex);
+	
+	switch (library->format)
+	{
+		case SMMainShowFormatText:
+			SMPrintPrefixedLines(bundle->vm_path, out_bytes, out_size, library->fout);
+			break;
+			
+		case SMMainShowFormatJSON:
+			fputs(library->found_cnt == 0 ? "[\n" : ",\n", library->fout);
+			fwrite(out_bytes, 1, out_size, library->fout);
+			break;
+			
+		case SMMainShowFormatNDJSON:
+			fwrite(out_bytes, 1, out_size, library->fout);
+			fputc('\n', library->fout);
+			break;
+	}
+	
+	SMPrintPrefixedLines(bundle->vm_path, err_bytes, err_size, library->ferr);
+	
+	library->found_cnt++;
+	
+	if (result != SMMainExitSuccess)
+	{
+		if (library->result == SMMainExitSuccess)
+			library->result = result;
+		
+		library->failed_cnt++;
+	}
+	
+	pthread_mutex_unlock(&library->mutex);
+	
+	// Clean.
+	if (writer)
+		SMJSONWriterFree(writer);
+	else
+		free(out_bytes);
+	
+	free(err_bytes);
+	free(bundle->vm_path);
+	free(bundle);
+}
+
+static int main_show_bundle(const char *vm_path, SMVMwareCache *cache, SMCLOptionsResult *opt_result, FILE *fout, FILE *ferr)
+{
+	int 			result = SMMainExitSuccess;
+
+	SMVMwareVMX		*g_vmx = NULL;
+	SMVMwareNVRAM	*g_nvram = NULL;
+	SMError			*error = NULL;
+	
+	// Handle options.
+	SMMainShowContent content;
+	
+	main_show_content(opt_result, &content);
+	
+	bool		show_vmx = content.vmx;
+	bool		show_nvram = content.nvram;
+	bool		show_nvram_efi_variables = content.nvram_efi_variables;
+	const char	*show_nvram_efi_variable = content.nvram_efi_variable;
 	
 	// Print VMX.
 	if (show_vmx)
 	{
 		// > Open VMX file.
-		SMVMwareVMX *vmx = SMGetVMXFromVM(vm_path, &g_vmx, &error);
+		SMVMwareVMX *vmx = SMGetVMXFromVM(vm_path, cache, &g_vmx, &error);
 		
 		if (!vmx)
 		{
@@ -344,7 +805,7 @@ static int main_show(SMCLOptionsResult *opt_result, FILE *fout, FILE *ferr)
 	if (show_nvram || show_nvram_efi_variables || show_nvram_efi_variable)
 	{
 		// > Open NVRAM file.
-		SMVMwareNVRAM *nvram = SMGetNVRAMFromVM(vm_path, &g_vmx, &g_nvram, &error);
+		SMVMwareNVRAM *nvram = SMGetNVRAMFromVM(vm_path, cache, &g_vmx, &g_nvram, &error);
 		
 		if (!nvram)
 		{
@@ -424,13 +885,7 @@ static int main_show(SMCLOptionsResult *opt_result, FILE *fout, FILE *ferr)
 					// > Attributes.
 					fprintf(fout, "       Attributes: 0x%x\n", attributes);
 					
-					if (attributes & EFI_VARIABLE_NON_VOLATILE)								fprintf(fout, "           efi-variable-non-volatile\n");
-					if (attributes & EFI_VARIABLE_BOOTSERVICE_ACCESS)						fprintf(fout, "           efi-variable-bootservice-access\n");
-					if (attributes & EFI_VARIABLE_RUNTIME_ACCESS)							fprintf(fout, "           efi-variable-runtime-access\n");
-					if (attributes & EFI_VARIABLE_HARDWARE_ERROR_RECORD)					fprintf(fout, "           efi-variable-hardware-error-record\n");
-					if (attributes & EFI_VARIABLE_AUTHENTICATED_WRITE_ACCESS)				fprintf(fout, "           efi-variable-authenticated-write-access\n");
-					if (attributes & EFI_VARIABLE_TIME_BASED_AUTHENTICATED_WRITE_ACCESS)	fprintf(fout, "           efi-variable-time-based-authenticated-write-access\n");
-					if (attributes & EFI_VARIABLE_APPEND_WRITE)								fprintf(fout, "           efi-variable-append-write\n");
+					SMPrintFlagsNames(attributes, g_efi_attributes_names, SMCountOf(g_efi_attributes_names), fout);
 
 					fprintf(fout, "\n");
 
@@ -468,18 +923,7 @@ static int main_show(SMCLOptionsResult *opt_result, FILE *fout, FILE *ferr)
 							
 							fprintf(fout, "       Value (Configurable Security Restrictions): 0x%x\n", csr);
 							
-							if (csr & CSR_ALLOW_UNTRUSTED_KEXTS)			fprintf(fout, "           allow-untrusted-kexts\n");
-							if (csr & CSR_ALLOW_UNRESTRICTED_FS)			fprintf(fout, "           allow-unrestricted-fs\n");
-							if (csr & CSR_ALLOW_TASK_FOR_PID)				fprintf(fout, "           allow-task-for-pid\n");
-							if (csr & CSR_ALLOW_KERNEL_DEBUGGER)			fprintf(fout, "           allow-kernel-debugger\n");
-							if (csr & CSR_ALLOW_APPLE_INTERNAL)				fprintf(fout, "           allow-apple-internal\n");
-							if (csr & CSR_ALLOW_UNRESTRICTED_DTRACE)		fprintf(fout, "           allow-unrestricted-dtrace\n");
-							if (csr & CSR_ALLOW_UNRESTRICTED_NVRAM)			fprintf(fout, "           allow-unrestricted-nvram\n");
-							if (csr & CSR_ALLOW_DEVICE_CONFIGURATION)		fprintf(fout, "           allow-device-configuration\n");
-							if (csr & CSR_ALLOW_ANY_RECOVERY_OS)			fprintf(fout, "           allow-any-recovery-os\n");
-							if (csr & CSR_ALLOW_UNAPPROVED_KEXTS)			fprintf(fout, "           allow-unapproved-kexts\n");
-							if (csr & CSR_ALLOW_EXECUTABLE_POLICY_OVERRIDE)	fprintf(fout, "           allow-executable-policy-override\n");
-							if (csr & CSR_ALLOW_UNAUTHENTICATED_ROOT)		fprintf(fout, "           allow-unauthenticated-root\n");
+							SMPrintFlagsNames(csr, g_csr_flags_names, SMCountOf(g_csr_flags_names), fout);
 							
 							fprintf(fout, "\n");
 						}
@@ -575,56 +1019,391 @@ fail:
 	
 clean:
 	SMErrorFree(error);
-	SMVMwareVMXFree(g_vmx);
-	SMVMwareNVRAMFree(g_nvram);
+	
+	if (!cache)
+	{
+		SMVMwareVMXFree(g_vmx);
+		SMVMwareNVRAMFree(g_nvram);
+	}
 	
 	return result;
 }
 
 
-#pragma mark > Change
-
-static int main_change(SMCLOptionsResult *opt_result, FILE *fout, FILE *ferr)
+static int main_show_bundle_json(const char *vm_path, SMVMwareCache *cache, SMCLOptionsResult *opt_result, SMJSONWriter *writer, FILE *ferr)
 {
 	int 			result = SMMainExitSuccess;
-
+	
 	SMVMwareVMX		*g_vmx = NULL;
 	SMVMwareNVRAM	*g_nvram = NULL;
 	SMError			*error = NULL;
 	
+	unsigned		depth = SMJSONWriterDepth(writer);
+	
 	// Handle options.
-	const char		*vm_path  = NULL;
-	char			*vmx_path_tmp_path = NULL;
-	char			*nvram_path_tmp_path = NULL;
+	SMMainShowContent content;
 	
-	for (size_t i = 0; i < SMCLOptionsResultParametersCount(opt_result); i++)
+	main_show_content(opt_result, &content);
+	
+	// Open record.
+	SMJSONWriterBeginObject(writer);
+	
+	SMJSONWriterKey(writer, "path");
+	SMJSONWriterString(writer, vm_path);
+	
+	// Write VMX.
+	if (content.vmx)
 	{
-		SMMainChange mainChangeOp = (SMMainChange)SMCLOptionsResultParameterIdentifierAtIndex(opt_result, i);
+		// > Open VMX file.
+		SMVMwareVMX *vmx = SMGetVMXFromVM(vm_path, cache, &g_vmx, &error);
 		
-		switch (mainChangeOp)
+		if (!vmx)
 		{
-			case SMMainChangeVM:
-			{
-				vm_path = SMCLOptionsResultParameterStringValueAtIndex(opt_result, i);
-				break;
-			}
-				
-			case SMMainChangeBootArgs:
+			result = SMMainExitInvalidVM;
+			goto fail;
+		}
+		
+		// > List & write entries.
+		size_t count = SMVMwareVMXEntriesCount(vmx);
+		
+		SMJSONWriterKey(writer, "vmx");
+		SMJSONWriterBeginArray(writer);
+		
+		for (size_t i = 0; i < count; i++)
+		{
+			SMVMwareVMXEntry *entry = SMVMwareVMXGetEntryAtIndex(vmx, i);
+			
+			SMJSONWriterBeginObject(writer);
+			SMJSONWriterKey(writer, "type");
+			
+			switch (SMVMwareVMXEntryGetType(entry))
 			{
-				// Open NVRAM file.
-				SMVMwareNVRAM *nvram = SMGetNVRAMFromVM(vm_path, &g_vmx, &g_nvram, &error);
-
-				if (!nvram)
+				case SMVMwareVMXEntryTypeEmpty:
+					SMJSONWriterString(writer, "empty-line");
+					break;
+					
+				case SMVMwareVMXEntryTypeComment:
 				{
-					result = SMMainExitInvalidVM;
-					goto fail;
+					const char *comment = SMVMwareVMXEntryGetComment(entry, &error);
+					
+					if (!comment)
+						goto fail;
+					
+					SMJSONWriterString(writer, "comment");
+					
+					SMJSONWriterKey(writer, "value");
+					SMJSONWriterString(writer, comment);
+					
+					break;
 				}
-
-				// Set boot arguments.
-				if (!SMVMwareNVRAMSetBootArgs(nvram, SMCLOptionsResultParameterStringValueAtIndex(opt_result, i), &error))
-					goto fail;
-				
-				break;
+					
+				case SMVMwareVMXEntryTypeKeyValue:
+				{
+					const char *key = SMVMwareVMXEntryGetKey(entry, &error);
+					
+					if (!key)
+						goto fail;
+					
+					const char *value = SMVMwareVMXEntryGetValue(entry, &error);
+					
+					if (!value)
+						goto fail;
+					
+					SMJSONWriterString(writer, "key-value");
+					
+					SMJSONWriterKey(writer, "key");
+					SMJSONWriterString(writer, key);
+					SMJSONWriterKey(writer, "value");
+					SMJSONWriterString(writer, value);
+					
+					break;
+				}
+			}
+			
+			SMJSONWriterEndObject(writer);
+		}
+		
+		SMJSONWriterEndArray(writer);
+	}
+	
+	// Write NVRAM.
+	if (content.nvram || content.nvram_efi_variables || content.nvram_efi_variable)
+	{
+		// > Open NVRAM file.
+		SMVMwareNVRAM *nvram = SMGetNVRAMFromVM(vm_path, cache, &g_vmx, &g_nvram, &error);
+		
+		if (!nvram)
+		{
+			result = SMMainExitInvalidVM;
+			goto fail;
+		}
+		
+		// > List & write entries.
+		// > Without full nvram content, variables are written as a flat list.
+		size_t count = SMVMwareNVRAMEntriesCount(nvram);
+		
+		SMJSONWriterKey(writer, content.nvram ? "nvram" : "nvram_efi_variables");
+		SMJSONWriterBeginArray(writer);
+		
+		for (size_t i = 0; i < count; i++)
+		{
+			SMVMwareNVRAMEntry	*entry = SMVMwareNVRAMGetEntryAtIndex(nvram, i);
+			size_t				var_count = SMVMwareNVRAMEntryVariablesCount(entry);
+			
+			if (content.nvram)
+			{
+				SMJSONWriterBeginObject(writer);
+				
+				SMJSONWriterKey(writer, "name");
+				SMJSONWriterString(writer, SMVMwareNVRAMEntryGetName(entry));
+				SMJSONWriterKey(writer, "subname");
+				SMJSONWriterString(writer, SMVMwareNVRAMEntryGetSubname(entry));
+			}
+			
+			// > Write variables.
+			if ((content.nvram_efi_variables || content.nvram_efi_variable) && var_count > 0)
+			{
+				if (content.nvram)
+				{
+					SMJSONWriterKey(writer, "variables");
+					SMJSONWriterBeginArray(writer);
+				}
+				
+				for (size_t j = 0; j < var_count; j++)
+				{
+					SMVMwareNVRAMEFIVariable *var = SMVMwareNVRAMEntryGetVariableAtIndex(entry, j);
+					
+					// > Check if we are interested by this variable.
+					if (!content.nvram_efi_variables && content.nvram_efi_variable)
+					{
+						const char *utf8_name = SMVMwareNVRAMVariableGetUTF8Name(var, NULL);
+						
+						if (!utf8_name || strcmp(utf8_name, content.nvram_efi_variable) != 0)
+							continue;
+					}
+					
+					SMWriteEFIVariableJSON(var, writer);
+				}
+				
+				if (content.nvram)
+					SMJSONWriterEndArray(writer);
+			}
+			
+			// > Write nvram sections content.
+			else if (content.nvram)
+			{
+				size_t		bytes_size = 0;
+				const void	*bytes = SMVMwareNVRAMEntryGetContentBytes(entry, &bytes_size);
+				
+				SMJSONWriterKey(writer, "content");
+				SMJSONWriterHexString(writer, bytes, bytes_size);
+			}
+			
+			if (content.nvram)
+				SMJSONWriterEndObject(writer);
+		}
+		
+		SMJSONWriterEndArray(writer);
+	}
+	
+	// Done.
+	goto clean;
+	
+fail:
+	
+	if (result == SMMainExitSuccess)
+		result = SMMainExitUnknowError;
+	
+	// > Keep the record valid, and tell why it's incomplete.
+	SMJSONWriterEndToDepth(writer, depth + 1);
+	SMJSONWriterKey(writer, "error");
+	
+	if (error)
+	{
+		SMJSONWriterString(writer, SMErrorGetSentencizedUserInfo(error));
+		fprintf(ferr, "Error: %s\n", SMErrorGetSentencizedUserInfo(error));
+	}
+	else
+		SMJSONWriterNull(writer);
+	
+clean:
+	SMJSONWriterEndObject(writer);
+	SMErrorFree(error);
+	
+	if (!cache)
+	{
+		SMVMwareVMXFree(g_vmx);
+		SMVMwareNVRAMFree(g_nvram);
+	}
+	
+	return result;
+}
+
+
+#pragma mark > Change
+
+static int main_change(SMCLOptionsResult *opt_result, FILE *fout, FILE *ferr)
+{
+	int					result = SMMainExitSuccess;
+	SMError				*error = NULL;
+	SMMainChangeBundle	*bundles = NULL;
+	size_t				bundles_cnt = 0;
+	size_t				jobs = 0;
+	
+	// Collect bundles.
+	for (size_t i = 0; i < SMCLOptionsResultParametersCount(opt_result); i++)
+	{
+		SMMainChange mainChangeOp = (SMMainChange)SMCLOptionsResultParameterIdentifierAtIndex(opt_result, i);
+		
+		switch (mainChangeOp)
+		{
+			case SMMainChangeVM:
+			{
+				const char *vm_path = SMCLOptionsResultParameterStringValueAtIndex(opt_result, i);
+				
+				SMAddBundle(&bundles, &bundles_cnt, vm_path, strlen(vm_path));
+				break;
+			}
+				
+			case SMMainChangeBundlesList:
+			{
+				if (!SMReadBundlesList(SMCLOptionsResultParameterStringValueAtIndex(opt_result, i), &bundles, &bundles_cnt, &error))
+				{
+					fprintf(ferr, "Error: %s\n", SMErrorGetSentencizedUserInfo(error));
+					result = SMMainExitInvalidArgs;
+					goto clean;
+				}
+				
+				break;
+			}
+				
+			case SMMainChangeJobs:
+			{
+				jobs = SMCLOptionsResultParameterUInt32ValueAtIndex(opt_result, i);
+				break;
+			}
+				
+			default:
+				break;
+		}
+	}
+	
+	if (bundles_cnt == 0)
+	{
+		fprintf(ferr, "Error: Missing virtual machine bundle.\n");
+		result = SMMainExitInvalidArgs;
+		goto clean;
+	}
+	
+	// Change a single bundle in place.
+	if (bundles_cnt == 1)
+	{
+		result = main_change_bundle(bundles[0].vm_path, opt_result, fout, ferr);
+		goto clean;
+	}
+	
+	// Change bundles in parallel.
+	// > Bundles vary in size, so they are run as independent tasks, balanced by work stealing.
+	// > Resolve the default count before capping it: 0 would stay 0, and give a worker per CPU for a few bundles.
+	if (jobs == 0)
+		jobs = SMThreadPoolDefaultThreadsCount();
+	
+	SMMainChangeContext	context = { .opt_result = opt_result, .bundles = bundles };
+	SMThreadPool		*pool = SMThreadPoolCreate(MIN(jobs, bundles_cnt));
+	
+	SMThreadPoolApply(pool, bundles_cnt, main_change_bundle_apply, &context);
+	SMThreadPoolFree(pool);
+	
+	// > Output results in order.
+	size_t failed_cnt = 0;
+	
+	for (size_t i = 0; i < bundles_cnt; i++)
+	{
+		SMMainChangeBundle *bundle = &bundles[i];
+		
+		SMPrintPrefixedLines(bundle->vm_path, bundle->out_bytes, bundle->out_size, fout);
+		SMPrintPrefixedLines(bundle->vm_path, bundle->err_bytes, bundle->err_size, ferr);
+		
+		if (bundle->result != SMMainExitSuccess)
+		{
+			if (result == SMMainExitSuccess)
+				result = bundle->result;
+			
+			failed_cnt++;
+		}
+	}
+	
+	if (failed_cnt > 0)
+		fprintf(ferr, "Error: Failed to change %zu of %zu virtual machines.\n", failed_cnt, bundles_cnt);
+	
+clean:
+	for (size_t i = 0; i < bundles_cnt; i++)
+	{
+		free(bundles[i].vm_path);
+		free(bundles[i].out_bytes);
+		free(bundles[i].err_bytes);
+	}
+	
+	free(bundles);
+	SMErrorFree(error);
+	
+	return result;
+}
+
+static void main_change_bundle_apply(size_t idx, void *context)
+{
+	SMMainChangeContext	*ctx = context;
+	SMMainChangeBundle	*bundle = &ctx->bundles[idx];
+	FILE				*fout = open_memstream(&bundle->out_bytes, &bundle->out_size);
+	FILE				*ferr = open_memstream(&bundle->err_bytes, &bundle->err_size);
+	
+	assert(fout && ferr);
+	
+	bundle->result = main_change_bundle(bundle->vm_path, ctx->opt_result, fout, ferr);
+	
+	fclose(fout);
+	fclose(ferr);
+}
+
+static int main_change_bundle(const char *vm_path, SMCLOptionsResult *opt_result, FILE *fout, FILE *ferr)
+{
+	int 			result = SMMainExitSuccess;
+
+	SMVMwareVMX		*g_vmx = NULL;
+	SMVMwareNVRAM	*g_nvram = NULL;
+	SMError			*error = NULL;
+	
+	// Handle options.
+	char			*vmx_path_tmp_path = NULL;
+	char			*nvram_path_tmp_path = NULL;
+	
+	for (size_t i = 0; i < SMCLOptionsResultParametersCount(opt_result); i++)
+	{
+		SMMainChange mainChangeOp = (SMMainChange)SMCLOptionsResultParameterIdentifierAtIndex(opt_result, i);
+		
+		switch (mainChangeOp)
+		{
+			case SMMainChangeVM:
+			case SMMainChangeBundlesList:
+			case SMMainChangeJobs:
+				break;
+				
+			case SMMainChangeBootArgs:
+			{
+				// Open NVRAM file.
+				SMVMwareNVRAM *nvram = SMGetNVRAMFromVM(vm_path, NULL, &g_vmx, &g_nvram, &error);
+
+				if (!nvram)
+				{
+					result = SMMainExitInvalidVM;
+					goto fail;
+				}
+
+				// Set boot arguments.
+				if (!SMVMwareNVRAMSetBootArgs(nvram, SMCLOptionsResultParameterStringValueAtIndex(opt_result, i), &error))
+					goto fail;
+				
+				break;
 			}
 				
 			case SMMainChangeCSREnable:
@@ -647,7 +1426,7 @@ static int main_change(SMCLOptionsResult *opt_result, FILE *fout, FILE *ferr)
 				else if (mainChangeOp == SMMainChangeCSREnable || mainChangeOp == SMMainChangeCSRDisable)
 				{
 					// Get VMX.
-					SMVMwareVMX *vmx = SMGetVMXFromVM(vm_path, &g_vmx, &error);
+					SMVMwareVMX *vmx = SMGetVMXFromVM(vm_path, NULL, &g_vmx, &error);
 					
 					if (!vmx)
 					{
@@ -667,7 +1446,7 @@ static int main_change(SMCLOptionsResult *opt_result, FILE *fout, FILE *ferr)
 				}
 
 				// Open NVRAM file.
-				SMVMwareNVRAM *nvram = SMGetNVRAMFromVM(vm_path, &g_vmx, &g_nvram, &error);
+				SMVMwareNVRAM *nvram = SMGetNVRAMFromVM(vm_path, NULL, &g_vmx, &g_nvram, &error);
 				
 				if (!nvram)
 				{
@@ -689,7 +1468,7 @@ static int main_change(SMCLOptionsResult *opt_result, FILE *fout, FILE *ferr)
 				uint32_t new_csr = SMCLOptionsResultParameterUInt32ValueAtIndex(opt_result, i);
 				
 				// Open NVRAM file.
-				SMVMwareNVRAM *nvram = SMGetNVRAMFromVM(vm_path, &g_vmx, &g_nvram, &error);
+				SMVMwareNVRAM *nvram = SMGetNVRAMFromVM(vm_path, NULL, &g_vmx, &g_nvram, &error);
 				
 				if (!nvram)
 				{
@@ -717,7 +1496,7 @@ static int main_change(SMCLOptionsResult *opt_result, FILE *fout, FILE *ferr)
 				}
 				
 				// Open VMX.
-				SMVMwareVMX *vmx = SMGetVMXFromVM(vm_path, &g_vmx, &error);
+				SMVMwareVMX *vmx = SMGetVMXFromVM(vm_path, NULL, &g_vmx, &error);
 				
 				if (!vmx)
 				{
@@ -730,7 +1509,7 @@ static int main_change(SMCLOptionsResult *opt_result, FILE *fout, FILE *ferr)
 					goto fail;
 
 				// Open NVRAM file.
-				SMVMwareNVRAM *nvram = SMGetNVRAMFromVM(vm_path, &g_vmx, &g_nvram, &error);
+				SMVMwareNVRAM *nvram = SMGetNVRAMFromVM(vm_path, NULL, &g_vmx, &g_nvram, &error);
 				
 				if (!nvram)
 				{
@@ -761,7 +1540,7 @@ static int main_change(SMCLOptionsResult *opt_result, FILE *fout, FILE *ferr)
 				}
 				
 				// Open NVRAM file.
-				SMVMwareNVRAM *nvram = SMGetNVRAMFromVM(vm_path, &g_vmx, &g_nvram, &error);
+				SMVMwareNVRAM *nvram = SMGetNVRAMFromVM(vm_path, NULL, &g_vmx, &g_nvram, &error);
 				
 				if (!nvram)
 				{
@@ -869,6 +1648,348 @@ clean:
 }
 
 
+#pragma mark > Apply
+
+static int main_apply(SMCLOptions *options, SMCLOptionsResult *opt_result, FILE *fout, FILE *ferr)
+{
+	int		result = SMMainExitSuccess;
+	char	*line = NULL;
+	size_t	line_capacity = 0;
+	ssize_t	line_len;
+	size_t	line_idx = 0;
+	size_t	records_cnt = 0;
+	size_t	failed_cnt = 0;
+	
+	// Open manifest.
+	const char	*manifest_path = SMCLOptionsResultParameterStringValueAtIndex(opt_result, 0);
+	FILE		*manifest = (strcmp(manifest_path, "-") == 0 ? stdin : fopen(manifest_path, "r"));
+	
+	if (!manifest)
+	{
+		fprintf(ferr, "Error: Can't open manifest '%s' (%d - %s).\n", manifest_path, errno, strerror(errno));
+		return SMMainExitInvalidArgs;
+	}
+	
+	// Apply records, one per line.
+	// > Each record is handled before reading the next one: memory doesn't depend on manifest size.
+	while ((line_len = getline(&line, &line_capacity, manifest)) != -1)
+	{
+		line_idx++;
+		
+		while (line_len > 0 && (line[line_len - 1] == '\n' || line[line_len - 1] == '\r'))
+			line[--line_len] = 0;
+		
+		// > Skip empty lines & comments.
+		const char *record = line + strspn(line, " \t");
+		
+		if (*record == 0 || *record == '#')
+			continue;
+		
+		// > Apply.
+		int record_result = main_apply_record(options, record, line_idx, fout, ferr);
+		
+		records_cnt++;
+		
+		if (record_result != SMMainExitSuccess)
+		{
+			if (result == SMMainExitSuccess)
+				result = record_result;
+			
+			failed_cnt++;
+		}
+	}
+	
+	if (failed_cnt > 0)
+		fprintf(ferr, "Error: Failed to apply %zu of %zu manifest records.\n", failed_cnt, records_cnt);
+	
+	// Clean.
+	free(line);
+	
+	if (manifest != stdin)
+		fclose(manifest);
+	
+	return result;
+}
+
+static int main_apply_record(SMCLOptions *options, const char *record, size_t line_idx, FILE *fout, FILE *ferr)
+{
+	int					result = SMMainExitSuccess;
+	char				**args = NULL;
+	const char			**argv = NULL;
+	SMCLOptionsResult	*opt_result = NULL;
+	SMError				*error = NULL;
+	const char			*vm_path = NULL;
+	
+	// Split record.
+	size_t args_cnt = 0;
+	
+	args = SMStringSplitArguments(record, &args_cnt);
+	
+	if (!args)
+	{
+		fprintf(ferr, "Error: Manifest line %zu: Unterminated quote.\n", line_idx);
+		result = SMMainExitInvalidArgs;
+		goto clean;
+	}
+	
+	// Parse record as 'change' arguments.
+	argv = malloc((args_cnt + 2) * sizeof(char *));
+	
+	assert(argv);
+	
+	argv[0] = "vm-config";
+	argv[1] = "change";
+	memcpy(argv + 2, args, args_cnt * sizeof(char *));
+	
+	opt_result = SMCLOptionsParse(options, (int)(args_cnt + 2), argv, &error);
+	
+	if (!opt_result)
+	{
+		fprintf(ferr, "Error: Manifest line %zu: %s\n", line_idx, SMErrorGetSentencizedUserInfo(error));
+		result = SMMainExitInvalidArgs;
+		goto clean;
+	}
+	
+	// Check record targets a single bundle.
+	for (size_t i = 0; i < SMCLOptionsResultParametersCount(opt_result); i++)
+	{
+		switch ((SMMainChange)SMCLOptionsResultParameterIdentifierAtIndex(opt_result, i))
+		{
+			case SMMainChangeVM:
+			{
+				if (vm_path)
+				{
+					fprintf(ferr, "Error: Manifest line %zu: Only one virtual machine bundle is allowed.\n", line_idx);
+					result = SMMainExitInvalidArgs;
+					goto clean;
+				}
+				
+				vm_path = SMCLOptionsResultParameterStringValueAtIndex(opt_result, i);
+				break;
+			}
+				
+			case SMMainChangeBundlesList:
+			case SMMainChangeJobs:
+			{
+				fprintf(ferr, "Error: Manifest line %zu: Options --bundles-list and --jobs are not allowed.\n", line_idx);
+				result = SMMainExitInvalidArgs;
+				goto clean;
+			}
+				
+			default:
+				break;
+		}
+	}
+	
+	if (!vm_path)
+	{
+		fprintf(ferr, "Error: Manifest line %zu: Missing virtual machine bundle.\n", line_idx);
+		result = SMMainExitInvalidArgs;
+		goto clean;
+	}
+	
+	// Change bundle, output prefixed by its path.
+	char	*out_bytes = NULL, *err_bytes = NULL;
+	size_t	out_size = 0, err_size = 0;
+	FILE	*bout = open_memstream(&out_bytes, &out_size);
+	FILE	*berr = open_memstream(&err_bytes, &err_size);
+	
+	assert(bout && berr);
+	
+	result = main_change_bundle(vm_path, opt_result, bout, berr);
+	
+	fclose(bout);
+	fclose(berr);
+	
+	SMPrintPrefixedLines(vm_path, out_bytes, out_size, fout);
+	SMPrintPrefixedLines(vm_path, err_bytes, err_size, ferr);
+	
+	free(out_bytes);
+	free(err_bytes);
+	
+clean:
+	SMCLOptionsResultFree(opt_result);
+	SMErrorFree(error);
+	free(argv);
+	free(args);
+	
+	return result;
+}
+
+
+
+#pragma mark > Serve
+
+static int main_serve(SMCLOptions *options, SMCLOptionsResult *opt_result, FILE *fout, FILE *ferr)
+{
+	const char	*socket_path = NULL;
+	size_t		cache_size = 64;
+	
+	// Handle options.
+	for (size_t i = 0; i < SMCLOptionsResultParametersCount(opt_result); i++)
+	{
+		switch ((SMMainServe)SMCLOptionsResultParameterIdentifierAtIndex(opt_result, i))
+		{
+			case SMMainServeSocket:
+				socket_path = SMCLOptionsResultParameterStringValueAtIndex(opt_result, i);
+				break;
+				
+			case SMMainServeCacheSize:
+				cache_size = SMCLOptionsResultParameterUInt32ValueAtIndex(opt_result, i);
+				break;
+		}
+	}
+	
+	// Keep working directory.
+	int directory_fd = open(".", O_RDONLY | O_CLOEXEC);
+	
+	if (directory_fd == -1)
+	{
+		fprintf(ferr, "Error: Can't open working directory (%d - %s).\n", errno, strerror(errno));
+		return SMMainExitUnknowError;
+	}
+	
+	// Create server.
+	SMError				*error = NULL;
+	SMMainServeContext	context = { .options = options, .cache = SMVMwareCacheCreate(cache_size), .directory_fd = directory_fd };
+	SMServer			*server = SMServerCreate(socket_path, main_serve_request, &context, &error);
+	
+	if (!server)
+	{
+		fprintf(ferr, "Error: %s\n", SMErrorGetSentencizedUserInfo(error));
+		
+		SMErrorFree(error);
+		SMVMwareCacheFree(context.cache);
+		close(directory_fd);
+		
+		return SMMainExitUnknowError;
+	}
+	
+	// Serve until interrupted.
+	// > Requests reading standard input (e.g. '--bundles-list -') get an empty one, and a client leaving early doesn't kill the server.
+	if (!freopen("/dev/null", "r", stdin))
+		fprintf(ferr, "Warning: Can't detach standard input (%d - %s).\n", errno, strerror(errno));
+	
+	signal(SIGPIPE, SIG_IGN);
+	
+	g_serve_server = server;
+	
+	signal(SIGINT, main_serve_signal);
+	signal(SIGTERM, main_serve_signal);
+	
+	// > Requests are handled one at a time: cached instances parse their content lazily, and can't be shared between threads.
+	SMServerRun(server);
+	
+	signal(SIGINT, SIG_DFL);
+	signal(SIGTERM, SIG_DFL);
+	
+	g_serve_server = NULL;
+	
+	// Clean.
+	SMServerFree(server);
+	SMVMwareCacheFree(context.cache);
+	close(directory_fd);
+	
+	return SMMainExitSuccess;
+}
+
+static int main_serve_request(const char *working_directory, int argc, const char *argv[], FILE *fout, FILE *ferr, void *context)
+{
+	SMMainServeContext *serve = context;
+	
+	// Move to client working directory, so relative paths are the client ones.
+	// > Requests are handled one at a time: the process working directory can be changed for the duration of a request.
+	if (working_directory && chdir(working_directory) == -1)
+	{
+		fprintf(ferr, "Error: Can't change to working directory '%s' (%d - %s).\n", working_directory, errno, strerror(errno));
+		return SMMainExitUnknowError;
+	}
+	
+	// Run request as a command line.
+	// > Requests don't contain the program name: add it, with the NULL terminator.
+	const char **main_argv = malloc(((size_t)argc + 2) * sizeof(char *));
+	
+	assert(main_argv);
+	
+	main_argv[0] = "vm-config";
+	memcpy(main_argv + 1, argv, ((size_t)argc + 1) * sizeof(char *));
+	
+	int result = main_run(serve->options, serve->cache, argc + 1, main_argv, fout, ferr);
+	
+	free(main_argv);
+	
+	// Restore server working directory.
+	if (working_directory && fchdir(serve->directory_fd) == -1)
+		fprintf(ferr, "Warning: Can't restore server working directory (%d - %s).\n", errno, strerror(errno));
+	
+	return result;
+}
+
+static void main_serve_signal(int sig)
+{
+	SMServer *server = g_serve_server;
+	
+	if (server)
+		SMServerStop(server);
+}
+
+
+#pragma mark > Call
+
+static int main_call(SMCLOptionsResult *opt_result, FILE *fout, FILE *ferr)
+{
+	int				result = SMMainExitSuccess;
+	SMError			*error = NULL;
+	SMServerClient	*client = NULL;
+	const char		*socket_path = NULL;
+	const char		**args = malloc(SMCLOptionsResultParametersCount(opt_result) * sizeof(char *));
+	size_t			args_cnt = 0;
+	
+	assert(args);
+	
+	// Handle options.
+	for (size_t i = 0; i < SMCLOptionsResultParametersCount(opt_result); i++)
+	{
+		switch ((SMMainCall)SMCLOptionsResultParameterIdentifierAtIndex(opt_result, i))
+		{
+			case SMMainCallSocket:
+				socket_path = SMCLOptionsResultParameterStringValueAtIndex(opt_result, i);
+				break;
+				
+			case SMMainCallArguments:
+				args[args_cnt++] = SMCLOptionsResultParameterStringValueAtIndex(opt_result, i);
+				break;
+		}
+	}
+	
+	// Send request.
+	char	*out_bytes = NULL, *err_bytes = NULL;
+	size_t	out_size = 0, err_size = 0;
+	
+	client = SMServerClientConnect(socket_path, &error);
+	
+	if (!client || !SMServerClientRun(client, (int)args_cnt, args, &result, &out_bytes, &out_size, &err_bytes, &err_size, &error))
+	{
+		fprintf(ferr, "Error: %s\n", SMErrorGetSentencizedUserInfo(error));
+		result = SMMainExitUnknowError;
+		goto clean;
+	}
+	
+	// Output response.
+	fwrite(out_bytes, 1, out_size, fout);
+	fwrite(err_bytes, 1, err_size, ferr);
+	
+clean:
+	SMServerClientFree(client);
+	SMErrorFree(error);
+	free(out_bytes);
+	free(err_bytes);
+	free(args);
+	
+	return result;
+}
+
+
 /*
 ** Information
 */
@@ -891,7 +2012,7 @@ static void show_version(FILE *output)
 
 #pragma mark > VMware
 
-static SMVMwareVMX * SMGetVMXFromVM(const char *vm_path, SMVMwareVMX **inoutVMX, SMError **error)
+static SMVMwareVMX * SMGetVMXFromVM(const char *vm_path, SMVMwareCache *cache, SMVMwareVMX **inoutVMX, SMError **error)
 {
 	if (*inoutVMX)
 		return *inoutVMX;
@@ -919,7 +2040,7 @@ static SMVMwareVMX * SMGetVMXFromVM(const char *vm_path, SMVMwareVMX **inoutVMX,
 		char *path = SMStringPathAppendComponent(vm_path, dp->d_name);
 		
 		found_vmx = true;
-		result = SMVMwareVMXOpen(path, error);
+		result = (cache ? SMVMwareCacheGetVMX(cache, path, error) : SMVMwareVMXOpen(path, error));
 		
 		free(path);
 		
@@ -940,7 +2061,7 @@ finish:
 	
 }
 
-static SMVMwareNVRAM * SMGetNVRAMFromVM(const char *vm_path, SMVMwareVMX **inoutVMX, SMVMwareNVRAM **inoutNVRAM, SMError **error)
+static SMVMwareNVRAM * SMGetNVRAMFromVM(const char *vm_path, SMVMwareCache *cache, SMVMwareVMX **inoutVMX, SMVMwareNVRAM **inoutNVRAM, SMError **error)
 {
 	if (*inoutNVRAM)
 		return *inoutNVRAM;
@@ -948,7 +2069,7 @@ static SMVMwareNVRAM * SMGetNVRAMFromVM(const char *vm_path, SMVMwareVMX **inout
 	SMVMwareNVRAM *result = NULL;
 	
 	// Get VMX.
-	SMVMwareVMX *vmx = SMGetVMXFromVM(vm_path, inoutVMX, error);
+	SMVMwareVMX *vmx = SMGetVMXFromVM(vm_path, cache, inoutVMX, error);
 	
 	if (!vmx)
 		return NULL;
@@ -971,7 +2092,7 @@ static SMVMwareNVRAM * SMGetNVRAMFromVM(const char *vm_path, SMVMwareVMX **inout
 	// Forge NVRAM path.
 	char *path = SMStringPathAppendComponent(vm_path, name);
 		
-	result = SMVMwareNVRAMOpen(path, error);
+	result = (cache ? SMVMwareCacheGetNVRAM(cache, path, error) : SMVMwareNVRAMOpen(path, error));
 	
 	free(path);
 	
@@ -984,6 +2105,61 @@ finish:
 }
 
 
+#pragma mark > Bundles
+
+static bool SMReadBundlesList(const char *list_path, SMMainChangeBundle **bundles, size_t *bundles_cnt, SMError **error)
+{
+	// Open list.
+	FILE *file = (strcmp(list_path, "-") == 0 ? stdin : fopen(list_path, "r"));
+	
+	if (!file)
+	{
+		SMSetErrorPtr(error, "main", -1, "can't open bundles list '%s' (%d - %s)", list_path, errno, strerror(errno));
+		return false;
+	}
+	
+	// Read paths, one per line.
+	char	*line = NULL;
+	size_t	line_capacity = 0;
+	ssize_t	line_len;
+	
+	while ((line_len = getline(&line, &line_capacity, file)) != -1)
+	{
+		while (line_len > 0 && (line[line_len - 1] == '\n' || line[line_len - 1] == '\r'))
+			line_len--;
+		
+		if (line_len == 0)
+			continue;
+		
+		SMAddBundle(bundles, bundles_cnt, line, (size_t)line_len);
+	}
+	
+	free(line);
+	
+	if (file != stdin)
+		fclose(file);
+	
+	return true;
+}
+
+static void SMAddBundle(SMMainChangeBundle **bundles, size_t *bundles_cnt, const char *vm_path, size_t vm_path_len)
+{
+	*bundles = reallocf(*bundles, (*bundles_cnt + 1) * sizeof(SMMainChangeBundle));
+	
+	assert(*bundles);
+	
+	SMMainChangeBundle *bundle = &(*bundles)[*bundles_cnt];
+	
+	memset(bundle, 0, sizeof(*bundle));
+	
+	bundle->vm_path = strndup(vm_path, vm_path_len);
+	
+	assert(bundle->vm_path);
+	
+	(*bundles_cnt)++;
+}
+
+
 #pragma mark > Output
 
 static void SMDumpBytes(const void *bytes, size_t size, size_t padding, FILE *output)
@@ -1036,3 +2212,186 @@ static void SMDumpBytes(const void *bytes, size_t size, size_t padding, FILE *ou
 	// Clean.
 	free(padding_str);
 }
+
+static void SMPrintPrefixedLines(const char *prefix, const char *bytes, size_t size, FILE *output)
+{
+	while (size > 0)
+	{
+		const char	*end = memchr(bytes, '\n', size);
+		size_t		line_size = (end ? (size_t)(end - bytes) + 1 : size);
+		
+		// > Skip empty lines, they don't separate anything once prefixed.
+		if (line_size > 1 || !end)
+		{
+			fprintf(output, "%s: ", prefix);
+			fwrite(bytes, 1, line_size, output);
+			
+			if (!end)
+				fputc('\n', output);
+		}
+		
+		bytes += line_size;
+		size -= line_size;
+	}
+}
+
+static void SMPrintFlagsNames(uint32_t flags, const SMMainFlagName *names, size_t count, FILE *output)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		if (flags & names[i].flag)
+			fprintf(output, "           %s\n", names[i].name);
+	}
+}
+
+
+#pragma mark > JSON
+
+static void SMWriteEFIVariableJSON(SMVMwareNVRAMEFIVariable *var, SMJSONWriter *writer)
+{
+	efi_guid_t apple_nvram_variable_guid = Apple_NVRAM_Variable_Guid;
+	efi_guid_t apple_screen_resolution_guid = Apple_Screen_Resolution_Guid;
+	efi_guid_t dhcpv6_service_binding_guid = DHCPv6_Service_Binding_Guid;
+	
+	uint32_t	attributes = SMVMwareNVRAMVariableGetAttributes(var);
+	
+	size_t		name_size = 0;
+	const void	*name = SMVMwareNVRAMVariableGetName(var, &name_size);
+	
+	size_t		value_size = 0;
+	const void	*value = SMVMwareNVRAMVariableGetValue(var, &value_size);
+	
+	const char	*utf8_name = SMVMwareNVRAMVariableGetUTF8Name(var, NULL);
+	
+	SMJSONWriterBeginObject(writer);
+	
+	// GUID.
+	efi_guid_t	guid = SMVMwareNVRAMVariableGetGUID(var);
+	char		guid_str[SMVMwareGUIDStringSize + 1];
+	
+	SMVMwareNVRAMGUIDToGUIDString(&guid, guid_str);
+	
+	SMJSONWriterKey(writer, "guid");
+	SMJSONWriterString(writer, guid_str);
+	
+	// Attributes.
+	SMJSONWriterKey(writer, "attributes");
+	SMJSONWriterUInt(writer, attributes);
+	
+	SMJSONWriterKey(writer, "attributes_names");
+	SMWriteFlagsNamesJSON(attributes, g_efi_attributes_names, SMCountOf(g_efi_attributes_names), writer);
+	
+	// Name.
+	// > Raw bytes are written in hexadecimal, decoded forms next to them.
+	SMJSONWriterKey(writer, "name");
+	SMJSONWriterHexString(writer, name, name_size);
+	
+	if (utf8_name)
+	{
+		SMJSONWriterKey(writer, "utf8_name");
+		SMJSONWriterString(writer, utf8_name);
+	}
+	
+	// Value.
+	SMJSONWriterKey(writer, "value");
+	SMJSONWriterHexString(writer, value, value_size);
+	
+	// Specific value handling.
+	// > Values have no alignment guarantee: integers are copied out.
+	if (utf8_name && memcmp(&guid, &apple_nvram_variable_guid, sizeof(guid)) == 0)
+	{
+		if (strcmp(utf8_name, "csr-active-config") == 0 && value_size == 4)
+		{
+			uint32_t csr;
+			
+			memcpy(&csr, value, sizeof(csr));
+			
+			SMJSONWriterKey(writer, "decoded");
+			SMJSONWriterBeginObject(writer);
+			
+			SMJSONWriterKey(writer, "csr_flags");
+			SMJSONWriterUInt(writer, csr);
+			SMJSONWriterKey(writer, "csr_flags_names");
+			SMWriteFlagsNamesJSON(csr, g_csr_flags_names, SMCountOf(g_csr_flags_names), writer);
+			
+			SMJSONWriterEndObject(writer);
+		}
+		else if (strcmp(utf8_name, "platform-uuid") == 0 && value_size == sizeof(uuid_t))
+		{
+			uuid_string_t uuid_str;
+			
+			uuid_unparse(value, uuid_str);
+			
+			SMJSONWriterKey(writer, "decoded");
+			SMJSONWriterBeginObject(writer);
+			
+			SMJSONWriterKey(writer, "uuid");
+			SMJSONWriterString(writer, uuid_str);
+			
+			SMJSONWriterEndObject(writer);
+		}
+		else if (strcmp(utf8_name, "fmm-computer-name") == 0 && value_size > 0)
+		{
+			SMJSONWriterKey(writer, "decoded");
+			SMJSONWriterBeginObject(writer);
+			
+			SMJSONWriterKey(writer, "computer_name");
+			SMJSONWriterStringBytes(writer, value, strnlen(value, value_size));
+			
+			SMJSONWriterEndObject(writer);
+		}
+	}
+	else if (utf8_name && memcmp(&guid, &apple_screen_resolution_guid, sizeof(guid)) == 0)
+	{
+		if ((strcmp(utf8_name, "width") == 0 || strcmp(utf8_name, "height") == 0) && value_size == 4)
+		{
+			uint32_t pixels;
+			
+			memcpy(&pixels, value, sizeof(pixels));
+			
+			SMJSONWriterKey(writer, "decoded");
+			SMJSONWriterBeginObject(writer);
+			
+			SMJSONWriterKey(writer, (utf8_name[0] == 'w' ? "screen_width" : "screen_height"));
+			SMJSONWriterUInt(writer, pixels);
+			
+			SMJSONWriterEndObject(writer);
+		}
+	}
+	else if (utf8_name && memcmp(&guid, &dhcpv6_service_binding_guid, sizeof(guid)) == 0)
+	{
+		if (strcmp(utf8_name, "ClientId") == 0 && value_size == 4 + sizeof(uuid_t))
+		{
+			uint32_t		unknown;
+			uuid_string_t	uuid_str;
+			
+			memcpy(&unknown, value, sizeof(unknown));
+			uuid_unparse((const uint8_t *)value + 4, uuid_str);
+			
+			SMJSONWriterKey(writer, "decoded");
+			SMJSONWriterBeginObject(writer);
+			
+			SMJSONWriterKey(writer, "client_id_unknown");
+			SMJSONWriterUInt(writer, unknown);
+			SMJSONWriterKey(writer, "client_id_uuid");
+			SMJSONWriterString(writer, uuid_str);
+			
+			SMJSONWriterEndObject(writer);
+		}
+	}
+	
+	SMJSONWriterEndObject(writer);
+}
+
+static void SMWriteFlagsNamesJSON(uint32_t flags, const SMMainFlagName *names, size_t count, SMJSONWriter *writer)
+{
+	SMJSONWriterBeginArray(writer);
+	
+	for (size_t i = 0; i < count; i++)
+	{
+		if (flags & names[i].flag)
+			SMJSONWriterString(writer, names[i].name);
+	}
+	
+	SMJSONWriterEndArray(writer);
+}